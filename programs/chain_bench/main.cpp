@@ -0,0 +1,515 @@
+/*
+ * chain_bench - replays a block range from an existing block_log on top of an optional state snapshot
+ * under repeatable conditions and writes a machine-readable performance report.
+ *
+ * Run:
+ *    chain_bench --bench-block-log /path/to/blockchain --bench-end-block 2000000 --bench-output report.json
+ *                [--bench-snapshot /path/to/shared_mem_dir] [--plugin account_history_rocksdb ...]
+ *
+ * Compare two reports (e.g. produced by two different builds):
+ *    chain_bench --compare baseline.json candidate.json [--max-regression 5]
+ */
+
+#include <appbase/application.hpp>
+#include <zattera/manifest/plugins.hpp>
+
+#include <zattera/protocol/version.hpp>
+
+#include <zattera/utils/git_revision.hpp>
+#include <zattera/utils/logging_config.hpp>
+
+#include <zattera/chain/block_log.hpp>
+#include <zattera/chain/block_notification.hpp>
+#include <zattera/chain/database.hpp>
+#include <zattera/chain/operation_notification.hpp>
+#include <zattera/chain/utils/signal.hpp>
+
+#include <zattera/plugins/chain/chain_plugin.hpp>
+
+#include <fc/exception/exception.hpp>
+#include <fc/filesystem.hpp>
+#include <fc/io/json.hpp>
+#include <fc/reflect/variant.hpp>
+
+#include <boost/exception/diagnostic_information.hpp>
+#include <boost/program_options.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <vector>
+
+namespace bpo = boost::program_options;
+namespace bfs = boost::filesystem;
+
+using std::string;
+using std::vector;
+
+namespace zattera { namespace chain_bench {
+
+using namespace zattera::chain;
+
+/// Set when the replay throws, the plugins are gone by the time main picks the exit status
+bool run_failed = false;
+
+struct operation_type_report
+{
+   string      name;
+   uint64_t    count = 0;
+   uint64_t    total_us = 0;
+   double      avg_us = 0;
+};
+
+struct bench_report
+{
+   string      zattera_git_revision;
+   uint32_t    start_block = 0;
+   uint32_t    end_block = 0;
+   uint32_t    blocks = 0;
+   uint64_t    transactions = 0;
+   uint64_t    operations = 0;
+   uint64_t    virtual_operations = 0;
+
+   double      elapsed_sec = 0;
+   double      blocks_per_sec = 0;
+   double      ops_per_sec = 0;
+
+   uint64_t    p50_block_us = 0;
+   uint64_t    p90_block_us = 0;
+   uint64_t    p99_block_us = 0;
+   uint64_t    max_block_us = 0;
+
+   uint64_t    rss_start_kb = 0;
+   uint64_t    rss_end_kb = 0;
+   int64_t     rss_growth_kb = 0;
+   uint64_t    shared_mem_used_start = 0;
+   uint64_t    shared_mem_used_end = 0;
+   int64_t     shared_mem_growth = 0;
+
+   vector< operation_type_report > operation_types;
+};
+
+} } // zattera::chain_bench
+
+FC_REFLECT( zattera::chain_bench::operation_type_report, (name)(count)(total_us)(avg_us) )
+FC_REFLECT( zattera::chain_bench::bench_report,
+   (zattera_git_revision)(start_block)(end_block)(blocks)(transactions)(operations)(virtual_operations)
+   (elapsed_sec)(blocks_per_sec)(ops_per_sec)
+   (p50_block_us)(p90_block_us)(p99_block_us)(max_block_us)
+   (rss_start_kb)(rss_end_kb)(rss_growth_kb)(shared_mem_used_start)(shared_mem_used_end)(shared_mem_growth)
+   (operation_types) )
+
+namespace zattera { namespace chain_bench {
+
+namespace detail {
+
+uint64_t read_rss_kb()
+{
+   FILE* input = fopen( "/proc/self/status", "r" );
+   if( input == nullptr )
+      return 0;
+
+   uint64_t rss = 0;
+   char line[256];
+   while( fgets( line, sizeof( line ), input ) != nullptr )
+   {
+      if( strncmp( line, "VmRSS:", 6 ) == 0 )
+      {
+         rss = strtoull( line + 6, nullptr, 10 );
+         break;
+      }
+   }
+
+   fclose( input );
+   return rss;
+}
+
+uint64_t percentile( const vector< uint64_t >& sorted, double p )
+{
+   if( sorted.empty() )
+      return 0;
+
+   size_t idx = size_t( p * double( sorted.size() - 1 ) + 0.5 );
+   return sorted[ std::min( idx, sorted.size() - 1 ) ];
+}
+
+class operation_name_visitor
+{
+   public:
+      typedef const char* result_type;
+
+      template< typename Op >
+      const char* operator()( const Op& )const { return fc::get_typename< Op >::name(); }
+};
+
+} // detail
+
+#define CHAIN_BENCH_PLUGIN_NAME "chain_bench"
+
+/**
+ * Drives the replay once every requested plugin has started, collects per-block and per-operation
+ * timings through the database signals and writes the report before quitting the application.
+ */
+class chain_bench_plugin : public appbase::plugin< chain_bench_plugin >
+{
+   public:
+      APPBASE_PLUGIN_REQUIRES( (zattera::plugins::chain::chain_plugin) )
+
+      static const std::string& name() { static std::string name = CHAIN_BENCH_PLUGIN_NAME; return name; }
+
+      virtual void set_program_options( appbase::options_description& cli, appbase::options_description& cfg ) override
+      {
+         cli.add_options()
+            ("bench-block-log", bpo::value< bfs::path >(), "Directory containing the source block_log to replay from. The --data-dir is used as scratch space and its state is wiped")
+            ("bench-snapshot", bpo::value< bfs::path >(), "Shared memory directory holding the state to start from (genesis if omitted)")
+            ("bench-end-block", bpo::value< uint32_t >()->default_value( 0 ), "Last block to apply (0 = head of the source block_log)")
+            ("bench-output", bpo::value< bfs::path >()->default_value( "chain_bench.json" ), "File the JSON report is written to")
+            ("bench-full-validation", bpo::bool_switch()->default_value( false ), "Apply blocks with full validation instead of the reindex skip flags")
+            ;
+      }
+
+      virtual void plugin_initialize( const appbase::variables_map& options ) override
+      {
+         FC_ASSERT( options.count( "bench-block-log" ), "--bench-block-log is required" );
+
+         _source_dir = options.at( "bench-block-log" ).as< bfs::path >();
+         _end_block = options.at( "bench-end-block" ).as< uint32_t >();
+         _output = options.at( "bench-output" ).as< bfs::path >();
+         _full_validation = options.at( "bench-full-validation" ).as< bool >();
+
+         FC_ASSERT( bfs::exists( _source_dir / "block_log" ), "No block_log found in ${d}", ("d", _source_dir.string()) );
+
+         auto& chain = appbase::app().get_plugin< zattera::plugins::chain::chain_plugin >();
+         prepare_data_dir( chain.state_storage_dir(),
+            options.count( "bench-snapshot" ) ? options.at( "bench-snapshot" ).as< bfs::path >() : bfs::path() );
+
+         auto& db = chain.db();
+         _pre_op_conn = db.add_pre_apply_operation_handler(
+            [this]( const operation_notification& ) { _op_start.push_back( now_us() ); }, *this, 0 );
+         _post_op_conn = db.add_post_apply_operation_handler(
+            [this]( const operation_notification& note ) { on_post_apply_operation( note ); }, *this, 0 );
+      }
+
+      virtual void plugin_startup() override
+      {
+         // Run after every plugin has been started so that their handlers see the whole range
+         appbase::app().get_io_service().post( [this]()
+         {
+            try
+            {
+               run();
+            }
+            catch( const fc::exception& e )
+            {
+               elog( "chain_bench failed: ${e}", ("e", e.to_detail_string()) );
+               run_failed = true;
+            }
+            catch( const std::exception& e )
+            {
+               elog( "chain_bench failed: ${e}", ("e", e.what()) );
+               run_failed = true;
+            }
+            appbase::app().quit();
+         } );
+      }
+
+      virtual void plugin_shutdown() override
+      {
+         chain::util::disconnect_signal( _pre_op_conn );
+         chain::util::disconnect_signal( _post_op_conn );
+      }
+
+   private:
+      static uint64_t now_us()
+      {
+         return std::chrono::duration_cast< std::chrono::microseconds >(
+            std::chrono::steady_clock::now().time_since_epoch() ).count();
+      }
+
+      /**
+       * The scratch data dir gets a fresh copy of the snapshot and a link to the source block_log, so every run
+       * starts from the same state and never writes to the source files.
+       */
+      void prepare_data_dir( const bfs::path& shared_mem_dir, const bfs::path& snapshot )
+      {
+         bfs::path block_dir = appbase::app().data_dir() / "blockchain";
+
+         bfs::remove( shared_mem_dir / "shared_memory.bin" );
+         bfs::remove( shared_mem_dir / "shared_memory.meta" );
+         bfs::remove( shared_mem_dir / "comment_content.log" );
+         bfs::remove( block_dir / "block_log" );
+         bfs::remove( block_dir / "block_log.index" );
+         bfs::create_directories( block_dir );
+         bfs::create_directories( shared_mem_dir );
+
+         bfs::create_symlink( bfs::absolute( _source_dir / "block_log" ), block_dir / "block_log" );
+         if( bfs::exists( _source_dir / "block_log.index" ) )
+            bfs::copy_file( _source_dir / "block_log.index", block_dir / "block_log.index" );
+
+         if( !snapshot.empty() )
+         {
+            FC_ASSERT( bfs::is_directory( snapshot ), "Snapshot ${s} is not a directory", ("s", snapshot.string()) );
+            for( bfs::directory_iterator itr( snapshot ); itr != bfs::directory_iterator(); ++itr )
+            {
+               if( bfs::is_regular_file( itr->path() ) )
+                  bfs::copy_file( itr->path(), shared_mem_dir / itr->path().filename(), bfs::copy_option::overwrite_if_exists );
+            }
+         }
+      }
+
+      void on_post_apply_operation( const operation_notification& note )
+      {
+         if( _op_start.empty() )
+            return;
+
+         uint64_t elapsed = now_us() - _op_start.back();
+         _op_start.pop_back();
+
+         auto& stats = _op_stats[ note.op.which() ];
+         if( stats.name.empty() )
+            stats.name = note.op.visit( detail::operation_name_visitor() );
+         ++stats.count;
+         stats.total_us += elapsed;
+
+         if( note.virtual_op )
+            ++_report.virtual_operations;
+         else
+            ++_report.operations;
+      }
+
+      void run()
+      {
+         auto& db = appbase::app().get_plugin< zattera::plugins::chain::chain_plugin >().db();
+
+         block_log source;
+         source.open( _source_dir / "block_log" );
+         FC_ASSERT( source.head(), "Source block_log is empty" );
+
+         uint32_t start_block = db.head_block_num() + 1;
+         uint32_t end_block = _end_block ? std::min( _end_block, source.head()->block_num() ) : source.head()->block_num();
+         FC_ASSERT( start_block <= end_block, "Nothing to replay: state head ${h}, end block ${e}", ("h", start_block - 1)("e", end_block) );
+
+         uint32_t skip = database::skip_block_log;
+         if( !_full_validation )
+         {
+            skip |= database::skip_witness_signature
+                  | database::skip_transaction_signatures
+                  | database::skip_transaction_dupe_check
+                  | database::skip_tapos_check
+                  | database::skip_merkle_check
+                  | database::skip_witness_schedule_check
+                  | database::skip_authority_check
+                  | database::skip_validate
+                  | database::skip_validate_invariants;
+         }
+
+         ilog( "chain_bench: applying blocks ${s} to ${e}", ("s", start_block)("e", end_block) );
+
+         _report.zattera_git_revision = zattera::utilities::git_revision_sha;
+         _report.start_block = start_block;
+         _report.end_block = end_block;
+         _report.rss_start_kb = detail::read_rss_kb();
+         _report.shared_mem_used_start = db.get_max_memory() - db.get_free_memory();
+
+         vector< uint64_t > block_us;
+         block_us.reserve( end_block - start_block + 1 );
+
+         uint64_t begin = now_us();
+         for( uint32_t n = start_block; n <= end_block; ++n )
+         {
+            auto block = source.read_block_by_num( n );
+            FC_ASSERT( block.valid(), "Block ${n} missing from source block_log", ("n", n) );
+
+            uint64_t block_begin = now_us();
+            db.with_write_lock( [&]()
+            {
+               db.push_block( *block, skip );
+            });
+            block_us.push_back( now_us() - block_begin );
+
+            _report.transactions += block->transactions.size();
+
+            if( n % 100000 == 0 )
+               ilog( "chain_bench: block ${n}", ("n", n) );
+         }
+         uint64_t elapsed = now_us() - begin;
+
+         _report.blocks = block_us.size();
+         _report.elapsed_sec = double( elapsed ) / 1000000.0;
+         if( elapsed )
+         {
+            _report.blocks_per_sec = double( _report.blocks ) * 1000000.0 / double( elapsed );
+            _report.ops_per_sec = double( _report.operations ) * 1000000.0 / double( elapsed );
+         }
+
+         std::sort( block_us.begin(), block_us.end() );
+         _report.p50_block_us = detail::percentile( block_us, 0.50 );
+         _report.p90_block_us = detail::percentile( block_us, 0.90 );
+         _report.p99_block_us = detail::percentile( block_us, 0.99 );
+         _report.max_block_us = block_us.empty() ? 0 : block_us.back();
+
+         _report.rss_end_kb = detail::read_rss_kb();
+         _report.rss_growth_kb = int64_t( _report.rss_end_kb ) - int64_t( _report.rss_start_kb );
+         _report.shared_mem_used_end = db.get_max_memory() - db.get_free_memory();
+         _report.shared_mem_growth = int64_t( _report.shared_mem_used_end ) - int64_t( _report.shared_mem_used_start );
+
+         for( auto& entry : _op_stats )
+         {
+            auto& stats = entry.second;
+            stats.avg_us = stats.count ? double( stats.total_us ) / double( stats.count ) : 0;
+            _report.operation_types.push_back( stats );
+         }
+         std::sort( _report.operation_types.begin(), _report.operation_types.end(),
+            []( const operation_type_report& a, const operation_type_report& b ) { return a.total_us > b.total_us; } );
+
+         fc::json::save_to_file( _report, _output );
+
+         ilog( "chain_bench: ${b} blocks in ${t} sec, ${bps} blocks/sec, ${ops} ops/sec, p50 ${p50} us, p99 ${p99} us. Report written to ${f}",
+            ("b", _report.blocks)("t", _report.elapsed_sec)("bps", _report.blocks_per_sec)("ops", _report.ops_per_sec)
+            ("p50", _report.p50_block_us)("p99", _report.p99_block_us)("f", _output.string()) );
+      }
+
+      bfs::path                                 _source_dir;
+      bfs::path                                 _output;
+      uint32_t                                  _end_block = 0;
+      bool                                      _full_validation = false;
+
+      bench_report                              _report;
+      std::map< int64_t, operation_type_report > _op_stats;
+      vector< uint64_t >                        _op_start;
+
+      boost::signals2::connection               _pre_op_conn;
+      boost::signals2::connection               _post_op_conn;
+};
+
+/**
+ * Prints the relative change of every headline metric and returns non-zero when the candidate is slower
+ * than the baseline by more than the allowed percentage.
+ */
+int compare_reports( const bfs::path& baseline_file, const bfs::path& candidate_file, double max_regression )
+{
+   auto baseline = fc::json::from_file( baseline_file ).as< bench_report >();
+   auto candidate = fc::json::from_file( candidate_file ).as< bench_report >();
+
+   if( baseline.start_block != candidate.start_block || baseline.end_block != candidate.end_block )
+      std::cerr << "warning: reports cover different block ranges\n";
+
+   bool regressed = false;
+
+   // higher_is_better tells which direction counts as a regression
+   auto row = [&]( const string& metric, double base, double cand, bool higher_is_better )
+   {
+      double change = base != 0 ? ( cand - base ) * 100.0 / base : 0;
+      double regression = higher_is_better ? -change : change;
+      bool bad = regression > max_regression;
+      regressed |= bad;
+
+      std::cout << std::left << std::setw( 40 ) << metric
+                << std::right << std::setw( 16 ) << std::fixed << std::setprecision( 2 ) << base
+                << std::setw( 16 ) << cand
+                << std::setw( 10 ) << std::showpos << change << "%" << std::noshowpos
+                << ( bad ? "  REGRESSION" : "" ) << "\n";
+   };
+
+   std::cout << std::left << std::setw( 40 ) << "metric"
+             << std::right << std::setw( 16 ) << "baseline" << std::setw( 16 ) << "candidate" << std::setw( 11 ) << "change" << "\n";
+
+   row( "blocks_per_sec", baseline.blocks_per_sec, candidate.blocks_per_sec, true );
+   row( "ops_per_sec", baseline.ops_per_sec, candidate.ops_per_sec, true );
+   row( "p50_block_us", baseline.p50_block_us, candidate.p50_block_us, false );
+   row( "p99_block_us", baseline.p99_block_us, candidate.p99_block_us, false );
+   row( "rss_growth_kb", baseline.rss_growth_kb, candidate.rss_growth_kb, false );
+   row( "shared_mem_growth", baseline.shared_mem_growth, candidate.shared_mem_growth, false );
+
+   std::map< string, operation_type_report > base_ops;
+   for( const auto& op : baseline.operation_types )
+      base_ops[ op.name ] = op;
+
+   for( const auto& op : candidate.operation_types )
+   {
+      auto itr = base_ops.find( op.name );
+      if( itr != base_ops.end() )
+         row( op.name + " avg_us", itr->second.avg_us, op.avg_us, false );
+   }
+
+   return regressed ? 1 : 0;
+}
+
+} } // zattera::chain_bench
+
+int main( int argc, char** argv )
+{
+   try
+   {
+      bpo::options_description compare_options;
+      compare_options.add_options()
+         ("compare", bpo::value< vector< string > >()->multitoken(), "Compare two reports: --compare baseline.json candidate.json")
+         ("max-regression", bpo::value< double >()->default_value( 5.0 ), "Percentage by which a metric may get worse before --compare fails")
+         ;
+
+      bpo::variables_map compare_args;
+      bpo::store( bpo::command_line_parser( argc, argv ).options( compare_options ).allow_unregistered().run(), compare_args );
+
+      if( compare_args.count( "compare" ) )
+      {
+         auto files = compare_args.at( "compare" ).as< vector< string > >();
+         FC_ASSERT( files.size() == 2, "--compare takes exactly two report files" );
+         return zattera::chain_bench::compare_reports( files[0], files[1], compare_args.at( "max-regression" ).as< double >() );
+      }
+
+      bpo::options_description options;
+      zattera::utilities::set_logging_program_options( options );
+      options.add( compare_options );
+      appbase::app().add_program_options( bpo::options_description(), options );
+
+      zattera::plugins::register_plugins();
+      appbase::app().register_plugin< zattera::chain_bench::chain_bench_plugin >();
+
+      appbase::app().set_version_string( "zattera_git_revision: " + fc::string( zattera::utilities::git_revision_sha ) + "\n" );
+      appbase::app().set_app_name( "chain_bench" );
+
+      bool initialized = appbase::app().initialize<
+            zattera::plugins::chain::chain_plugin,
+            zattera::chain_bench::chain_bench_plugin >
+            ( argc, argv );
+
+      if( !initialized )
+         return 0;
+
+      try
+      {
+         fc::optional< fc::logging_config > logging_config = zattera::utilities::load_logging_config( appbase::app().get_args(), appbase::app().data_dir() );
+         if( logging_config )
+            fc::configure_logging( *logging_config );
+      }
+      catch( const fc::exception& e )
+      {
+         wlog( "Error parsing logging config. ${e}", ("e", e.to_string()) );
+      }
+
+      appbase::app().startup();
+      appbase::app().exec();
+      return zattera::chain_bench::run_failed ? 1 : 0;
+   }
+   catch ( const boost::exception& e )
+   {
+      std::cerr << boost::diagnostic_information(e) << "\n";
+   }
+   catch ( const fc::exception& e )
+   {
+      std::cerr << e.to_detail_string() << "\n";
+   }
+   catch ( const std::exception& e )
+   {
+      std::cerr << e.what() << "\n";
+   }
+   catch ( ... )
+   {
+      std::cerr << "unknown exception\n";
+   }
+
+   return -1;
+}
@@ -0,0 +1,745 @@
+/*
+ * chain_gen - builds a synthetic chain from genesis and writes it to a block_log, for benchmarking replay and API
+ * performance without production data.
+ *
+ * Blocks are assembled directly from an operation template (transfers, votes, comments and custom_json issued by
+ * accounts picked with a Zipf distribution) and applied with the reindex skip flags, instead of going through
+ * database::generate_block() which applies every transaction twice and validates it in full.
+ *
+ * Run (needs a test mode build, the generated accounts are funded from the genesis supply):
+ *    chain_gen --data-dir /tmp/gen --gen-output /tmp/synthetic --gen-blocks 2000000 [--gen-accounts 10000]
+ *              [--gen-transactions-per-block 50] [--gen-operation-mix vote=45,transfer=25,comment=15,custom_json=15]
+ *
+ * Replay the result:
+ *    chain_bench --data-dir /tmp/bench --bench-block-log /tmp/synthetic
+ */
+
+#include <appbase/application.hpp>
+#include <zattera/manifest/plugins.hpp>
+
+#include <zattera/protocol/config.hpp>
+#include <zattera/protocol/prepared_block.hpp>
+#include <zattera/protocol/zattera_operations.hpp>
+
+#include <zattera/utils/git_revision.hpp>
+#include <zattera/utils/key_conversion.hpp>
+#include <zattera/utils/logging_config.hpp>
+
+#include <zattera/chain/account_object.hpp>
+#include <zattera/chain/block_log.hpp>
+#include <zattera/chain/database.hpp>
+#include <zattera/chain/witness_objects.hpp>
+
+#include <zattera/plugins/chain/chain_plugin.hpp>
+
+#include <fc/exception/exception.hpp>
+#include <fc/filesystem.hpp>
+#include <fc/io/raw.hpp>
+
+#include <boost/algorithm/string.hpp>
+#include <boost/exception/diagnostic_information.hpp>
+#include <boost/program_options.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <deque>
+#include <iostream>
+#include <random>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+namespace bpo = boost::program_options;
+namespace bfs = boost::filesystem;
+
+using std::string;
+using std::vector;
+
+namespace zattera { namespace chain_gen {
+
+using namespace zattera::chain;
+using namespace zattera::protocol;
+
+/// Set when generation throws, the plugins are gone by the time main picks the exit status
+bool run_failed = false;
+
+enum generated_operation_type
+{
+   generate_transfer,
+   generate_vote,
+   generate_comment,
+   generate_custom_json,
+   generated_operation_type_count
+};
+
+namespace detail {
+
+const char* const operation_type_names[ generated_operation_type_count ] = { "transfer", "vote", "comment", "custom_json" };
+
+const char* const categories[] = { "general", "photography", "music", "travel", "food", "technology", "art", "gaming" };
+
+const char* const custom_json_actions[] = { "follow", "reblog", "claim", "play", "subscribe" };
+
+/// Comments are not replied to deeper than this, threads on the live chain rarely go further
+const uint16_t max_reply_depth = 8;
+
+/// Number of recent comments kept as candidates for replies and votes
+const size_t max_recent_comments = 50000;
+
+/**
+ * Parses the operation mix, e.g. "vote=45,transfer=25,comment=15,custom_json=15", into one weight per
+ * generated_operation_type. Types that are not listed get a weight of 0.
+ */
+vector< double > parse_operation_mix( const string& mix )
+{
+   vector< double > weights( generated_operation_type_count, 0 );
+
+   vector< string > entries;
+   boost::split( entries, mix, boost::is_any_of( "," ) );
+   for( auto entry : entries )
+   {
+      boost::trim( entry );
+      if( entry.empty() )
+         continue;
+
+      auto eq = entry.find( '=' );
+      FC_ASSERT( eq != string::npos, "Operation mix entry ${e} is not of the form type=weight", ("e", entry) );
+
+      string name = entry.substr( 0, eq );
+      auto type = std::find( operation_type_names, operation_type_names + generated_operation_type_count, name ) - operation_type_names;
+      FC_ASSERT( type < generated_operation_type_count, "Unknown operation type ${n} in operation mix", ("n", name) );
+
+      weights[ type ] = std::stod( entry.substr( eq + 1 ) );
+      FC_ASSERT( weights[ type ] >= 0, "Operation mix weights cannot be negative" );
+   }
+
+   FC_ASSERT( std::any_of( weights.begin(), weights.end(), []( double w ){ return w > 0; } ), "Operation mix is empty" );
+   return weights;
+}
+
+} // detail
+
+#define CHAIN_GEN_PLUGIN_NAME "chain_gen"
+
+/**
+ * Generates the chain once the chain plugin has opened an empty database in the scratch --data-dir. Every block
+ * is applied to that database, so the generator can pick operations that are valid against the current state, and
+ * appended to the output block_log as soon as it has been applied.
+ *
+ * Account keys are derived from the account name and cached, so transactions and blocks can optionally be signed
+ * and the chain replayed with full validation.
+ */
+class chain_gen_plugin : public appbase::plugin< chain_gen_plugin >
+{
+   public:
+      APPBASE_PLUGIN_REQUIRES( (zattera::plugins::chain::chain_plugin) )
+
+      static const std::string& name() { static std::string name = CHAIN_GEN_PLUGIN_NAME; return name; }
+
+      virtual void set_program_options( appbase::options_description& cli, appbase::options_description& cfg ) override
+      {
+         cli.add_options()
+            ("gen-output", bpo::value< bfs::path >(), "Directory the generated block_log is written to. The --data-dir is used as scratch space and its state is wiped")
+            ("gen-blocks", bpo::value< uint32_t >()->default_value( 100000 ), "Number of blocks to generate")
+            ("gen-accounts", bpo::value< uint32_t >()->default_value( 10000 ), "Number of accounts created and funded at the start of the chain")
+            ("gen-transactions-per-block", bpo::value< double >()->default_value( 50 ), "Average number of transactions per block, the actual count follows a Poisson distribution")
+            ("gen-operation-mix", bpo::value< string >()->default_value( "vote=45,transfer=25,comment=15,custom_json=15" ), "Relative weights of the generated operation types")
+            ("gen-zipf-exponent", bpo::value< double >()->default_value( 1.0 ), "Skew of account activity, account n is picked with a weight of 1 / n^exponent")
+            ("gen-seed", bpo::value< uint64_t >()->default_value( 1 ), "Seed of the random generator, the same seed and options produce the same chain")
+            ("gen-genesis-key", bpo::value< string >(), "WIF private key of the genesis account and witness, defaults to the test genesis key in test mode builds")
+            ("gen-sign-transactions", bpo::bool_switch()->default_value( false ), "Sign every transaction with the cached key of its account")
+            ("gen-full-validation", bpo::bool_switch()->default_value( false ), "Apply the generated blocks with full validation instead of the reindex skip flags")
+            ;
+      }
+
+      virtual void plugin_initialize( const appbase::variables_map& options ) override
+      {
+         FC_ASSERT( options.count( "gen-output" ), "--gen-output is required" );
+
+         _output_dir = options.at( "gen-output" ).as< bfs::path >();
+         _block_count = options.at( "gen-blocks" ).as< uint32_t >();
+         _account_count = options.at( "gen-accounts" ).as< uint32_t >();
+         _sign_transactions = options.at( "gen-sign-transactions" ).as< bool >();
+         _full_validation = options.at( "gen-full-validation" ).as< bool >();
+
+         FC_ASSERT( _account_count >= 2, "--gen-accounts must be at least 2" );
+         FC_ASSERT( !bfs::exists( _output_dir / "block_log" ), "${d} already contains a block_log", ("d", _output_dir.string()) );
+#ifdef IS_TEST_MODE
+         FC_ASSERT( _block_count < TEST_MODE_BLOCK_LIMIT, "Test mode builds cannot produce more than ${n} blocks", ("n", TEST_MODE_BLOCK_LIMIT) );
+#endif
+
+         if( options.count( "gen-genesis-key" ) )
+         {
+            _genesis_key = zattera::utilities::wif_to_key( options.at( "gen-genesis-key" ).as< string >() );
+            FC_ASSERT( _genesis_key.valid(), "--gen-genesis-key is not a valid WIF key" );
+         }
+#ifdef IS_TEST_MODE
+         else
+         {
+            _genesis_key = ZATTERA_GENESIS_PRIVATE_KEY;
+         }
+#endif
+         FC_ASSERT( _genesis_key.valid() || !( _sign_transactions || _full_validation ),
+            "Signing needs --gen-genesis-key, the genesis account funds the generated accounts" );
+         FC_ASSERT( _sign_transactions || !_full_validation, "--gen-full-validation needs --gen-sign-transactions" );
+
+         _skip = database::skip_block_log | database::skip_fork_db;
+         if( !_full_validation )
+         {
+            _skip |= database::skip_witness_signature
+                   | database::skip_transaction_signatures
+                   | database::skip_transaction_dupe_check
+                   | database::skip_tapos_check
+                   | database::skip_merkle_check
+                   | database::skip_witness_schedule_check
+                   | database::skip_authority_check
+                   | database::skip_validate
+                   | database::skip_validate_invariants;
+         }
+
+         _rng.seed( options.at( "gen-seed" ).as< uint64_t >() );
+
+         vector< double > account_weights( _account_count );
+         double exponent = options.at( "gen-zipf-exponent" ).as< double >();
+         for( uint32_t i = 0; i < _account_count; ++i )
+            account_weights[i] = 1.0 / std::pow( double( i + 1 ), exponent );
+         _account_dist = std::discrete_distribution< uint32_t >( account_weights.begin(), account_weights.end() );
+
+         auto op_weights = detail::parse_operation_mix( options.at( "gen-operation-mix" ).as< string >() );
+         _operation_dist = std::discrete_distribution< int >( op_weights.begin(), op_weights.end() );
+
+         double transactions_per_block = options.at( "gen-transactions-per-block" ).as< double >();
+         FC_ASSERT( transactions_per_block > 0, "--gen-transactions-per-block must be positive" );
+         _transaction_count_dist = std::poisson_distribution< uint32_t >( transactions_per_block );
+
+         auto& chain = appbase::app().get_plugin< zattera::plugins::chain::chain_plugin >();
+         wipe_data_dir( chain.state_storage_dir() );
+      }
+
+      virtual void plugin_startup() override
+      {
+         appbase::app().get_io_service().post( [this]()
+         {
+            try
+            {
+               run();
+            }
+            catch( const fc::exception& e )
+            {
+               elog( "chain_gen failed: ${e}", ("e", e.to_detail_string()) );
+               on_failure();
+            }
+            catch( const std::exception& e )
+            {
+               elog( "chain_gen failed: ${e}", ("e", e.what()) );
+               on_failure();
+            }
+            appbase::app().quit();
+         } );
+      }
+
+      virtual void plugin_shutdown() override {}
+
+   private:
+      struct generated_comment
+      {
+         uint32_t                      author = 0;
+         string                        permlink;
+         uint16_t                      depth = 0;
+         fc::time_point_sec            created;
+         std::unordered_set< uint32_t > voters;
+      };
+
+      static uint64_t now_us()
+      {
+         return std::chrono::duration_cast< std::chrono::microseconds >(
+            std::chrono::steady_clock::now().time_since_epoch() ).count();
+      }
+
+      /// The chain always starts from genesis, so the state and block_log of a previous run are removed
+      void wipe_data_dir( const bfs::path& shared_mem_dir )
+      {
+         bfs::path block_dir = appbase::app().data_dir() / "blockchain";
+
+         bfs::remove( shared_mem_dir / "shared_memory.bin" );
+         bfs::remove( shared_mem_dir / "shared_memory.meta" );
+         bfs::remove( shared_mem_dir / "comment_content.log" );
+         bfs::remove( block_dir / "block_log" );
+         bfs::remove( block_dir / "block_log.index" );
+      }
+
+      database& db()
+      {
+         return appbase::app().get_plugin< zattera::plugins::chain::chain_plugin >().db();
+      }
+
+      uint32_t pick_account()
+      {
+         return _account_dist( _rng );
+      }
+
+      /// Recent comments are far more likely to be voted on and replied to
+      generated_comment& pick_comment()
+      {
+         std::geometric_distribution< size_t > age( 0.01 );
+         size_t back = std::min( age( _rng ), _comments.size() - 1 );
+         return _comments[ _comments.size() - 1 - back ];
+      }
+
+      void cache_account_keys()
+      {
+         _account_names.reserve( _account_count );
+         _account_keys.reserve( _account_count );
+         for( uint32_t i = 0; i < _account_count; ++i )
+         {
+            _account_names.push_back( "gen" + std::to_string( i ) );
+            _account_keys.push_back( fc::ecc::private_key::regenerate( fc::sha256::hash( "chain_gen " + _account_names.back() ) ) );
+         }
+      }
+
+      signed_transaction make_transaction( operation&& op, const fc::ecc::private_key& key, fc::time_point_sec when )
+      {
+         signed_transaction trx;
+         trx.operations.push_back( std::move( op ) );
+         trx.set_reference_block( db().head_block_id() );
+         trx.set_expiration( when + fc::seconds( 60 ) );
+         if( _sign_transactions )
+            trx.sign( key, db().get_chain_id() );
+         return trx;
+      }
+
+      /**
+       * Applies a block holding the given transactions in the next slot and appends it to the output block_log.
+       */
+      void push_generated_block( vector< signed_transaction >&& transactions )
+      {
+         auto& d = db();
+
+         signed_block block;
+         block.previous = d.head_block_id();
+         block.timestamp = d.get_slot_time( 1 );
+         block.witness = d.get_scheduled_witness( 1 );
+         block.transactions = std::move( transactions );
+         block.transaction_merkle_root = block.calculate_merkle_root();
+         if( _genesis_key.valid() && block.witness == ZATTERA_GENESIS_WITNESS_NAME )
+            block.sign( *_genesis_key );
+
+         prepared_block prepared( std::move( block ) );
+         d.with_write_lock( [&]()
+         {
+            d.push_block( prepared, _skip );
+         });
+         _output.append( prepared );
+
+         _transactions += prepared.block().transactions.size();
+      }
+
+      /// Leaves room for the block header and the transaction count
+      size_t block_size_budget()
+      {
+         return std::min< size_t >( db().get_dynamic_global_properties().maximum_block_size, ZATTERA_SOFT_MAX_BLOCK_SIZE ) - 1024;
+      }
+
+      /**
+       * Creates the accounts and gives each one a share of the genesis supply, half of it liquid for transfers and a
+       * quarter as vesting shares for voting. Account creation, funding and vesting go in one transaction per account.
+       */
+      void create_accounts()
+      {
+         auto& d = db();
+         const auto& genesis = d.get_account( ZATTERA_GENESIS_WITNESS_NAME );
+         asset fee = d.get_witness_schedule_object().median_props.account_creation_fee;
+
+         int64_t supply = genesis.liquid_balance.amount.value - fee.amount.value * _account_count;
+         asset liquid_share( supply / 2 / _account_count, LIQUID_SYMBOL );
+         asset vesting_share( supply / 4 / _account_count, LIQUID_SYMBOL );
+         FC_ASSERT( liquid_share.amount > 0 && vesting_share.amount > 0,
+            "The genesis account cannot fund ${n} accounts, chain_gen needs a test mode build", ("n", _account_count) );
+
+         vector< signed_transaction > transactions;
+         size_t block_size = 0;
+         for( uint32_t i = 0; i < _account_count; ++i )
+         {
+            fc::time_point_sec when = d.get_slot_time( 1 );
+            public_key_type key = _account_keys[i].get_public_key();
+
+            account_create_operation create;
+            create.fee = fee;
+            create.creator = ZATTERA_GENESIS_WITNESS_NAME;
+            create.new_account_name = _account_names[i];
+            create.owner = authority( 1, key, 1 );
+            create.active = create.owner;
+            create.posting = create.owner;
+            create.memo_key = key;
+
+            transfer_operation transfer;
+            transfer.from = ZATTERA_GENESIS_WITNESS_NAME;
+            transfer.to = _account_names[i];
+            transfer.amount = liquid_share;
+
+            transfer_to_vesting_operation vest;
+            vest.from = ZATTERA_GENESIS_WITNESS_NAME;
+            vest.to = _account_names[i];
+            vest.amount = vesting_share;
+
+            signed_transaction trx;
+            trx.operations = { create, transfer, vest };
+            trx.set_reference_block( d.head_block_id() );
+            trx.set_expiration( when + fc::seconds( 60 ) );
+            if( _sign_transactions )
+               trx.sign( *_genesis_key, d.get_chain_id() );
+
+            block_size += fc::raw::pack_size( trx );
+            transactions.push_back( std::move( trx ) );
+            if( block_size >= block_size_budget() / 2 )
+            {
+               push_generated_block( std::move( transactions ) );
+               transactions.clear();
+               block_size = 0;
+            }
+         }
+
+         if( transactions.size() )
+            push_generated_block( std::move( transactions ) );
+      }
+
+      bool generate_transfer_operation( operation& op, uint32_t& signer )
+      {
+         uint32_t from = pick_account();
+         uint32_t to = pick_account();
+         if( from == to )
+            to = ( to + 1 ) % _account_count;
+
+         // Spending of earlier transfers in the same block is not visible in the state yet
+         int64_t available = db().get_account( _account_names[ from ] ).liquid_balance.amount.value - _spent[ from ];
+         std::lognormal_distribution< double > amount_dist( 7.0, 2.0 );
+         int64_t amount = std::min( std::max( int64_t( amount_dist( _rng ) ), int64_t( 1 ) ), available / 10 );
+         if( amount <= 0 )
+            return false;
+
+         _spent[ from ] += amount;
+
+         transfer_operation transfer;
+         transfer.from = _account_names[ from ];
+         transfer.to = _account_names[ to ];
+         transfer.amount = asset( amount, LIQUID_SYMBOL );
+         // The sequence number keeps otherwise identical transfers from having the same transaction id
+         transfer.memo = "chain_gen " + std::to_string( _sequence++ );
+         op = std::move( transfer );
+         signer = from;
+         return true;
+      }
+
+      bool generate_vote_operation( operation& op, uint32_t& signer )
+      {
+         if( _comments.empty() )
+            return false;
+
+         uint32_t voter = pick_account();
+         generated_comment& comment = pick_comment();
+         if( !_voted_this_block.insert( voter ).second )
+            return false;
+         if( comment.voters.count( voter ) )
+            return false;
+
+         const auto& account = db().get_account( _account_names[ voter ] );
+         int64_t elapsed_seconds = ( db().head_block_time() - account.last_vote_time ).to_seconds();
+         int64_t regenerated_power = ( ZATTERA_100_PERCENT * elapsed_seconds ) / ZATTERA_VOTE_REGENERATION_SECONDS;
+         int64_t current_power = std::min( int64_t( account.voting_power + regenerated_power ), int64_t( ZATTERA_100_PERCENT ) );
+         // Heavy voters wait for their voting power to regenerate, as they would on the live chain
+         if( current_power < ZATTERA_100_PERCENT / 10 )
+            return false;
+
+         comment.voters.insert( voter );
+
+         std::uniform_int_distribution< int > percent( 1, 100 );
+         int roll = percent( _rng );
+         vote_operation vote;
+         vote.voter = _account_names[ voter ];
+         vote.author = _account_names[ comment.author ];
+         vote.permlink = comment.permlink;
+         if( roll <= 80 )
+            vote.weight = ZATTERA_100_PERCENT;
+         else if( roll <= 97 )
+            vote.weight = int16_t( ZATTERA_1_PERCENT * percent( _rng ) );
+         else
+            vote.weight = -ZATTERA_100_PERCENT;
+         op = std::move( vote );
+         signer = voter;
+         return true;
+      }
+
+      bool generate_comment_operation( operation& op, uint32_t& signer )
+      {
+         uint32_t author = pick_account();
+         if( !_posted_this_block.insert( author ).second )
+            return false;
+
+         const auto& account = db().get_account( _account_names[ author ] );
+         auto now = db().head_block_time();
+
+         std::bernoulli_distribution root_post( 0.2 );
+         const generated_comment* parent = nullptr;
+         if( !_comments.empty() && !root_post( _rng ) )
+         {
+            parent = &pick_comment();
+            if( parent->depth >= detail::max_reply_depth || ( now - account.last_post ) < ZATTERA_MIN_REPLY_INTERVAL )
+               return false;
+         }
+         else if( ( now - account.last_root_post ) <= ZATTERA_MIN_ROOT_COMMENT_INTERVAL )
+         {
+            return false;
+         }
+
+         std::lognormal_distribution< double > body_size( 6.5, 1.0 );
+         size_t size = std::min( std::max( size_t( body_size( _rng ) ), size_t( 1 ) ), _body_text.size() );
+         std::uniform_int_distribution< size_t > category( 0, sizeof( detail::categories ) / sizeof( detail::categories[0] ) - 1 );
+
+         comment_operation comment;
+         comment.author = _account_names[ author ];
+         comment.permlink = "p" + std::to_string( _sequence++ );
+         comment.body = _body_text.substr( 0, size );
+         if( parent )
+         {
+            comment.parent_author = _account_names[ parent->author ];
+            comment.parent_permlink = parent->permlink;
+         }
+         else
+         {
+            string tag = detail::categories[ category( _rng ) ];
+            comment.parent_permlink = tag;
+            comment.title = "Generated post " + comment.permlink;
+            comment.json_metadata = "{\"tags\":[\"" + tag + "\"],\"app\":\"chain_gen\"}";
+         }
+
+         generated_comment generated;
+         generated.author = author;
+         generated.permlink = comment.permlink;
+         generated.depth = parent ? parent->depth + 1 : 0;
+         generated.created = now;
+         _comments.push_back( std::move( generated ) );
+
+         op = std::move( comment );
+         signer = author;
+         return true;
+      }
+
+      bool generate_custom_json_operation( operation& op, uint32_t& signer )
+      {
+         uint32_t account = pick_account();
+         uint32_t target = pick_account();
+         std::uniform_int_distribution< size_t > action( 0, sizeof( detail::custom_json_actions ) / sizeof( detail::custom_json_actions[0] ) - 1 );
+
+         custom_json_operation custom;
+         custom.required_posting_auths.insert( _account_names[ account ] );
+         custom.id = "chain_gen";
+         custom.json = "{\"seq\":" + std::to_string( _sequence++ ) + ",\"action\":\"" + detail::custom_json_actions[ action( _rng ) ]
+                     + "\",\"target\":\"" + string( _account_names[ target ] ) + "\"}";
+         op = std::move( custom );
+         signer = account;
+         return true;
+      }
+
+      /**
+       * Fills the next block from the operation template. An operation that would fail against the current state
+       * (an author posting too soon, a voter without voting power, ...) is replaced by a new pick, up to a few times.
+       */
+      vector< signed_transaction > generate_transactions()
+      {
+         fc::time_point_sec when = db().get_slot_time( 1 );
+         fc::time_point_sec now = db().head_block_time();
+
+         // Only comments that still accept upvotes are voted on. Operations see the head block time of the previous
+         // block while the next one is applied, and a comment is created at that time as well.
+         while( !_comments.empty() && _comments.front().created + fc::seconds( ZATTERA_CASHOUT_WINDOW_SECONDS ) - ZATTERA_UPVOTE_LOCKOUT <= fc::time_point( now ) )
+            _comments.pop_front();
+         while( _comments.size() > detail::max_recent_comments )
+            _comments.pop_front();
+
+         _spent.clear();
+         _voted_this_block.clear();
+         _posted_this_block.clear();
+
+         vector< signed_transaction > transactions;
+         size_t budget = block_size_budget();
+         size_t block_size = 0;
+         uint32_t count = _transaction_count_dist( _rng );
+         for( uint32_t i = 0; i < count && block_size < budget; ++i )
+         {
+            operation op;
+            uint32_t signer = 0;
+            bool generated = false;
+            for( int attempt = 0; attempt < 4 && !generated; ++attempt )
+            {
+               switch( _operation_dist( _rng ) )
+               {
+                  case generate_transfer:    generated = generate_transfer_operation( op, signer ); break;
+                  case generate_vote:        generated = generate_vote_operation( op, signer ); break;
+                  case generate_comment:     generated = generate_comment_operation( op, signer ); break;
+                  case generate_custom_json: generated = generate_custom_json_operation( op, signer ); break;
+               }
+            }
+            if( !generated )
+               continue;
+
+            transactions.push_back( make_transaction( std::move( op ), _account_keys[ signer ], when ) );
+            block_size += fc::raw::pack_size( transactions.back() );
+            ++_operations;
+         }
+
+         return transactions;
+      }
+
+      /// The output dir held no block_log before this run, so a partial one is removed rather than left to be mistaken for a complete chain
+      void on_failure()
+      {
+         run_failed = true;
+         try
+         {
+            _output.close();
+            bfs::remove( _output_dir / "block_log" );
+            bfs::remove( _output_dir / "block_log.index" );
+            elog( "chain_gen: removed the incomplete block_log from ${o}", ("o", _output_dir.string()) );
+         }
+         catch( ... )
+         {
+            elog( "chain_gen: the block_log in ${o} is incomplete and could not be removed", ("o", _output_dir.string()) );
+         }
+      }
+
+      void run()
+      {
+         auto& d = db();
+         FC_ASSERT( d.head_block_num() == 0, "The scratch database is not empty" );
+
+         bfs::create_directories( _output_dir );
+         _output.open( _output_dir / "block_log" );
+
+         ilog( "chain_gen: generating ${b} blocks with ${a} accounts into ${o}",
+            ("b", _block_count)("a", _account_count)("o", _output_dir.string()) );
+
+         uint64_t begin = now_us();
+
+         cache_account_keys();
+         create_accounts();
+         uint32_t setup_blocks = d.head_block_num();
+         ilog( "chain_gen: created ${a} accounts in ${b} blocks", ("a", _account_count)("b", setup_blocks) );
+
+         while( d.head_block_num() < _block_count )
+         {
+            push_generated_block( generate_transactions() );
+
+            if( d.head_block_num() % 100000 == 0 )
+            {
+               _output.flush();
+               ilog( "chain_gen: block ${n}", ("n", d.head_block_num()) );
+            }
+         }
+
+         _output.close();
+         double elapsed = double( now_us() - begin ) / 1000000.0;
+
+         ilog( "chain_gen: ${b} blocks, ${t} transactions, ${o} generated operations in ${s} sec (${bps} blocks/sec), block_log is ${size} bytes",
+            ("b", d.head_block_num())("t", _transactions)("o", _operations)("s", elapsed)
+            ("bps", elapsed > 0 ? double( d.head_block_num() ) / elapsed : 0)
+            ("size", bfs::file_size( _output_dir / "block_log" )) );
+      }
+
+      bfs::path                                 _output_dir;
+      uint32_t                                  _block_count = 0;
+      uint32_t                                  _account_count = 0;
+      bool                                      _sign_transactions = false;
+      bool                                      _full_validation = false;
+      uint32_t                                  _skip = 0;
+      fc::optional< fc::ecc::private_key >      _genesis_key;
+
+      std::mt19937_64                           _rng;
+      std::discrete_distribution< uint32_t >    _account_dist;
+      std::discrete_distribution< int >         _operation_dist;
+      std::poisson_distribution< uint32_t >     _transaction_count_dist;
+
+      vector< account_name_type >               _account_names;
+      vector< fc::ecc::private_key >            _account_keys;
+      std::deque< generated_comment >           _comments;
+      uint64_t                                  _sequence = 0;
+      const string                              _body_text = make_body_text();
+
+      std::unordered_map< uint32_t, int64_t >   _spent;
+      std::unordered_set< uint32_t >            _voted_this_block;
+      std::unordered_set< uint32_t >            _posted_this_block;
+
+      block_log                                 _output;
+      uint64_t                                  _transactions = 0;
+      uint64_t                                  _operations = 0;
+
+      static string make_body_text()
+      {
+         static const string words = "Lorem ipsum dolor sit amet, consectetur adipiscing elit, sed do eiusmod tempor "
+            "incididunt ut labore et dolore magna aliqua. Ut enim ad minim veniam, quis nostrud exercitation ullamco "
+            "laboris nisi ut aliquip ex ea commodo consequat. ";
+         string text;
+         while( text.size() < 16 * 1024 )
+            text += words;
+         return text;
+      }
+};
+
+} } // zattera::chain_gen
+
+int main( int argc, char** argv )
+{
+   try
+   {
+      bpo::options_description options;
+      zattera::utilities::set_logging_program_options( options );
+      appbase::app().add_program_options( bpo::options_description(), options );
+
+      zattera::plugins::register_plugins();
+      appbase::app().register_plugin< zattera::chain_gen::chain_gen_plugin >();
+
+      appbase::app().set_version_string( "zattera_git_revision: " + fc::string( zattera::utilities::git_revision_sha ) + "\n" );
+      appbase::app().set_app_name( "chain_gen" );
+
+      bool initialized = appbase::app().initialize<
+            zattera::plugins::chain::chain_plugin,
+            zattera::chain_gen::chain_gen_plugin >
+            ( argc, argv );
+
+      if( !initialized )
+         return 0;
+
+      try
+      {
+         fc::optional< fc::logging_config > logging_config = zattera::utilities::load_logging_config( appbase::app().get_args(), appbase::app().data_dir() );
+         if( logging_config )
+            fc::configure_logging( *logging_config );
+      }
+      catch( const fc::exception& e )
+      {
+         wlog( "Error parsing logging config. ${e}", ("e", e.to_string()) );
+      }
+
+      appbase::app().startup();
+      appbase::app().exec();
+      return zattera::chain_gen::run_failed ? 1 : 0;
+   }
+   catch ( const boost::exception& e )
+   {
+      std::cerr << boost::diagnostic_information(e) << "\n";
+   }
+   catch ( const fc::exception& e )
+   {
+      std::cerr << e.to_detail_string() << "\n";
+   }
+   catch ( const std::exception& e )
+   {
+      std::cerr << e.what() << "\n";
+   }
+   catch ( ... )
+   {
+      std::cerr << "unknown exception\n";
+   }
+
+   return -1;
+}
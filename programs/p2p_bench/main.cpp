@@ -0,0 +1,278 @@
+/*
+ * p2p_bench - measures how many transactions a single p2p node can take in from a large number of
+ * peers.  A hub node and the simulated peers all run in this process and talk over 127.0.0.1, every
+ * node has an empty chain, so the numbers only cover the networking code: inventory bookkeeping,
+ * fetching, and re-advertising each transaction to the other peers.
+ *
+ * Run:
+ *    p2p_bench [--peers 200] [--transactions-per-second 2000] [--duration 30] [--redundancy 4]
+ */
+
+#include <graphene/net/config.hpp>
+#include <graphene/net/core_messages.hpp>
+#include <graphene/net/node.hpp>
+
+#include <zattera/protocol/transaction.hpp>
+
+#include <fc/exception/exception.hpp>
+#include <fc/filesystem.hpp>
+#include <fc/io/json.hpp>
+#include <fc/network/ip.hpp>
+#include <fc/reflect/variant.hpp>
+#include <fc/thread/thread.hpp>
+#include <fc/variant_object.hpp>
+
+#include <boost/program_options.hpp>
+
+#include <atomic>
+#include <ctime>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <unordered_set>
+#include <vector>
+
+namespace bpo = boost::program_options;
+
+using std::string;
+using std::vector;
+
+namespace zattera { namespace p2p_bench {
+
+using graphene::net::item_hash_t;
+using graphene::net::item_id;
+
+struct bench_report
+{
+   uint32_t peers = 0;
+   uint32_t peers_connected = 0;
+   uint32_t redundancy = 0;
+   uint32_t duration_seconds = 0;
+   uint64_t transactions_broadcast = 0;
+   uint64_t transactions_received = 0;
+   double   transactions_per_second = 0;
+   double   cpu_us_per_transaction = 0;
+};
+
+/**
+ * Just enough of a blockchain for a node to connect and exchange transactions: every node is at the
+ * genesis of the same empty chain.  Simulated peers claim to have every item so they never fetch the
+ * transactions the hub re-advertises to them, the hub counts each transaction handed to it.
+ */
+class bench_delegate : public graphene::net::node_delegate
+{
+   public:
+      explicit bench_delegate( bool has_everything ) : _has_everything( has_everything ) {}
+
+      zattera::protocol::chain_id_type get_chain_id() const override { return zattera::protocol::chain_id_type(); }
+
+      bool has_item( const item_id& id ) override
+      {
+         if( _has_everything )
+            return true;
+         std::lock_guard< std::mutex > guard( _mutex );
+         return _received.find( id.item_hash ) != _received.end();
+      }
+
+      bool handle_block( const graphene::net::block_message&, bool, std::vector< fc::uint160_t >& ) override { return false; }
+
+      void handle_transaction( const graphene::net::trx_message& trx_msg ) override
+      {
+         std::lock_guard< std::mutex > guard( _mutex );
+         if( _received.insert( graphene::net::message( trx_msg ).id() ).second )
+            ++received_count;
+      }
+
+      void handle_message( const graphene::net::message& ) override {}
+
+      std::vector< item_hash_t > get_block_ids( const std::vector< item_hash_t >&, uint32_t& remaining_item_count, uint32_t ) override
+      {
+         remaining_item_count = 0;
+         return std::vector< item_hash_t >();
+      }
+
+      graphene::net::message get_item( const item_id& id ) override
+      {
+         FC_THROW_EXCEPTION( fc::key_not_found_exception, "item ${id} is not available", ("id", id) );
+      }
+
+      std::vector< item_hash_t > get_blockchain_synopsis( const item_hash_t&, uint32_t ) override { return std::vector< item_hash_t >(); }
+
+      void sync_status( uint32_t, uint32_t ) override {}
+      void connection_count_changed( uint32_t ) override {}
+      uint32_t get_block_number( const item_hash_t& ) override { return 0; }
+      fc::time_point_sec get_block_time( const item_hash_t& ) override { return fc::time_point_sec::min(); }
+      fc::time_point_sec get_blockchain_now() override { return fc::time_point::now(); }
+      item_hash_t get_head_block_id() const override { return item_hash_t(); }
+      uint32_t estimate_last_known_fork_from_git_revision_timestamp( uint32_t ) const override { return 0; }
+      void error_encountered( const std::string&, const fc::oexception& ) override {}
+
+      std::atomic< uint64_t > received_count{ 0 };
+
+   private:
+      bool                                 _has_everything;
+      std::mutex                           _mutex;
+      std::unordered_set< fc::uint160_t >  _received;
+};
+
+struct bench_node
+{
+   bench_node( const string& name, const fc::path& config_dir, bool has_everything ) :
+      delegate( has_everything ),
+      node( std::make_shared< graphene::net::node >( name ) )
+   {
+      node->load_configuration( config_dir );
+      node->set_node_delegate( &delegate );
+   }
+
+   void start( const fc::mutable_variant_object& parameters )
+   {
+      node->set_advanced_node_parameters( parameters );
+      node->listen_to_p2p_network();
+      node->connect_to_p2p_network();
+      node->sync_from( item_id( graphene::net::block_message_type, item_hash_t() ), std::vector< uint32_t >() );
+   }
+
+   bench_delegate                         delegate;
+   std::shared_ptr< graphene::net::node > node;
+};
+
+/** a transaction that is unique for each counter value, nothing checks that it is valid */
+zattera::protocol::signed_transaction make_transaction( uint64_t counter, fc::time_point_sec expiration )
+{
+   zattera::protocol::signed_transaction trx;
+   trx.ref_block_num = uint16_t( counter );
+   trx.ref_block_prefix = uint32_t( counter >> 16 );
+   trx.expiration = expiration;
+   return trx;
+}
+
+bench_report run( uint32_t peer_count, uint32_t transactions_per_second, uint32_t duration_seconds, uint32_t redundancy )
+{
+   fc::temp_directory data_dir;
+   bench_report report;
+   report.peers = peer_count;
+   report.redundancy = redundancy;
+   report.duration_seconds = duration_seconds;
+
+   bench_node hub( "p2p_bench hub", data_dir.path() / "hub", false );
+   hub.node->listen_on_endpoint( fc::ip::endpoint( fc::ip::address( "127.0.0.1" ), 0 ), false );
+   hub.start( fc::mutable_variant_object()
+      ( "desired_number_of_connections", 0 )
+      ( "maximum_number_of_connections", peer_count + GRAPHENE_NET_DEFAULT_DESIRED_CONNECTIONS )
+      ( "peer_advertising_disabled", true ) );
+   fc::ip::endpoint hub_endpoint = hub.node->get_actual_listening_endpoint();
+   ilog( "hub listening at ${ep}, starting ${n} peers", ("ep", hub_endpoint)("n", peer_count) );
+
+   // the peers only ever talk to the hub
+   vector< std::unique_ptr< bench_node > > peers;
+   for( uint32_t i = 0; i < peer_count; ++i )
+   {
+      peers.emplace_back( new bench_node( "p2p_bench peer", data_dir.path() / ( "peer" + std::to_string( i ) ), true ) );
+      peers.back()->start( fc::mutable_variant_object()
+         ( "accept_incoming_connections", false )
+         ( "desired_number_of_connections", 1 )
+         ( "maximum_number_of_connections", 1 ) );
+      peers.back()->node->connect_to_endpoint( hub_endpoint );
+   }
+
+   fc::time_point connect_deadline = fc::time_point::now() + fc::seconds( 60 );
+   while( hub.node->get_connection_count() < peer_count && fc::time_point::now() < connect_deadline )
+      fc::usleep( fc::milliseconds( 100 ) );
+   report.peers_connected = hub.node->get_connection_count();
+   ilog( "${n} peers connected, broadcasting for ${s} seconds", ("n", report.peers_connected)("s", duration_seconds) );
+
+   const fc::microseconds tick = fc::milliseconds( 10 );
+   const uint64_t transactions_to_broadcast = uint64_t( transactions_per_second ) * duration_seconds;
+   fc::time_point_sec expiration = fc::time_point::now() + fc::hours( 1 );
+   uint64_t received_before = hub.delegate.received_count;
+   std::clock_t cpu_start = std::clock();
+   fc::time_point start = fc::time_point::now();
+
+   // each transaction is broadcast by `redundancy` consecutive peers, so the hub hears about most
+   // items from several peers like it would on a real network
+   size_t next_peer = 0;
+   fc::time_point next_tick = start;
+   while( report.transactions_broadcast < transactions_to_broadcast )
+   {
+      next_tick += tick;
+      uint64_t due = std::min< uint64_t >( transactions_to_broadcast,
+         uint64_t( ( next_tick - start ).count() ) * transactions_per_second / 1000000 );
+      for( ; report.transactions_broadcast < due; ++report.transactions_broadcast )
+      {
+         graphene::net::trx_message msg( make_transaction( report.transactions_broadcast, expiration ) );
+         for( uint32_t r = 0; r < redundancy; ++r )
+            peers[ ( next_peer + r ) % peers.size() ]->node->broadcast( msg );
+         next_peer = ( next_peer + 1 ) % peers.size();
+      }
+      fc::time_point now = fc::time_point::now();
+      if( now < next_tick )
+         fc::usleep( next_tick - now );
+   }
+
+   // give the hub a moment to fetch what's still outstanding
+   fc::time_point drain_deadline = fc::time_point::now() + fc::seconds( 10 );
+   while( hub.delegate.received_count - received_before < report.transactions_broadcast && fc::time_point::now() < drain_deadline )
+      fc::usleep( fc::milliseconds( 100 ) );
+
+   fc::microseconds elapsed = fc::time_point::now() - start;
+   double cpu_us = double( std::clock() - cpu_start ) * 1000000 / CLOCKS_PER_SEC;
+   report.transactions_received = hub.delegate.received_count - received_before;
+   report.transactions_per_second = report.transactions_received * 1000000.0 / std::max< int64_t >( elapsed.count(), 1 );
+   if( report.transactions_received )
+      report.cpu_us_per_transaction = cpu_us / report.transactions_received;
+
+   for( auto& peer : peers )
+      peer->node->close();
+   hub.node->close();
+   return report;
+}
+
+} } // zattera::p2p_bench
+
+FC_REFLECT( zattera::p2p_bench::bench_report,
+   (peers)(peers_connected)(redundancy)(duration_seconds)
+   (transactions_broadcast)(transactions_received)(transactions_per_second)(cpu_us_per_transaction) )
+
+int main( int argc, char** argv )
+{
+   try
+   {
+      bpo::options_description options( "p2p_bench options" );
+      options.add_options()
+         ( "help,h", "Print this help message and exit." )
+         ( "peers", bpo::value< uint32_t >()->default_value( GRAPHENE_NET_DEFAULT_MAX_CONNECTIONS ), "Number of simulated peers connected to the node under test" )
+         ( "transactions-per-second", bpo::value< uint32_t >()->default_value( 2000 ), "Unique transactions the peers broadcast per second" )
+         ( "duration", bpo::value< uint32_t >()->default_value( 30 ), "Seconds to broadcast for" )
+         ( "redundancy", bpo::value< uint32_t >()->default_value( 4 ), "Number of peers that broadcast each transaction" )
+         ;
+
+      bpo::variables_map args;
+      bpo::store( bpo::parse_command_line( argc, argv, options ), args );
+      bpo::notify( args );
+      if( args.count( "help" ) )
+      {
+         std::cout << options << "\n";
+         return 0;
+      }
+
+      uint32_t peers = args.at( "peers" ).as< uint32_t >();
+      uint32_t redundancy = args.at( "redundancy" ).as< uint32_t >();
+      FC_ASSERT( peers > 0, "--peers must be at least 1" );
+      FC_ASSERT( redundancy > 0 && redundancy <= peers, "--redundancy must be between 1 and --peers" );
+
+      auto report = zattera::p2p_bench::run( peers, args.at( "transactions-per-second" ).as< uint32_t >(),
+                                             args.at( "duration" ).as< uint32_t >(), redundancy );
+      std::cout << fc::json::to_pretty_string( report ) << "\n";
+      return 0;
+   }
+   catch( const fc::exception& e )
+   {
+      std::cerr << e.to_detail_string() << "\n";
+   }
+   catch( const std::exception& e )
+   {
+      std::cerr << e.what() << "\n";
+   }
+   return 1;
+}
@@ -17,6 +17,8 @@
 
 #include <fc/macros.hpp>
 
+#include <limits>
+
 namespace fc {
 
 struct aes_encoder::impl 
@@ -169,6 +171,155 @@ uint32_t aes_decoder::final_decode( char* plaintext )
 
 
 
+namespace detail {
+
+   struct aes_gcm_state
+   {
+      evp_cipher_ctx ctx;
+      uint32_t       nonce_prefix = 0;
+      uint64_t       counter = 0;
+
+      void init( const fc::sha256& key, uint32_t prefix, bool encrypt )
+      {
+         ctx.obj = EVP_CIPHER_CTX_new();
+         if( !ctx )
+            FC_THROW_EXCEPTION( aes_exception, "error allocating evp cipher context",
+                                ("s", ERR_error_string( ERR_get_error(), nullptr) ) );
+
+         int ok = encrypt ? EVP_EncryptInit_ex( ctx, EVP_aes_256_gcm(), NULL, (const unsigned char*)&key, NULL )
+                          : EVP_DecryptInit_ex( ctx, EVP_aes_256_gcm(), NULL, (const unsigned char*)&key, NULL );
+         if( 1 != ok )
+            FC_THROW_EXCEPTION( aes_exception, "error during aes 256 gcm init",
+                                ("s", ERR_error_string( ERR_get_error(), nullptr) ) );
+
+         nonce_prefix = prefix;
+         counter = 0;
+      }
+
+      /** sets the nonce of the next message, big endian prefix followed by the big endian counter */
+      void next_nonce( bool encrypt )
+      {
+         FC_ASSERT( ctx, "aes gcm is not initialized" );
+         FC_ASSERT( counter != std::numeric_limits< uint64_t >::max(), "aes gcm nonces exhausted" );
+
+         unsigned char nonce[12];
+         for( int i = 0; i < 4; ++i )
+            nonce[i] = uint8_t( nonce_prefix >> ( 8 * ( 3 - i ) ) );
+         for( int i = 0; i < 8; ++i )
+            nonce[4 + i] = uint8_t( counter >> ( 8 * ( 7 - i ) ) );
+         ++counter;
+
+         int ok = encrypt ? EVP_EncryptInit_ex( ctx, NULL, NULL, NULL, nonce )
+                          : EVP_DecryptInit_ex( ctx, NULL, NULL, NULL, nonce );
+         if( 1 != ok )
+            FC_THROW_EXCEPTION( aes_exception, "error setting aes 256 gcm nonce",
+                                ("s", ERR_error_string( ERR_get_error(), nullptr) ) );
+      }
+   };
+
+} // detail
+
+struct aes_gcm_encoder::impl : public detail::aes_gcm_state {};
+
+aes_gcm_encoder::aes_gcm_encoder()
+{
+   static int init = init_openssl();
+   FC_UNUSED(init);
+}
+
+aes_gcm_encoder::~aes_gcm_encoder()
+{
+}
+
+void aes_gcm_encoder::init( const fc::sha256& key, uint32_t nonce_prefix )
+{
+   my->init( key, nonce_prefix, true );
+}
+
+void aes_gcm_encoder::begin( const char* aad, size_t aad_len )
+{
+   my->next_nonce( true );
+
+   int len = 0;
+   if( aad_len && 1 != EVP_EncryptUpdate( my->ctx, NULL, &len, (const unsigned char*)aad, aad_len ) )
+      FC_THROW_EXCEPTION( aes_exception, "error during aes 256 gcm encryption of aad",
+                          ("s", ERR_error_string( ERR_get_error(), nullptr) ) );
+}
+
+void aes_gcm_encoder::update( const char* plaintxt, size_t plaintext_len, char* ciphertxt )
+{
+   if( plaintext_len == 0 )
+      return;
+
+   int ciphertext_len = 0;
+   if( 1 != EVP_EncryptUpdate( my->ctx, (unsigned char*)ciphertxt, &ciphertext_len, (const unsigned char*)plaintxt, plaintext_len ) )
+      FC_THROW_EXCEPTION( aes_exception, "error during aes 256 gcm encryption update",
+                          ("s", ERR_error_string( ERR_get_error(), nullptr) ) );
+   FC_ASSERT( static_cast<size_t>(ciphertext_len) == plaintext_len, "",
+      ("ciphertext_len",ciphertext_len)("plaintext_len",plaintext_len) );
+}
+
+void aes_gcm_encoder::finish( char* tag )
+{
+   int len = 0;
+   unsigned char unused[16];
+   if( 1 != EVP_EncryptFinal_ex( my->ctx, unused, &len ) ||
+       1 != EVP_CIPHER_CTX_ctrl( my->ctx, EVP_CTRL_GCM_GET_TAG, tag_size, tag ) )
+      FC_THROW_EXCEPTION( aes_exception, "error during aes 256 gcm encryption final",
+                          ("s", ERR_error_string( ERR_get_error(), nullptr) ) );
+}
+
+struct aes_gcm_decoder::impl : public detail::aes_gcm_state {};
+
+aes_gcm_decoder::aes_gcm_decoder()
+{
+   static int init = init_openssl();
+   FC_UNUSED(init);
+}
+
+aes_gcm_decoder::~aes_gcm_decoder()
+{
+}
+
+void aes_gcm_decoder::init( const fc::sha256& key, uint32_t nonce_prefix )
+{
+   my->init( key, nonce_prefix, false );
+}
+
+void aes_gcm_decoder::begin( const char* aad, size_t aad_len )
+{
+   my->next_nonce( false );
+
+   int len = 0;
+   if( aad_len && 1 != EVP_DecryptUpdate( my->ctx, NULL, &len, (const unsigned char*)aad, aad_len ) )
+      FC_THROW_EXCEPTION( aes_exception, "error during aes 256 gcm decryption of aad",
+                          ("s", ERR_error_string( ERR_get_error(), nullptr) ) );
+}
+
+void aes_gcm_decoder::update( const char* ciphertxt, size_t ciphertxt_len, char* plaintext )
+{
+   if( ciphertxt_len == 0 )
+      return;
+
+   int plaintext_len = 0;
+   if( 1 != EVP_DecryptUpdate( my->ctx, (unsigned char*)plaintext, &plaintext_len, (const unsigned char*)ciphertxt, ciphertxt_len ) )
+      FC_THROW_EXCEPTION( aes_exception, "error during aes 256 gcm decryption update",
+                          ("s", ERR_error_string( ERR_get_error(), nullptr) ) );
+   FC_ASSERT( ciphertxt_len == static_cast<size_t>(plaintext_len), "",
+      ("ciphertxt_len",ciphertxt_len)("plaintext_len",plaintext_len) );
+}
+
+bool aes_gcm_decoder::finish( const char* tag )
+{
+   if( 1 != EVP_CIPHER_CTX_ctrl( my->ctx, EVP_CTRL_GCM_SET_TAG, tag_size, const_cast<char*>(tag) ) )
+      FC_THROW_EXCEPTION( aes_exception, "error setting aes 256 gcm tag",
+                          ("s", ERR_error_string( ERR_get_error(), nullptr) ) );
+
+   int len = 0;
+   unsigned char unused[16];
+   return 1 == EVP_DecryptFinal_ex( my->ctx, unused, &len );
+}
+
 /** example method from wiki.opensslfoundation.com */
 unsigned aes_encrypt(unsigned char *plaintext, int plaintext_len, unsigned char *key,
                      unsigned char *iv, unsigned char *ciphertext)
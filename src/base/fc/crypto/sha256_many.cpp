@@ -0,0 +1,448 @@
+#include <fc/crypto/sha256.hpp>
+#include <fc/exception/exception.hpp>
+
+#include <algorithm>
+#include <string.h>
+
+#if defined( __x86_64__ ) && ( defined( __GNUC__ ) || defined( __clang__ ) )
+#define FC_SHA256_X86 1
+#include <cpuid.h>
+#include <immintrin.h>
+#endif
+
+namespace fc {
+
+namespace {
+
+   const uint32_t initial_state[8] = {
+      0x6a09e667, 0xbb67ae85, 0x3c6ef372, 0xa54ff53a, 0x510e527f, 0x9b05688c, 0x1f83d9ab, 0x5be0cd19
+   };
+
+   const uint32_t round_constants[64] = {
+      0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5, 0x3956c25b, 0x59f111f1, 0x923f82a4, 0xab1c5ed5,
+      0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3, 0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174,
+      0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc, 0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+      0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7, 0xc6e00bf3, 0xd5a79147, 0x06ca6351, 0x14292967,
+      0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13, 0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85,
+      0xa2bfe8a1, 0xa81a664b, 0xc24b8b70, 0xc76c51a3, 0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+      0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5, 0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f, 0x682e6ff3,
+      0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208, 0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2
+   };
+
+   inline void store_be32( char* p, uint32_t v )
+   {
+      uint8_t* b = (uint8_t*)p;
+      b[0] = uint8_t( v >> 24 );
+      b[1] = uint8_t( v >> 16 );
+      b[2] = uint8_t( v >> 8 );
+      b[3] = uint8_t( v );
+   }
+
+   /**
+    *  Every input of a hash_many call has the same size, so all of them consist of the same number
+    *  of 64 byte blocks: the full blocks of the input, read in place, followed by one or two blocks
+    *  holding the remaining bytes and the padding. When the size is a multiple of 64 the padding
+    *  block is the same for every input and is built only once.
+    */
+   struct message_layout
+   {
+      explicit message_layout( uint32_t size ) :
+         size( size ),
+         full_blocks( size / 64 ),
+         rest( size % 64 ),
+         tail_blocks( rest + 9 > 64 ? 2 : 1 ) {}
+
+      uint32_t blocks()const { return full_blocks + tail_blocks; }
+      bool shared_tail()const { return rest == 0; }
+
+      /// Writes the last bytes of msg and the padding into tail, which holds 128 bytes
+      void build_tail( const char* msg, char* tail )const
+      {
+         memcpy( tail, msg + full_blocks * 64, rest );
+         tail[ rest ] = char( 0x80 );
+         char* len = tail + tail_blocks * 64 - 8;
+         memset( tail + rest + 1, 0, len - tail - rest - 1 );
+         uint64_t bits = uint64_t( size ) * 8;
+         store_be32( len, uint32_t( bits >> 32 ) );
+         store_be32( len + 4, uint32_t( bits ) );
+      }
+
+      const char* block( const char* msg, const char* tail, uint32_t b )const
+      {
+         return b < full_blocks ? msg + b * 64 : tail + ( b - full_blocks ) * 64;
+      }
+
+      uint32_t size;
+      uint32_t full_blocks;
+      uint32_t rest;
+      uint32_t tail_blocks;
+   };
+
+   void hash_many_generic( const char* data, uint32_t size, size_t count, sha256* out )
+   {
+      for( size_t i = 0; i < count; ++i )
+         out[i] = sha256::hash( data + i * size, size );
+   }
+
+#ifdef FC_SHA256_X86
+
+#define FC_SHANI __attribute__(( target( "sha,sse4.1,ssse3" ) ))
+
+   /**
+    *  Compresses one block of each of N messages with the SHA extensions, state is in the ABEF/CDGH
+    *  layout they use. A single message is bound by the latency of sha256rnds2, interleaving the
+    *  independent rounds of two messages keeps the unit busy.
+    */
+   template< int N >
+   FC_SHANI inline void shani_compress( __m128i state0[N], __m128i state1[N], const char* const blocks[N] )
+   {
+      const __m128i byte_swap = _mm_set_epi64x( 0x0c0d0e0f08090a0bULL, 0x0405060700010203ULL );
+      __m128i abef[N], cdgh[N], msg[N][4];
+
+      for( int n = 0; n < N; ++n )
+      {
+         abef[n] = state0[n];
+         cdgh[n] = state1[n];
+      }
+
+#pragma GCC unroll 16
+      for( int g = 0; g < 16; ++g )
+      {
+         const __m128i k = _mm_loadu_si128( (const __m128i*)( round_constants + g * 4 ) );
+#pragma GCC unroll 2
+         for( int n = 0; n < N; ++n )
+         {
+            __m128i& w = msg[n][ g % 4 ];
+            if( g < 4 )
+            {
+               w = _mm_shuffle_epi8( _mm_loadu_si128( (const __m128i*)( blocks[n] + g * 16 ) ), byte_swap );
+            }
+            else
+            {
+               // W[t] = s1(W[t-2]) + W[t-7] + s0(W[t-15]) + W[t-16], four words at a time
+               const __m128i& prev1 = msg[n][ ( g + 3 ) % 4 ];
+               const __m128i& prev2 = msg[n][ ( g + 2 ) % 4 ];
+               __m128i t = _mm_add_epi32( _mm_sha256msg1_epu32( w, msg[n][ ( g + 1 ) % 4 ] ), _mm_alignr_epi8( prev1, prev2, 4 ) );
+               w = _mm_sha256msg2_epu32( t, prev1 );
+            }
+
+            const __m128i wk = _mm_add_epi32( w, k );
+            state1[n] = _mm_sha256rnds2_epu32( state1[n], state0[n], wk );
+            state0[n] = _mm_sha256rnds2_epu32( state0[n], state1[n], _mm_shuffle_epi32( wk, 0x0E ) );
+         }
+      }
+
+      for( int n = 0; n < N; ++n )
+      {
+         state0[n] = _mm_add_epi32( state0[n], abef[n] );
+         state1[n] = _mm_add_epi32( state1[n], cdgh[n] );
+      }
+   }
+
+   template< int N >
+   FC_SHANI inline void hash_shani( const message_layout& layout, const char* const msgs[N], const char* shared_tail, sha256* out )
+   {
+      const __m128i byte_swap = _mm_set_epi64x( 0x0c0d0e0f08090a0bULL, 0x0405060700010203ULL );
+      char tails[N][128];
+      const char* tail[N];
+      __m128i state0[N], state1[N];
+
+      for( int n = 0; n < N; ++n )
+      {
+         if( shared_tail )
+         {
+            tail[n] = shared_tail;
+         }
+         else
+         {
+            layout.build_tail( msgs[n], tails[n] );
+            tail[n] = tails[n];
+         }
+
+         __m128i tmp = _mm_shuffle_epi32( _mm_loadu_si128( (const __m128i*)&initial_state[0] ), 0xB1 ); // CDAB
+         state1[n] = _mm_shuffle_epi32( _mm_loadu_si128( (const __m128i*)&initial_state[4] ), 0x1B ); // EFGH
+         state0[n] = _mm_alignr_epi8( tmp, state1[n], 8 ); // ABEF
+         state1[n] = _mm_blend_epi16( state1[n], tmp, 0xF0 ); // CDGH
+      }
+
+      for( uint32_t b = 0; b < layout.blocks(); ++b )
+      {
+         const char* blocks[N];
+         for( int n = 0; n < N; ++n )
+            blocks[n] = layout.block( msgs[n], tail[n], b );
+         shani_compress< N >( state0, state1, blocks );
+      }
+
+      for( int n = 0; n < N; ++n )
+      {
+         __m128i tmp = _mm_shuffle_epi32( state0[n], 0x1B ); // FEBA
+         __m128i dchg = _mm_shuffle_epi32( state1[n], 0xB1 ); // DCHG
+         __m128i dcba = _mm_blend_epi16( tmp, dchg, 0xF0 );
+         __m128i hgfe = _mm_alignr_epi8( dchg, tmp, 8 );
+         _mm_storeu_si128( (__m128i*)out[n].data(), _mm_shuffle_epi8( dcba, byte_swap ) );
+         _mm_storeu_si128( (__m128i*)( out[n].data() + 16 ), _mm_shuffle_epi8( hgfe, byte_swap ) );
+      }
+   }
+
+   FC_SHANI void hash_many_shani( const char* data, uint32_t size, size_t count, sha256* out )
+   {
+      message_layout layout( size );
+      char shared_tail[128];
+      if( layout.shared_tail() )
+         layout.build_tail( data, shared_tail );
+      const char* tail = layout.shared_tail() ? shared_tail : nullptr;
+
+      size_t i = 0;
+      for( ; i + 2 <= count; i += 2 )
+      {
+         const char* msgs[2] = { data + i * size, data + ( i + 1 ) * size };
+         hash_shani< 2 >( layout, msgs, tail, out + i );
+      }
+      if( i < count )
+      {
+         const char* msgs[1] = { data + i * size };
+         hash_shani< 1 >( layout, msgs, tail, out + i );
+      }
+   }
+
+#undef FC_SHANI
+
+#define FC_AVX2 __attribute__(( target( "avx2" ) ))
+
+   FC_AVX2 inline __m256i rotr( __m256i x, int n )
+   {
+      return _mm256_or_si256( _mm256_srli_epi32( x, n ), _mm256_slli_epi32( x, 32 - n ) );
+   }
+
+   FC_AVX2 inline __m256i xor3( __m256i a, __m256i b, __m256i c )
+   {
+      return _mm256_xor_si256( _mm256_xor_si256( a, b ), c );
+   }
+
+   /// Turns eight rows of eight words into eight columns, row j becomes lane j of every vector
+   FC_AVX2 inline void transpose8( __m256i r[8] )
+   {
+      __m256i t0 = _mm256_unpacklo_epi32( r[0], r[1] ), t1 = _mm256_unpackhi_epi32( r[0], r[1] );
+      __m256i t2 = _mm256_unpacklo_epi32( r[2], r[3] ), t3 = _mm256_unpackhi_epi32( r[2], r[3] );
+      __m256i t4 = _mm256_unpacklo_epi32( r[4], r[5] ), t5 = _mm256_unpackhi_epi32( r[4], r[5] );
+      __m256i t6 = _mm256_unpacklo_epi32( r[6], r[7] ), t7 = _mm256_unpackhi_epi32( r[6], r[7] );
+
+      __m256i u0 = _mm256_unpacklo_epi64( t0, t2 ), u1 = _mm256_unpackhi_epi64( t0, t2 );
+      __m256i u2 = _mm256_unpacklo_epi64( t1, t3 ), u3 = _mm256_unpackhi_epi64( t1, t3 );
+      __m256i u4 = _mm256_unpacklo_epi64( t4, t6 ), u5 = _mm256_unpackhi_epi64( t4, t6 );
+      __m256i u6 = _mm256_unpacklo_epi64( t5, t7 ), u7 = _mm256_unpackhi_epi64( t5, t7 );
+
+      r[0] = _mm256_permute2x128_si256( u0, u4, 0x20 ); r[4] = _mm256_permute2x128_si256( u0, u4, 0x31 );
+      r[1] = _mm256_permute2x128_si256( u1, u5, 0x20 ); r[5] = _mm256_permute2x128_si256( u1, u5, 0x31 );
+      r[2] = _mm256_permute2x128_si256( u2, u6, 0x20 ); r[6] = _mm256_permute2x128_si256( u2, u6, 0x31 );
+      r[3] = _mm256_permute2x128_si256( u3, u7, 0x20 ); r[7] = _mm256_permute2x128_si256( u3, u7, 0x31 );
+   }
+
+   /// Compresses one block of each of eight messages, lane j of every vector belongs to message j.
+   FC_AVX2 void avx2_compress( __m256i state[8], const char* const blocks[8] )
+   {
+      const __m256i byte_swap = _mm256_set_epi64x( 0x0c0d0e0f08090a0bULL, 0x0405060700010203ULL,
+                                                   0x0c0d0e0f08090a0bULL, 0x0405060700010203ULL );
+      __m256i w[16];
+      for( int half = 0; half < 2; ++half )
+      {
+         for( int j = 0; j < 8; ++j )
+            w[ half * 8 + j ] = _mm256_loadu_si256( (const __m256i*)( blocks[j] + half * 32 ) );
+         transpose8( w + half * 8 );
+      }
+      for( int t = 0; t < 16; ++t )
+         w[t] = _mm256_shuffle_epi8( w[t], byte_swap );
+
+      __m256i a = state[0], b = state[1], c = state[2], d = state[3];
+      __m256i e = state[4], f = state[5], g = state[6], h = state[7];
+
+#pragma GCC unroll 64
+      for( int t = 0; t < 64; ++t )
+      {
+         // The schedule is kept as a ring of the last sixteen words
+         if( t >= 16 )
+         {
+            const __m256i w15 = w[ ( t - 15 ) % 16 ], w2 = w[ ( t - 2 ) % 16 ];
+            __m256i s0 = xor3( rotr( w15, 7 ), rotr( w15, 18 ), _mm256_srli_epi32( w15, 3 ) );
+            __m256i s1 = xor3( rotr( w2, 17 ), rotr( w2, 19 ), _mm256_srli_epi32( w2, 10 ) );
+            w[ t % 16 ] = _mm256_add_epi32( _mm256_add_epi32( w[ t % 16 ], s0 ), _mm256_add_epi32( w[ ( t - 7 ) % 16 ], s1 ) );
+         }
+
+         __m256i s1 = xor3( rotr( e, 6 ), rotr( e, 11 ), rotr( e, 25 ) );
+         __m256i ch = _mm256_xor_si256( _mm256_and_si256( e, f ), _mm256_andnot_si256( e, g ) );
+         __m256i t1 = _mm256_add_epi32( _mm256_add_epi32( h, s1 ),
+                      _mm256_add_epi32( ch, _mm256_add_epi32( w[ t % 16 ], _mm256_set1_epi32( round_constants[t] ) ) ) );
+         __m256i s0 = xor3( rotr( a, 2 ), rotr( a, 13 ), rotr( a, 22 ) );
+         __m256i maj = _mm256_or_si256( _mm256_and_si256( _mm256_or_si256( a, b ), c ), _mm256_and_si256( a, b ) );
+         __m256i t2 = _mm256_add_epi32( s0, maj );
+
+         h = g; g = f; f = e;
+         e = _mm256_add_epi32( d, t1 );
+         d = c; c = b; b = a;
+         a = _mm256_add_epi32( t1, t2 );
+      }
+
+      state[0] = _mm256_add_epi32( state[0], a );
+      state[1] = _mm256_add_epi32( state[1], b );
+      state[2] = _mm256_add_epi32( state[2], c );
+      state[3] = _mm256_add_epi32( state[3], d );
+      state[4] = _mm256_add_epi32( state[4], e );
+      state[5] = _mm256_add_epi32( state[5], f );
+      state[6] = _mm256_add_epi32( state[6], g );
+      state[7] = _mm256_add_epi32( state[7], h );
+   }
+
+   FC_AVX2 void hash_many_avx2( const char* data, uint32_t size, size_t count, sha256* out )
+   {
+      const __m256i byte_swap = _mm256_set_epi64x( 0x0c0d0e0f08090a0bULL, 0x0405060700010203ULL,
+                                                   0x0c0d0e0f08090a0bULL, 0x0405060700010203ULL );
+      message_layout layout( size );
+      char tails[8][128];
+      if( layout.shared_tail() )
+         layout.build_tail( data, tails[0] );
+
+      for( size_t first = 0; first < count; first += 8 )
+      {
+         size_t lanes = std::min< size_t >( 8, count - first );
+         const char* msgs[8];
+         const char* tail[8];
+         for( size_t j = 0; j < 8; ++j )
+         {
+            // Unused lanes of the last group repeat the first message, their result is dropped
+            msgs[j] = data + ( first + ( j < lanes ? j : 0 ) ) * size;
+            if( layout.shared_tail() )
+            {
+               tail[j] = tails[0];
+            }
+            else
+            {
+               layout.build_tail( msgs[j], tails[j] );
+               tail[j] = tails[j];
+            }
+         }
+
+         __m256i state[8];
+         for( int i = 0; i < 8; ++i )
+            state[i] = _mm256_set1_epi32( initial_state[i] );
+
+         for( uint32_t b = 0; b < layout.blocks(); ++b )
+         {
+            const char* blocks[8];
+            for( size_t j = 0; j < 8; ++j )
+               blocks[j] = layout.block( msgs[j], tail[j], b );
+            avx2_compress( state, blocks );
+         }
+
+         // Transposing back turns the vector of word i into the digest of message i
+         transpose8( state );
+         for( size_t j = 0; j < lanes; ++j )
+            _mm256_storeu_si256( (__m256i*)out[ first + j ].data(), _mm256_shuffle_epi8( state[j], byte_swap ) );
+      }
+   }
+
+#undef FC_AVX2
+
+   bool cpu_has_shani()
+   {
+      unsigned int eax, ebx, ecx, edx;
+      if( !__get_cpuid( 1, &eax, &ebx, &ecx, &edx ) || !( ecx & bit_SSE4_1 ) || !( ecx & bit_SSSE3 ) )
+         return false;
+      if( !__get_cpuid_count( 7, 0, &eax, &ebx, &ecx, &edx ) )
+         return false;
+      return ( ebx & ( 1u << 29 ) ) != 0;
+   }
+
+   bool cpu_has_avx2()
+   {
+      unsigned int eax, ebx, ecx, edx;
+      if( !__get_cpuid( 1, &eax, &ebx, &ecx, &edx ) || !( ecx & bit_OSXSAVE ) || !( ecx & bit_AVX ) )
+         return false;
+      // The OS must save the upper halves of the ymm registers
+      uint32_t xcr0_lo, xcr0_hi;
+      __asm__( "xgetbv" : "=a"( xcr0_lo ), "=d"( xcr0_hi ) : "c"( 0 ) );
+      if( ( xcr0_lo & 6 ) != 6 )
+         return false;
+      if( !__get_cpuid_count( 7, 0, &eax, &ebx, &ecx, &edx ) )
+         return false;
+      return ( ebx & bit_AVX2 ) != 0;
+   }
+
+#endif // FC_SHA256_X86
+
+   sha256::backend best_backend()
+   {
+#ifdef FC_SHA256_X86
+      // One SHA-NI lane is faster than eight AVX2 lanes
+      if( cpu_has_shani() )
+         return sha256::shani_backend;
+      if( cpu_has_avx2() )
+         return sha256::avx2_backend;
+#endif
+      return sha256::generic_backend;
+   }
+
+   sha256::backend& selected_backend()
+   {
+      static sha256::backend b = best_backend();
+      return b;
+   }
+
+} // anonymous
+
+bool sha256::backend_supported( backend b )
+{
+   switch( b )
+   {
+      case generic_backend:
+         return true;
+#ifdef FC_SHA256_X86
+      case shani_backend:
+         return cpu_has_shani();
+      case avx2_backend:
+         return cpu_has_avx2();
+#endif
+      default:
+         return false;
+   }
+}
+
+const char* sha256::backend_name( backend b )
+{
+   switch( b )
+   {
+      case generic_backend: return "generic";
+      case shani_backend:   return "sha-ni";
+      case avx2_backend:    return "avx2";
+   }
+   return "unknown";
+}
+
+sha256::backend sha256::active_backend()
+{
+   return selected_backend();
+}
+
+void sha256::set_backend( backend b )
+{
+   FC_ASSERT( backend_supported( b ), "SHA256 backend ${b} is not supported by this CPU", ("b", backend_name( b )) );
+   selected_backend() = b;
+}
+
+void sha256::hash_many( const char* data, uint32_t size, size_t count, sha256* out )
+{
+   switch( selected_backend() )
+   {
+#ifdef FC_SHA256_X86
+      case shani_backend:
+         hash_many_shani( data, size, count, out );
+         return;
+      case avx2_backend:
+         hash_many_avx2( data, size, count, out );
+         return;
+#endif
+      default:
+         hash_many_generic( data, size, count, out );
+   }
+}
+
+} // fc
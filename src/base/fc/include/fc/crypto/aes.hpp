@@ -37,6 +37,54 @@ namespace fc {
          fc::fwd<impl,96> my;
     };
 
+    /**
+     *  AES-256-GCM over a stream of messages sharing one key. The 96 bit nonce of every message is
+     *  the 32 bit prefix given to init() followed by a 64 bit message counter, so a key must never
+     *  be given to two encoders with the same prefix. OpenSSL uses AES-NI and carry-less
+     *  multiplication where the CPU has them.
+     *
+     *  A message is sealed by begin(), any number of update() calls and finish(), so the plaintext
+     *  can be encrypted straight from the buffers it is scattered over. Input and output of
+     *  update() may be the same buffer.
+     */
+    class aes_gcm_encoder
+    {
+       public:
+         static const size_t tag_size = 16;
+
+         aes_gcm_encoder();
+         ~aes_gcm_encoder();
+
+         void init( const fc::sha256& key, uint32_t nonce_prefix = 0 );
+         /** starts the next message, aad is authenticated but not encrypted */
+         void begin( const char* aad, size_t aad_len );
+         void update( const char* plaintxt, size_t len, char* ciphertxt );
+         /** writes the tag_size bytes authentication tag of the message */
+         void finish( char* tag );
+
+       private:
+         struct      impl;
+         fc::fwd<impl,32> my;
+    };
+    class aes_gcm_decoder
+    {
+       public:
+         static const size_t tag_size = aes_gcm_encoder::tag_size;
+
+         aes_gcm_decoder();
+         ~aes_gcm_decoder();
+
+         void init( const fc::sha256& key, uint32_t nonce_prefix = 0 );
+         void begin( const char* aad, size_t aad_len );
+         void update( const char* ciphertxt, size_t len, char* plaintxt );
+         /** returns false if the message or its aad do not match the tag, the plaintext must then be discarded */
+         bool finish( const char* tag );
+
+       private:
+         struct      impl;
+         fc::fwd<impl,32> my;
+    };
+
     unsigned aes_encrypt(unsigned char *plaintext, int plaintext_len, unsigned char *key,
                          unsigned char *iv, unsigned char *ciphertext);
     unsigned aes_decrypt(unsigned char *ciphertext, int ciphertext_len, unsigned char *key,
@@ -32,6 +32,30 @@ class sha256
       return e.result();
     }
 
+    /**
+     * Implementations of hash_many. The SHA extensions hash two messages at a time with dedicated
+     * instructions, AVX2 hashes eight messages at once in the lanes of its registers and the
+     * generic backend calls hash() for every message.
+     */
+    enum backend
+    {
+      generic_backend,
+      shani_backend,
+      avx2_backend
+    };
+
+    /**
+     * Hashes count messages of size bytes each, stored back to back at data, into out[0..count).
+     * Uses the fastest backend the CPU supports unless another one was chosen with set_backend.
+     */
+    static void hash_many( const char* data, uint32_t size, size_t count, sha256* out );
+
+    static bool        backend_supported( backend b );
+    static const char* backend_name( backend b );
+    static backend     active_backend();
+    /// Selects the backend of hash_many, meant for tests and benchmarks
+    static void        set_backend( backend b );
+
     class encoder
     {
       public:
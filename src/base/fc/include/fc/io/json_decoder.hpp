@@ -0,0 +1,219 @@
+#pragma once
+#include <fc/io/json_document.hpp>
+#include <fc/reflect/reflect.hpp>
+#include <fc/reflect/variant.hpp>
+
+#include <string>
+#include <type_traits>
+#include <vector>
+
+namespace fc
+{
+   /**
+    *  Opts a reflected type into member-wise decoding by fc::from_json.
+    *
+    *  Only valid for types whose from_variant is the reflected default; types with a custom
+    *  from_variant (assets, keys, static variants, ...) must not be marked and are decoded
+    *  through a variant instead.
+    */
+   template< typename T >
+   struct json_decode_reflected : std::false_type {};
+
+   template< typename T > void from_json( const json_value& v, T& o );
+
+   namespace detail
+   {
+      template< typename T >
+      struct is_json_integer : std::integral_constant< bool,
+            std::is_same< T, int8_t >::value  || std::is_same< T, uint8_t >::value  ||
+            std::is_same< T, int16_t >::value || std::is_same< T, uint16_t >::value ||
+            std::is_same< T, int32_t >::value || std::is_same< T, uint32_t >::value ||
+            std::is_same< T, int64_t >::value || std::is_same< T, uint64_t >::value > {};
+
+      /**
+       *  Decodes a value of type T, reading the JSON text directly when the token has the
+       *  expected type and falling back to from_variant otherwise, so both paths accept exactly
+       *  the same input.
+       */
+      template< typename T, typename Enable = void >
+      struct json_decoder
+      {
+         static void decode( const json_value& v, T& o )
+         {
+            from_variant( v.to_variant(), o );
+         }
+      };
+
+      template<>
+      struct json_decoder< bool >
+      {
+         static void decode( const json_value& v, bool& o )
+         {
+            o = v.as_bool();
+         }
+      };
+
+      template< typename T >
+      struct json_decoder< T, typename std::enable_if< is_json_integer< T >::value >::type >
+      {
+         static void decode( const json_value& v, T& o )
+         {
+            if( v.is_integer() )
+               o = static_cast< T >( v.as_int64() );
+            else
+               from_variant( v.to_variant(), o );
+         }
+      };
+
+      template< typename T >
+      struct json_decoder< T, typename std::enable_if< std::is_floating_point< T >::value >::type >
+      {
+         static void decode( const json_value& v, T& o )
+         {
+            o = static_cast< T >( v.as_double() );
+         }
+      };
+
+      template<>
+      struct json_decoder< std::string >
+      {
+         static void decode( const json_value& v, std::string& o )
+         {
+            o = v.as_string();
+         }
+      };
+
+      template<>
+      struct json_decoder< variant >
+      {
+         static void decode( const json_value& v, variant& o )
+         {
+            o = v.to_variant();
+         }
+      };
+
+      template< typename T >
+      struct json_decoder< optional< T > >
+      {
+         static void decode( const json_value& v, optional< T >& o )
+         {
+            if( v.is_null() )
+            {
+               o = optional< T >();
+            }
+            else
+            {
+               o = T();
+               from_json( v, *o );
+            }
+         }
+      };
+
+      // std::vector< char > is hex encoded by from_variant
+      template< typename T >
+      struct json_decoder< std::vector< T >, typename std::enable_if< !std::is_same< T, char >::value >::type >
+      {
+         static void decode( const json_value& v, std::vector< T >& o )
+         {
+            if( !v.is_array() )
+            {
+               from_variant( v.to_variant(), o );
+               return;
+            }
+
+            o.clear();
+            o.reserve( v.size() );
+            v.for_each_element( [&]( const json_value& e )
+            {
+               o.emplace_back();
+               from_json( e, o.back() );
+            });
+         }
+      };
+
+      template< typename T >
+      class json_member_table
+      {
+         public:
+            typedef void (*decode_fn)( const json_value&, T& );
+
+            struct entry
+            {
+               std::string name;
+               decode_fn   decode;
+            };
+
+            static const std::vector< entry >& get()
+            {
+               static const std::vector< entry > table = build();
+               return table;
+            }
+
+            template< typename Member, class Class, Member (Class::*member) >
+            void operator()( const char* name )const
+            {
+               _entries.push_back( entry{ name, &decode_member< Member, Class, member > } );
+            }
+
+         private:
+            json_member_table( std::vector< entry >& entries ) : _entries( entries ) {}
+
+            static std::vector< entry > build()
+            {
+               std::vector< entry > entries;
+               fc::reflector< T >::visit( json_member_table( entries ) );
+               return entries;
+            }
+
+            template< typename Member, class Class, Member (Class::*member) >
+            static void decode_member( const json_value& v, T& o )
+            {
+               from_json( v, o.*member );
+            }
+
+            std::vector< entry >& _entries;
+      };
+
+      /** Decodes a reflected struct member by member, ignoring unknown keys like from_variant */
+      template< typename T >
+      struct json_object_decoder
+      {
+         static void decode( const json_value& v, T& o )
+         {
+            if( !v.is_object() )
+            {
+               from_variant( v.to_variant(), o );
+               return;
+            }
+
+            const auto& table = json_member_table< T >::get();
+            v.for_each_member( [&]( const std::string& key, const json_value& value )
+            {
+               for( const auto& e : table )
+               {
+                  if( e.name == key )
+                  {
+                     e.decode( value, o );
+                     return;
+                  }
+               }
+            });
+         }
+      };
+
+      template< typename T >
+      struct json_decoder< T, typename std::enable_if< json_decode_reflected< T >::value >::type >
+         : json_object_decoder< T > {};
+   }
+
+   /** Decodes v into o without building an intermediate variant where the type allows it */
+   template< typename T >
+   void from_json( const json_value& v, T& o )
+   {
+      detail::json_decoder< T >::decode( v, o );
+   }
+
+} // fc
+
+#define FC_JSON_DECODE_REFLECTED( TYPE ) \
+namespace fc { template<> struct json_decode_reflected< TYPE > : std::true_type {}; }
@@ -0,0 +1,131 @@
+#pragma once
+#include <fc/exception/exception.hpp>
+#include <fc/variant.hpp>
+
+#include <string>
+#include <vector>
+
+namespace fc
+{
+   class json_value;
+
+   /**
+    *  A strictly parsed JSON text whose values are decoded on demand.
+    *
+    *  Parsing runs in two stages. Stage one classifies the input 64 bytes at a time (with SSE2
+    *  where available) into bitmasks of quotes, backslashes, structural characters and
+    *  whitespace, and from those derives the position of every structural character and value
+    *  outside of strings without branching per byte. Stage two walks those positions, validates
+    *  the grammar and records for every value where it ends, so any value can be skipped in
+    *  constant time.
+    *
+    *  Strings and numbers are only decoded when they are read, either as a variant through
+    *  json_value::to_variant() or directly into a C++ type with fc::from_json (see
+    *  fc/io/json_decoder.hpp).
+    *
+    *  The document refers to the text it was constructed from, which must outlive it.
+    */
+   class json_document
+   {
+      public:
+         /** @throws parse_error_exception if utf8_str is not a single valid JSON value */
+         explicit json_document( const std::string& utf8_str );
+
+         json_value root()const;
+
+      private:
+         friend class json_value;
+
+         struct token
+         {
+            /// offset of the first character of the value
+            uint32_t pos;
+            /// offset of the closing quote or bracket, or one past the last character of a literal
+            uint32_t end;
+            /// index of the first token after this value
+            uint32_t next;
+         };
+
+         void     build_tape( const std::vector< uint32_t >& structurals );
+         void     parse_value( const std::vector< uint32_t >& structurals, size_t& i, uint32_t depth );
+
+         const std::string&      _text;
+         std::vector< token >    _tape;
+   };
+
+   /**
+    *  A lightweight reference to one value of a json_document.
+    */
+   class json_value
+   {
+      public:
+         enum type_id
+         {
+            null_type,
+            bool_type,
+            number_type,
+            string_type,
+            array_type,
+            object_type
+         };
+
+         type_id type()const;
+
+         bool is_null()const   { return type() == null_type; }
+         bool is_bool()const   { return type() == bool_type; }
+         bool is_number()const { return type() == number_type; }
+         bool is_string()const { return type() == string_type; }
+         bool is_array()const  { return type() == array_type; }
+         bool is_object()const { return type() == object_type; }
+
+         /// True for numbers without fraction or exponent
+         bool is_integer()const;
+
+         bool        as_bool()const;
+         int64_t     as_int64()const;
+         uint64_t    as_uint64()const;
+         double      as_double()const;
+         std::string as_string()const;
+
+         /// The undecoded text of this value
+         std::string raw()const;
+
+         /// Builds the same variant the legacy parser builds for this value
+         variant     to_variant()const;
+
+         /** Calls f( const std::string& key, const json_value& value ) for every member of an object */
+         template< typename Functor >
+         void for_each_member( Functor&& f )const
+         {
+            FC_ASSERT( is_object(), "Expected a JSON object" );
+            uint32_t end = tok().next;
+            for( uint32_t i = _index + 1; i < end; i = _doc->_tape[ i + 1 ].next )
+               f( json_value( *_doc, i ).as_string(), json_value( *_doc, i + 1 ) );
+         }
+
+         /** Calls f( const json_value& element ) for every element of an array */
+         template< typename Functor >
+         void for_each_element( Functor&& f )const
+         {
+            FC_ASSERT( is_array(), "Expected a JSON array" );
+            uint32_t end = tok().next;
+            for( uint32_t i = _index + 1; i < end; i = _doc->_tape[ i ].next )
+               f( json_value( *_doc, i ) );
+         }
+
+         /// Number of members of an object or elements of an array
+         size_t size()const;
+
+      private:
+         friend class json_document;
+
+         json_value( const json_document& doc, uint32_t index ) : _doc( &doc ), _index( index ) {}
+
+         const json_document::token& tok()const { return _doc->_tape[ _index ]; }
+         char first_char()const { return _doc->_text[ tok().pos ]; }
+
+         const json_document*    _doc;
+         uint32_t                _index;
+   };
+
+} // fc
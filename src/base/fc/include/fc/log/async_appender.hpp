@@ -0,0 +1,54 @@
+#pragma once
+
+#include <fc/log/appender.hpp>
+#include <fc/log/logger.hpp>
+#include <fc/variant.hpp>
+
+namespace fc
+{
+   /**
+    *  Wraps another appender and hands log messages to it from a dedicated writer thread.
+    *
+    *  The logging thread only enqueues the (reference counted) log_message into a bounded
+    *  lock-free ring buffer; format string substitution, stringification and the actual
+    *  I/O of the wrapped appender all happen on the writer thread.
+    *
+    *  When the ring buffer is full the message is either dropped (the number of dropped
+    *  messages is reported by the writer once the burst is over) or the caller spins until
+    *  the writer frees a slot, depending on the configured overflow policy.
+    */
+   class async_appender : public appender
+   {
+      public:
+         struct overflow_policy { enum type { drop, block }; };
+
+         struct config
+         {
+            /// type of the wrapped appender, e.g. "file" or "console"
+            string                       type;
+            /// configuration of the wrapped appender
+            variant                      args;
+            /// ring buffer capacity, rounded up to a power of two
+            uint32_t                     max_queue_size = 8192;
+            overflow_policy::type        overflow = overflow_policy::drop;
+         };
+
+         async_appender( const variant& args );
+         ~async_appender();
+         virtual void log( const log_message& m ) override;
+
+         /// Blocks until every message enqueued before the call has been written
+         void flush();
+
+         /// Number of messages discarded because the ring buffer was full
+         uint64_t dropped_messages()const;
+
+      private:
+         class impl;
+         std::unique_ptr<impl> my;
+   };
+} // namespace fc
+
+#include <fc/reflect/reflect.hpp>
+FC_REFLECT_ENUM( fc::async_appender::overflow_policy::type, (drop)(block) )
+FC_REFLECT( fc::async_appender::config, (type)(args)(max_queue_size)(overflow) )
@@ -11,6 +11,7 @@
  **/
 #pragma once
 #include <stdexcept>
+#include <type_traits>
 #include <typeinfo>
 #include <fc/exception/exception.hpp>
 
@@ -19,7 +20,7 @@ namespace fc {
 // Implementation details, the user should not import this:
 namespace impl {
 
-template<int64_t N, typename... Ts>
+template<typename... Ts>
 struct storage_ops;
 
 template<typename X, typename... Ts>
@@ -54,84 +55,55 @@ struct move_construct
    }
 };
 
-template<int64_t N, typename T, typename... Ts>
-struct storage_ops<N, T&, Ts...> {
-    static void del(int64_t n, void *data) {}
-    static void con(int64_t n, void *data) {}
-
-    template<typename visitor>
-    static typename visitor::result_type apply(int64_t n, void *data, visitor& v) {}
-
-    template<typename visitor>
-    static typename visitor::result_type apply(int64_t n, void *data, const visitor& v) {}
-
-    template<typename visitor>
-    static typename visitor::result_type apply(int64_t n, const void *data, visitor& v) {}
-
-    template<typename visitor>
-    static typename visitor::result_type apply(int64_t n, const void *data, const visitor& v) {}
-};
-
-template<int64_t N, typename T, typename... Ts>
-struct storage_ops<N, T, Ts...> {
-    static void del(int64_t n, void *data) {
-        if(n == N) reinterpret_cast<T*>(data)->~T();
-        else storage_ops<N + 1, Ts...>::del(n, data);
-    }
-    static void con(int64_t n, void *data) {
-        if(n == N) new(reinterpret_cast<T*>(data)) T();
-        else storage_ops<N + 1, Ts...>::con(n, data);
-    }
-
-    template<typename visitor>
-    static typename visitor::result_type apply(int64_t n, void *data, visitor& v) {
-        if(n == N) return v(*reinterpret_cast<T*>(data));
-        else return storage_ops<N + 1, Ts...>::apply(n, data, v);
-    }
-
-    template<typename visitor>
-    static typename visitor::result_type apply(int64_t n, void *data, const visitor& v) {
-        if(n == N) return v(*reinterpret_cast<T*>(data));
-        else return storage_ops<N + 1, Ts...>::apply(n, data, v);
-    }
+/**
+ * Dispatch goes through tables of function pointers indexed by the tag, one table per
+ * operation and visitor type, instead of comparing the tag against every alternative in turn.
+ * The tables are constant initialized, so a visit costs a bounds check and an indirect call
+ * regardless of the number of alternatives.
+ */
+template<typename T>
+void destroy_alternative( void* data ) {
+    reinterpret_cast<T*>(data)->~T();
+}
+
+template<typename T>
+void construct_alternative( void* data ) {
+    new(reinterpret_cast<T*>(data)) T();
+}
+
+template<typename Visitor>
+using visitor_result = typename std::remove_const<Visitor>::type::result_type;
+
+// Data carries the constness of the storage, Visitor may be const qualified
+template<typename T, typename Data, typename Visitor>
+visitor_result<Visitor> visit_alternative( Data* data, Visitor& v ) {
+    typedef typename std::conditional<std::is_const<Data>::value, const T, T>::type value_type;
+    return v(*reinterpret_cast<value_type*>(data));
+}
 
-    template<typename visitor>
-    static typename visitor::result_type apply(int64_t n, const void *data, visitor& v) {
-        if(n == N) return v(*reinterpret_cast<const T*>(data));
-        else return storage_ops<N + 1, Ts...>::apply(n, data, v);
+template<typename... Ts>
+struct storage_ops {
+    static void check_tag(int64_t n) {
+        if(n < 0 || n >= int64_t(sizeof...(Ts)))
+            FC_THROW_EXCEPTION( fc::assert_exception, "Internal error: static_variant tag is invalid." );
     }
 
-    template<typename visitor>
-    static typename visitor::result_type apply(int64_t n, const void *data, const visitor& v) {
-        if(n == N) return v(*reinterpret_cast<const T*>(data));
-        else return storage_ops<N + 1, Ts...>::apply(n, data, v);
-    }
-};
-
-template<int64_t N>
-struct storage_ops<N> {
     static void del(int64_t n, void *data) {
-       FC_THROW_EXCEPTION( fc::assert_exception, "Internal error: static_variant tag is invalid.");
+        static constexpr void (*table[])(void*) = { &destroy_alternative<Ts>... };
+        check_tag(n);
+        table[n](data);
     }
     static void con(int64_t n, void *data) {
-       FC_THROW_EXCEPTION( fc::assert_exception, "Internal error: static_variant tag is invalid." );
+        static constexpr void (*table[])(void*) = { &construct_alternative<Ts>... };
+        check_tag(n);
+        table[n](data);
     }
 
-    template<typename visitor>
-    static typename visitor::result_type apply(int64_t n, void *data, visitor& v) {
-       FC_THROW_EXCEPTION( fc::assert_exception, "Internal error: static_variant tag is invalid." );
-    }
-    template<typename visitor>
-    static typename visitor::result_type apply(int64_t n, void *data, const visitor& v) {
-       FC_THROW_EXCEPTION( fc::assert_exception, "Internal error: static_variant tag is invalid." );
-    }
-    template<typename visitor>
-    static typename visitor::result_type apply(int64_t n, const void *data, visitor& v) {
-       FC_THROW_EXCEPTION( fc::assert_exception, "Internal error: static_variant tag is invalid." );
-    }
-    template<typename visitor>
-    static typename visitor::result_type apply(int64_t n, const void *data, const visitor& v) {
-       FC_THROW_EXCEPTION( fc::assert_exception, "Internal error: static_variant tag is invalid." );
+    template<typename Data, typename Visitor>
+    static visitor_result<Visitor> apply(int64_t n, Data *data, Visitor& v) {
+        static constexpr visitor_result<Visitor> (*table[])(Data*, Visitor&) = { &visit_alternative<Ts, Data, Visitor>... };
+        check_tag(n);
+        return table[n](data, v);
     }
 };
 
@@ -213,7 +185,7 @@ public:
     static_variant()
     {
        _tag = 0;
-       impl::storage_ops<0, Types...>::con(0, storage);
+       impl::storage_ops<Types...>::con(0, storage);
     }
 
     template<typename... Other>
@@ -240,7 +212,7 @@ public:
         init(v);
     }
     ~static_variant() {
-       impl::storage_ops<0, Types...>::del(_tag, storage);
+       impl::storage_ops<Types...>::del(_tag, storage);
     }
 
 
@@ -307,22 +279,22 @@ public:
     }
     template<typename visitor>
     typename visitor::result_type visit(visitor& v) {
-        return impl::storage_ops<0, Types...>::apply(_tag, storage, v);
+        return impl::storage_ops<Types...>::apply(_tag, storage, v);
     }
 
     template<typename visitor>
     typename visitor::result_type visit(const visitor& v) {
-        return impl::storage_ops<0, Types...>::apply(_tag, storage, v);
+        return impl::storage_ops<Types...>::apply(_tag, storage, v);
     }
 
     template<typename visitor>
     typename visitor::result_type visit(visitor& v)const {
-        return impl::storage_ops<0, Types...>::apply(_tag, storage, v);
+        return impl::storage_ops<Types...>::apply(_tag, storage, v);
     }
 
     template<typename visitor>
     typename visitor::result_type visit(const visitor& v)const {
-        return impl::storage_ops<0, Types...>::apply(_tag, storage, v);
+        return impl::storage_ops<Types...>::apply(_tag, storage, v);
     }
 
     static int64_t count() { return static_cast< int64_t >( impl::type_info<Types...>::count ); }
@@ -330,7 +302,7 @@ public:
       FC_ASSERT( w < count() && w >= 0 );
       this->~static_variant();
       _tag = w;
-      impl::storage_ops<0, Types...>::con(_tag, storage);
+      impl::storage_ops<Types...>::con(_tag, storage);
     }
 
     int64_t which() const {return _tag;}
@@ -38,6 +38,7 @@ namespace fc {
       uint64_t    _posted_num;
       priority    _prio;
       time_point  _when;
+      time_point  _ready_time; // when the task became ready to run, only set while profiling
       void        _set_active_context(context*);
       context*    _active_context;
       task_base*  _next;
@@ -0,0 +1,44 @@
+#pragma once
+#include <fc/time.hpp>
+#include <fc/reflect/reflect.hpp>
+
+#include <string>
+#include <vector>
+
+namespace fc {
+
+   /**
+    *  Scheduler statistics for every task of an fc::thread that was started with the same
+    *  description. Time is charged to a task from the moment its fiber is switched in until it
+    *  yields, blocks or completes; each such interval is a slice.
+    */
+   struct task_profile
+   {
+      std::string    description;
+      uint64_t       runs = 0;          ///< tasks that ran to completion
+      uint64_t       slices = 0;        ///< times a task was switched in
+      uint64_t       long_slices = 0;   ///< slices longer than the thread's long slice threshold
+      microseconds   run_time;          ///< total time spent running
+      microseconds   ready_time;        ///< total time spent ready to run, waiting for the thread
+      microseconds   longest_slice;     ///< longest time run without yielding
+   };
+
+   /**
+    *  Snapshot of the task profile of one fc::thread, see fc::thread::set_profiling().
+    *  Time spent outside of any task, like the scheduler loop itself or code run directly by
+    *  the thread's owner, is reported under "[no task]". Time the thread spends idle waiting
+    *  for work is not charged to anything.
+    */
+   struct thread_profile
+   {
+      std::string                   thread_name;
+      time_point                    since;
+      microseconds                  long_slice_threshold;
+      uint64_t                      context_switches = 0;
+      std::vector< task_profile >   tasks;   ///< ordered by run_time, busiest first
+   };
+
+} // namespace fc
+
+FC_REFLECT( fc::task_profile, (description)(runs)(slices)(long_slices)(run_time)(ready_time)(longest_slice) )
+FC_REFLECT( fc::thread_profile, (thread_name)(since)(long_slice_threshold)(context_switches)(tasks) )
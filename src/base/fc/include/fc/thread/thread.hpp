@@ -9,6 +9,7 @@
 namespace fc {
   class time_point;
   class microseconds;
+  struct thread_profile;
 
    namespace detail
    {
@@ -56,6 +57,25 @@ namespace fc {
        *  async tasks and promises.
        */
       void    debug( const fc::string& d );
+
+      /**
+       *  @brief starts or stops collecting per task scheduler statistics on this thread.
+       *
+       *  While enabled the scheduler records, for each task description, how long its tasks
+       *  ran, how long they were ready but waiting for the thread and how often they were
+       *  switched in. Any stretch of running without yielding longer than
+       *  <code>long_slice_threshold</code> is counted as a long slice. Enabling resets the
+       *  collected statistics.
+       */
+      void    set_profiling( bool enabled, const microseconds& long_slice_threshold = fc::milliseconds(50) );
+      bool    is_profiling()const;
+
+      /**
+       *  @brief returns the statistics collected since profiling was enabled or last reset.
+       *
+       *  Runs on this thread, waiting for it if called from another one.
+       */
+      thread_profile get_profile( bool reset = false );
      
      
       /**
@@ -0,0 +1,534 @@
+#include <fc/io/json_document.hpp>
+#include <fc/variant_object.hpp>
+
+#include <cctype>
+#include <cstdlib>
+#include <cstring>
+#include <limits>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+namespace fc
+{
+   namespace
+   {
+      const uint32_t max_depth = 100;
+
+      struct block_masks
+      {
+         uint64_t quote = 0;
+         uint64_t backslash = 0;
+         uint64_t structural = 0;
+         uint64_t whitespace = 0;
+      };
+
+#if defined(__SSE2__)
+      inline uint64_t eq_mask( __m128i v, char c )
+      {
+         return uint16_t( _mm_movemask_epi8( _mm_cmpeq_epi8( v, _mm_set1_epi8( c ) ) ) );
+      }
+
+      /** Classifies 64 bytes, 16 at a time */
+      inline void classify( const char* p, block_masks& m )
+      {
+         for( uint32_t k = 0; k < 4; ++k )
+         {
+            __m128i v = _mm_loadu_si128( reinterpret_cast< const __m128i* >( p + 16 * k ) );
+            uint32_t shift = 16 * k;
+
+            m.quote      |= eq_mask( v, '"' ) << shift;
+            m.backslash  |= eq_mask( v, '\\' ) << shift;
+            m.structural |= ( eq_mask( v, '{' ) | eq_mask( v, '}' ) | eq_mask( v, '[' ) | eq_mask( v, ']' )
+                            | eq_mask( v, ':' ) | eq_mask( v, ',' ) ) << shift;
+            m.whitespace |= ( eq_mask( v, ' ' ) | eq_mask( v, '\t' ) | eq_mask( v, '\n' ) | eq_mask( v, '\r' ) ) << shift;
+         }
+      }
+#else
+      inline void classify( const char* p, block_masks& m )
+      {
+         for( uint32_t k = 0; k < 64; ++k )
+         {
+            uint64_t bit = uint64_t( 1 ) << k;
+            switch( p[k] )
+            {
+               case '"':  m.quote |= bit; break;
+               case '\\': m.backslash |= bit; break;
+               case '{': case '}': case '[': case ']': case ':': case ',':
+                  m.structural |= bit; break;
+               case ' ': case '\t': case '\n': case '\r':
+                  m.whitespace |= bit; break;
+               default: break;
+            }
+         }
+      }
+#endif
+
+      /**
+       *  Returns the characters preceded by an odd number of backslashes, i.e. the escaped ones.
+       *  prev_odd carries whether the previous block ended in an odd backslash run.
+       */
+      inline uint64_t find_escaped( uint64_t backslash, uint64_t& prev_odd )
+      {
+         const uint64_t even_bits = 0x5555555555555555ULL;
+         const uint64_t odd_bits = ~even_bits;
+
+         uint64_t start_edges = backslash & ~( backslash << 1 );
+         uint64_t even_start_mask = even_bits ^ prev_odd;
+         uint64_t even_starts = start_edges & even_start_mask;
+         uint64_t odd_starts = start_edges & ~even_start_mask;
+         uint64_t even_carries = backslash + even_starts;
+         uint64_t odd_carries = backslash + odd_starts;
+         bool ends_odd = odd_carries < backslash;
+
+         odd_carries |= prev_odd;
+         prev_odd = ends_odd ? 1 : 0;
+
+         uint64_t even_carry_ends = even_carries & ~backslash;
+         uint64_t odd_carry_ends = odd_carries & ~backslash;
+         return ( even_carry_ends & odd_bits ) | ( odd_carry_ends & even_bits );
+      }
+
+      inline uint64_t prefix_xor( uint64_t x )
+      {
+         x ^= x << 1;
+         x ^= x << 2;
+         x ^= x << 4;
+         x ^= x << 8;
+         x ^= x << 16;
+         x ^= x << 32;
+         return x;
+      }
+
+      /** Stage one: positions of structural characters, quotes and literal starts outside of strings */
+      void find_structurals( const std::string& text, std::vector< uint32_t >& out )
+      {
+         const size_t size = text.size();
+         out.reserve( size / 4 + 16 );
+
+         uint64_t prev_odd_backslash = 0;
+         uint64_t prev_in_string = 0;
+         // the start of the input acts like whitespace preceding the first literal
+         uint64_t prev_pred = 1;
+
+         char tail[64];
+         for( size_t base = 0; base < size; base += 64 )
+         {
+            const char* p = text.data() + base;
+            if( size - base < 64 )
+            {
+               memset( tail, ' ', sizeof( tail ) );
+               memcpy( tail, p, size - base );
+               p = tail;
+            }
+
+            block_masks m;
+            classify( p, m );
+
+            uint64_t escaped = find_escaped( m.backslash, prev_odd_backslash );
+            uint64_t quotes = m.quote & ~escaped;
+            uint64_t in_string = prefix_xor( quotes ) ^ prev_in_string;
+            prev_in_string = uint64_t( int64_t( in_string ) >> 63 );
+
+            uint64_t pred = m.structural | m.whitespace | m.quote;
+            uint64_t literal_starts = ( ( pred << 1 ) | prev_pred ) & ~pred & ~in_string;
+            prev_pred = pred >> 63;
+
+            uint64_t bits = ( m.structural & ~in_string ) | quotes | literal_starts;
+            while( bits )
+            {
+               out.push_back( uint32_t( base + __builtin_ctzll( bits ) ) );
+               bits &= bits - 1;
+            }
+         }
+
+         if( prev_in_string )
+            FC_THROW_EXCEPTION( parse_error_exception, "EOF before closing '\"'" );
+      }
+
+      inline bool is_literal_char( char c )
+      {
+         switch( c )
+         {
+            case ' ': case '\t': case '\n': case '\r':
+            case '{': case '}': case '[': case ']': case ':': case ',': case '"':
+               return false;
+            default:
+               return true;
+         }
+      }
+
+      inline bool is_digit( char c ) { return c >= '0' && c <= '9'; }
+
+      bool is_number( const char* p, const char* e )
+      {
+         if( p != e && *p == '-' ) ++p;
+         if( p == e ) return false;
+
+         if( *p == '0' ) ++p;
+         else if( is_digit( *p ) ) while( p != e && is_digit( *p ) ) ++p;
+         else return false;
+
+         if( p != e && *p == '.' )
+         {
+            ++p;
+            if( p == e || !is_digit( *p ) ) return false;
+            while( p != e && is_digit( *p ) ) ++p;
+         }
+
+         if( p != e && ( *p == 'e' || *p == 'E' ) )
+         {
+            ++p;
+            if( p != e && ( *p == '+' || *p == '-' ) ) ++p;
+            if( p == e || !is_digit( *p ) ) return false;
+            while( p != e && is_digit( *p ) ) ++p;
+         }
+
+         return p == e;
+      }
+
+      uint64_t parse_magnitude( const char* p, const char* e )
+      {
+         uint64_t v = 0;
+         for( ; p != e; ++p )
+         {
+            uint64_t d = uint64_t( *p - '0' );
+            if( v > ( std::numeric_limits< uint64_t >::max() - d ) / 10 )
+               FC_THROW_EXCEPTION( parse_error_exception, "Number out of range" );
+            v = v * 10 + d;
+         }
+         return v;
+      }
+
+      void check_hex4( const char* p, const char* e )
+      {
+         if( e - p < 4 )
+            FC_THROW_EXCEPTION( parse_error_exception, "Truncated \\u escape" );
+
+         for( int i = 0; i < 4; ++i )
+            if( !isxdigit( static_cast< unsigned char >( p[i] ) ) )
+               FC_THROW_EXCEPTION( parse_error_exception, "Invalid \\u escape" );
+      }
+
+      /**
+       *  Decodes escapes the way the legacy parser (parseEscape in json.cpp) does, so a request gives the
+       *  same strings whichever parser handles it: only \t \n \r and \\ are translated, any other
+       *  escaped character is kept as is without the backslash, \u0041 becomes "u0041". Escapes that are
+       *  not valid JSON are still rejected, the caller falls back to the legacy parser for those.
+       */
+      std::string unescape( const char* p, const char* e )
+      {
+         std::string out;
+         out.reserve( e - p );
+
+         while( p != e )
+         {
+            const char* bs = static_cast< const char* >( memchr( p, '\\', e - p ) );
+            if( bs == nullptr )
+            {
+               out.append( p, e );
+               break;
+            }
+
+            out.append( p, bs );
+            p = bs + 1;
+            if( p == e )
+               FC_THROW_EXCEPTION( parse_error_exception, "String ended with '\\'" );
+
+            switch( *p++ )
+            {
+               case 'n':  out += '\n'; break;
+               case 'r':  out += '\r'; break;
+               case 't':  out += '\t'; break;
+               case '"':
+               case '\\':
+               case '/':
+               case 'b':
+               case 'f':
+                  out += p[-1];
+                  break;
+               case 'u':
+                  check_hex4( p, e );
+                  out += 'u';
+                  break;
+               default:
+                  FC_THROW_EXCEPTION( parse_error_exception, "Invalid escape '\\${c}'", ("c", std::string( p - 1, p )) );
+            }
+         }
+
+         return out;
+      }
+   }
+
+   json_document::json_document( const std::string& utf8_str ) : _text( utf8_str )
+   {
+      FC_ASSERT( utf8_str.size() < std::numeric_limits< uint32_t >::max(), "JSON text too large" );
+
+      std::vector< uint32_t > structurals;
+      find_structurals( _text, structurals );
+      build_tape( structurals );
+   }
+
+   json_value json_document::root()const
+   {
+      return json_value( *this, 0 );
+   }
+
+   void json_document::build_tape( const std::vector< uint32_t >& structurals )
+   {
+      if( structurals.empty() )
+         FC_THROW_EXCEPTION( parse_error_exception, "Unexpected end of input" );
+
+      _tape.reserve( structurals.size() / 2 + 1 );
+
+      size_t i = 0;
+      parse_value( structurals, i, 1 );
+
+      if( i != structurals.size() )
+         FC_THROW_EXCEPTION( parse_error_exception, "Unexpected '${c}' after JSON value at offset ${o}",
+                             ("c", std::string( 1, _text[ structurals[i] ] ))("o", structurals[i]) );
+   }
+
+   void json_document::parse_value( const std::vector< uint32_t >& s, size_t& i, uint32_t depth )
+   {
+      const size_t n = s.size();
+      if( i >= n )
+         FC_THROW_EXCEPTION( parse_error_exception, "Unexpected end of input" );
+
+      uint32_t index = uint32_t( _tape.size() );
+      uint32_t pos = s[i];
+      uint32_t end = 0;
+      char c = _text[ pos ];
+
+      _tape.push_back( token{ pos, 0, 0 } );
+
+      switch( c )
+      {
+         case '{':
+         case '[':
+         {
+            if( depth >= max_depth )
+               FC_THROW_EXCEPTION( parse_error_exception, "Object graph too deep" );
+
+            const char close = ( c == '{' ) ? '}' : ']';
+            ++i;
+
+            if( i < n && _text[ s[i] ] == close )
+            {
+               end = s[i++];
+               break;
+            }
+
+            while( true )
+            {
+               if( c == '{' )
+               {
+                  if( i >= n || _text[ s[i] ] != '"' )
+                     FC_THROW_EXCEPTION( parse_error_exception, "Expected string key at offset ${o}", ("o", i < n ? s[i] : _text.size()) );
+
+                  parse_value( s, i, depth + 1 );
+
+                  if( i >= n || _text[ s[i] ] != ':' )
+                     FC_THROW_EXCEPTION( parse_error_exception, "Expected ':' at offset ${o}", ("o", i < n ? s[i] : _text.size()) );
+                  ++i;
+               }
+
+               parse_value( s, i, depth + 1 );
+
+               if( i >= n )
+                  FC_THROW_EXCEPTION( parse_error_exception, "Expected '${c}' before end of input", ("c", std::string( 1, close )) );
+
+               char d = _text[ s[i] ];
+               if( d == ',' )
+               {
+                  ++i;
+                  continue;
+               }
+               if( d == close )
+               {
+                  end = s[i++];
+                  break;
+               }
+
+               FC_THROW_EXCEPTION( parse_error_exception, "Expected ',' or '${c}' at offset ${o}", ("c", std::string( 1, close ))("o", s[i]) );
+            }
+            break;
+         }
+         case '"':
+            // stage one emits every unescaped quote, so the closing one is always next
+            if( i + 1 >= n )
+               FC_THROW_EXCEPTION( parse_error_exception, "EOF before closing '\"'" );
+            end = s[ i + 1 ];
+            i += 2;
+
+            // reject invalid escapes up front like any other grammar error
+            if( memchr( _text.data() + pos + 1, '\\', end - pos - 1 ) != nullptr )
+               unescape( _text.data() + pos + 1, _text.data() + end );
+            break;
+         case '}':
+         case ']':
+         case ':':
+         case ',':
+            FC_THROW_EXCEPTION( parse_error_exception, "Unexpected '${c}' at offset ${o}", ("c", std::string( 1, c ))("o", pos) );
+         default:
+         {
+            end = pos;
+            while( end < _text.size() && is_literal_char( _text[ end ] ) )
+               ++end;
+
+            const char* b = _text.data() + pos;
+            const char* e = _text.data() + end;
+            size_t len = end - pos;
+
+            bool valid = ( len == 4 && memcmp( b, "true", 4 ) == 0 )
+                      || ( len == 5 && memcmp( b, "false", 5 ) == 0 )
+                      || ( len == 4 && memcmp( b, "null", 4 ) == 0 )
+                      || is_number( b, e );
+
+            if( !valid )
+               FC_THROW_EXCEPTION( parse_error_exception, "Invalid literal '${l}' at offset ${o}", ("l", std::string( b, e ))("o", pos) );
+
+            ++i;
+            break;
+         }
+      }
+
+      _tape[ index ].end = end;
+      _tape[ index ].next = uint32_t( _tape.size() );
+   }
+
+   json_value::type_id json_value::type()const
+   {
+      switch( first_char() )
+      {
+         case '{': return object_type;
+         case '[': return array_type;
+         case '"': return string_type;
+         case 't':
+         case 'f': return bool_type;
+         case 'n': return null_type;
+         default:  return number_type;
+      }
+   }
+
+   bool json_value::is_integer()const
+   {
+      if( !is_number() )
+         return false;
+
+      const char* b = _doc->_text.data() + tok().pos;
+      const char* e = _doc->_text.data() + tok().end;
+      for( ; b != e; ++b )
+         if( *b == '.' || *b == 'e' || *b == 'E' )
+            return false;
+      return true;
+   }
+
+   bool json_value::as_bool()const
+   {
+      if( is_bool() )
+         return first_char() == 't';
+      return to_variant().as_bool();
+   }
+
+   int64_t json_value::as_int64()const
+   {
+      if( !is_integer() )
+         return to_variant().as_int64();
+
+      const char* b = _doc->_text.data() + tok().pos;
+      const char* e = _doc->_text.data() + tok().end;
+      if( *b == '-' )
+      {
+         uint64_t m = parse_magnitude( b + 1, e );
+         if( m > uint64_t( std::numeric_limits< int64_t >::max() ) + 1 )
+            FC_THROW_EXCEPTION( parse_error_exception, "Couldn't parse int64_t" );
+         return int64_t( 0 - m );
+      }
+      return int64_t( parse_magnitude( b, e ) );
+   }
+
+   uint64_t json_value::as_uint64()const
+   {
+      return uint64_t( as_int64() );
+   }
+
+   double json_value::as_double()const
+   {
+      if( !is_number() )
+         return to_variant().as_double();
+
+      std::string str = raw();
+      return std::strtod( str.c_str(), nullptr );
+   }
+
+   std::string json_value::as_string()const
+   {
+      if( !is_string() )
+         return to_variant().as_string();
+
+      const char* b = _doc->_text.data() + tok().pos + 1;
+      const char* e = _doc->_text.data() + tok().end;
+      if( memchr( b, '\\', e - b ) == nullptr )
+         return std::string( b, e );
+      return unescape( b, e );
+   }
+
+   std::string json_value::raw()const
+   {
+      uint32_t end = tok().end;
+      if( !is_number() && !is_bool() && !is_null() )
+         ++end;
+      return _doc->_text.substr( tok().pos, end - tok().pos );
+   }
+
+   variant json_value::to_variant()const
+   {
+      switch( type() )
+      {
+         case null_type:
+            return variant();
+         case bool_type:
+            return variant( first_char() == 't' );
+         case string_type:
+            return variant( as_string() );
+         case number_type:
+         {
+            if( !is_integer() )
+               return variant( as_double() );
+            if( first_char() == '-' )
+               return variant( as_int64() );
+            return variant( parse_magnitude( _doc->_text.data() + tok().pos, _doc->_text.data() + tok().end ) );
+         }
+         case array_type:
+         {
+            variants arr;
+            arr.reserve( size() );
+            for_each_element( [&]( const json_value& v ) { arr.push_back( v.to_variant() ); } );
+            return variant( std::move( arr ) );
+         }
+         case object_type:
+         {
+            mutable_variant_object obj;
+            for_each_member( [&]( const std::string& k, const json_value& v ) { obj( k, v.to_variant() ); } );
+            return variant( std::move( obj ) );
+         }
+      }
+      return variant();
+   }
+
+   size_t json_value::size()const
+   {
+      size_t count = 0;
+      uint32_t end = tok().next;
+      if( is_object() )
+         for( uint32_t i = _index + 1; i < end; i = _doc->_tape[ i + 1 ].next )
+            ++count;
+      else if( is_array() )
+         for( uint32_t i = _index + 1; i < end; i = _doc->_tape[ i ].next )
+            ++count;
+      return count;
+   }
+
+} // fc
@@ -0,0 +1,259 @@
+#include <fc/log/async_appender.hpp>
+#include <fc/exception/exception.hpp>
+#include <fc/reflect/variant.hpp>
+
+#include <boost/thread/condition_variable.hpp>
+#include <boost/thread/mutex.hpp>
+
+#include <atomic>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+namespace fc {
+
+   extern std::unordered_map<std::string,appender_factory::ptr>& get_appender_factory_map();
+
+   namespace detail {
+
+      /**
+       *  Bounded multi-producer / single-consumer ring buffer.
+       *
+       *  Every cell carries a sequence number which tells producers and the consumer whether
+       *  the cell is free for the current lap, so neither side ever takes a lock.
+       */
+      class log_message_ring
+      {
+         public:
+            explicit log_message_ring( uint32_t capacity )
+            {
+               uint32_t size = 2;
+               while( size < capacity )
+                  size <<= 1;
+
+               _mask = size - 1;
+               _cells = std::vector< cell >( size );
+               for( uint32_t i = 0; i < size; ++i )
+                  _cells[i].sequence.store( i, std::memory_order_relaxed );
+            }
+
+            bool try_push( const log_message& m )
+            {
+               uint64_t pos = _enqueue_pos.load( std::memory_order_relaxed );
+               for( ;; )
+               {
+                  cell& c = _cells[ pos & _mask ];
+                  uint64_t seq = c.sequence.load( std::memory_order_acquire );
+                  int64_t diff = int64_t( seq ) - int64_t( pos );
+
+                  if( diff == 0 )
+                  {
+                     if( _enqueue_pos.compare_exchange_weak( pos, pos + 1, std::memory_order_relaxed ) )
+                     {
+                        c.msg = m;
+                        c.sequence.store( pos + 1, std::memory_order_release );
+                        return true;
+                     }
+                  }
+                  else if( diff < 0 )
+                  {
+                     return false;
+                  }
+                  else
+                  {
+                     pos = _enqueue_pos.load( std::memory_order_relaxed );
+                  }
+               }
+            }
+
+            bool try_pop( log_message& m )
+            {
+               cell& c = _cells[ _dequeue_pos & _mask ];
+               uint64_t seq = c.sequence.load( std::memory_order_acquire );
+               if( int64_t( seq ) - int64_t( _dequeue_pos + 1 ) < 0 )
+                  return false;
+
+               m = std::move( c.msg );
+               c.msg = log_message();
+               c.sequence.store( _dequeue_pos + _mask + 1, std::memory_order_release );
+               ++_dequeue_pos;
+               return true;
+            }
+
+         private:
+            struct cell
+            {
+               cell() {}
+               cell( const cell& ) {}
+
+               std::atomic< uint64_t >    sequence;
+               log_message                msg;
+            };
+
+            std::vector< cell >           _cells;
+            uint64_t                      _mask = 0;
+            std::atomic< uint64_t >       _enqueue_pos{ 0 };
+            // only touched by the writer thread
+            uint64_t                      _dequeue_pos = 0;
+      };
+
+   } // detail
+
+   class async_appender::impl
+   {
+      public:
+         impl( const config& c ) : cfg( c ), ring( c.max_queue_size ) {}
+
+         void writer_main()
+         {
+            log_message m;
+            for( ;; )
+            {
+               uint32_t written = 0;
+               while( ring.try_pop( m ) )
+               {
+                  write( m );
+                  ++written;
+               }
+
+               report_dropped();
+
+               if( written )
+               {
+                  written_count.fetch_add( written, std::memory_order_release );
+                  boost::unique_lock< boost::mutex > lock( wake_mutex );
+                  flushed.notify_all();
+                  continue;
+               }
+
+               if( stopping.load( std::memory_order_acquire ) )
+                  break;
+
+               boost::unique_lock< boost::mutex > lock( wake_mutex );
+               writer_idle.store( true, std::memory_order_release );
+               wake.wait_for( lock, boost::chrono::milliseconds( 50 ) );
+               writer_idle.store( false, std::memory_order_release );
+            }
+         }
+
+         void write( const log_message& m )
+         {
+            try
+            {
+               target->log( m );
+            }
+            catch( const fc::exception& e )
+            {
+               std::cerr << "async_appender: error writing log message: " << e.to_detail_string() << "\n";
+            }
+            catch( const std::exception& e )
+            {
+               std::cerr << "async_appender: error writing log message: " << e.what() << "\n";
+            }
+            catch( ... )
+            {
+               std::cerr << "async_appender: unknown error writing log message\n";
+            }
+         }
+
+         void report_dropped()
+         {
+            uint64_t dropped = dropped_count.load( std::memory_order_relaxed );
+            if( dropped == reported_dropped )
+               return;
+
+            write( FC_LOG_MESSAGE( warn, "Log queue overflow, dropped ${n} messages",
+                                   ("n", dropped - reported_dropped) ) );
+            reported_dropped = dropped;
+         }
+
+         void notify_writer()
+         {
+            if( writer_idle.load( std::memory_order_acquire ) )
+            {
+               boost::unique_lock< boost::mutex > lock( wake_mutex );
+               wake.notify_one();
+            }
+         }
+
+         config                        cfg;
+         appender::ptr                 target;
+         detail::log_message_ring      ring;
+         std::thread                   writer;
+
+         std::atomic< bool >           stopping{ false };
+         std::atomic< bool >           writer_idle{ false };
+         std::atomic< uint64_t >       enqueued_count{ 0 };
+         std::atomic< uint64_t >       written_count{ 0 };
+         std::atomic< uint64_t >       dropped_count{ 0 };
+         uint64_t                      reported_dropped = 0;
+
+         boost::mutex                  wake_mutex;
+         boost::condition_variable     wake;
+         boost::condition_variable     flushed;
+   };
+
+   async_appender::async_appender( const variant& args ) :
+      my( new impl( args.as< config >() ) )
+   {
+      FC_ASSERT( my->cfg.type != "async", "async_appender cannot wrap another async_appender" );
+      FC_ASSERT( my->cfg.max_queue_size > 0, "max_queue_size must be positive" );
+
+      auto fact_itr = get_appender_factory_map().find( my->cfg.type );
+      FC_ASSERT( fact_itr != get_appender_factory_map().end(), "Unknown appender type '${t}'", ("t", my->cfg.type) );
+
+      my->target = fact_itr->second->create( my->cfg.args );
+      FC_ASSERT( my->target, "Unable to create appender of type '${t}'", ("t", my->cfg.type) );
+
+      my->writer = std::thread( [this]() { my->writer_main(); } );
+   }
+
+   async_appender::~async_appender()
+   {
+      my->stopping.store( true, std::memory_order_release );
+      {
+         boost::unique_lock< boost::mutex > lock( my->wake_mutex );
+         my->wake.notify_one();
+      }
+
+      if( my->writer.joinable() )
+         my->writer.join();
+   }
+
+   void async_appender::log( const log_message& m )
+   {
+      while( !my->ring.try_push( m ) )
+      {
+         if( my->cfg.overflow == overflow_policy::drop )
+         {
+            my->dropped_count.fetch_add( 1, std::memory_order_relaxed );
+            my->notify_writer();
+            return;
+         }
+
+         my->notify_writer();
+         std::this_thread::yield();
+      }
+
+      my->enqueued_count.fetch_add( 1, std::memory_order_relaxed );
+      my->notify_writer();
+   }
+
+   void async_appender::flush()
+   {
+      uint64_t target_count = my->enqueued_count.load( std::memory_order_relaxed );
+
+      boost::unique_lock< boost::mutex > lock( my->wake_mutex );
+      my->wake.notify_one();
+      while( my->written_count.load( std::memory_order_acquire ) < target_count )
+         my->flushed.wait_for( lock, boost::chrono::milliseconds( 10 ) );
+   }
+
+   uint64_t async_appender::dropped_messages()const
+   {
+      return my->dropped_count.load( std::memory_order_relaxed );
+   }
+
+} // fc
@@ -4,6 +4,7 @@
 #include <iostream>
 #include <fc/crypto/aes.hpp>
 #include <fc/crypto/city.hpp>
+#include <fc/crypto/hex.hpp>
 #include <fc/exception/exception.hpp>
 #include <fc/filesystem.hpp>
 
@@ -70,4 +71,85 @@ BOOST_AUTO_TEST_CASE( aes_encrypt_decrypt_roundtrip )
 //    BOOST_CHECK( !memcmp( dcrypt.data(), data.data(), len) );
 }
 
+BOOST_AUTO_TEST_CASE( aes_gcm_known_answers )
+{
+    // Test cases 13 and 14 of the GCM specification: all zero key, all zero nonce
+    fc::sha256 key;
+    char tag[fc::aes_gcm_encoder::tag_size];
+
+    fc::aes_gcm_encoder empty;
+    empty.init( key );
+    empty.begin( nullptr, 0 );
+    empty.finish( tag );
+    BOOST_CHECK_EQUAL( fc::to_hex( tag, sizeof(tag) ), "530f8afbc74536b9a963b4f1c4cb738b" );
+
+    char block[16] = {};
+    fc::aes_gcm_encoder enc;
+    enc.init( key );
+    enc.begin( nullptr, 0 );
+    enc.update( block, sizeof(block), block );
+    enc.finish( tag );
+    BOOST_CHECK_EQUAL( fc::to_hex( block, sizeof(block) ), "cea7403d4d606b6e074ec5d3baf39d18" );
+    BOOST_CHECK_EQUAL( fc::to_hex( tag, sizeof(tag) ), "d0d1c8a799996bf0265b98b5d48ab919" );
+
+    fc::aes_gcm_decoder dec;
+    dec.init( key );
+    dec.begin( nullptr, 0 );
+    dec.update( block, sizeof(block), block );
+    BOOST_CHECK( dec.finish( tag ) );
+    BOOST_CHECK_EQUAL( fc::to_hex( block, sizeof(block) ), "00000000000000000000000000000000" );
+}
+
+BOOST_AUTO_TEST_CASE( aes_gcm_message_stream )
+{
+    const fc::sha256 key = fc::sha256::hash( std::string( "gcm" ) );
+    const std::string header = "header";
+    const std::string body = "a body that is not a multiple of the block size";
+    const uint32_t aad = 1234;
+
+    fc::aes_gcm_encoder enc;
+    enc.init( key, 7 );
+    fc::aes_gcm_decoder dec;
+    dec.init( key, 7 );
+
+    for( int i = 0; i < 3; ++i )
+    {
+        // encrypted from two buffers, decrypted in place as one
+        std::vector<char> sealed( header.size() + body.size() );
+        char tag[fc::aes_gcm_encoder::tag_size];
+        enc.begin( (const char*)&aad, sizeof(aad) );
+        enc.update( header.data(), header.size(), sealed.data() );
+        enc.update( body.data(), body.size(), sealed.data() + header.size() );
+        enc.finish( tag );
+        BOOST_CHECK( std::string( sealed.begin(), sealed.end() ) != header + body );
+
+        if( i == 1 )
+        {
+            // a modified message fails authentication and the nonce still advances
+            sealed[3] ^= 1;
+            dec.begin( (const char*)&aad, sizeof(aad) );
+            dec.update( sealed.data(), sealed.size(), sealed.data() );
+            BOOST_CHECK( !dec.finish( tag ) );
+            continue;
+        }
+
+        dec.begin( (const char*)&aad, sizeof(aad) );
+        dec.update( sealed.data(), sealed.size(), sealed.data() );
+        BOOST_CHECK( dec.finish( tag ) );
+        BOOST_CHECK_EQUAL( std::string( sealed.begin(), sealed.end() ), header + body );
+    }
+
+    // a different aad fails authentication
+    std::vector<char> sealed( body.size() );
+    char tag[fc::aes_gcm_encoder::tag_size];
+    enc.begin( (const char*)&aad, sizeof(aad) );
+    enc.update( body.data(), body.size(), sealed.data() );
+    enc.finish( tag );
+
+    const uint32_t other_aad = aad + 1;
+    dec.begin( (const char*)&other_aad, sizeof(other_aad) );
+    dec.update( sealed.data(), sealed.size(), sealed.data() );
+    BOOST_CHECK( !dec.finish( tag ) );
+}
+
 BOOST_AUTO_TEST_SUITE_END()
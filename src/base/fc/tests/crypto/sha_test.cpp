@@ -9,6 +9,7 @@
 #include <fc/exception/exception.hpp>
 
 #include <iostream>
+#include <vector>
 
 // SHA test vectors taken from http://www.di-mgt.com.au/sha_testvectors.html
 static const std::string TEST1("abc");
@@ -157,6 +158,38 @@ BOOST_AUTO_TEST_CASE( sha256_hashing )
     BOOST_CHECK_EQUAL( "d61967f63c7dd183914a4ae452c9f6ad5d462ce3d277798075b107615c1a8a30", (std::string) fc::sha256::hash(fourth) );
 }
 
+BOOST_AUTO_TEST_CASE( sha256_hash_many )
+{
+    const fc::sha256::backend original = fc::sha256::active_backend();
+    std::vector<char> data( 200 * 20 );
+    for( size_t i = 0; i < data.size(); i++ )
+        data[i] = char( i * 7 + i / 13 );
+
+    for( auto b : { fc::sha256::generic_backend, fc::sha256::shani_backend, fc::sha256::avx2_backend } )
+    {
+        if( !fc::sha256::backend_supported( b ) )
+        {
+            BOOST_TEST_MESSAGE( std::string( "skipping unsupported backend " ) + fc::sha256::backend_name( b ) );
+            continue;
+        }
+        fc::sha256::set_backend( b );
+        BOOST_CHECK( fc::sha256::active_backend() == b );
+
+        for( uint32_t size = 0; size <= 200; size++ )
+        {
+            for( size_t count : { 1, 3, 7, 8, 9, 17, 20 } )
+            {
+                std::vector<fc::sha256> out( count );
+                fc::sha256::hash_many( data.data(), size, count, out.data() );
+                for( size_t i = 0; i < count; i++ )
+                    BOOST_REQUIRE_EQUAL( fc::sha256::hash( data.data() + i * size, size ).str(), out[i].str() );
+            }
+        }
+    }
+
+    fc::sha256::set_backend( original );
+}
+
 BOOST_AUTO_TEST_CASE( sha512_hashing )
 {
     init_5();
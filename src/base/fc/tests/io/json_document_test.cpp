@@ -0,0 +1,208 @@
+#include <boost/test/unit_test.hpp>
+
+#include <fc/io/json.hpp>
+#include <fc/io/json_decoder.hpp>
+#include <fc/optional.hpp>
+
+#include <random>
+#include <string>
+#include <vector>
+
+namespace {
+
+   struct json_inner
+   {
+      std::string             name;
+      uint32_t                weight = 0;
+   };
+
+   struct json_outer
+   {
+      int64_t                       id = 0;
+      bool                          flag = false;
+      double                        ratio = 0;
+      std::vector< json_inner >     items;
+      fc::optional< std::string >   memo;
+      fc::variant                   extra;
+      std::vector< uint16_t >       numbers;
+   };
+
+   /// Reflected, but decoded by its own from_variant
+   struct json_custom
+   {
+      std::string             name;
+   };
+
+   fc::variant parse_fast( const std::string& s )
+   {
+      fc::json_document doc( s );
+      return doc.root().to_variant();
+   }
+
+   void require_same( const std::string& s )
+   {
+      BOOST_TEST_MESSAGE( s );
+      BOOST_REQUIRE_EQUAL( fc::json::to_string( parse_fast( s ) ), fc::json::to_string( fc::json::from_string( s ) ) );
+   }
+
+   std::string random_string( std::mt19937& rng )
+   {
+      static const char alphabet[] = "ab \\\"{}[]:,tn";
+      std::string s = "\"";
+      uint32_t len = rng() % 90;
+      for( uint32_t i = 0; i < len; ++i )
+      {
+         char c = alphabet[ rng() % ( sizeof( alphabet ) - 1 ) ];
+         if( c == '\\' )
+         {
+            static const char* const escapes[] = { "\\\\", "\\\"", "\\/", "\\b", "\\f", "\\n", "\\r", "\\t", "\\u00e9" };
+            s += escapes[ rng() % ( sizeof( escapes ) / sizeof( escapes[0] ) ) ];
+         }
+         else if( c == '"' )
+            s += "\\\"";
+         else
+            s += c;
+      }
+      return s + "\"";
+   }
+
+   std::string random_json( std::mt19937& rng, uint32_t depth )
+   {
+      switch( depth > 4 ? rng() % 4 : rng() % 6 )
+      {
+         case 0: return random_string( rng );
+         case 1: return std::to_string( int64_t( rng() ) - int64_t( rng() ) );
+         case 2: return ( rng() % 2 ) ? "true" : "null";
+         case 3: return std::to_string( rng() % 1000 ) + "." + std::to_string( rng() % 1000 );
+         case 4:
+         {
+            std::string s = "[";
+            uint32_t n = rng() % 5;
+            for( uint32_t i = 0; i < n; ++i )
+               s += ( i ? ", " : " " ) + random_json( rng, depth + 1 );
+            return s + "]";
+         }
+         default:
+         {
+            std::string s = "{";
+            uint32_t n = rng() % 5;
+            for( uint32_t i = 0; i < n; ++i )
+               s += ( i ? ",\n" : "" ) + random_string( rng ) + " : " + random_json( rng, depth + 1 );
+            return s + "}";
+         }
+      }
+   }
+}
+
+namespace fc {
+   void from_variant( const fc::variant& v, json_custom& o )
+   {
+      o.name = "custom:" + v.get_object()[ "name" ].as_string();
+   }
+}
+
+FC_REFLECT( json_inner, (name)(weight) )
+FC_REFLECT( json_outer, (id)(flag)(ratio)(items)(memo)(extra)(numbers) )
+FC_REFLECT( json_custom, (name) )
+FC_JSON_DECODE_REFLECTED( json_inner )
+FC_JSON_DECODE_REFLECTED( json_outer )
+
+BOOST_AUTO_TEST_SUITE( fc_json_document )
+
+BOOST_AUTO_TEST_CASE( matches_legacy_parser )
+{
+   require_same( "{}" );
+   require_same( "[]" );
+   require_same( "  \"plain\"  " );
+   require_same( "-42" );
+   require_same( "18446744073709551615" );
+   require_same( "[1, -2, 3.25, true, false, null, \"x\"]" );
+   require_same( "{\"a\":{\"b\":[{\"c\":\"\\\\\"}]},\"d\":\"say \\\"hi\\\"\"}" );
+   require_same( "{\"dup\":1,\"dup\":2}" );
+   require_same( "{\"k\":\"tab\\tnew\\nline\\r\"}" );
+
+   // escapes and quotes straddling the 64 byte blocks of stage one
+   for( size_t pad = 50; pad < 80; ++pad )
+   {
+      require_same( "[\"" + std::string( pad, 'x' ) + "\\\\\", \"" + std::string( pad, '\\' ) + std::string( pad, '\\' ) + "\"]" );
+      require_same( "{\"" + std::string( pad, 'y' ) + "\":\"\\\"\\\\\\\"{]\"}" );
+   }
+}
+
+BOOST_AUTO_TEST_CASE( matches_legacy_parser_random )
+{
+   std::mt19937 rng( 7 );
+   for( int i = 0; i < 2000; ++i )
+      require_same( random_json( rng, 0 ) );
+}
+
+BOOST_AUTO_TEST_CASE( rejects_invalid_json )
+{
+   const std::vector< std::string > invalid = {
+      "", "   ", "{", "[1,]", "{\"a\":}", "{\"a\" 1}", "{a:1}", "\"abc", "tru", "nul", "1 2",
+      "{\"a\":1}}", "[1]]", "01", "1.", "-", "[\"\\q\"]", "{\"a\":1,}", "\"a\"b", "[1 2]"
+   };
+
+   for( const auto& s : invalid )
+   {
+      BOOST_TEST_MESSAGE( s );
+      BOOST_CHECK_THROW( fc::json_document doc( s ), fc::parse_error_exception );
+   }
+
+   BOOST_CHECK_THROW( fc::json_document doc( std::string( 100, '[' ) + std::string( 100, ']' ) ), fc::parse_error_exception );
+   BOOST_CHECK_NO_THROW( fc::json_document doc( std::string( 99, '[' ) + std::string( 99, ']' ) ) );
+}
+
+BOOST_AUTO_TEST_CASE( escapes_decode_like_legacy_parser )
+{
+   // only \t \n \r and \\ are translated, like the legacy parser does
+   std::string s = "[\"\\u0041\\ud83d\\ude00\\/\\b\\f\\t\\\\\"]";
+   require_same( s );
+
+   fc::json_document doc( s );
+   std::vector< std::string > v;
+   fc::from_json( doc.root(), v );
+   BOOST_REQUIRE_EQUAL( v.size(), 1u );
+   BOOST_REQUIRE_EQUAL( v[0], "u0041ud83dude00/bf\t\\" );
+
+   BOOST_CHECK_THROW( fc::json_document doc( "[\"\\u00g1\"]" ), fc::parse_error_exception );
+   BOOST_CHECK_THROW( fc::json_document doc( "[\"\\u00\"]" ), fc::parse_error_exception );
+}
+
+BOOST_AUTO_TEST_CASE( typed_decoding )
+{
+   std::string s = "{\"id\":-7,\"unknown\":{\"x\":[1,2]},\"flag\":true,\"ratio\":0.5,"
+                   "\"items\":[{\"name\":\"a\",\"weight\":3},{\"name\":\"b\",\"weight\":\"4\"}],"
+                   "\"memo\":\"hello\",\"extra\":{\"k\":[null]},\"numbers\":[1,\"2\",3]}";
+
+   fc::json_document doc( s );
+   json_outer fast;
+   fc::from_json( doc.root(), fast );
+
+   json_outer legacy = fc::json::from_string( s ).as< json_outer >();
+
+   BOOST_REQUIRE_EQUAL( fc::json::to_string( fast ), fc::json::to_string( legacy ) );
+   BOOST_REQUIRE_EQUAL( fast.id, -7 );
+   BOOST_REQUIRE( fast.flag );
+   BOOST_REQUIRE_EQUAL( fast.items.size(), 2u );
+   BOOST_REQUIRE_EQUAL( fast.items[1].weight, 4u );
+   BOOST_REQUIRE( fast.memo.valid() && *fast.memo == "hello" );
+   BOOST_REQUIRE_EQUAL( fast.numbers.size(), 3u );
+
+   fc::json_document null_memo( "{\"memo\":null}" );
+   json_outer o;
+   o.memo = "x";
+   fc::from_json( null_memo.root(), o );
+   BOOST_REQUIRE( !o.memo.valid() );
+
+   fc::json_document not_object( "[1]" );
+   BOOST_CHECK_THROW( fc::from_json( not_object.root(), o ), fc::bad_cast_exception );
+
+   // types not marked with FC_JSON_DECODE_REFLECTED keep their own from_variant
+   fc::json_document custom( "{\"name\":\"x\"}" );
+   json_custom c;
+   fc::from_json( custom.root(), c );
+   BOOST_REQUIRE_EQUAL( c.name, "custom:x" );
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,107 @@
+#include <boost/test/unit_test.hpp>
+
+#include <fc/static_variant.hpp>
+
+#include <string>
+#include <vector>
+
+namespace {
+
+int live_counters = 0;
+
+struct counted
+{
+   counted() { ++live_counters; }
+   counted( const counted& ) { ++live_counters; }
+   ~counted() { --live_counters; }
+};
+
+typedef fc::static_variant< int64_t, std::string, std::vector< int >, counted > test_variant;
+
+struct describe_visitor
+{
+   typedef std::string result_type;
+
+   std::string operator()( const int64_t& v )const { return "int " + std::to_string( v ); }
+   std::string operator()( const std::string& v )const { return "string " + v; }
+   std::string operator()( const std::vector< int >& v )const { return "vector " + std::to_string( v.size() ); }
+   std::string operator()( const counted& )const { return "counted"; }
+};
+
+// Mutating visitor that keeps state, so it is only usable through the non-const overloads
+struct append_visitor
+{
+   typedef void result_type;
+
+   int calls = 0;
+
+   void operator()( int64_t& v ) { ++calls; v += 1; }
+   void operator()( std::string& v ) { ++calls; v += "!"; }
+   void operator()( std::vector< int >& v ) { ++calls; v.push_back( 0 ); }
+   void operator()( counted& ) { ++calls; }
+};
+
+} // namespace
+
+BOOST_AUTO_TEST_SUITE( static_variant_tests )
+
+BOOST_AUTO_TEST_CASE( visits_every_alternative )
+{
+   test_variant v;
+   BOOST_CHECK_EQUAL( 0, v.which() );
+   BOOST_CHECK_EQUAL( "int 0", v.visit( describe_visitor() ) );
+
+   v = std::string( "abc" );
+   BOOST_CHECK_EQUAL( 1, v.which() );
+   BOOST_CHECK_EQUAL( "string abc", v.visit( describe_visitor() ) );
+
+   v = std::vector< int >{ 1, 2, 3 };
+   const test_variant& cv = v;
+   describe_visitor d;
+   BOOST_CHECK_EQUAL( "vector 3", cv.visit( d ) );
+
+   append_visitor a;
+   v.visit( a );
+   v = int64_t( 41 );
+   v.visit( a );
+   BOOST_CHECK_EQUAL( 2, a.calls );
+   BOOST_CHECK_EQUAL( 42, v.get< int64_t >() );
+
+   for( int64_t i = 0; i < test_variant::count(); ++i )
+   {
+      v.set_which( i );
+      BOOST_CHECK_EQUAL( i, v.which() );
+      v.visit( a );
+   }
+   BOOST_CHECK_EQUAL( 2 + test_variant::count(), a.calls );
+}
+
+BOOST_AUTO_TEST_CASE( copies_moves_and_destroys_the_active_alternative )
+{
+   BOOST_CHECK_EQUAL( 0, live_counters );
+   {
+      test_variant v = counted();
+      BOOST_CHECK_EQUAL( 1, live_counters );
+
+      test_variant copy( v );
+      BOOST_CHECK_EQUAL( 2, live_counters );
+      BOOST_CHECK_EQUAL( "counted", copy.visit( describe_visitor() ) );
+
+      copy = std::string( "replaced" );
+      BOOST_CHECK_EQUAL( 1, live_counters );
+
+      test_variant moved( std::move( copy ) );
+      BOOST_CHECK_EQUAL( "string replaced", moved.visit( describe_visitor() ) );
+   }
+   BOOST_CHECK_EQUAL( 0, live_counters );
+}
+
+BOOST_AUTO_TEST_CASE( rejects_invalid_tags )
+{
+   test_variant v;
+   BOOST_CHECK_THROW( v.set_which( test_variant::count() ), fc::assert_exception );
+   BOOST_CHECK_THROW( v.set_which( -1 ), fc::assert_exception );
+   BOOST_CHECK_EQUAL( 0, v.which() );
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -1,6 +1,7 @@
 #include <boost/test/unit_test.hpp>
 
 #include <fc/thread/thread.hpp>
+#include <fc/thread/task_profile.hpp>
 
 using namespace fc;
 
@@ -91,4 +92,60 @@ BOOST_AUTO_TEST_CASE( reschedules_yielded_task )
     BOOST_CHECK_EQUAL(10, reschedule_count);
 }
 
+BOOST_AUTO_TEST_CASE( profiles_tasks )
+{
+    fc::thread thread("my");
+    thread.set_profiling(true, fc::milliseconds(5));
+    BOOST_CHECK(thread.is_profiling());
+
+    auto busy = thread.async([]
+            {
+                fc::time_point end = fc::time_point::now() + fc::milliseconds(20);
+                while (fc::time_point::now() < end);
+            }, "busy");
+    auto yielder = thread.async([]
+            {
+                for (int i = 0; i < 10; i++)
+                    fc::yield();
+            }, "yielder");
+    busy.wait();
+    yielder.wait();
+
+    fc::thread_profile profile = thread.get_profile(true);
+    BOOST_CHECK_EQUAL("my", profile.thread_name);
+    BOOST_CHECK(profile.context_switches > 0);
+
+    auto find = [](const fc::thread_profile& p, const std::string& desc) -> const fc::task_profile* {
+        for (const auto& t : p.tasks)
+            if (t.description == desc)
+                return &t;
+        return nullptr;
+    };
+
+    const fc::task_profile* b = find(profile, "busy");
+    BOOST_REQUIRE(b != nullptr);
+    BOOST_CHECK_EQUAL(1u, b->runs);
+    BOOST_CHECK_EQUAL(1u, b->slices);
+    BOOST_CHECK_EQUAL(1u, b->long_slices);
+    BOOST_CHECK(b->run_time >= fc::milliseconds(20));
+    BOOST_CHECK(b->longest_slice == b->run_time);
+    BOOST_CHECK_EQUAL("busy", profile.tasks.front().description);
+
+    const fc::task_profile* y = find(profile, "yielder");
+    BOOST_REQUIRE(y != nullptr);
+    BOOST_CHECK_EQUAL(1u, y->runs);
+    BOOST_CHECK(y->slices >= 11);
+    BOOST_CHECK_EQUAL(0u, y->long_slices);
+    // the yielder was posted while busy was spinning
+    BOOST_CHECK(y->ready_time >= fc::milliseconds(15));
+
+    profile = thread.get_profile();
+    BOOST_CHECK(find(profile, "busy") == nullptr);
+
+    thread.set_profiling(false);
+    BOOST_CHECK(!thread.is_profiling());
+    thread.async([]{}, "unprofiled").wait();
+    BOOST_CHECK(find(thread.get_profile(), "unprofiled") == nullptr);
+}
+
 BOOST_AUTO_TEST_SUITE_END()
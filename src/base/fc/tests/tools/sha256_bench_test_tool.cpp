@@ -0,0 +1,63 @@
+#include <fc/crypto/sha256.hpp>
+
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <vector>
+
+// Compares sha256::hash called per message with every hash_many backend the CPU supports,
+// on 64 byte messages (one merkle tree level) and 32 byte messages (single digests).
+
+static double seconds_since( std::chrono::steady_clock::time_point start )
+{
+   return std::chrono::duration< double >( std::chrono::steady_clock::now() - start ).count();
+}
+
+static void report( const char* name, uint32_t size, size_t hashes, double secs )
+{
+   std::cout << std::left << std::setw( 10 ) << name
+             << std::right << std::setw( 6 ) << size << " bytes  "
+             << std::fixed << std::setprecision( 2 ) << std::setw( 10 ) << hashes / secs / 1e6 << " Mhash/s  "
+             << std::setw( 10 ) << hashes * double( size ) / secs / ( 1 << 20 ) << " MiB/s" << std::endl;
+}
+
+int main( int argc, char** argv )
+{
+   size_t count = argc > 1 ? std::strtoull( argv[1], nullptr, 10 ) : 4096;
+   int rounds = argc > 2 ? std::atoi( argv[2] ) : 200;
+
+   std::vector< char > data( count * 64 );
+   for( size_t i = 0; i < data.size(); i++ )
+      data[i] = char( i * 31 + 7 );
+   std::vector< fc::sha256 > out( count );
+
+   const fc::sha256::backend original = fc::sha256::active_backend();
+   std::cout << "default backend: " << fc::sha256::backend_name( original ) << ", "
+             << count << " messages x " << rounds << " rounds" << std::endl;
+
+   for( uint32_t size : { 32u, 64u } )
+   {
+      auto start = std::chrono::steady_clock::now();
+      for( int r = 0; r < rounds; r++ )
+         for( size_t i = 0; i < count; i++ )
+            out[i] = fc::sha256::hash( data.data() + i * size, size );
+      report( "hash", size, count * rounds, seconds_since( start ) );
+
+      for( auto b : { fc::sha256::generic_backend, fc::sha256::shani_backend, fc::sha256::avx2_backend } )
+      {
+         if( !fc::sha256::backend_supported( b ) )
+            continue;
+
+         fc::sha256::set_backend( b );
+         start = std::chrono::steady_clock::now();
+         for( int r = 0; r < rounds; r++ )
+            fc::sha256::hash_many( data.data(), size, count, out.data() );
+         report( fc::sha256::backend_name( b ), size, count * rounds, seconds_since( start ) );
+      }
+   }
+
+   fc::sha256::set_backend( original );
+   return 0;
+}
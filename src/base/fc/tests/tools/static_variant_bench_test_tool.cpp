@@ -0,0 +1,104 @@
+#include <fc/static_variant.hpp>
+
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <utility>
+#include <vector>
+
+// Compares fc::static_variant::visit, which dispatches through a table indexed by the tag, with
+// the recursive tag comparison it replaced, on a variant with as many alternatives as
+// zattera::protocol::operation. Tags are random, as they are when replaying blocks.
+
+template< size_t N >
+struct alternative
+{
+   uint64_t value = N;
+};
+
+template< size_t... I >
+fc::static_variant< alternative< I >... > make_variant( std::index_sequence< I... > );
+
+static const size_t alternative_count = 48;
+typedef decltype( make_variant( std::make_index_sequence< alternative_count >() ) ) bench_variant;
+
+struct sum_visitor
+{
+   typedef uint64_t result_type;
+
+   template< size_t N >
+   uint64_t operator()( const alternative< N >& a )const { return a.value * ( N + 1 ); }
+};
+
+// The dispatch static_variant used before, one comparison per preceding alternative
+template< int64_t N, typename... Ts >
+struct recursive_dispatch;
+
+template< int64_t N, typename T, typename... Ts >
+struct recursive_dispatch< N, T, Ts... >
+{
+   template< typename Variant, typename Visitor >
+   static typename Visitor::result_type apply( const Variant& v, const Visitor& visitor )
+   {
+      if( v.which() == N )
+         return visitor( v.template get< T >() );
+      return recursive_dispatch< N + 1, Ts... >::apply( v, visitor );
+   }
+};
+
+template< int64_t N >
+struct recursive_dispatch< N >
+{
+   template< typename Variant, typename Visitor >
+   static typename Visitor::result_type apply( const Variant&, const Visitor& )
+   {
+      FC_THROW_EXCEPTION( fc::assert_exception, "Internal error: static_variant tag is invalid." );
+   }
+};
+
+template< size_t... I >
+uint64_t recursive_visit( const bench_variant& v, std::index_sequence< I... > )
+{
+   return recursive_dispatch< 0, alternative< I >... >::apply( v, sum_visitor() );
+}
+
+template< typename Visit >
+static void run( const char* name, const std::vector< bench_variant >& variants, int rounds, Visit&& visit )
+{
+   uint64_t sum = 0;
+   auto start = std::chrono::steady_clock::now();
+   for( int r = 0; r < rounds; r++ )
+      for( const auto& v : variants )
+         sum += visit( v );
+   double secs = std::chrono::duration< double >( std::chrono::steady_clock::now() - start ).count();
+   double visits = double( variants.size() ) * rounds;
+
+   std::cout << std::left << std::setw( 12 ) << name << std::right
+             << std::fixed << std::setprecision( 2 ) << std::setw( 8 ) << secs * 1e9 / visits << " ns/visit"
+             << "  (checksum " << sum << ")" << std::endl;
+}
+
+int main( int argc, char** argv )
+{
+   size_t count = argc > 1 ? std::strtoull( argv[1], nullptr, 10 ) : 100000;
+   int rounds = argc > 2 ? std::atoi( argv[2] ) : 200;
+
+   std::mt19937 rng( 42 );
+   std::uniform_int_distribution< int64_t > tags( 0, alternative_count - 1 );
+   std::vector< bench_variant > variants( count );
+   for( auto& v : variants )
+      v.set_which( tags( rng ) );
+
+   std::cout << alternative_count << " alternatives, " << count << " variants x " << rounds << " rounds" << std::endl;
+
+   run( "table", variants, rounds, []( const bench_variant& v ) { return v.visit( sum_visitor() ); } );
+   run( "recursive", variants, rounds, []( const bench_variant& v )
+   {
+      return recursive_visit( v, std::make_index_sequence< alternative_count >() );
+   } );
+
+   return 0;
+}
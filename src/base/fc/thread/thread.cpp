@@ -1,8 +1,11 @@
 #include <fc/thread/thread.hpp>
+#include <fc/thread/task_profile.hpp>
 #include <fc/vector.hpp>
 #include <fc/io/sstream.hpp>
 #include <fc/log/logger.hpp>
 #include "thread_d.hpp"
+#include <algorithm>
+#include <map>
 
 #if defined(_MSC_VER) && !defined(NDEBUG)
 # include <windows.h>
@@ -148,6 +151,71 @@ namespace fc {
 
    void          thread::debug( const fc::string& d ) { /*my->debug(d);*/ }
 
+   void thread::set_profiling( bool enabled, const microseconds& long_slice_threshold )
+   {
+     if (!is_current())
+     {
+       async([=](){ set_profiling(enabled, long_slice_threshold); }, "thread::set_profiling").wait();
+       return;
+     }
+     if( enabled && !my->profiling )
+       my->reset_profile();
+     my->long_slice_threshold = long_slice_threshold;
+     my->profiling = enabled;
+   }
+
+   bool thread::is_profiling()const
+   {
+     return my->profiling.load( boost::memory_order_relaxed );
+   }
+
+   thread_profile thread::get_profile( bool reset )
+   {
+     if (!is_current())
+       return async([=](){ return get_profile(reset); }, "thread::get_profile").wait();
+
+     thread_profile result;
+     result.thread_name = my->name;
+     result.since = my->profiling_since;
+     result.long_slice_threshold = my->long_slice_threshold;
+     result.context_switches = my->context_switches;
+
+     // the same description may be stored at different addresses, merge those
+     std::map< std::string, thread_d::task_counters > by_name;
+     for( const auto& entry : my->task_counters_by_desc )
+     {
+       thread_d::task_counters& merged = by_name[ entry.first ];
+       merged.runs += entry.second.runs;
+       merged.slices += entry.second.slices;
+       merged.long_slices += entry.second.long_slices;
+       merged.run_time += entry.second.run_time;
+       merged.ready_time += entry.second.ready_time;
+       merged.longest_slice = std::max( merged.longest_slice, entry.second.longest_slice );
+     }
+
+     result.tasks.reserve( by_name.size() );
+     for( const auto& entry : by_name )
+     {
+       task_profile task;
+       task.description = entry.first;
+       task.runs = entry.second.runs;
+       task.slices = entry.second.slices;
+       task.long_slices = entry.second.long_slices;
+       task.run_time = microseconds( entry.second.run_time );
+       task.ready_time = microseconds( entry.second.ready_time );
+       task.longest_slice = microseconds( entry.second.longest_slice );
+       result.tasks.push_back( std::move( task ) );
+     }
+     std::sort( result.tasks.begin(), result.tasks.end(), []( const task_profile& a, const task_profile& b )
+     {
+       return a.run_time > b.run_time;
+     });
+
+     if( reset )
+       my->reset_profile();
+     return result;
+   }
+
   void thread::quit(fc::promise<void>* quitDone /*= nullptr*/)
   {
     //if quitting from a different thread, start quit task on thread.
@@ -346,6 +414,11 @@ namespace fc {
    void thread::async_task( task_base* t, const priority& p, const time_point& tp ) {
       assert(my);
       t->_when = tp;
+      if( my->profiling.load( boost::memory_order_relaxed ) )
+      {
+         time_point now = time_point::now();
+         t->_ready_time = tp > now ? tp : now;
+      }
      // slog( "when %lld", t->_when.time_since_epoch().count() );
      // slog( "delay %lld", (tp - fc::time_point::now()).count() );
       task_base* stale_head = my->task_in_queue.load(boost::memory_order_relaxed);
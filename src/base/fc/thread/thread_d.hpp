@@ -6,6 +6,7 @@
 #include <boost/thread/condition_variable.hpp>
 #include <boost/thread.hpp>
 #include <boost/atomic.hpp>
+#include <unordered_map>
 #include <vector>
 //#include <fc/logger.hpp>
 
@@ -28,7 +29,9 @@ namespace fc {
              current(0),
              pt_head(0),
              blocked(0),
-             next_unused_task_storage_slot(0)
+             next_unused_task_storage_slot(0),
+             profiling(false),
+             context_switches(0)
 #ifndef NDEBUG
              ,non_preemptable_scope_count(0)
 #endif
@@ -98,6 +101,25 @@ namespace fc {
            std::vector<detail::specific_data_info> non_task_specific_data;
            unsigned next_unused_task_storage_slot;
 
+           // scheduler statistics, only collected while profiling is set (see thread::set_profiling)
+           struct task_counters
+           {
+              uint64_t runs = 0;
+              uint64_t slices = 0;
+              uint64_t long_slices = 0;
+              int64_t  run_time = 0;
+              int64_t  ready_time = 0;
+              int64_t  longest_slice = 0;
+           };
+
+           boost::atomic<bool>      profiling;
+           fc::microseconds         long_slice_threshold;
+           time_point               profiling_since;
+           time_point               slice_start; // when the running fiber was switched in or last charged
+           uint64_t                 context_switches;
+           // keyed by the task description pointer, descriptions are string literals
+           std::unordered_map<const char*, task_counters> task_counters_by_desc;
+
 #ifndef NDEBUG
            unsigned                 non_preemptable_scope_count;
 #endif
@@ -147,6 +169,66 @@ namespace fc {
               fc::cerr<<"-------------------------------------------------\n";
            }
 #endif
+           task_counters& counters_for( const fc::context* c )
+           {
+              const char* desc = c && c->cur_task ? c->cur_task->get_desc() : nullptr;
+              return task_counters_by_desc[ desc ? desc : "[no task]" ];
+           }
+
+           void reset_profile()
+           {
+              task_counters_by_desc.clear();
+              context_switches = 0;
+              profiling_since = slice_start = time_point::now();
+           }
+
+           // charges the time since slice_start to the task running on c
+           void profile_end_slice( const fc::context* c, const time_point& now )
+           {
+              task_counters& counters = counters_for( c );
+              int64_t slice = ( now - slice_start ).count();
+              ++counters.slices;
+              counters.run_time += slice;
+              if( slice > counters.longest_slice )
+                counters.longest_slice = slice;
+              if( slice > long_slice_threshold.count() )
+                ++counters.long_slices;
+              slice_start = now;
+           }
+
+           void profile_ready_wait( task_counters& counters, time_point& ready_time, const time_point& now )
+           {
+              if( ready_time != time_point() )
+              {
+                counters.ready_time += ( now - ready_time ).count();
+                ready_time = time_point();
+              }
+           }
+
+           // called right before switching from the prev fiber to next
+           void profile_switch( fc::context* prev, fc::context* next )
+           {
+              time_point now = time_point::now();
+              profile_end_slice( prev, now );
+              profile_ready_wait( counters_for( next ), next->ready_time, now );
+              ++context_switches;
+           }
+
+           // called when the running fiber picks up a new task
+           void profile_task_start( task_base* t )
+           {
+              time_point now = time_point::now();
+              profile_end_slice( current, now );
+              profile_ready_wait( task_counters_by_desc[ t->get_desc() ? t->get_desc() : "[no task]" ], t->_ready_time, now );
+           }
+
+           // called when the task running on the current fiber completes
+           void profile_task_end()
+           {
+              profile_end_slice( current, time_point::now() );
+              ++counters_for( current ).runs;
+           }
+
             // insert at from of blocked linked list
            inline void add_to_blocked( fc::context* c )
            {
@@ -181,6 +263,7 @@ namespace fc {
            {
 
              context_to_add->context_posted_num = next_posted_num++;
+             context_to_add->ready_time = profiling.load( boost::memory_order_relaxed ) ? time_point::now() : time_point();
              ready_heap.push_back(context_to_add);
              std::push_heap(ready_heap.begin(), ready_heap.end(), task_priority_less());
            }
@@ -391,6 +474,8 @@ namespace fc {
 
                 // jump to next context, saving current context
                 fc::context* prev = current;
+                if( profiling.load( boost::memory_order_relaxed ) )
+                  profile_switch( prev, next );
                 current = next;
                 if (reschedule)
                 {
@@ -436,6 +521,8 @@ namespace fc {
                                           &fc::thread::current() );
                 }
 
+                if( profiling.load( boost::memory_order_relaxed ) )
+                  profile_switch( prev, next );
                 current = next;
                 if( reschedule )
                 {
@@ -507,10 +594,14 @@ namespace fc {
            void run_next_task()
            {
               task_base* next = dequeue();
+              if( profiling.load( boost::memory_order_relaxed ) )
+                profile_task_start( next );
 
               next->_set_active_context( current );
               current->cur_task = next;
               next->run();
+              if( profiling.load( boost::memory_order_relaxed ) )
+                profile_task_end();
               current->cur_task = 0;
               next->_set_active_context(0);
               next->release();
@@ -585,6 +676,11 @@ namespace fc {
 
                   if( done )
                     return;
+
+                  // time spent idle is not charged to anything
+                  bool profile = profiling.load( boost::memory_order_relaxed );
+                  if( profile )
+                    profile_end_slice( current, time_point::now() );
                   if( timeout_time == time_point::maximum() )
                     task_ready.wait( lock );
                   else if( timeout_time != time_point::min() )
@@ -612,6 +708,9 @@ namespace fc {
                     task_ready.wait_until( lock, boost::chrono::steady_clock::now() +
                                                  boost::chrono::microseconds(timeout_time.time_since_epoch().count() - time_point::now().time_since_epoch().count()) );
                   }
+
+                  if( profile )
+                    slice_start = time_point::now();
                 }
               }
            }
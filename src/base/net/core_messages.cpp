@@ -22,6 +22,7 @@
  * THE SOFTWARE.
  */
 #include <graphene/net/core_messages.hpp>
+#include <cstring>
 
 
 namespace graphene { namespace net {
@@ -45,6 +46,18 @@ namespace graphene { namespace net {
   const core_message_type_enum check_firewall_reply_message::type            = core_message_type_enum::check_firewall_reply_message_type;
   const core_message_type_enum get_current_connections_request_message::type = core_message_type_enum::get_current_connections_request_message_type;
   const core_message_type_enum get_current_connections_reply_message::type   = core_message_type_enum::get_current_connections_reply_message_type;
+  const core_message_type_enum transport_upgrade_message::type               = core_message_type_enum::transport_upgrade_message_type;
+  const core_message_type_enum compact_block_message::type                   = core_message_type_enum::compact_block_message_type;
+  const core_message_type_enum fetch_block_transactions_message::type        = core_message_type_enum::fetch_block_transactions_message_type;
+  const core_message_type_enum block_transactions_message::type              = core_message_type_enum::block_transactions_message_type;
+
+  uint64_t compact_short_id( const item_hash_t& transaction_message_hash )
+  {
+    uint64_t short_id;
+    static_assert( sizeof( transaction_message_hash._hash ) >= sizeof( short_id ), "item hash is too short" );
+    memcpy( &short_id, transaction_message_hash._hash, sizeof( short_id ) );
+    return short_id;
+  }
 
 } } // graphene::net
 
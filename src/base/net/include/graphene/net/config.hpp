@@ -79,6 +79,12 @@
 
 #define GRAPHENE_NET_MAX_INVENTORY_SIZE_IN_MINUTES           2
 
+/**
+ * Inventory lists are expired in steps of this many seconds (see timestamped_item_set),
+ * so an item stays in a list for up to this much longer than the times above
+ */
+#define GRAPHENE_NET_INVENTORY_BUCKET_DURATION_SECONDS       5
+
 #define GRAPHENE_NET_MAX_BLOCKS_PER_PEER_DURING_SYNCING      200
 
 /**
@@ -137,3 +143,16 @@
 #define GRAPHENE_NET_PORT_WAIT_DELAY_SECONDS                   5
 
 #define GRAPHENE_NET_MAX_PEERDB_SIZE                           1000
+
+/**
+ * The peer database is a log of updates that is rewritten, keeping only the latest record
+ * for each peer, once it holds this many more entries than peers
+ */
+#define GRAPHENE_NET_PEERDB_COMPACTION_THRESHOLD               1000
+
+/**
+ * Peers are ranked for connecting and syncing against these, a peer we have no measurements
+ * for is assumed to perform at exactly this level
+ */
+#define GRAPHENE_NET_PEER_SCORE_REFERENCE_LATENCY_MS           500
+#define GRAPHENE_NET_PEER_SCORE_REFERENCE_BYTES_PER_SECOND     (1024 * 1024)
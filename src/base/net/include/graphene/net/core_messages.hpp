@@ -86,6 +86,10 @@ namespace graphene { namespace net {
     check_firewall_reply_message_type            = 5015,
     get_current_connections_request_message_type = 5016,
     get_current_connections_reply_message_type   = 5017,
+    transport_upgrade_message_type               = 5018,
+    compact_block_message_type                   = 5019,
+    fetch_block_transactions_message_type        = 5020,
+    block_transactions_message_type              = 5021,
     core_message_type_last                       = 5099
   };
 
@@ -397,6 +401,76 @@ namespace graphene { namespace net {
     std::vector<current_connection_data> current_connections;
   };
 
+  /**
+   *  Sent only to peers whose hello advertised sealed_transport_name. It is the last message the
+   *  sender writes in the AES-CBC stream, everything after it is written as AES-256-GCM sealed
+   *  frames, see stcp_socket. It is consumed by message_oriented_connection and never reaches
+   *  the node.
+   */
+  struct transport_upgrade_message
+  {
+    static const core_message_type_enum type;
+  };
+
+  /// Value of the "transport" hello user_data field of nodes accepting transport_upgrade_message
+  const char* const sealed_transport_name = "aes-256-gcm";
+
+  /**
+   *  Short id of a transaction in a compact_block_message: the first 8 bytes of the hash of the
+   *  trx_message carrying it, which is how the transaction is known in inventory and in the
+   *  message cache.
+   */
+  uint64_t compact_short_id( const item_hash_t& transaction_message_hash );
+
+  struct prefilled_transaction
+  {
+    uint32_t           index = 0;   ///< position of the transaction in the block
+    signed_transaction trx;
+  };
+
+  /**
+   *  A block_message sent as its header and a short id for every transaction, in reply to a
+   *  fetch_items_message for compact_block_message_type from a peer whose hello user_data has
+   *  "compact_blocks" set. Transactions the sender does not believe the peer has seen are sent
+   *  in full in prefilled_transactions; the short ids cover the remaining positions in order.
+   *
+   *  The receiver fills in the transactions from its message cache, requests the ones it is
+   *  missing with a fetch_block_transactions_message and accepts the rebuilt block only if the
+   *  block_message it packs to hashes to item_hash.
+   */
+  struct compact_block_message
+  {
+    static const core_message_type_enum type;
+
+    item_hash_t                               item_hash;   ///< hash of the block_message this stands for
+    block_id_type                             block_id;
+    zattera::protocol::signed_block_header    header;
+    std::vector<uint64_t>                     short_transaction_ids;
+    std::vector<prefilled_transaction>        prefilled_transactions;
+  };
+
+  struct fetch_block_transactions_message
+  {
+    static const core_message_type_enum type;
+
+    item_hash_t           item_hash;
+    std::vector<uint32_t> transaction_indexes;
+
+    fetch_block_transactions_message() {}
+    fetch_block_transactions_message(const item_hash_t& item_hash, std::vector<uint32_t> transaction_indexes) :
+      item_hash(item_hash),
+      transaction_indexes(std::move(transaction_indexes))
+    {}
+  };
+
+  struct block_transactions_message
+  {
+    static const core_message_type_enum type;
+
+    item_hash_t                     item_hash;
+    std::vector<signed_transaction> transactions;   ///< in the order they were requested
+  };
+
 
 } } // graphene::net
 
@@ -421,6 +495,10 @@ FC_REFLECT_ENUM( graphene::net::core_message_type_enum,
                  (check_firewall_reply_message_type)
                  (get_current_connections_request_message_type)
                  (get_current_connections_reply_message_type)
+                 (transport_upgrade_message_type)
+                 (compact_block_message_type)
+                 (fetch_block_transactions_message_type)
+                 (block_transactions_message_type)
                  (core_message_type_last) )
 
 FC_REFLECT( graphene::net::trx_message, (trx) )
@@ -497,6 +575,15 @@ FC_REFLECT(graphene::net::current_connection_data, (connection_duration)
                                               (connection_direction)
                                               (firewalled)
                                               (user_data))
+FC_REFLECT_EMPTY(graphene::net::transport_upgrade_message)
+FC_REFLECT(graphene::net::prefilled_transaction, (index)(trx))
+FC_REFLECT(graphene::net::compact_block_message, (item_hash)
+                                                 (block_id)
+                                                 (header)
+                                                 (short_transaction_ids)
+                                                 (prefilled_transactions))
+FC_REFLECT(graphene::net::fetch_block_transactions_message, (item_hash)(transaction_indexes))
+FC_REFLECT(graphene::net::block_transactions_message, (item_hash)(transactions))
 FC_REFLECT(graphene::net::get_current_connections_reply_message, (upload_rate_one_minute)
                                                             (download_rate_one_minute)
                                                             (upload_rate_fifteen_minutes)
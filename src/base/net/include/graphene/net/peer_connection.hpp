@@ -27,6 +27,7 @@
 #include <graphene/net/peer_database.hpp>
 #include <graphene/net/message_oriented_connection.hpp>
 #include <graphene/net/stcp_socket.hpp>
+#include <graphene/net/timestamped_item_set.hpp>
 #include <graphene/net/config.hpp>
 
 #include <boost/tuple/tuple.hpp>
@@ -208,6 +209,7 @@ namespace graphene { namespace net
       fc::optional<std::string> platform;
       fc::optional<uint32_t> bitness;
       fc::optional<zattera::protocol::chain_id_type> chain_id;
+      bool             supports_compact_blocks = false; /// set from the "compact_blocks" field of the hello user_data
 
       // for inbound connections, these fields record what the peer sent us in
       // its hello message.  For outbound, they record what we sent the peer
@@ -234,31 +236,33 @@ namespace graphene { namespace net
       bool inhibit_fetching_sync_blocks = false;
       /// @}
 
+      /// how the current batch of sync blocks is going, folded into the peer's potential_peer_record
+      /// once the whole batch has arrived
+      /// @{
+      fc::time_point sync_batch_start_time;
+      uint64_t sync_batch_bytes_received = 0;
+      uint32_t sync_batch_blocks_received = 0;
+      fc::microseconds sync_batch_total_latency;
+      /// @}
+
       /// latency timing data
       std::unordered_map< item_hash_t, fc::time_point > pending_item_request_times;
       /// @}
 
       /// non-synchronization state data
       /// @{
-      struct timestamped_item_id
-      {
-        item_id            item;
-        fc::time_point_sec timestamp;
-        timestamped_item_id(const item_id& item, const fc::time_point_sec timestamp) :
-          item(item),
-          timestamp(timestamp)
-        {}
-      };
-      struct timestamp_index{};
-      typedef boost::multi_index_container<timestamped_item_id,
-                                           boost::multi_index::indexed_by<boost::multi_index::hashed_unique<boost::multi_index::member<timestamped_item_id, item_id, &timestamped_item_id::item>,
-                                                                                                            std::hash<item_id> >,
-                                                                          boost::multi_index::ordered_non_unique<boost::multi_index::tag<timestamp_index>,
-                                                                                                                 boost::multi_index::member<timestamped_item_id, fc::time_point_sec, &timestamped_item_id::timestamp> > > > timestamped_items_set_type;
-      timestamped_items_set_type inventory_peer_advertised_to_us;
-      timestamped_items_set_type inventory_advertised_to_peer;
+      timestamped_item_set inventory_peer_advertised_to_us;
+      timestamped_item_set inventory_advertised_to_peer;
 
       item_to_time_map_type items_requested_from_peer;  /// items we've requested from this peer during normal operation.  fetch from another peer if this peer disconnects
+
+      /** a block this peer sent us as a compact_block_message, waiting for the transactions we asked for */
+      struct partial_compact_block
+      {
+        block_message         block;
+        std::vector<uint32_t> missing_transaction_indexes;
+      };
+      std::unordered_map<item_hash_t, partial_compact_block> compact_blocks_being_rebuilt; /// keyed by the hash of the block_message
       /// @}
 
       // if they're flooding us with transactions, we set this to avoid fetching for a few seconds to let the
@@ -346,5 +350,3 @@ FC_REFLECT_ENUM(graphene::net::peer_connection::connection_negotiation_status, (
                                                                           (negotiation_complete)
                                                                           (closing)
                                                                           (closed) )
-
-FC_REFLECT( graphene::net::peer_connection::timestamped_item_id, (item)(timestamp));
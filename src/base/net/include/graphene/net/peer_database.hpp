@@ -53,6 +53,13 @@ namespace graphene { namespace net {
     uint32_t                          number_of_failed_connection_attempts;
     fc::optional<fc::exception>       last_error;
 
+    /// measured performance, all zero until we have received blocks from the peer
+    /// @{
+    uint32_t                          number_of_blocks_delivered = 0;
+    uint32_t                          average_block_latency_ms = 0;      /// from requesting a block to receiving it
+    uint32_t                          average_sync_bytes_per_second = 0; /// over whole batches of sync blocks
+    /// @}
+
     potential_peer_record() :
       number_of_successful_connection_attempts(0),
     number_of_failed_connection_attempts(0){}
@@ -66,6 +73,16 @@ namespace graphene { namespace net {
       number_of_successful_connection_attempts(0),
       number_of_failed_connection_attempts(0)
     {}  
+
+    /** folds blocks received from the peer into the moving averages above */
+    void record_block_deliveries(uint32_t block_count, fc::microseconds average_latency);
+    void record_sync_throughput(uint64_t bytes_received, fc::microseconds elapsed);
+
+    /**
+     * How much we'd like to be connected to this peer, higher is better.  Combines the share of
+     * connection attempts that succeeded with the measured latency and sync throughput.
+     */
+    double score() const;
   };
 
   namespace detail
@@ -112,6 +129,9 @@ namespace graphene { namespace net {
     iterator begin() const;
     iterator end() const;
     size_t size() const;
+
+    /** all records, best score first */
+    std::vector<potential_peer_record> get_ranked_records() const;
   private:
     std::unique_ptr<detail::peer_database_impl> my;
   };
@@ -119,4 +139,5 @@ namespace graphene { namespace net {
 } } // end namespace graphene::net
 
 FC_REFLECT_ENUM(graphene::net::potential_peer_last_connection_disposition, (never_attempted_to_connect)(last_connection_failed)(last_connection_rejected)(last_connection_handshaking_failed)(last_connection_succeeded))
-FC_REFLECT(graphene::net::potential_peer_record, (endpoint)(last_seen_time)(last_connection_disposition)(last_connection_attempt_time)(number_of_successful_connection_attempts)(number_of_failed_connection_attempts)(last_error) )
+FC_REFLECT(graphene::net::potential_peer_record, (endpoint)(last_seen_time)(last_connection_disposition)(last_connection_attempt_time)(number_of_successful_connection_attempts)(number_of_failed_connection_attempts)(last_error)
+                                             (number_of_blocks_delivered)(average_block_latency_ms)(average_sync_bytes_per_second) )
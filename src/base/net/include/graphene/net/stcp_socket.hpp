@@ -26,11 +26,21 @@
 #include <fc/crypto/aes.hpp>
 #include <fc/crypto/elliptic.hpp>
 
+#include <initializer_list>
+#include <memory>
+#include <vector>
+
 namespace graphene { namespace net {
 
 /**
  *  Uses ECDH to negotiate a aes key for communicating
  *  with other nodes on the network.
+ *
+ *  The stream starts out AES-CBC encrypted in 16 byte blocks. Each direction can be switched
+ *  to sealed frames once both ends agree to: AES-256-GCM authenticated frames holding
+ *  <plaintext size (uint32, authenticated)> <ciphertext> <16 bytes tag>, with one key per
+ *  direction derived from the shared secret. Frames are encrypted straight from and into the
+ *  caller's buffers, without padding or intermediate copies.
  */
 class stcp_socket : public virtual fc::iostream
 {
@@ -56,8 +66,30 @@ class stcp_socket : public virtual fc::iostream
     using istream::get;
     void             get( char& c ) { read( &c, 1 ); }
     fc::sha512       get_shared_secret() const { return _shared_secret; }
+
+    struct frame_part          { const char* data; size_t size; };
+    struct mutable_frame_part  { char* data; size_t size; };
+
+    /// Everything written after this call must be written with write_sealed_frame()
+    void             enable_sealed_writes();
+    /// Everything read after this call must be read with read_sealed_frame_size() and read_sealed_frame()
+    void             enable_sealed_reads();
+    bool             sealed_writes()const { return (bool)_send_gcm; }
+    bool             sealed_reads()const  { return (bool)_recv_gcm; }
+
+    /// Writes one frame holding the concatenation of parts, returns the number of bytes sent
+    size_t           write_sealed_frame( std::initializer_list< frame_part > parts );
+    /// Reads the size of the next frame, which is authenticated by the following read_sealed_frame()
+    uint32_t         read_sealed_frame_size();
+    /**
+     *  Reads and decrypts the frame into parts, whose sizes must add up to the frame size, and
+     *  verifies it. Throws, leaving garbage in parts, if the frame was modified. Returns the
+     *  number of bytes received for the frame, including its size.
+     */
+    size_t           read_sealed_frame( std::initializer_list< mutable_frame_part > parts );
   private:
     void do_key_exchange();
+    fc::sha256 sealed_frame_key( const fc::ecc::public_key_data& sender )const;
 
     fc::sha512           _shared_secret;
     fc::ecc::private_key _priv_key;
@@ -68,6 +100,13 @@ class stcp_socket : public virtual fc::iostream
     fc::aes_decoder      _recv_aes;
     std::shared_ptr<char> _read_buffer;
     std::shared_ptr<char> _write_buffer;
+
+    fc::ecc::public_key_data _local_public_key;
+    fc::ecc::public_key_data _remote_public_key;
+    std::unique_ptr<fc::aes_gcm_encoder> _send_gcm;
+    std::unique_ptr<fc::aes_gcm_decoder> _recv_gcm;
+    std::vector<char>     _frame_buffer;
+    uint32_t              _sealed_frame_size = 0;
 #ifndef NDEBUG
     bool _read_buffer_in_use;
     bool _write_buffer_in_use;
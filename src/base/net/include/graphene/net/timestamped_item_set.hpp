@@ -0,0 +1,53 @@
+#pragma once
+
+#include <graphene/net/config.hpp>
+#include <graphene/net/core_messages.hpp>
+
+#include <fc/time.hpp>
+
+#include <deque>
+#include <unordered_map>
+#include <vector>
+
+namespace graphene { namespace net {
+
+  /**
+   * A set of item ids that remembers roughly when each item was added.  Used for the inventory we
+   * exchange with each peer and for the items that recently failed to push, where the only questions
+   * asked are "is this item in the set" and "forget everything older than this".
+   *
+   * Items are appended to buckets covering a fixed number of seconds each, so expiring old items drops
+   * whole buckets from the front instead of walking an ordered index that has to be updated on every
+   * insert.  A timestamp is only as precise as its bucket: an item is kept up to one bucket duration
+   * longer than asked.
+   */
+  class timestamped_item_set
+  {
+  public:
+    explicit timestamped_item_set(uint32_t bucket_duration_in_seconds = GRAPHENE_NET_INVENTORY_BUCKET_DURATION_SECONDS);
+
+    /** returns false, and leaves the item's timestamp alone, if the item is already in the set */
+    bool insert(const item_id& item, fc::time_point_sec timestamp);
+    bool contains(const item_id& item) const { return _items.find(item) != _items.end(); }
+    bool erase(const item_id& item) { return _items.erase(item) != 0; }
+
+    /** removes the items added before oldest_timestamp_to_keep and returns how many there were */
+    size_t erase_older_than(fc::time_point_sec oldest_timestamp_to_keep);
+    void clear();
+
+    size_t size() const { return _items.size(); }
+    bool empty() const { return _items.empty(); }
+
+  private:
+    struct bucket
+    {
+      uint32_t             start_time;
+      std::vector<item_id> items; /// may still hold items erased since, they are skipped when the bucket expires
+    };
+
+    uint32_t                              _bucket_duration;
+    std::unordered_map<item_id, uint32_t> _items; /// start_time of the bucket each item is in
+    std::deque<bucket>                    _buckets;
+  };
+
+} } // graphene::net
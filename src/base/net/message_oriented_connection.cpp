@@ -29,6 +29,7 @@
 #include <fc/io/enum_type.hpp>
 
 #include <graphene/net/message_oriented_connection.hpp>
+#include <graphene/net/core_messages.hpp>
 #include <graphene/net/stcp_socket.hpp>
 #include <graphene/net/config.hpp>
 
@@ -68,6 +69,7 @@ namespace graphene { namespace net {
 #endif
 
       void read_loop();
+      void read_message(message& m);
       void start_read_loop();
     public:
       fc::tcp_socket& get_socket();
@@ -138,13 +140,47 @@ namespace graphene { namespace net {
       _sock.bind(local_endpoint);
     }
 
-    void message_oriented_connection_impl::read_loop()
+    void message_oriented_connection_impl::read_message(message& m)
     {
-      VERIFY_CORRECT_THREAD();
+      if (_sock.sealed_reads())
+      {
+        // the header and the data are decrypted in place, straight into the message
+        uint32_t frame_size = _sock.read_sealed_frame_size();
+        FC_ASSERT( frame_size >= sizeof(message_header) && frame_size - sizeof(message_header) <= MAX_MESSAGE_SIZE,
+                   "", ("frame_size",frame_size)("MAX_MESSAGE_SIZE",MAX_MESSAGE_SIZE) );
+        m.data.resize(frame_size - sizeof(message_header));
+        _bytes_received += _sock.read_sealed_frame({ { (char*)static_cast<message_header*>(&m), sizeof(message_header) },
+                                                     { m.data.data(), m.data.size() } });
+        FC_ASSERT( m.size == m.data.size(), "", ("m.size",m.size)("frame_size",frame_size) );
+        return;
+      }
+
       const int BUFFER_SIZE = 16;
       const int LEFTOVER = BUFFER_SIZE - sizeof(message_header);
       static_assert(BUFFER_SIZE >= sizeof(message_header), "insufficient buffer");
 
+      char buffer[BUFFER_SIZE];
+      _sock.read(buffer, BUFFER_SIZE);
+      _bytes_received += BUFFER_SIZE;
+      memcpy((char*)&m, buffer, sizeof(message_header));
+
+      FC_ASSERT( m.size <= MAX_MESSAGE_SIZE, "", ("m.size",m.size)("MAX_MESSAGE_SIZE",MAX_MESSAGE_SIZE) );
+
+      size_t remaining_bytes_with_padding = 16 * ((m.size - LEFTOVER + 15) / 16);
+      m.data.resize(LEFTOVER + remaining_bytes_with_padding); //give extra 16 bytes to allow for padding added in send call
+      std::copy(buffer + sizeof(message_header), buffer + sizeof(buffer), m.data.begin());
+      if (remaining_bytes_with_padding)
+      {
+        _sock.read(&m.data[LEFTOVER], remaining_bytes_with_padding);
+        _bytes_received += remaining_bytes_with_padding;
+      }
+      m.data.resize(m.size); // truncate off the padding bytes
+    }
+
+    void message_oriented_connection_impl::read_loop()
+    {
+      VERIFY_CORRECT_THREAD();
+
       _connected_time = fc::time_point::now();
 
       fc::oexception exception_to_rethrow;
@@ -155,24 +191,17 @@ namespace graphene { namespace net {
         message m;
         while( true )
         {
-          char buffer[BUFFER_SIZE];
-          _sock.read(buffer, BUFFER_SIZE);
-          _bytes_received += BUFFER_SIZE;
-          memcpy((char*)&m, buffer, sizeof(message_header));
+          read_message(m);
 
-          FC_ASSERT( m.size <= MAX_MESSAGE_SIZE, "", ("m.size",m.size)("MAX_MESSAGE_SIZE",MAX_MESSAGE_SIZE) );
+          _last_message_received_time = fc::time_point::now();
 
-          size_t remaining_bytes_with_padding = 16 * ((m.size - LEFTOVER + 15) / 16);
-          m.data.resize(LEFTOVER + remaining_bytes_with_padding); //give extra 16 bytes to allow for padding added in send call
-          std::copy(buffer + sizeof(message_header), buffer + sizeof(buffer), m.data.begin());
-          if (remaining_bytes_with_padding)
+          if (m.msg_type == transport_upgrade_message_type)
           {
-            _sock.read(&m.data[LEFTOVER], remaining_bytes_with_padding);
-            _bytes_received += remaining_bytes_with_padding;
+            // the peer writes sealed frames from here on
+            if (!_sock.sealed_reads())
+              _sock.enable_sealed_reads();
+            continue;
           }
-          m.data.resize(m.size); // truncate off the padding bytes
-
-          _last_message_received_time = fc::time_point::now();
 
           try
           {
@@ -255,22 +284,35 @@ namespace graphene { namespace net {
 
       try
       {
-        size_t size_of_message_and_header = sizeof(message_header) + message_to_send.size;
         if( message_to_send.size > MAX_MESSAGE_SIZE )
            elog("Trying to send a message larger than MAX_MESSAGE_SIZE. This probably won't work...");
-        //pad the message we send to a multiple of 16 bytes
-        size_t size_with_padding = 16 * ((size_of_message_and_header + 15) / 16);
-        std::unique_ptr<char[]> padded_message(new char[size_with_padding]);
 
-        memcpy(padded_message.get(), (char*)&message_to_send, sizeof(message_header));
-        memcpy(padded_message.get() + sizeof(message_header), message_to_send.data.data(), message_to_send.size );
-        char* paddingSpace = padded_message.get() + sizeof(message_header) + message_to_send.size;
-        size_t toClean = size_with_padding - size_of_message_and_header;
-        memset(paddingSpace, 0, toClean);
-
-        _sock.write(padded_message.get(), size_with_padding);
+        if (_sock.sealed_writes())
+        {
+          // encrypted straight from the header and the serialized message, no padding needed
+          _bytes_sent += _sock.write_sealed_frame({ { (const char*)static_cast<const message_header*>(&message_to_send), sizeof(message_header) },
+                                                    { message_to_send.data.data(), message_to_send.size } });
+        }
+        else
+        {
+          size_t size_of_message_and_header = sizeof(message_header) + message_to_send.size;
+          //pad the message we send to a multiple of 16 bytes
+          size_t size_with_padding = 16 * ((size_of_message_and_header + 15) / 16);
+          std::unique_ptr<char[]> padded_message(new char[size_with_padding]);
+
+          memcpy(padded_message.get(), (char*)&message_to_send, sizeof(message_header));
+          memcpy(padded_message.get() + sizeof(message_header), message_to_send.data.data(), message_to_send.size );
+          char* paddingSpace = padded_message.get() + sizeof(message_header) + message_to_send.size;
+          size_t toClean = size_with_padding - size_of_message_and_header;
+          memset(paddingSpace, 0, toClean);
+
+          _sock.write(padded_message.get(), size_with_padding);
+          _bytes_sent += size_with_padding;
+
+          if (message_to_send.msg_type == transport_upgrade_message_type)
+            _sock.enable_sealed_writes(); // the peer expects sealed frames after this message
+        }
         _sock.flush();
-        _bytes_sent += size_with_padding;
         _last_message_sent_time = fc::time_point::now();
       } FC_RETHROW_EXCEPTIONS( warn, "unable to send message" );
     }
@@ -179,6 +179,7 @@ namespace graphene { namespace net {
                         const message_propagation_data& propagation_data, const fc::uint160_t& message_content_hash );
       message get_message( const message_hash_type& hash_of_message_to_lookup );
       message_propagation_data get_message_propagation_data( const fc::uint160_t& hash_of_message_contents_to_lookup ) const;
+      fc::optional<signed_transaction> get_transaction_by_short_id( uint64_t short_id ) const;
       size_t size() const { return _message_cache.size(); }
     };
 
@@ -223,27 +224,110 @@ namespace graphene { namespace net {
       FC_THROW_EXCEPTION(  fc::key_not_found_exception, "Requested message not in cache" );
     }
 
-    // when requesting items from peers, we want to prioritize any blocks before
-    // transactions, but otherwise request items in the order we heard about them
-    struct prioritized_item_id
+    /**
+     *  Returns the cached transaction whose message hash starts with short_id (see compact_short_id()),
+     *  or nothing if there is none or more than one
+     */
+    fc::optional<signed_transaction> blockchain_tied_message_cache::get_transaction_by_short_id( uint64_t short_id ) const
     {
-      item_id  item;
-      unsigned sequence_number;
-      fc::time_point timestamp; // the time we last heard about this item in an inventory message
+      message_hash_type lowest_matching_hash;
+      memcpy( lowest_matching_hash._hash, &short_id, sizeof( short_id ) );
 
-      prioritized_item_id(const item_id& item, unsigned sequence_number) :
-        item(item),
-        sequence_number(sequence_number),
-        timestamp(fc::time_point::now())
-      {}
-      bool operator<(const prioritized_item_id& rhs) const
+      const auto& hash_index = _message_cache.get<message_hash_index>();
+      fc::optional<signed_transaction> result;
+      for( auto iter = hash_index.lower_bound( lowest_matching_hash );
+           iter != hash_index.end() && compact_short_id( iter->message_hash ) == short_id; ++iter )
+      {
+        if( iter->message_body.msg_type != trx_message_type )
+          continue;
+        if( result )
+          return fc::optional<signed_transaction>();
+        result = iter->message_body.as<trx_message>().trx;
+      }
+      return result;
+    }
+
+    /**
+     * The items we know a peer has and we want.  When requesting items from peers, we want to
+     * prioritize any blocks before transactions, but otherwise request items in the order we heard
+     * about them.
+     *
+     * Each item type has its own queue in arrival order, walked from the highest type down, and a
+     * hash index maps every queued item to its current queue entry.  Erasing an item only removes
+     * it from the index, the entry it leaves in the queue is dropped the next time the queues are
+     * walked.
+     */
+    class items_to_fetch_queue
+    {
+    public:
+      /** returns false if the item is already queued */
+      bool insert(const item_id& item)
       {
         static_assert(graphene::net::block_message_type > graphene::net::trx_message_type,
-                      "block_message_type must be greater than trx_message_type for prioritized_item_ids to sort correctly");
-        if (item.item_type != rhs.item.item_type)
-          return item.item_type > rhs.item.item_type;
-        return (signed)(rhs.sequence_number - sequence_number) > 0;
+                      "block_message_type must be greater than trx_message_type for blocks to be fetched first");
+        uint32_t sequence_number = _next_sequence_number++;
+        if (!_index.emplace(item, index_entry{sequence_number, fc::time_point::now()}).second)
+          return false;
+        _queues[item.item_type].push_back(queue_entry{item, sequence_number});
+        return true;
+      }
+
+      /** records that we just heard about an already queued item again, returns false if it isn't queued */
+      bool update_timestamp(const item_id& item)
+      {
+        auto iter = _index.find(item);
+        if (iter == _index.end())
+          return false;
+        iter->second.timestamp = fc::time_point::now();
+        return true;
+      }
+
+      bool erase(const item_id& item) { return _index.erase(item) != 0; }
+      size_t size() const { return _index.size(); }
+
+      /**
+       * Calls visitor(item, timestamp) for every queued item in the order they should be fetched,
+       * where timestamp is the last time we heard about the item in an inventory message.  Items
+       * for which the visitor returns true are removed.  The visitor must not modify the queue.
+       */
+      template<typename Visitor>
+      void visit(Visitor&& visitor)
+      {
+        for (auto& type_and_queue : _queues)
+        {
+          std::deque<queue_entry>& queue = type_and_queue.second;
+          size_t kept = 0;
+          for (size_t i = 0; i < queue.size(); ++i)
+          {
+            auto iter = _index.find(queue[i].item);
+            if (iter == _index.end() || iter->second.sequence_number != queue[i].sequence_number)
+              continue;
+            if (visitor(queue[i].item, iter->second.timestamp))
+            {
+              _index.erase(iter);
+              continue;
+            }
+            queue[kept++] = queue[i];
+          }
+          queue.resize(kept);
+        }
       }
+
+    private:
+      struct queue_entry
+      {
+        item_id  item;
+        uint32_t sequence_number;
+      };
+      struct index_entry
+      {
+        uint32_t       sequence_number;
+        fc::time_point timestamp; // the time we last heard about this item in an inventory message
+      };
+
+      std::map<uint32_t, std::deque<queue_entry>, std::greater<uint32_t> > _queues; /// by item type, blocks first
+      std::unordered_map<item_id, index_entry>                             _index;
+      uint32_t                                                             _next_sequence_number = 0;
     };
 
 /////////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -385,7 +469,7 @@ namespace graphene { namespace net {
       std::unique_ptr<statistics_gathering_node_delegate_wrapper> _delegate;
 
 #define NODE_CONFIGURATION_FILENAME      "node_config.json"
-#define POTENTIAL_PEER_DATABASE_FILENAME "peers.json"
+#define POTENTIAL_PEER_DATABASE_FILENAME "peers.dat"
       fc::path             _node_configuration_directory;
       node_configuration   _node_configuration;
 
@@ -432,16 +516,11 @@ namespace graphene { namespace net {
       bool                   _items_to_fetch_updated;
       fc::future<void>       _fetch_item_loop_done;
 
-      struct item_id_index{};
-      typedef boost::multi_index_container<prioritized_item_id,
-                                           boost::multi_index::indexed_by<boost::multi_index::ordered_unique<boost::multi_index::identity<prioritized_item_id> >,
-                                                                          boost::multi_index::hashed_unique<boost::multi_index::tag<item_id_index>,
-                                                                                                            boost::multi_index::member<prioritized_item_id, item_id, &prioritized_item_id::item>,
-                                                                                                            std::hash<item_id> > >
-                                           > items_to_fetch_set_type;
-      unsigned _items_to_fetch_sequence_counter;
-      items_to_fetch_set_type _items_to_fetch; /// list of items we know another peer has and we want
-      peer_connection::timestamped_items_set_type _recently_failed_items; /// list of transactions we've recently pushed and had rejected by the delegate
+      items_to_fetch_queue _items_to_fetch; /// list of items we know another peer has and we want
+      timestamped_item_set _recently_failed_items; /// list of transactions we've recently pushed and had rejected by the delegate
+      /// the peer each item in a peer's items_requested_from_peer was requested from, so we don't have to ask every peer.
+      /// entries are not always removed when the request completes, check the peer's list before trusting one
+      std::unordered_map<item_id, std::weak_ptr<peer_connection> > _items_requested_from_peers;
       // @}
 
       /// used by the task that advertises inventory during normal operation
@@ -449,6 +528,7 @@ namespace graphene { namespace net {
       fc::promise<void>::ptr        _retrigger_advertise_inventory_loop_promise;
       fc::future<void>              _advertise_inventory_loop_done;
       std::unordered_set<item_id>   _new_inventory; /// list of items we have received but not yet advertised to our peers
+      timestamped_item_set          _inventory_advertised_to_peers; /// items we have advertised to at least one peer, expired like the peers' inventory
       // @}
 
       fc::future<void>     _terminate_inactive_connections_loop_done;
@@ -552,6 +632,10 @@ namespace graphene { namespace net {
       void fetch_sync_items_loop();
       void trigger_fetch_sync_items_loop();
 
+      double get_peer_score(const peer_connection_ptr& peer);
+      void record_block_delivery(peer_connection* peer, fc::microseconds latency);
+      void record_sync_batch_performance(peer_connection* peer);
+
       bool is_item_in_any_peers_inventory(const item_id& item) const;
       void fetch_items_loop();
       void trigger_fetch_items_loop();
@@ -611,6 +695,16 @@ namespace graphene { namespace net {
       void on_item_not_available_message( peer_connection* originating_peer,
                                           const item_not_available_message& item_not_available_message_received );
 
+      void send_compact_blocks( peer_connection* peer, const std::vector<item_hash_t>& block_message_hashes );
+      void on_compact_block_message( peer_connection* originating_peer,
+                                     const compact_block_message& compact_block_message_received );
+      void on_fetch_block_transactions_message( peer_connection* originating_peer,
+                                                const fetch_block_transactions_message& fetch_block_transactions_message_received );
+      void on_block_transactions_message( peer_connection* originating_peer,
+                                          const block_transactions_message& block_transactions_message_received );
+      void process_rebuilt_compact_block( peer_connection* originating_peer, const item_hash_t& block_message_hash,
+                                          const graphene::net::block_message& rebuilt_block );
+
       void on_item_ids_inventory_message( peer_connection* originating_peer,
                                           const item_ids_inventory_message& item_ids_inventory_message_received );
 
@@ -811,7 +905,6 @@ namespace graphene { namespace net {
       _sync_items_to_fetch_updated(false),
       _suspend_fetching_sync_blocks(false),
       _items_to_fetch_updated(false),
-      _items_to_fetch_sequence_counter(0),
       _recent_block_interval_in_seconds(ZATTERA_BLOCK_INTERVAL),
       _user_agent_string(user_agent),
       _most_recent_blocks_accepted(GRAPHENE_NET_DEFAULT_MAX_CONNECTIONS),
@@ -931,8 +1024,11 @@ namespace graphene { namespace net {
             bool initiated_connection_this_pass = false;
             _potential_peer_database_updated = false;
 
-            for (peer_database::iterator iter = _potential_peer_db.begin();
-                 iter != _potential_peer_db.end() && is_wanting_new_connections();
+            // try the peers that have served us best first, connecting can update their records
+            // so we work from a copy
+            std::vector<potential_peer_record> ranked_peers = _potential_peer_db.get_ranked_records();
+            for (auto iter = ranked_peers.begin();
+                 iter != ranked_peers.end() && is_wanting_new_connections();
                  ++iter)
             {
               fc::microseconds delay_until_retry = fc::seconds((iter->number_of_failed_connection_attempts + 1) * _node_configuration.peer_connection_retry_timeout);
@@ -1031,6 +1127,13 @@ namespace graphene { namespace net {
       VERIFY_CORRECT_THREAD();
       dlog( "requesting ${item_count} item(s) ${items_to_request} from peer ${endpoint}",
             ("item_count", items_to_request.size())("items_to_request", items_to_request)("endpoint", peer->get_remote_endpoint()) );
+      if (peer->sync_items_requested_from_peer.empty())
+      {
+        peer->sync_batch_start_time = fc::time_point::now();
+        peer->sync_batch_bytes_received = 0;
+        peer->sync_batch_blocks_received = 0;
+        peer->sync_batch_total_latency = fc::microseconds();
+      }
       for (const item_hash_t& item_to_request : items_to_request)
       {
         _active_sync_requests.insert( active_sync_requests_map::value_type(item_to_request, fc::time_point::now() ) );
@@ -1055,9 +1158,18 @@ namespace graphene { namespace net {
             ASSERT_TASK_NOT_PREEMPTED();
             std::set<item_hash_t> sync_items_to_request;
 
-            // for each idle peer that we're syncing with
+            // the peers that have performed best get the blocks we need first
+            std::vector<std::pair<double, peer_connection_ptr> > ranked_peers;
             for( const peer_connection_ptr& peer : _active_connections )
+              if( peer->we_need_sync_items_from_peer )
+                ranked_peers.emplace_back( get_peer_score( peer ), peer );
+            std::stable_sort( ranked_peers.begin(), ranked_peers.end(),
+                              []( const std::pair<double, peer_connection_ptr>& a, const std::pair<double, peer_connection_ptr>& b ) { return a.first > b.first; } );
+
+            // for each idle peer that we're syncing with
+            for( const auto& score_and_peer : ranked_peers )
             {
+              const peer_connection_ptr& peer = score_and_peer.second;
               if( peer->we_need_sync_items_from_peer &&
                   sync_item_requests_to_send.find(peer) == sync_item_requests_to_send.end() && // if we've already scheduled a request for this peer, don't consider scheduling another
                   peer->idle() )
@@ -1103,6 +1215,50 @@ namespace graphene { namespace net {
       } // while( !canceled )
     }
 
+    double node_impl::get_peer_score(const peer_connection_ptr& peer)
+    {
+      fc::optional<fc::ip::endpoint> inbound_endpoint = peer->get_endpoint_for_connecting();
+      if (inbound_endpoint)
+      {
+        fc::optional<potential_peer_record> peer_record = _potential_peer_db.lookup_entry_for_endpoint(*inbound_endpoint);
+        if (peer_record)
+          return peer_record->score();
+      }
+      return potential_peer_record().score();
+    }
+
+    void node_impl::record_block_delivery(peer_connection* peer, fc::microseconds latency)
+    {
+      fc::optional<fc::ip::endpoint> inbound_endpoint = peer->get_endpoint_for_connecting();
+      if (!inbound_endpoint)
+        return;
+      fc::optional<potential_peer_record> updated_peer_record = _potential_peer_db.lookup_entry_for_endpoint(*inbound_endpoint);
+      if (updated_peer_record)
+      {
+        updated_peer_record->record_block_deliveries(1, latency);
+        _potential_peer_db.update_entry(*updated_peer_record);
+      }
+    }
+
+    void node_impl::record_sync_batch_performance(peer_connection* peer)
+    {
+      fc::optional<fc::ip::endpoint> inbound_endpoint = peer->get_endpoint_for_connecting();
+      if (!inbound_endpoint || peer->sync_batch_blocks_received == 0)
+        return;
+      fc::optional<potential_peer_record> updated_peer_record = _potential_peer_db.lookup_entry_for_endpoint(*inbound_endpoint);
+      if (updated_peer_record)
+      {
+        updated_peer_record->record_block_deliveries(peer->sync_batch_blocks_received,
+                                                     fc::microseconds(peer->sync_batch_total_latency.count() / peer->sync_batch_blocks_received));
+        updated_peer_record->record_sync_throughput(peer->sync_batch_bytes_received, fc::time_point::now() - peer->sync_batch_start_time);
+        _potential_peer_db.update_entry(*updated_peer_record);
+        dlog("peer ${endpoint} delivered a batch of ${count} sync blocks, now averaging ${latency}ms latency and ${rate} bytes/s",
+             ("endpoint", *inbound_endpoint)("count", peer->sync_batch_blocks_received)
+             ("latency", updated_peer_record->average_block_latency_ms)("rate", updated_peer_record->average_sync_bytes_per_second));
+      }
+      peer->sync_batch_blocks_received = 0;
+    }
+
     void node_impl::trigger_fetch_sync_items_loop()
     {
       VERIFY_CORRECT_THREAD();
@@ -1116,7 +1272,7 @@ namespace graphene { namespace net {
     {
       for( const peer_connection_ptr& peer : _active_connections )
       {
-        if (peer->inventory_peer_advertised_to_us.find(item) != peer->inventory_peer_advertised_to_us.end() )
+        if (peer->inventory_peer_advertised_to_us.contains(item))
           return true;
       }
       return false;
@@ -1136,73 +1292,75 @@ namespace graphene { namespace net {
         // we need to construct a list of items to request from each peer first,
         // then send the messages (in two steps, to avoid yielding while iterating)
         // we want to evenly distribute our requests among our peers.
-        struct requested_item_count_index {};
         struct peer_and_items_to_fetch
         {
           peer_connection_ptr peer;
           std::vector<item_id> item_ids;
           peer_and_items_to_fetch(const peer_connection_ptr& peer) : peer(peer) {}
-          bool operator<(const peer_and_items_to_fetch& rhs) const { return peer < rhs.peer; }
-          size_t number_of_items() const { return item_ids.size(); }
         };
-        typedef boost::multi_index_container<peer_and_items_to_fetch,
-                                             boost::multi_index::indexed_by<boost::multi_index::ordered_unique<boost::multi_index::member<peer_and_items_to_fetch, peer_connection_ptr, &peer_and_items_to_fetch::peer> >,
-                                                                            boost::multi_index::ordered_non_unique<boost::multi_index::tag<requested_item_count_index>,
-                                                                                                                   boost::multi_index::const_mem_fun<peer_and_items_to_fetch, size_t, &peer_and_items_to_fetch::number_of_items> > > > fetch_messages_to_send_set;
-        fetch_messages_to_send_set items_by_peer;
+        std::vector<peer_and_items_to_fetch> items_by_peer;
 
         // initialize the fetch_messages_to_send with an empty set of items for all idle peers
         for (const peer_connection_ptr& peer : _active_connections)
           if (peer->idle())
-            items_by_peer.insert(peer_and_items_to_fetch(peer));
+            items_by_peer.emplace_back(peer);
+
+        // the peers that can take more requests, ordered by the number of items we've already decided
+        // to ask them for.  A peer leaves the list once it has been given the maximum number of items
+        std::vector<size_t> peers_by_requested_item_count(items_by_peer.size());
+        for (size_t i = 0; i < items_by_peer.size(); ++i)
+          peers_by_requested_item_count[i] = i;
 
         // now loop over all items we want to fetch
-        for (auto item_iter = _items_to_fetch.begin(); item_iter != _items_to_fetch.end();)
-        {
-          if (item_iter->timestamp < oldest_timestamp_to_fetch)
+        _items_to_fetch.visit([&](const item_id& item, const fc::time_point& timestamp) {
+          if (timestamp < oldest_timestamp_to_fetch)
           {
             // this item has probably already fallen out of our peers' caches, we'll just ignore it.
             // this can happen during flooding, and the _items_to_fetch could otherwise get clogged
             // with a bunch of items that we'll never be able to request from any peer
-            wlog("Unable to fetch item ${item} before its likely expiration time, removing it from our list of items to fetch", ("item", item_iter->item));
-            item_iter = _items_to_fetch.erase(item_iter);
+            wlog("Unable to fetch item ${item} before its likely expiration time, removing it from our list of items to fetch", ("item", item));
+            return true;
           }
-          else
+
+          // find a peer that has it, we'll use the one who has the least requests going to it to load balance
+          for (auto peer_iter = peers_by_requested_item_count.begin(); peer_iter != peers_by_requested_item_count.end(); ++peer_iter)
           {
-            // find a peer that has it, we'll use the one who has the least requests going to it to load balance
-            bool item_fetched = false;
-            for (auto peer_iter = items_by_peer.get<requested_item_count_index>().begin(); peer_iter != items_by_peer.get<requested_item_count_index>().end(); ++peer_iter)
+            peer_and_items_to_fetch& peer_and_items = items_by_peer[*peer_iter];
+            const peer_connection_ptr& peer = peer_and_items.peer;
+            if (!peer->inventory_peer_advertised_to_us.contains(item))
+              continue;
+            if (item.item_type == graphene::net::trx_message_type && peer->is_transaction_fetching_inhibited())
             {
-              const peer_connection_ptr& peer = peer_iter->peer;
-              // if they have the item and we haven't already decided to ask them for too many other items
-              if (peer_iter->item_ids.size() < GRAPHENE_NET_MAX_ITEMS_PER_PEER_DURING_NORMAL_OPERATION &&
-                  peer->inventory_peer_advertised_to_us.find(item_iter->item) != peer->inventory_peer_advertised_to_us.end())
-              {
-                if (item_iter->item.item_type == graphene::net::trx_message_type && peer->is_transaction_fetching_inhibited())
-                  next_peer_unblocked_time = std::min(peer->transaction_fetching_inhibited_until, next_peer_unblocked_time);
-                else
-                {
-                  //dlog("requesting item ${hash} from peer ${endpoint}",
-                  //     ("hash", iter->item.item_hash)("endpoint", peer->get_remote_endpoint()));
-                  item_id item_id_to_fetch = item_iter->item;
-                  peer->items_requested_from_peer.insert(peer_connection::item_to_time_map_type::value_type(item_id_to_fetch, fc::time_point::now()));
-                  item_iter = _items_to_fetch.erase(item_iter);
-                  item_fetched = true;
-                  items_by_peer.get<requested_item_count_index>().modify(peer_iter, [&item_id_to_fetch](peer_and_items_to_fetch& peer_and_items) {
-                    peer_and_items.item_ids.push_back(item_id_to_fetch);
-                  });
-                  break;
-                }
-              }
+              next_peer_unblocked_time = std::min(peer->transaction_fetching_inhibited_until, next_peer_unblocked_time);
+              continue;
             }
-            if (!item_fetched)
-              ++item_iter;
+
+            //dlog("requesting item ${hash} from peer ${endpoint}",
+            //     ("hash", iter->item.item_hash)("endpoint", peer->get_remote_endpoint()));
+            peer->items_requested_from_peer.insert(peer_connection::item_to_time_map_type::value_type(item, fc::time_point::now()));
+            _items_requested_from_peers[item] = peer;
+            peer_and_items.item_ids.push_back(item);
+
+            // keep the list ordered: move the peer behind every peer with as many items as it now has
+            size_t requested_item_count = peer_and_items.item_ids.size();
+            if (requested_item_count >= GRAPHENE_NET_MAX_ITEMS_PER_PEER_DURING_NORMAL_OPERATION)
+              peers_by_requested_item_count.erase(peer_iter);
+            else
+              std::rotate(peer_iter, peer_iter + 1,
+                          std::find_if(peer_iter + 1, peers_by_requested_item_count.end(), [&](size_t i) {
+                            return items_by_peer[i].item_ids.size() > requested_item_count;
+                          }));
+            return true;
           }
-        }
+          return false;
+        });
 
         // we've figured out which peer will be providing each item, now send the messages.
         for (const peer_and_items_to_fetch& peer_and_items : items_by_peer)
         {
+          if (peer_and_items.item_ids.empty())
+            continue;
+
           // the item lists are heterogenous and
           // the fetch_items_message can only deal with one item type at a time.
           std::map<uint32_t, std::vector<item_hash_t> > items_to_fetch_by_type;
@@ -1222,7 +1380,14 @@ namespace graphene { namespace net {
                         ("endpoint", peer_and_items.peer->get_remote_endpoint())("id", id));
               }
 
-            peer_and_items.peer->send_message(fetch_items_message(items_by_type.first,
+            // blocks are still tracked in items_requested_from_peer as block_message_type, peers
+            // that support it send them back as compact_block_messages
+            uint32_t item_type_to_request = items_by_type.first;
+            if (item_type_to_request == core_message_type_enum::block_message_type &&
+                peer_and_items.peer->supports_compact_blocks)
+              item_type_to_request = core_message_type_enum::compact_block_message_type;
+
+            peer_and_items.peer->send_message(fetch_items_message(item_type_to_request,
                                                                   items_by_type.second));
           }
         }
@@ -1289,11 +1454,11 @@ namespace graphene { namespace net {
               //if (peer->inventory_peer_advertised_to_us.find(item_to_advertise) != peer->inventory_peer_advertised_to_us.end() )
               //   wdump((*peer->inventory_peer_advertised_to_us.find(item_to_advertise)));
 
-              if (peer->inventory_advertised_to_peer.find(item_to_advertise) == peer->inventory_advertised_to_peer.end() &&
-                  peer->inventory_peer_advertised_to_us.find(item_to_advertise) == peer->inventory_peer_advertised_to_us.end())
+              if (!peer->inventory_advertised_to_peer.contains(item_to_advertise) &&
+                  !peer->inventory_peer_advertised_to_us.contains(item_to_advertise))
               {
                 items_to_advertise_by_type[item_to_advertise.item_type].push_back(item_to_advertise.item_hash);
-                peer->inventory_advertised_to_peer.insert(peer_connection::timestamped_item_id(item_to_advertise, fc::time_point::now()));
+                peer->inventory_advertised_to_peer.insert(item_to_advertise, fc::time_point::now());
                 ++total_items_to_send_to_this_peer;
                 if (item_to_advertise.item_type == trx_message_type)
                   testnetlog("advertising transaction ${id} to peer ${endpoint}", ("id", item_to_advertise.item_hash)("endpoint", peer->get_remote_endpoint()));
@@ -1310,6 +1475,13 @@ namespace graphene { namespace net {
           peer->clear_old_inventory();
         }
 
+        // remember everything we've advertised in one place, so inventory messages from our peers can
+        // tell we already have an item without looking through every peer's inventory
+        fc::time_point_sec now = fc::time_point::now();
+        _inventory_advertised_to_peers.erase_older_than(now - fc::minutes(GRAPHENE_NET_MAX_INVENTORY_SIZE_IN_MINUTES));
+        for (const item_id& item_advertised : inventory_to_advertise)
+          _inventory_advertised_to_peers.insert(item_advertised, now);
+
         for (auto iter = inventory_messages_to_send.begin(); iter != inventory_messages_to_send.end(); ++iter)
           iter->first->send_message(iter->second);
         inventory_messages_to_send.clear();
@@ -1433,6 +1605,8 @@ namespace graphene { namespace net {
                         ("peer", active_peer->get_remote_endpoint())("id", item_and_time.first.item_hash));
                   wlog("Disconnecting peer ${peer} because they didn't respond to my request for item ${id}",
                         ("peer", active_peer->get_remote_endpoint())("id", item_and_time.first.item_hash));
+                  if (item_and_time.first.item_type == block_message_type)
+                    active_peer->compact_blocks_being_rebuilt.erase(item_and_time.first.item_hash);
                   disconnect_due_to_request_timeout = true;
                   break;
                 }
@@ -1557,9 +1731,17 @@ namespace graphene { namespace net {
       // this has nothing to do with updating the peer list, but we need to prune this list
       // at regular intervals, this is a fine place to do it.
       fc::time_point_sec oldest_failed_ids_to_keep(fc::time_point::now() - fc::minutes(GRAPHENE_NET_PRUNE_FAILED_IDS_MINUTES));
-      auto oldest_failed_ids_to_keep_iter = _recently_failed_items.get<peer_connection::timestamp_index>().lower_bound(oldest_failed_ids_to_keep);
-      auto begin_iter = _recently_failed_items.get<peer_connection::timestamp_index>().begin();
-      _recently_failed_items.get<peer_connection::timestamp_index>().erase(begin_iter, oldest_failed_ids_to_keep_iter);
+      _recently_failed_items.erase_older_than(oldest_failed_ids_to_keep);
+
+      // the same goes for requests whose peer has gone away or has since given up on them
+      for (auto iter = _items_requested_from_peers.begin(); iter != _items_requested_from_peers.end();)
+      {
+        peer_connection_ptr peer = iter->second.lock();
+        if (!peer || peer->items_requested_from_peer.find(iter->first) == peer->items_requested_from_peer.end())
+          iter = _items_requested_from_peers.erase(iter);
+        else
+          ++iter;
+      }
 
       if (!_node_is_shutting_down && !_fetch_updated_peer_lists_loop_done.canceled() )
          _fetch_updated_peer_lists_loop_done = schedule_task( [this](){ fetch_updated_peer_lists_loop(); },
@@ -1847,6 +2029,15 @@ namespace graphene { namespace net {
       case core_message_type_enum::get_current_connections_reply_message_type:
         on_get_current_connections_reply_message(originating_peer, received_message.as<get_current_connections_reply_message>());
         break;
+      case core_message_type_enum::compact_block_message_type:
+        on_compact_block_message(originating_peer, received_message.as<compact_block_message>());
+        break;
+      case core_message_type_enum::fetch_block_transactions_message_type:
+        on_fetch_block_transactions_message(originating_peer, received_message.as<fetch_block_transactions_message>());
+        break;
+      case core_message_type_enum::block_transactions_message_type:
+        on_block_transactions_message(originating_peer, received_message.as<block_transactions_message>());
+        break;
 
       default:
         // ignore any message in between core_message_type_first and _last that we don't handle above
@@ -1891,6 +2082,8 @@ namespace graphene { namespace net {
         user_data["last_known_fork_block_number"] = _hard_fork_block_numbers.back();
 
       user_data["chain_id"] = _delegate->get_chain_id();
+      user_data["transport"] = sealed_transport_name;
+      user_data["compact_blocks"] = true;
 
       return user_data;
     }
@@ -1916,6 +2109,8 @@ namespace graphene { namespace net {
         originating_peer->last_known_fork_block_number = user_data["last_known_fork_block_number"].as<uint32_t>();
       if (user_data.contains("chain_id"))
         originating_peer->chain_id = user_data["chain_id"].as<zattera::protocol::chain_id_type>();
+      if (user_data.contains("compact_blocks"))
+        originating_peer->supports_compact_blocks = user_data["compact_blocks"].as_bool();
     }
 
     void node_impl::on_hello_message( peer_connection* originating_peer, const hello_message& hello_message_received )
@@ -2112,6 +2307,13 @@ namespace graphene { namespace net {
             originating_peer->send_message(message(connection_accepted_message()));
             dlog("Received a hello_message from peer ${peer}, sending reply to accept connection",
                  ("peer", originating_peer->get_remote_endpoint()));
+
+            // peers that understand it get everything after this message as AES-GCM sealed frames,
+            // older peers keep the AES-CBC stream
+            if (hello_message_received.user_data.contains("transport") &&
+                hello_message_received.user_data["transport"].is_string() &&
+                hello_message_received.user_data["transport"].as_string() == sealed_transport_name)
+              originating_peer->send_message(message(transport_upgrade_message()));
           }
         }
       }
@@ -2797,6 +2999,12 @@ namespace graphene { namespace net {
            ("type", fetch_items_message_received.item_type)
            ("endpoint", originating_peer->get_remote_endpoint()));
 
+      if (fetch_items_message_received.item_type == compact_block_message_type)
+      {
+        send_compact_blocks(originating_peer, fetch_items_message_received.items_to_fetch);
+        return;
+      }
+
       fc::optional<message> last_block_message_sent;
 
       std::list<message> reply_messages;
@@ -2856,17 +3064,225 @@ namespace graphene { namespace net {
       }
     }
 
+    // the hash a transaction is known by in inventory and in the message cache, i.e. the id() of
+    // the trx_message carrying it
+    static item_hash_t get_transaction_message_hash(const signed_transaction& trx)
+    {
+      return fc::ripemd160::hash(trx);
+    }
+
+    void node_impl::send_compact_blocks(peer_connection* peer, const std::vector<item_hash_t>& block_message_hashes)
+    {
+      VERIFY_CORRECT_THREAD();
+      for (const item_hash_t& block_message_hash : block_message_hashes)
+      {
+        item_id block_item(block_message_type, block_message_hash);
+        message requested_message = get_message_for_item(block_item);
+        if (requested_message.msg_type != block_message_type)
+        {
+          peer->send_message(item_not_available_message(block_item));
+          continue;
+        }
+
+        graphene::net::block_message block = requested_message.as<graphene::net::block_message>();
+        compact_block_message compact_block;
+        compact_block.item_hash = block_message_hash;
+        compact_block.block_id = block.block_id;
+        compact_block.header = block.block;
+
+        // send the transactions the peer may not have seen in full, everything that went through
+        // our inventory exchange with them as a short id
+        for (uint32_t i = 0; i < block.block.transactions.size(); ++i)
+        {
+          signed_transaction& trx = block.block.transactions[i];
+          item_id transaction_item(trx_message_type, get_transaction_message_hash(trx));
+          if (peer->inventory_peer_advertised_to_us.contains(transaction_item) ||
+              peer->inventory_advertised_to_peer.contains(transaction_item))
+            compact_block.short_transaction_ids.push_back(compact_short_id(transaction_item.item_hash));
+          else
+            compact_block.prefilled_transactions.push_back(prefilled_transaction{i, std::move(trx)});
+        }
+        dlog("sending block ${id} to peer ${endpoint} as a compact block with ${short} short ids and ${prefilled} prefilled transactions",
+             ("id", block.block_id)("endpoint", peer->get_remote_endpoint())
+             ("short", compact_block.short_transaction_ids.size())("prefilled", compact_block.prefilled_transactions.size()));
+
+        peer->last_block_delegate_has_seen = block.block_id;
+        peer->last_block_time_delegate_has_seen = block.block.timestamp;
+        peer->send_message(compact_block);
+      }
+    }
+
+    void node_impl::on_compact_block_message(peer_connection* originating_peer, const compact_block_message& compact_block_message_received)
+    {
+      VERIFY_CORRECT_THREAD();
+      const item_hash_t& block_message_hash = compact_block_message_received.item_hash;
+      if (originating_peer->items_requested_from_peer.find(item_id(block_message_type, block_message_hash)) == originating_peer->items_requested_from_peer.end() ||
+          originating_peer->compact_blocks_being_rebuilt.find(block_message_hash) != originating_peer->compact_blocks_being_rebuilt.end())
+      {
+        wlog("received a compact block I didn't ask for from peer ${endpoint}, disconnecting from peer",
+             ("endpoint", originating_peer->get_remote_endpoint()));
+        fc::exception detailed_error(FC_LOG_MESSAGE(error, "You sent me a compact block that I didn't ask for, message_hash: ${message_hash}",
+                                                    ("message_hash", block_message_hash)));
+        disconnect_from_peer(originating_peer, "You sent me a message that I didn't request", true, detailed_error);
+        return;
+      }
+
+      const size_t transaction_count = compact_block_message_received.short_transaction_ids.size() +
+                                       compact_block_message_received.prefilled_transactions.size();
+      peer_connection::partial_compact_block partial_block;
+      partial_block.block.block_id = compact_block_message_received.block_id;
+      static_cast<zattera::protocol::signed_block_header&>(partial_block.block.block) = compact_block_message_received.header;
+      partial_block.block.block.transactions.resize(transaction_count);
+
+      std::vector<bool> prefilled(transaction_count, false);
+      for (const prefilled_transaction& prefilled_trx : compact_block_message_received.prefilled_transactions)
+      {
+        if (prefilled_trx.index >= transaction_count || prefilled[prefilled_trx.index])
+        {
+          wlog("peer ${endpoint} sent a compact block with invalid transaction positions, disconnecting from peer",
+               ("endpoint", originating_peer->get_remote_endpoint()));
+          fc::exception detailed_error(FC_LOG_MESSAGE(error, "Invalid compact block, message_hash: ${message_hash}",
+                                                      ("message_hash", block_message_hash)));
+          disconnect_from_peer(originating_peer, "You sent me an invalid compact block", true, detailed_error);
+          return;
+        }
+        prefilled[prefilled_trx.index] = true;
+        partial_block.block.block.transactions[prefilled_trx.index] = prefilled_trx.trx;
+      }
+
+      auto short_id_iter = compact_block_message_received.short_transaction_ids.begin();
+      for (uint32_t i = 0; i < transaction_count; ++i)
+      {
+        if (prefilled[i])
+          continue;
+        fc::optional<signed_transaction> cached_trx = _message_cache.get_transaction_by_short_id(*short_id_iter++);
+        if (cached_trx)
+          partial_block.block.block.transactions[i] = std::move(*cached_trx);
+        else
+          partial_block.missing_transaction_indexes.push_back(i);
+      }
+
+      dlog("received compact block ${id} from peer ${endpoint}, ${missing} of ${count} transactions are missing",
+           ("id", compact_block_message_received.block_id)("endpoint", originating_peer->get_remote_endpoint())
+           ("missing", partial_block.missing_transaction_indexes.size())("count", transaction_count));
+
+      if (partial_block.missing_transaction_indexes.empty())
+      {
+        process_rebuilt_compact_block(originating_peer, block_message_hash, partial_block.block);
+        return;
+      }
+
+      originating_peer->send_message(fetch_block_transactions_message(block_message_hash, partial_block.missing_transaction_indexes));
+      originating_peer->compact_blocks_being_rebuilt.emplace(block_message_hash, std::move(partial_block));
+    }
+
+    void node_impl::on_fetch_block_transactions_message(peer_connection* originating_peer,
+                                                        const fetch_block_transactions_message& fetch_block_transactions_message_received)
+    {
+      VERIFY_CORRECT_THREAD();
+      item_id block_item(block_message_type, fetch_block_transactions_message_received.item_hash);
+      message requested_message = get_message_for_item(block_item);
+      if (requested_message.msg_type != block_message_type)
+      {
+        originating_peer->send_message(item_not_available_message(block_item));
+        return;
+      }
+
+      graphene::net::block_message block = requested_message.as<graphene::net::block_message>();
+      block_transactions_message reply;
+      reply.item_hash = fetch_block_transactions_message_received.item_hash;
+      reply.transactions.reserve(fetch_block_transactions_message_received.transaction_indexes.size());
+      for (uint32_t index : fetch_block_transactions_message_received.transaction_indexes)
+      {
+        if (index >= block.block.transactions.size())
+        {
+          wlog("peer ${endpoint} requested a transaction past the end of block ${id}, disconnecting from peer",
+               ("endpoint", originating_peer->get_remote_endpoint())("id", block.block_id));
+          fc::exception detailed_error(FC_LOG_MESSAGE(error, "Invalid transaction index ${index} for block ${id}",
+                                                      ("index", index)("id", block.block_id)));
+          disconnect_from_peer(originating_peer, "You requested a transaction that is not in the block", true, detailed_error);
+          return;
+        }
+        reply.transactions.push_back(std::move(block.block.transactions[index]));
+      }
+      originating_peer->send_message(reply);
+    }
+
+    void node_impl::on_block_transactions_message(peer_connection* originating_peer,
+                                                  const block_transactions_message& block_transactions_message_received)
+    {
+      VERIFY_CORRECT_THREAD();
+      const item_hash_t& block_message_hash = block_transactions_message_received.item_hash;
+      auto partial_block_iter = originating_peer->compact_blocks_being_rebuilt.find(block_message_hash);
+      if (partial_block_iter == originating_peer->compact_blocks_being_rebuilt.end())
+      {
+        wlog("received block transactions I didn't ask for from peer ${endpoint}, disconnecting from peer",
+             ("endpoint", originating_peer->get_remote_endpoint()));
+        fc::exception detailed_error(FC_LOG_MESSAGE(error, "You sent me block transactions that I didn't ask for, message_hash: ${message_hash}",
+                                                    ("message_hash", block_message_hash)));
+        disconnect_from_peer(originating_peer, "You sent me a message that I didn't request", true, detailed_error);
+        return;
+      }
+
+      peer_connection::partial_compact_block partial_block = std::move(partial_block_iter->second);
+      originating_peer->compact_blocks_being_rebuilt.erase(partial_block_iter);
+
+      const std::vector<signed_transaction>& transactions = block_transactions_message_received.transactions;
+      if (transactions.size() != partial_block.missing_transaction_indexes.size())
+      {
+        wlog("peer ${endpoint} sent ${sent} of the ${count} transactions I requested for block ${id}, fetching the full block",
+             ("endpoint", originating_peer->get_remote_endpoint())("sent", transactions.size())
+             ("count", partial_block.missing_transaction_indexes.size())("id", partial_block.block.block_id));
+        originating_peer->send_message(fetch_items_message(block_message_type, {block_message_hash}));
+        return;
+      }
+
+      for (size_t i = 0; i < transactions.size(); ++i)
+        partial_block.block.block.transactions[partial_block.missing_transaction_indexes[i]] = transactions[i];
+      process_rebuilt_compact_block(originating_peer, block_message_hash, partial_block.block);
+    }
+
+    void node_impl::process_rebuilt_compact_block(peer_connection* originating_peer, const item_hash_t& block_message_hash,
+                                                  const graphene::net::block_message& rebuilt_block)
+    {
+      VERIFY_CORRECT_THREAD();
+      // a short id can match the wrong cached transaction, and nothing but the hash ties the
+      // header and the transactions the peer sent to the block it advertised
+      if (message(rebuilt_block).id() != block_message_hash)
+      {
+        wlog("compact block ${id} from peer ${endpoint} did not rebuild to the block that was advertised, fetching the full block",
+             ("id", rebuilt_block.block_id)("endpoint", originating_peer->get_remote_endpoint()));
+        originating_peer->send_message(fetch_items_message(block_message_type, {block_message_hash}));
+        return;
+      }
+
+      auto item_iter = originating_peer->items_requested_from_peer.find(item_id(block_message_type, block_message_hash));
+      if (item_iter != originating_peer->items_requested_from_peer.end())
+      {
+        STATSD_TIMER( "p2p", "latency", "compact_block_message_type", fc::time_point::now() - item_iter->second, 1.0f );
+        record_block_delivery(originating_peer, fc::time_point::now() - item_iter->second);
+        originating_peer->items_requested_from_peer.erase(item_iter);
+        _items_requested_from_peers.erase(item_id(block_message_type, block_message_hash));
+      }
+      process_block_during_normal_operation(originating_peer, rebuilt_block, block_message_hash);
+      if (originating_peer->idle())
+        trigger_fetch_items_loop();
+    }
+
     void node_impl::on_item_not_available_message( peer_connection* originating_peer, const item_not_available_message& item_not_available_message_received )
     {
       VERIFY_CORRECT_THREAD();
       const item_id& requested_item = item_not_available_message_received.requested_item;
+      if (requested_item.item_type == block_message_type)
+        originating_peer->compact_blocks_being_rebuilt.erase(requested_item.item_hash);
       auto regular_item_iter = originating_peer->items_requested_from_peer.find(requested_item);
       if (regular_item_iter != originating_peer->items_requested_from_peer.end())
       {
         originating_peer->items_requested_from_peer.erase( regular_item_iter );
         originating_peer->inventory_peer_advertised_to_us.erase( requested_item );
+        _items_requested_from_peers.erase( requested_item );
         if (is_item_in_any_peers_inventory(requested_item))
-          _items_to_fetch.insert(prioritized_item_id(requested_item, _items_to_fetch_sequence_counter++));
+          _items_to_fetch.insert(requested_item);
         wlog("Peer doesn't have the requested item.");
         trigger_fetch_items_loop();
         return;
@@ -2911,17 +3327,16 @@ namespace graphene { namespace net {
           // we've processed this item but haven't advertised it to our peers yet, don't fetch it again
           continue;
 
-        bool we_advertised_this_item_to_a_peer = false;
+        bool we_advertised_this_item_to_a_peer = _inventory_advertised_to_peers.contains(advertised_item_id);
         bool we_requested_this_item_from_a_peer = false;
-        for (const peer_connection_ptr& peer : _active_connections)
+        auto requested_iter = _items_requested_from_peers.find(advertised_item_id);
+        if (requested_iter != _items_requested_from_peers.end())
         {
-          if (peer->inventory_advertised_to_peer.find(advertised_item_id) != peer->inventory_advertised_to_peer.end())
-          {
-            we_advertised_this_item_to_a_peer = true;
-            break;
-          }
-          if (peer->items_requested_from_peer.find(advertised_item_id) != peer->items_requested_from_peer.end())
+          peer_connection_ptr peer = requested_iter->second.lock();
+          if (peer && peer->items_requested_from_peer.find(advertised_item_id) != peer->items_requested_from_peer.end())
             we_requested_this_item_from_a_peer = true;
+          else
+            _items_requested_from_peers.erase(requested_iter);
         }
 
         // if we have already advertised it to a peer, we must have it, no need to do anything else
@@ -2934,32 +3349,26 @@ namespace graphene { namespace net {
                originating_peer->is_inventory_advertised_to_us_list_full_for_transactions()) ||
               originating_peer->is_inventory_advertised_to_us_list_full())
             break;
-          originating_peer->inventory_peer_advertised_to_us.insert(peer_connection::timestamped_item_id(advertised_item_id, fc::time_point::now()));
+          originating_peer->inventory_peer_advertised_to_us.insert(advertised_item_id, fc::time_point::now());
           if (!we_requested_this_item_from_a_peer)
           {
-            if (_recently_failed_items.find(item_id(item_ids_inventory_message_received.item_type, item_hash)) != _recently_failed_items.end())
+            if (_recently_failed_items.contains(advertised_item_id))
             {
               dlog("not adding ${item_hash} to our list of items to fetch because we've recently fetched a copy and it failed to push",
                    ("item_hash", item_hash));
             }
             else
             {
-              auto items_to_fetch_iter = _items_to_fetch.get<item_id_index>().find(advertised_item_id);
-              if (items_to_fetch_iter == _items_to_fetch.get<item_id_index>().end())
+              // if another peer has told us about this item already, but this peer just told us it has the item
+              // too, we can expect it to be around in this peer's cache for longer, so update its timestamp
+              if (!_items_to_fetch.update_timestamp(advertised_item_id))
               {
                 // it's new to us
-                _items_to_fetch.insert(prioritized_item_id(advertised_item_id, _items_to_fetch_sequence_counter++));
+                _items_to_fetch.insert(advertised_item_id);
                 dlog("adding item ${item_hash} from inventory message to our list of items to fetch",
                      ("item_hash", item_hash));
                 trigger_fetch_items_loop();
               }
-              else
-              {
-                // another peer has told us about this item already, but this peer just told us it has the item
-                // too, we can expect it to be around in this peer's cache for longer, so update its timestamp
-                _items_to_fetch.get<item_id_index>().modify(items_to_fetch_iter,
-                                                            [](prioritized_item_id& item) { item.timestamp = fc::time_point::now(); });
-              }
             }
           }
         }
@@ -3081,7 +3490,7 @@ namespace graphene { namespace net {
         for (const auto& item_and_time : originating_peer->items_requested_from_peer)
         {
           if (is_item_in_any_peers_inventory(item_and_time.first))
-            _items_to_fetch.insert(prioritized_item_id(item_and_time.first, _items_to_fetch_sequence_counter++));
+            _items_to_fetch.insert(item_and_time.first);
         }
         trigger_fetch_items_loop();
       }
@@ -3480,7 +3889,7 @@ namespace graphene { namespace net {
           bool new_transaction_discovered = false;
           for (const item_hash_t& transaction_message_hash : contained_transaction_message_ids)
           {
-            _items_to_fetch.get<item_id_index>().erase(item_id(trx_message_type, transaction_message_hash));
+            _items_to_fetch.erase(item_id(trx_message_type, transaction_message_hash));
             // there are two ways we could behave here: we could either act as if we received
             // the transaction outside the block and offer it to our peers, or we could just
             // forget about it (we would still advertise this block to our peers so they should
@@ -3515,8 +3924,7 @@ namespace graphene { namespace net {
         {
           ASSERT_TASK_NOT_PREEMPTED(); // don't yield while iterating over _active_connections
 
-          auto iter = peer->inventory_peer_advertised_to_us.find(block_message_item_id);
-          if (iter != peer->inventory_peer_advertised_to_us.end())
+          if (peer->inventory_peer_advertised_to_us.contains(block_message_item_id))
           {
             // this peer offered us the item.  It will eventually expire from the peer's
             // inventory_peer_advertised_to_us list after some time has passed (currently 2 minutes).
@@ -3610,11 +4018,15 @@ namespace graphene { namespace net {
       // mode before we receive and process the item.  In that case, we should process the item as a normal
       // item to avoid confusing the sync code)
       graphene::net::block_message block_message_to_process(message_to_process.as<graphene::net::block_message>());
+      // the full block supersedes any compact block we were still rebuilding from this peer
+      originating_peer->compact_blocks_being_rebuilt.erase(message_hash);
       auto item_iter = originating_peer->items_requested_from_peer.find(item_id(graphene::net::block_message_type, message_hash));
       if (item_iter != originating_peer->items_requested_from_peer.end())
       {
         STATSD_TIMER( "p2p", "latency", "block_message_type", message_receive_time - item_iter->second, 1.0f );
+        record_block_delivery(originating_peer, message_receive_time - item_iter->second);
         originating_peer->items_requested_from_peer.erase(item_iter);
+        _items_requested_from_peers.erase(item_id(graphene::net::block_message_type, message_hash));
         process_block_during_normal_operation(originating_peer, block_message_to_process, message_hash);
         if (originating_peer->idle())
           trigger_fetch_items_loop();
@@ -3633,7 +4045,16 @@ namespace graphene { namespace net {
           try
           {
             originating_peer->last_sync_item_received_time = fc::time_point::now();
-            _active_sync_requests.erase(block_message_to_process.block_id);
+            auto active_sync_request_iter = _active_sync_requests.find(block_message_to_process.block_id);
+            if (active_sync_request_iter != _active_sync_requests.end())
+            {
+              originating_peer->sync_batch_total_latency += message_receive_time - active_sync_request_iter->second;
+              _active_sync_requests.erase(active_sync_request_iter);
+            }
+            originating_peer->sync_batch_bytes_received += message_to_process.size;
+            ++originating_peer->sync_batch_blocks_received;
+            if (originating_peer->sync_items_requested_from_peer.empty())
+              record_sync_batch_performance(originating_peer);
             process_block_during_sync(originating_peer, block_message_to_process, message_hash);
             if (originating_peer->idle())
             {
@@ -3966,6 +4387,7 @@ namespace graphene { namespace net {
       {
         STATSD_TIMER( "p2p", "latency", fc::variant( core_message_type_enum( message_to_process.msg_type ) ).as_string(), message_receive_time - iter->second, 0.1f );
         originating_peer->items_requested_from_peer.erase( iter );
+        _items_requested_from_peers.erase( item_id(message_to_process.msg_type, message_hash) );
         if (originating_peer->idle())
           trigger_fetch_items_loop();
 
@@ -3991,7 +4413,7 @@ namespace graphene { namespace net {
         {
           wlog( "client rejected message sent by peer ${peer}, ${e}", ("peer", originating_peer->get_remote_endpoint() )("e", e) );
           // record it so we don't try to fetch this item again
-          _recently_failed_items.insert(peer_connection::timestamped_item_id(item_id(message_to_process.msg_type, message_hash ), fc::time_point::now()));
+          _recently_failed_items.insert(item_id(message_to_process.msg_type, message_hash), fc::time_point::now());
           return;
         }
 
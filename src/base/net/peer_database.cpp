@@ -36,7 +36,53 @@
 #include <graphene/net/peer_database.hpp>
 #include <graphene/net/config.hpp>
 
+#include <cmath>
+#include <fstream>
+
 namespace graphene { namespace net {
+
+  namespace
+  {
+    /// moving averages give each new sample this share of the weight
+    const uint32_t moving_average_weight = 8;
+
+    uint32_t update_moving_average(uint32_t average, uint64_t sample)
+    {
+      sample = std::min<uint64_t>(sample, std::numeric_limits<uint32_t>::max());
+      if (average == 0)
+        return (uint32_t)sample;
+      return (uint32_t)((uint64_t(average) * (moving_average_weight - 1) + sample) / moving_average_weight);
+    }
+  }
+
+  void potential_peer_record::record_block_deliveries(uint32_t block_count, fc::microseconds average_latency)
+  {
+    if (block_count == 0)
+      return;
+    number_of_blocks_delivered += block_count;
+    average_block_latency_ms = update_moving_average(average_block_latency_ms, std::max<int64_t>(average_latency.count() / 1000, 1));
+  }
+
+  void potential_peer_record::record_sync_throughput(uint64_t bytes_received, fc::microseconds elapsed)
+  {
+    if (bytes_received == 0 || elapsed.count() <= 0)
+      return;
+    average_sync_bytes_per_second = update_moving_average(average_sync_bytes_per_second,
+                                                          std::max<uint64_t>(bytes_received * 1000000 / elapsed.count(), 1));
+  }
+
+  double potential_peer_record::score() const
+  {
+    // start peers we've never tried at one half
+    double reliability = (number_of_successful_connection_attempts + 1.0) /
+                         (number_of_successful_connection_attempts + number_of_failed_connection_attempts + 2.0);
+    double latency_ms = average_block_latency_ms ? average_block_latency_ms : GRAPHENE_NET_PEER_SCORE_REFERENCE_LATENCY_MS;
+    double bytes_per_second = average_sync_bytes_per_second ? average_sync_bytes_per_second : GRAPHENE_NET_PEER_SCORE_REFERENCE_BYTES_PER_SECOND;
+    return reliability *
+           (2.0 * GRAPHENE_NET_PEER_SCORE_REFERENCE_LATENCY_MS / (GRAPHENE_NET_PEER_SCORE_REFERENCE_LATENCY_MS + latency_ms)) *
+           std::sqrt(bytes_per_second / GRAPHENE_NET_PEER_SCORE_REFERENCE_BYTES_PER_SECOND);
+  }
+
   namespace detail
   {
     using namespace boost::multi_index;
@@ -58,8 +104,30 @@ namespace graphene { namespace net {
                                                                     std::hash<fc::ip::endpoint> > > > potential_peer_set;
 
     private:
+      /**
+       * The database file is a log of these entries, each preceded by its size as a uint32_t, and
+       * replayed in order when the database is opened.  Changes are appended as they are made and
+       * the log is rewritten from scratch when it has grown too far past the number of peers.
+       */
+      enum log_entry_type : uint8_t
+      {
+        update_log_entry, /// followed by a potential_peer_record
+        erase_log_entry   /// followed by an endpoint
+      };
+
       potential_peer_set     _potential_peer_set;
       fc::path _peer_database_filename;
+      std::ofstream _log;
+      size_t _log_entry_count = 0;
+
+      void load_log();
+      void load_legacy_json_file(const fc::path& json_filename);
+      void prune();
+      template<typename T>
+      static void write_log_entry(std::ostream& out, log_entry_type type, const T& payload);
+      template<typename T>
+      void append_to_log(log_entry_type type, const T& payload);
+      void rewrite_log();
 
     public:
       void open(const fc::path& databaseFilename);
@@ -73,6 +141,7 @@ namespace graphene { namespace net {
       peer_database::iterator begin() const;
       peer_database::iterator end() const;
       size_t size() const;
+      std::vector<potential_peer_record> get_ranked_records() const;
     };
 
     class peer_database_iterator_impl
@@ -90,60 +159,182 @@ namespace graphene { namespace net {
     void peer_database_impl::open(const fc::path& peer_database_filename)
     {
       _peer_database_filename = peer_database_filename;
+      fc::path legacy_json_filename = peer_database_filename;
+      legacy_json_filename.replace_extension(".json");
       if (fc::exists(_peer_database_filename))
+        load_log();
+      else if (fc::exists(legacy_json_filename))
+        load_legacy_json_file(legacy_json_filename);
+
+      prune();
+      rewrite_log();
+      if (fc::exists(legacy_json_filename) && fc::exists(_peer_database_filename))
+        fc::remove(legacy_json_filename);
+    }
+
+    void peer_database_impl::load_log()
+    {
+      std::vector<char> contents(fc::file_size(_peer_database_filename));
       {
+        std::ifstream in(_peer_database_filename.generic_string(), std::ios::in | std::ios::binary);
+        in.read(contents.data(), contents.size());
+        contents.resize(in.gcount());
+      }
+
+      size_t position = 0;
+      while (position + sizeof(uint32_t) <= contents.size())
+      {
+        uint32_t entry_size;
+        fc::datastream<const char*> size_ds(contents.data() + position, sizeof(entry_size));
+        fc::raw::unpack(size_ds, entry_size);
+        if (entry_size == 0 || position + sizeof(uint32_t) + entry_size > contents.size())
+          break; // a write that was cut short, everything before it is intact
         try
         {
-          std::vector<potential_peer_record> peer_records = fc::json::from_file(_peer_database_filename).as<std::vector<potential_peer_record> >();
-          std::copy(peer_records.begin(), peer_records.end(), std::inserter(_potential_peer_set, _potential_peer_set.end()));
-
-          if (_potential_peer_set.size() > GRAPHENE_NET_MAX_PEERDB_SIZE)
+          fc::datastream<const char*> ds(contents.data() + position + sizeof(uint32_t), entry_size);
+          uint8_t type;
+          fc::raw::unpack(ds, type);
+          if (type == update_log_entry)
+          {
+            potential_peer_record record;
+            fc::raw::unpack(ds, record);
+            update_entry(record);
+          }
+          else if (type == erase_log_entry)
           {
-            // prune database to a reasonable size
-            auto iter = _potential_peer_set.begin();
-            std::advance(iter, GRAPHENE_NET_MAX_PEERDB_SIZE);
-            _potential_peer_set.erase(iter, _potential_peer_set.end());
+            fc::ip::endpoint endpoint;
+            fc::raw::unpack(ds, endpoint);
+            erase(endpoint);
           }
         }
         catch (const fc::exception& e)
         {
-          elog("error opening peer database file ${peer_database_filename}, starting with a clean database", 
-               ("peer_database_filename", _peer_database_filename));
+          elog("error reading peer database file ${peer_database_filename}, ignoring the rest of it: ${e}",
+               ("peer_database_filename", _peer_database_filename)("e", e));
+          break;
         }
+        position += sizeof(uint32_t) + entry_size;
       }
+      if (position != contents.size())
+        wlog("ignored ${count} bytes at the end of peer database file ${peer_database_filename}",
+             ("count", contents.size() - position)("peer_database_filename", _peer_database_filename));
     }
 
-    void peer_database_impl::close()
+    void peer_database_impl::load_legacy_json_file(const fc::path& json_filename)
     {
-      std::vector<potential_peer_record> peer_records;
-      peer_records.reserve(_potential_peer_set.size());
-      std::copy(_potential_peer_set.begin(), _potential_peer_set.end(), std::back_inserter(peer_records));
+      try
+      {
+        std::vector<potential_peer_record> peer_records = fc::json::from_file(json_filename).as<std::vector<potential_peer_record> >();
+        std::copy(peer_records.begin(), peer_records.end(), std::inserter(_potential_peer_set, _potential_peer_set.end()));
+        ilog("imported ${count} peers from ${json_filename}", ("count", _potential_peer_set.size())("json_filename", json_filename));
+      }
+      catch (const fc::exception& e)
+      {
+        elog("error opening peer database file ${peer_database_filename}, starting with a clean database", 
+             ("peer_database_filename", json_filename));
+      }
+    }
 
+    void peer_database_impl::prune()
+    {
+      if (_potential_peer_set.size() <= GRAPHENE_NET_MAX_PEERDB_SIZE)
+        return;
+
+      // keep the peers we'd most like to connect to
+      std::vector<potential_peer_record> ranked_records = get_ranked_records();
+      for (size_t i = GRAPHENE_NET_MAX_PEERDB_SIZE; i < ranked_records.size(); ++i)
+        _potential_peer_set.get<endpoint_index>().erase(ranked_records[i].endpoint);
+    }
+
+    template<typename T>
+    void peer_database_impl::write_log_entry(std::ostream& out, log_entry_type type, const T& payload)
+    {
+      uint32_t entry_size = sizeof(uint8_t) + fc::raw::pack_size(payload);
+      std::vector<char> entry(sizeof(entry_size) + entry_size);
+      fc::datastream<char*> ds(entry.data(), entry.size());
+      fc::raw::pack(ds, entry_size);
+      fc::raw::pack(ds, (uint8_t)type);
+      fc::raw::pack(ds, payload);
+      out.write(entry.data(), entry.size());
+    }
+
+    template<typename T>
+    void peer_database_impl::append_to_log(log_entry_type type, const T& payload)
+    {
+      if (!_log.is_open())
+        return;
+
+      write_log_entry(_log, type, payload);
+      _log.flush();
+      if (!_log)
+      {
+        elog("error writing to peer database file ${peer_database_filename}, further changes will not be saved",
+             ("peer_database_filename", _peer_database_filename));
+        _log.close();
+        return;
+      }
+
+      if (++_log_entry_count > _potential_peer_set.size() + GRAPHENE_NET_PEERDB_COMPACTION_THRESHOLD)
+      {
+        prune();
+        rewrite_log();
+      }
+    }
+
+    void peer_database_impl::rewrite_log()
+    {
+      _log.close();
+      _log_entry_count = 0;
       try
       {
         fc::path peer_database_filename_dir = _peer_database_filename.parent_path();
         if (!fc::exists(peer_database_filename_dir))
           fc::create_directories(peer_database_filename_dir);
-        fc::json::save_to_file(peer_records, _peer_database_filename);
+
+        // write the new log next to the old one so a crash can't leave us with neither
+        fc::path temporary_filename = _peer_database_filename.generic_string() + ".tmp";
+        {
+          std::ofstream out(temporary_filename.generic_string(), std::ios::out | std::ios::binary | std::ios::trunc);
+          for (const potential_peer_record& record : _potential_peer_set)
+            write_log_entry(out, update_log_entry, record);
+          out.flush();
+          FC_ASSERT(out, "unable to write ${temporary_filename}", ("temporary_filename", temporary_filename));
+        }
+        fc::rename(temporary_filename, _peer_database_filename);
+        _log_entry_count = _potential_peer_set.size();
+
+        _log.open(_peer_database_filename.generic_string(), std::ios::out | std::ios::binary | std::ios::app);
       }
       catch (const fc::exception& e)
       {
-        elog("error saving peer database to file ${peer_database_filename}", 
-             ("peer_database_filename", _peer_database_filename));
+        elog("error saving peer database to file ${peer_database_filename}: ${e}", 
+             ("peer_database_filename", _peer_database_filename)("e", e));
       }
+    }
+
+    void peer_database_impl::close()
+    {
+      if (_log.is_open())
+        rewrite_log();
+      _log.close();
       _potential_peer_set.clear();
     }
 
     void peer_database_impl::clear()
     {
       _potential_peer_set.clear();
+      if (_log.is_open())
+        rewrite_log();
     }
 
     void peer_database_impl::erase(const fc::ip::endpoint& endpointToErase)
     {
       auto iter = _potential_peer_set.get<endpoint_index>().find(endpointToErase);
       if (iter != _potential_peer_set.get<endpoint_index>().end())
+      {
         _potential_peer_set.get<endpoint_index>().erase(iter);
+        append_to_log(erase_log_entry, endpointToErase);
+      }
     }
 
     void peer_database_impl::update_entry(const potential_peer_record& updatedRecord)
@@ -153,6 +344,7 @@ namespace graphene { namespace net {
         _potential_peer_set.get<endpoint_index>().modify(iter, [&updatedRecord](potential_peer_record& record) { record = updatedRecord; });
       else
         _potential_peer_set.get<endpoint_index>().insert(updatedRecord);
+      append_to_log(update_log_entry, updatedRecord);
     }
 
     potential_peer_record peer_database_impl::lookup_or_create_entry_for_endpoint(const fc::ip::endpoint& endpointToLookup)
@@ -186,6 +378,16 @@ namespace graphene { namespace net {
       return _potential_peer_set.size();
     }
 
+    std::vector<potential_peer_record> peer_database_impl::get_ranked_records() const
+    {
+      std::vector<potential_peer_record> records(_potential_peer_set.begin(), _potential_peer_set.end());
+      // stable, so equally ranked peers stay in the order they were last seen
+      std::stable_sort(records.begin(), records.end(), [](const potential_peer_record& a, const potential_peer_record& b) {
+        return a.score() > b.score();
+      });
+      return records;
+    }
+
     peer_database_iterator::peer_database_iterator()
     {
     }
@@ -274,4 +476,9 @@ namespace graphene { namespace net {
     return my->size();
   }
 
+  std::vector<potential_peer_record> peer_database::get_ranked_records() const
+  {
+    return my->get_ranked_records();
+  }
+
 } } // end namespace graphene::net
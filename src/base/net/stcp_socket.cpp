@@ -24,6 +24,9 @@
 #include <assert.h>
 
 #include <algorithm>
+#include <limits>
+
+#include <boost/endian/conversion.hpp>
 
 #include <fc/crypto/hex.hpp>
 #include <fc/crypto/aes.hpp>
@@ -53,12 +56,14 @@ void stcp_socket::do_key_exchange()
   _priv_key = fc::ecc::private_key::generate();
   fc::ecc::public_key pub = _priv_key.get_public_key();
   fc::ecc::public_key_data s = pub.serialize();
+  _local_public_key = s;
   std::shared_ptr<char> serialized_key_buffer(new char[sizeof(fc::ecc::public_key_data)], [](char* p){ delete[] p; });
   memcpy(serialized_key_buffer.get(), (char*)&s, sizeof(fc::ecc::public_key_data));
   _sock.write( serialized_key_buffer, sizeof(fc::ecc::public_key_data) );
   _sock.read( serialized_key_buffer, sizeof(fc::ecc::public_key_data) );
   fc::ecc::public_key_data rpub;
   memcpy((char*)&rpub, serialized_key_buffer.get(), sizeof(fc::ecc::public_key_data));
+  _remote_public_key = rpub;
 
   _shared_secret = _priv_key.get_shared_secret( rpub );
 //    ilog("shared secret ${s}", ("s", shared_secret) );
@@ -182,6 +187,101 @@ void stcp_socket::accept()
   do_key_exchange();
 }
 
+/**
+ *  Both directions share the ECDH secret, so the key of each direction also hashes in the
+ *  public key of its sender. Every key is then used by a single encoder and GCM nonces,
+ *  which restart at zero, are never reused.
+ */
+fc::sha256 stcp_socket::sealed_frame_key( const fc::ecc::public_key_data& sender )const
+{
+  static const char label[] = "stcp aes-256-gcm";
+  fc::sha256::encoder enc;
+  enc.write( (const char*)&_shared_secret, sizeof(_shared_secret) );
+  enc.write( (const char*)&sender, sizeof(sender) );
+  enc.write( label, sizeof(label) - 1 );
+  return enc.result();
+}
+
+void stcp_socket::enable_sealed_writes()
+{
+  FC_ASSERT( !_send_gcm, "sealed writes are already enabled" );
+  _send_gcm.reset( new fc::aes_gcm_encoder() );
+  _send_gcm->init( sealed_frame_key( _local_public_key ) );
+}
+
+void stcp_socket::enable_sealed_reads()
+{
+  FC_ASSERT( !_recv_gcm, "sealed reads are already enabled" );
+  _recv_gcm.reset( new fc::aes_gcm_decoder() );
+  _recv_gcm->init( sealed_frame_key( _remote_public_key ) );
+}
+
+size_t stcp_socket::write_sealed_frame( std::initializer_list< frame_part > parts )
+{ try {
+    FC_ASSERT( _send_gcm, "sealed writes are not enabled" );
+
+    size_t plaintext_size = 0;
+    for( const auto& part : parts )
+      plaintext_size += part.size;
+    FC_ASSERT( plaintext_size <= std::numeric_limits<uint32_t>::max() );
+
+    // the buffer only grows, so nothing is cleared or reallocated for typical messages
+    const size_t frame_size = sizeof(uint32_t) + plaintext_size + fc::aes_gcm_encoder::tag_size;
+    if( _frame_buffer.size() < frame_size )
+      _frame_buffer.resize( frame_size );
+    char* frame = _frame_buffer.data();
+
+    const uint32_t size_le = boost::endian::native_to_little( uint32_t(plaintext_size) );
+    memcpy( frame, &size_le, sizeof(size_le) );
+
+    _send_gcm->begin( frame, sizeof(size_le) );
+    size_t offset = sizeof(size_le);
+    for( const auto& part : parts )
+    {
+      _send_gcm->update( part.data, part.size, frame + offset );
+      offset += part.size;
+    }
+    _send_gcm->finish( frame + offset );
+
+    _sock.write( frame, frame_size );
+    return frame_size;
+} FC_RETHROW_EXCEPTIONS( warn, "" ) }
+
+uint32_t stcp_socket::read_sealed_frame_size()
+{
+  FC_ASSERT( _recv_gcm, "sealed reads are not enabled" );
+  uint32_t size_le = 0;
+  _sock.read( (char*)&size_le, sizeof(size_le) );
+  _sealed_frame_size = boost::endian::little_to_native( size_le );
+  return _sealed_frame_size;
+}
+
+size_t stcp_socket::read_sealed_frame( std::initializer_list< mutable_frame_part > parts )
+{
+  FC_ASSERT( _recv_gcm, "sealed reads are not enabled" );
+
+  const uint32_t size_le = boost::endian::native_to_little( _sealed_frame_size );
+  _recv_gcm->begin( (const char*)&size_le, sizeof(size_le) );
+
+  size_t plaintext_size = 0;
+  for( const auto& part : parts )
+  {
+    if( part.size == 0 )
+      continue;
+    _sock.read( part.data, part.size );
+    _recv_gcm->update( part.data, part.size, part.data );
+    plaintext_size += part.size;
+  }
+  FC_ASSERT( plaintext_size == _sealed_frame_size, "frame parts do not match the frame size",
+             ("parts", plaintext_size)("frame", _sealed_frame_size) );
+
+  char tag[fc::aes_gcm_decoder::tag_size];
+  _sock.read( tag, sizeof(tag) );
+  FC_ASSERT( _recv_gcm->finish( tag ), "sealed frame failed authentication" );
+
+  return sizeof(size_le) + plaintext_size + sizeof(tag);
+}
+
 
 }} // namespace graphene::net
 
@@ -0,0 +1,52 @@
+#include <graphene/net/timestamped_item_set.hpp>
+
+namespace graphene { namespace net {
+
+  timestamped_item_set::timestamped_item_set(uint32_t bucket_duration_in_seconds) :
+    _bucket_duration(bucket_duration_in_seconds)
+  {}
+
+  bool timestamped_item_set::insert(const item_id& item, fc::time_point_sec timestamp)
+  {
+    uint32_t start_time = timestamp.sec_since_epoch() - timestamp.sec_since_epoch() % _bucket_duration;
+    // timestamps are not required to be increasing, an older one goes in the newest bucket and is
+    // simply kept a little longer
+    if (!_buckets.empty() && start_time < _buckets.back().start_time)
+      start_time = _buckets.back().start_time;
+
+    if (!_items.emplace(item, start_time).second)
+      return false;
+
+    if (_buckets.empty() || _buckets.back().start_time != start_time)
+      _buckets.push_back(bucket{start_time, {}});
+    _buckets.back().items.push_back(item);
+    return true;
+  }
+
+  size_t timestamped_item_set::erase_older_than(fc::time_point_sec oldest_timestamp_to_keep)
+  {
+    size_t erased = 0;
+    while (!_buckets.empty() && _buckets.front().start_time + _bucket_duration <= oldest_timestamp_to_keep.sec_since_epoch())
+    {
+      for (const item_id& item : _buckets.front().items)
+      {
+        // skip items that were erased, and erased then inserted again into a later bucket
+        auto iter = _items.find(item);
+        if (iter != _items.end() && iter->second == _buckets.front().start_time)
+        {
+          _items.erase(iter);
+          ++erased;
+        }
+      }
+      _buckets.pop_front();
+    }
+    return erased;
+  }
+
+  void timestamped_item_set::clear()
+  {
+    _items.clear();
+    _buckets.clear();
+  }
+
+} } // graphene::net
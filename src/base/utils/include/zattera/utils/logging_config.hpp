@@ -1,5 +1,6 @@
 #pragma once
 
+#include <fc/log/async_appender.hpp>
 #include <fc/log/console_appender.hpp>
 #include <fc/log/file_appender.hpp>
 #include <fc/log/logger.hpp>
@@ -17,6 +18,8 @@ struct appender_args
    std::string appender;
    std::string file;
    std::string stream;
+   bool        async = false;
+   std::string overflow = "drop";
 
    void validate();
 };
@@ -36,5 +39,5 @@ fc::optional<fc::logging_config> load_logging_config( const boost::program_optio
 
 } } // zattera::utilities
 
-FC_REFLECT( zattera::utilities::appender_args, (appender)(file)(stream) )
+FC_REFLECT( zattera::utilities::appender_args, (appender)(file)(stream)(async)(overflow) )
 FC_REFLECT( zattera::utilities::logger_args, (name)(level)(appender) )
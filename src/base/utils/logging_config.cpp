@@ -17,6 +17,19 @@ void appender_args::validate()
 {
    FC_ASSERT( appender.length(), "Must specify an appender name" );
    FC_ASSERT( ( file.length() > 0 ) ^ ( stream.length() > 0 ), "Must specify either a file or a stream" );
+   FC_ASSERT( overflow == "drop" || overflow == "block", "Overflow policy must be either drop or block" );
+}
+
+static fc::appender_config make_appender_config( const appender_args& appender, const std::string& type, const fc::variant& args )
+{
+   if( !appender.async )
+      return fc::appender_config( appender.appender, type, args );
+
+   fc::async_appender::config async_appender_config;
+   async_appender_config.type = type;
+   async_appender_config.args = args;
+   async_appender_config.overflow = fc::variant( appender.overflow ).as< fc::async_appender::overflow_policy::type >();
+   return fc::appender_config( appender.appender, "async", fc::variant( async_appender_config ) );
 }
 
 void logger_args::validate()
@@ -40,7 +53,8 @@ void set_logging_program_options( boost::program_options::options_description& o
 
    options.add_options()
       ("log-appender", boost::program_options::value< std::vector< std::string > >()->composing()->default_value( default_appender, str_default_appender ),
-         "Appender definition json: {\"appender\", \"stream\", \"file\"} Can only specify a file OR a stream" )
+         "Appender definition json: {\"appender\", \"stream\", \"file\", \"async\", \"overflow\"} Can only specify a file OR a stream. "
+         "Async appenders write from a background thread and either drop or block when their queue is full" )
       ("log-console-appender", boost::program_options::value< std::vector< std::string > >()->composing() )
       ("log-file-appender", boost::program_options::value< std::vector< std::string > >()->composing() )
       ("log-logger", boost::program_options::value< std::vector< std::string > >()->composing()->default_value( default_logger, str_default_logger ),
@@ -94,7 +108,7 @@ fc::optional<fc::logging_config> load_logging_config( const boost::program_optio
                                                 fc::console_appender::color::red));
             console_appender_config.stream = fc::variant( appender.stream ).as< fc::console_appender::stream::type >();
             logging_config.appenders.push_back(
-               fc::appender_config( appender.appender, "console", fc::variant( console_appender_config ) ) );
+               make_appender_config( appender, "console", fc::variant( console_appender_config ) ) );
             found_logging_config = true;
          }
          else // validate ensures the is either a stream or file configured
@@ -112,7 +126,7 @@ fc::optional<fc::logging_config> load_logging_config( const boost::program_optio
             file_appender_config.rotation_interval = fc::hours(1);
             file_appender_config.rotation_limit = fc::days(1);
             logging_config.appenders.push_back(
-               fc::appender_config( appender.appender, "file", fc::variant( file_appender_config ) ) );
+               make_appender_config( appender, "file", fc::variant( file_appender_config ) ) );
             found_logging_config = true;
          }
       }
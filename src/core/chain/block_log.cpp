@@ -195,6 +195,17 @@ namespace zattera { namespace chain {
    }
 
    uint64_t block_log::append( const signed_block& b )
+   {
+      auto data = fc::raw::pack_to_vector( b );
+      return append_packed( b, b.id(), data.data(), data.size() );
+   }
+
+   uint64_t block_log::append( const prepared_block& b )
+   {
+      return append_packed( b.block(), b.id(), b.packed().data(), b.packed().size() );
+   }
+
+   uint64_t block_log::append_packed( const signed_block& b, const block_id_type& id, const char* data, size_t size )
    {
       try
       {
@@ -212,12 +223,11 @@ namespace zattera { namespace chain {
          FC_ASSERT( static_cast<uint64_t>(my->index_stream.tellp()) == sizeof( uint64_t ) * ( b.block_num() - 1 ),
             "Append to index file occuring at wrong position.",
             ( "position", (uint64_t) my->index_stream.tellp() )( "expected",( b.block_num() - 1 ) * sizeof( uint64_t ) ) );
-         auto data = fc::raw::pack_to_vector( b );
-         my->block_stream.write( data.data(), data.size() );
+         my->block_stream.write( data, size );
          my->block_stream.write( (char*)&pos, sizeof( pos ) );
          my->index_stream.write( (char*)&pos, sizeof( pos ) );
          my->head = b;
-         my->head_id = b.id();
+         my->head_id = id;
 
          return pos;
       }
@@ -0,0 +1,260 @@
+#include <zattera/chain/comment_content_store.hpp>
+#include <deque>
+#include <fstream>
+#include <list>
+#include <unordered_map>
+#include <fc/crypto/sha256.hpp>
+#include <fc/io/raw.hpp>
+
+#include <boost/thread/mutex.hpp>
+
+#define STORE_READ  (std::ios::in | std::ios::binary)
+#define STORE_WRITE (std::ios::out | std::ios::binary | std::ios::app)
+
+namespace zattera { namespace chain {
+
+   namespace detail {
+      class comment_content_store_impl {
+         public:
+            typedef std::pair< uint64_t, comment_content > cache_entry;
+
+            fc::path                 file;
+            std::fstream             write_stream;
+            std::fstream             read_stream;
+            uint64_t                 file_size = 0;
+            bool                     write_dirty = false;
+
+            /// Entries by position, most recently used first
+            std::list< cache_entry > cache;
+            std::unordered_map< uint64_t, std::list< cache_entry >::iterator > cache_index;
+            uint64_t                 cache_limit = 0;
+            uint64_t                 cached_bytes = 0;
+
+            /// Last entry written for each recently written comment, oldest first in recent_order
+            struct recent_entry
+            {
+               uint64_t    position;
+               uint32_t    size;
+               fc::sha256  digest;
+            };
+            std::unordered_map< int64_t, recent_entry > recent;
+            std::deque< std::pair< int64_t, uint64_t > > recent_order;
+            static const size_t      recent_limit = 65536;
+
+            boost::mutex             mtx;
+
+            static uint64_t entry_bytes( const comment_content& c )
+            {
+               return c.title.size() + c.body.size() + c.json_metadata.size();
+            }
+
+            void open_streams()
+            {
+               write_stream.open( file.generic_string().c_str(), STORE_WRITE );
+               read_stream.open( file.generic_string().c_str(), STORE_READ );
+               file_size = fc::file_size( file );
+               write_dirty = false;
+            }
+
+            void close_streams()
+            {
+               if( write_stream.is_open() )
+                  write_stream.close();
+               if( read_stream.is_open() )
+                  read_stream.close();
+            }
+
+            void clear_cache()
+            {
+               cache.clear();
+               cache_index.clear();
+               cached_bytes = 0;
+               recent.clear();
+               recent_order.clear();
+            }
+
+            void remember( int64_t id, uint64_t position, uint32_t size, const fc::sha256& digest )
+            {
+               recent[ id ] = recent_entry{ position, size, digest };
+               recent_order.emplace_back( id, position );
+
+               while( recent_order.size() > recent_limit )
+               {
+                  auto itr = recent.find( recent_order.front().first );
+                  if( itr != recent.end() && itr->second.position == recent_order.front().second )
+                     recent.erase( itr );
+                  recent_order.pop_front();
+               }
+            }
+
+            const comment_content* find_cached( uint64_t position )
+            {
+               auto itr = cache_index.find( position );
+               if( itr == cache_index.end() )
+                  return nullptr;
+
+               cache.splice( cache.begin(), cache, itr->second );
+               return &itr->second->second;
+            }
+
+            void insert_cached( uint64_t position, const comment_content& content )
+            {
+               uint64_t bytes = entry_bytes( content );
+               if( bytes > cache_limit )
+                  return;
+
+               cache.emplace_front( position, content );
+               cache_index[ position ] = cache.begin();
+               cached_bytes += bytes;
+
+               while( cached_bytes > cache_limit )
+               {
+                  cached_bytes -= entry_bytes( cache.back().second );
+                  cache_index.erase( cache.back().first );
+                  cache.pop_back();
+               }
+            }
+      };
+   }
+
+   typedef boost::unique_lock< boost::mutex > store_lock;
+
+   comment_content_store::comment_content_store()
+   :my( new detail::comment_content_store_impl() )
+   {
+      my->write_stream.exceptions( std::fstream::failbit | std::fstream::badbit );
+      my->read_stream.exceptions( std::fstream::failbit | std::fstream::badbit );
+   }
+
+   comment_content_store::~comment_content_store()
+   {
+      if( is_open() )
+         flush();
+   }
+
+   void comment_content_store::open( const fc::path& file, uint64_t cache_size )
+   {
+      store_lock lock( my->mtx );
+      my->close_streams();
+      my->clear_cache();
+
+      my->file = file;
+      my->cache_limit = cache_size;
+      my->open_streams();
+      ilog( "Opened comment content store ${f}, ${s} bytes", ("f", file)("s", my->file_size) );
+   }
+
+   void comment_content_store::close()
+   {
+      store_lock lock( my->mtx );
+      my->close_streams();
+      my->clear_cache();
+      my->file_size = 0;
+      my->write_dirty = false;
+   }
+
+   bool comment_content_store::is_open()const
+   {
+      return my->write_stream.is_open();
+   }
+
+   void comment_content_store::clear()
+   {
+      store_lock lock( my->mtx );
+      FC_ASSERT( my->write_stream.is_open(), "Comment content store is not open" );
+      my->close_streams();
+      my->clear_cache();
+      std::ofstream( my->file.generic_string().c_str(), std::ios::out | std::ios::binary | std::ios::trunc );
+      my->open_streams();
+   }
+
+   void comment_content_store::flush()
+   {
+      store_lock lock( my->mtx );
+      if( my->write_dirty )
+      {
+         my->write_stream.flush();
+         my->write_dirty = false;
+      }
+   }
+
+   uint64_t comment_content_store::append( comment_id_type comment, const comment_content& content, uint32_t& entry_size )
+   {
+      store_lock lock( my->mtx );
+      FC_ASSERT( my->write_stream.is_open(), "Comment content store is not open" );
+
+      int64_t id = comment._id;
+      auto packed_content = fc::raw::pack_size( content );
+      FC_ASSERT( packed_content + sizeof( id ) <= std::numeric_limits< uint32_t >::max(), "Comment content is too large to store" );
+      entry_size = uint32_t( packed_content + sizeof( id ) );
+
+      std::vector< char > data( sizeof( entry_size ) + entry_size );
+      fc::datastream< char* > ds( data.data(), data.size() );
+      fc::raw::pack( ds, entry_size );
+      fc::raw::pack( ds, id );
+      fc::raw::pack( ds, content );
+
+      // The same operation is applied as a pending transaction, again after every block and in its block
+      auto digest = fc::sha256::hash( data.data(), data.size() );
+      auto last = my->recent.find( id );
+      if( last != my->recent.end() && last->second.size == entry_size && last->second.digest == digest )
+         return last->second.position;
+
+      uint64_t position = my->file_size;
+      my->write_stream.write( data.data(), data.size() );
+      my->file_size += data.size();
+      my->write_dirty = true;
+
+      my->remember( id, position, entry_size, digest );
+      my->insert_cached( position, content );
+      return position;
+   }
+
+   comment_content comment_content_store::read( comment_id_type comment, uint64_t position, uint32_t entry_size )const
+   {
+      store_lock lock( my->mtx );
+      FC_ASSERT( my->read_stream.is_open(), "Comment content store is not open" );
+
+      if( const comment_content* cached = my->find_cached( position ) )
+         return *cached;
+
+      FC_ASSERT( position + sizeof( entry_size ) + entry_size <= my->file_size,
+         "Comment content entry is past the end of the store", ("position", position)("size", entry_size)("file_size", my->file_size) );
+
+      if( my->write_dirty )
+      {
+         my->write_stream.flush();
+         my->write_dirty = false;
+      }
+
+      std::vector< char > data( sizeof( entry_size ) + entry_size );
+      my->read_stream.seekg( position );
+      my->read_stream.read( data.data(), data.size() );
+
+      fc::datastream< const char* > ds( data.data(), data.size() );
+      uint32_t stored_size;
+      int64_t stored_id;
+      fc::raw::unpack( ds, stored_size );
+      fc::raw::unpack( ds, stored_id );
+      FC_ASSERT( stored_size == entry_size && stored_id == comment._id,
+         "Comment content entry does not belong to this comment, the store does not match the state",
+         ("comment", comment)("position", position)("stored_id", stored_id)("stored_size", stored_size) );
+
+      comment_content content;
+      fc::raw::unpack( ds, content );
+
+      my->insert_cached( position, content );
+      return content;
+   }
+
+   uint64_t comment_content_store::size()const
+   {
+      return my->file_size;
+   }
+
+   uint64_t comment_content_store::cached_bytes()const
+   {
+      return my->cached_bytes;
+   }
+
+} } // zattera::chain
@@ -1,5 +1,6 @@
 #include <zattera/protocol/zattera_operations.hpp>
 #include <zattera/protocol/runtime_config.hpp>
+#include <zattera/protocol/transaction_util.hpp>
 
 #include <zattera/chain/block_summary_object.hpp>
 #include <zattera/chain/custom_operation_interpreter.hpp>
@@ -20,6 +21,7 @@
 #include <zattera/chain/utils/asset.hpp>
 #include <zattera/chain/utils/reward.hpp>
 #include <zattera/chain/utils/uint256.hpp>
+#include <zattera/chain/utils/worker_pool.hpp>
 #include <zattera/chain/utils/reward.hpp>
 
 #include <fc/smart_ref_impl.hpp>
@@ -82,6 +84,7 @@ class database_impl
 
       database&                              _self;
       evaluator_registry< operation >        _evaluator_registry;
+      std::unique_ptr< util::worker_pool >   _validation_pool;
 };
 
 database_impl::database_impl( database& self )
@@ -107,7 +110,20 @@ void database::open( const open_args& args )
       initialize_indexes();
       initialize_evaluators();
 
-      if( !find< dynamic_global_property_object >() )
+      bool new_state = !find< dynamic_global_property_object >();
+
+      // The store is opened whenever it exists, content written by an earlier run that enabled it
+      // stays readable, new content only goes there when enabled.
+      _use_comment_content_store = args.use_comment_content_store;
+      fc::path comment_content_file = args.shared_mem_dir / "comment_content.log";
+      if( _use_comment_content_store || fc::exists( comment_content_file ) )
+      {
+         _comment_content_store.open( comment_content_file, args.comment_content_cache_size );
+         if( new_state )
+            _comment_content_store.clear();
+      }
+
+      if( new_state )
          with_write_lock( [&]()
          {
             init_genesis( args.liquid_initial_supply, args.dollar_initial_supply );
@@ -127,8 +143,20 @@ void database::open( const open_args& args )
             ("rev", revision())("head_block", head_block_num()) );
          if (args.do_validate_invariants)
             validate_invariants();
+
+         // Entries the state references may not have reached the store if the process was killed
+         const auto* content_store = find< comment_content_store_object >();
+         if( content_store != nullptr && content_store->committed_size > 0 )
+         {
+            FC_ASSERT( _comment_content_store.is_open() && _comment_content_store.size() >= content_store->committed_size,
+               "Comment content store is shorter than the chain state expects. Please reindex blockchain.",
+               ("store_size", _comment_content_store.size())("committed_size", content_store->committed_size) );
+         }
       });
 
+      if( args.compact_shared_file )
+         compact_shared_memory();
+
       if( head_block_num() )
       {
          auto head_block = _block_log.read_block_by_num( head_block_num() );
@@ -224,15 +252,15 @@ uint32_t database::reindex( const open_args& args )
             if( cur_block_num % 100000 == 0 )
                std::cerr << "   " << double( cur_block_num * 100 ) / last_block_num << "%   " << cur_block_num << " of " << last_block_num <<
                "   (" << (get_free_memory() / (1024*1024)) << "M free)\n";
-            apply_block( itr.first, skip_flags );
+            apply_block( prepared_block( std::move( itr.first ) ), skip_flags );
 
             if( (args.benchmark.first > 0) && (cur_block_num % args.benchmark.first == 0) )
                args.benchmark.second( cur_block_num, get_abstract_index_cntr() );
             itr = _block_log.read_block( itr.second );
          }
 
-         apply_block( itr.first, skip_flags );
          note.last_block_number = itr.first.block_num();
+         apply_block( prepared_block( std::move( itr.first ) ), skip_flags );
 
          if( (args.benchmark.first > 0) && (note.last_block_number % args.benchmark.first == 0) )
             args.benchmark.second( note.last_block_number, get_abstract_index_cntr() );
@@ -258,6 +286,7 @@ void database::wipe( const fc::path& data_dir, const fc::path& shared_mem_dir, b
 {
    close();
    chainbase::database::wipe( shared_mem_dir );
+   fc::remove_all( shared_mem_dir / "comment_content.log" );
    if( include_blocks )
    {
       fc::remove_all( data_dir / "block_log" );
@@ -274,19 +303,32 @@ void database::close(bool rewind)
       // DB state (issue #336).
       clear_pending();
 
-      chainbase::database::flush();
+      flush();
       chainbase::database::close();
 
       _block_log.close();
+      _comment_content_store.close();
 
       _fork_db.reset();
    }
    FC_CAPTURE_AND_RETHROW()
 }
 
+void database::flush()
+{
+   // The shared memory file references entries of the store, they must be on disk first
+   if( _comment_content_store.is_open() )
+      _comment_content_store.flush();
+   chainbase::database::flush();
+}
+
 bool database::is_known_block( const block_id_type& id )const
 { try {
-   return fetch_block_by_id( id ).valid();
+   if( _fork_db.is_known_block( id ) )
+      return true;
+
+   auto tmp = _block_log.read_block_by_num( protocol::block_header::num_from_id( id ) );
+   return tmp && tmp->id() == id;
 } FC_CAPTURE_AND_RETHROW() }
 
 /**
@@ -357,6 +399,15 @@ optional<signed_block> database::fetch_block_by_id( const block_id_type& id )con
    return b->data;
 } FC_CAPTURE_AND_RETHROW() }
 
+optional<prepared_block> database::fetch_prepared_block_by_id( const block_id_type& id )const
+{ try {
+   optional< prepared_block > result;
+   auto b = _fork_db.fetch_block( id );
+   if( b )
+      result = b->prepared;
+   return result;
+} FC_CAPTURE_AND_RETHROW() }
+
 optional<signed_block> database::fetch_block_by_number( uint32_t block_num )const
 { try {
    optional< signed_block > b;
@@ -544,6 +595,48 @@ const comment_object* database::find_comment( const account_name_type& author, c
 }
 #endif
 
+comment_content database::get_comment_content( const comment_id_type& comment )const
+{
+   const auto* con = find< comment_content_object, by_comment >( comment );
+   if( con == nullptr )
+      return comment_content();
+   return get_comment_content( *con );
+}
+
+comment_content database::get_comment_content( const comment_content_object& con )const
+{ try {
+   if( con.content_size )
+      return _comment_content_store.read( con.comment, con.content_position, con.content_size );
+
+   comment_content content;
+   content.title = to_string( con.title );
+   content.body = to_string( con.body );
+   content.json_metadata = to_string( con.json_metadata );
+   return content;
+} FC_CAPTURE_AND_RETHROW( (con.comment) ) }
+
+void database::set_comment_content( comment_content_object& con, const comment_content& content )
+{
+   if( _use_comment_content_store )
+   {
+      con.content_position = _comment_content_store.append( con.comment, content, con.content_size );
+      con.title.clear();
+      con.title.shrink_to_fit();
+      con.body.clear();
+      con.body.shrink_to_fit();
+      con.json_metadata.clear();
+      con.json_metadata.shrink_to_fit();
+   }
+   else
+   {
+      con.content_position = 0;
+      con.content_size = 0;
+      from_string( con.title, content.title );
+      from_string( con.body, content.body );
+      from_string( con.json_metadata, content.json_metadata );
+   }
+}
+
 const escrow_object& database::get_escrow( const account_name_type& name, uint32_t escrow_id )const
 { try {
    return get< escrow_object, by_from_id >( boost::make_tuple( name, escrow_id ) );
@@ -641,6 +734,11 @@ bool database::before_last_checkpoint()const
  * @return true if we switched forks as a result of this push.
  */
 bool database::push_block(const signed_block& new_block, uint32_t skip)
+{
+   return push_block( prepared_block( new_block ), skip );
+}
+
+bool database::push_block(const prepared_block& new_block, uint32_t skip)
 {
    //fc::time_point begin_time = fc::time_point::now();
 
@@ -653,7 +751,7 @@ bool database::push_block(const signed_block& new_block, uint32_t skip)
          {
             result = _push_block(new_block);
          }
-         FC_CAPTURE_AND_RETHROW( (new_block) )
+         FC_CAPTURE_AND_RETHROW( (new_block.block()) )
 
          check_free_memory( false, new_block.block_num() );
       });
@@ -682,7 +780,7 @@ void database::_maybe_warn_multiple_production( uint32_t height )const
    return;
 }
 
-bool database::_push_block(const signed_block& new_block)
+bool database::_push_block(const prepared_block& new_block)
 { try {
    #ifdef IS_TEST_MODE
    FC_ASSERT(new_block.block_num() < TEST_MODE_BLOCK_LIMIT, "Testnet block limit exceeded");
@@ -701,10 +799,10 @@ bool database::_push_block(const signed_block& new_block)
       {
          //If the newly pushed block is the same height as head, we get head back in new_head
          //Only switch forks if new_head is actually higher than head
-         if( new_head->data.block_num() > head_block_num() )
+         if( new_head->num > head_block_num() )
          {
             // wlog( "Switching to fork: ${id}", ("id",new_head->data.id()) );
-            auto branches = _fork_db.fetch_branch_from(new_head->data.id(), head_block_id());
+            auto branches = _fork_db.fetch_branch_from(new_head->id, head_block_id());
 
             // pop blocks until we hit the forked block
             while( head_block_id() != branches.second.back()->data.previous )
@@ -718,7 +816,7 @@ bool database::_push_block(const signed_block& new_block)
                 try
                 {
                    auto session = start_undo_session();
-                   apply_block( (*ritr)->data, skip );
+                   apply_block( (*ritr)->prepared, skip );
                    session.push();
                 }
                 catch ( const fc::exception& e ) { except = e; }
@@ -728,7 +826,7 @@ bool database::_push_block(const signed_block& new_block)
                    // remove the rest of branches.first from the fork_db, those blocks are invalid
                    while( ritr != branches.first.rend() )
                    {
-                      _fork_db.remove( (*ritr)->data.id() );
+                      _fork_db.remove( (*ritr)->id );
                       ++ritr;
                    }
                    _fork_db.set_head( branches.second.front() );
@@ -741,7 +839,7 @@ bool database::_push_block(const signed_block& new_block)
                    for( auto ritr = branches.second.rbegin(); ritr != branches.second.rend(); ++ritr )
                    {
                       auto session = start_undo_session();
-                      apply_block( (*ritr)->data, skip );
+                      apply_block( (*ritr)->prepared, skip );
                       session.push();
                    }
                    throw *except;
@@ -958,13 +1056,15 @@ signed_block database::_generate_block(
    if( !(skip & skip_witness_signature) )
       pending_block.sign( block_signing_private_key );
 
+   prepared_block prepared( pending_block );
+
    // TODO:  Move this to _push_block() so session is restored.
    if( !(skip & skip_block_size_check) )
    {
-      FC_ASSERT( fc::raw::pack_size(pending_block) <= ZATTERA_MAX_BLOCK_SIZE );
+      FC_ASSERT( prepared.pack_size() <= ZATTERA_MAX_BLOCK_SIZE );
    }
 
-   push_block( pending_block, skip );
+   push_block( prepared, skip );
 
    return pending_block;
 }
@@ -2228,6 +2328,7 @@ void database::initialize_indexes()
    add_core_index< witness_schedule_index                  >(*this);
    add_core_index< comment_index                           >(*this);
    add_core_index< comment_content_index                   >(*this);
+   add_core_index< comment_content_store_index             >(*this);
    add_core_index< comment_vote_index                      >(*this);
    add_core_index< witness_vote_index                      >(*this);
    add_core_index< limit_order_index                       >(*this);
@@ -2486,6 +2587,14 @@ void database::notify_changed_objects()
 
 }
 
+void database::set_parallel_validation_threads( uint32_t threads )
+{
+   if( threads > 0 )
+      _my->_validation_pool.reset( new util::worker_pool( threads ) );
+   else
+      _my->_validation_pool.reset();
+}
+
 void database::set_flush_interval( uint32_t flush_blocks )
 {
    _flush_blocks = flush_blocks;
@@ -2494,7 +2603,7 @@ void database::set_flush_interval( uint32_t flush_blocks )
 
 //////////////////// private methods ////////////////////
 
-void database::apply_block( const signed_block& next_block, uint32_t skip )
+void database::apply_block( const prepared_block& next_block, uint32_t skip )
 { try {
    //fc::time_point begin_time = fc::time_point::now();
 
@@ -2526,6 +2635,19 @@ void database::apply_block( const signed_block& next_block, uint32_t skip )
       _apply_block( next_block );
    } );
 
+   if( _comment_content_store.is_open() )
+   {
+      // The shared memory file outlives a killed process, the entries the block references must be
+      // handed to the OS before the state records them
+      _comment_content_store.flush();
+      uint64_t store_size = _comment_content_store.size();
+      const auto* content_store = find< comment_content_store_object >();
+      if( content_store == nullptr )
+         create< comment_content_store_object >( [&]( comment_content_store_object& o ) { o.committed_size = store_size; } );
+      else if( content_store->committed_size != store_size )
+         modify( *content_store, [&]( comment_content_store_object& o ) { o.committed_size = store_size; } );
+   }
+
    /*try
    {
    /// check invariants
@@ -2559,11 +2681,31 @@ void database::apply_block( const signed_block& next_block, uint32_t skip )
       {
          _next_flush_block = 0;
          //ilog( "Flushing database shared memory at block ${b}", ("b", block_num) );
-         chainbase::database::flush();
+         flush();
       }
    }
 
-} FC_CAPTURE_AND_RETHROW( (next_block) ) }
+} FC_CAPTURE_AND_RETHROW( (next_block.block()) ) }
+
+void database::compact_shared_memory()
+{
+   with_write_lock( [&]()
+   {
+      uint64_t used_before = get_max_memory() - get_free_memory();
+      auto start = fc::time_point::now();
+
+      ilog( "Compacting shared memory file, ${n}M in use", ("n", used_before / (1024*1024)) );
+
+      compact();
+
+      uint64_t used_after = get_max_memory() - get_free_memory();
+      ilog( "Compacted shared memory file in ${t} ms: ${b}M -> ${a}M in use, ${s}M reclaimed",
+         ("t", ( fc::time_point::now() - start ).count() / 1000)
+         ("b", used_before / (1024*1024))
+         ("a", used_after / (1024*1024))
+         ("s", ( used_before - std::min( used_before, used_after ) ) / (1024*1024)) );
+   });
+}
 
 void database::check_free_memory( bool force_print, uint32_t current_block_num )
 {
@@ -2604,9 +2746,10 @@ void database::check_free_memory( bool force_print, uint32_t current_block_num )
    }
 }
 
-void database::_apply_block( const signed_block& next_block )
+void database::_apply_block( const prepared_block& prepared )
 { try {
-   block_notification note( next_block );
+   block_notification note( prepared );
+   const signed_block& next_block = prepared.block();
 
    notify_pre_apply_block( note );
 
@@ -2663,11 +2806,11 @@ void database::_apply_block( const signed_block& next_block )
 
    if( !( skip & skip_merkle_check ) )
    {
-      auto merkle_root = next_block.calculate_merkle_root();
+      auto merkle_root = prepared.calculate_merkle_root();
 
       try
       {
-         FC_ASSERT( next_block.transaction_merkle_root == merkle_root, "Merkle check failed", ("next_block.transaction_merkle_root",next_block.transaction_merkle_root)("calc",merkle_root)("next_block",next_block)("id",next_block.id()) );
+         FC_ASSERT( next_block.transaction_merkle_root == merkle_root, "Merkle check failed", ("next_block.transaction_merkle_root",next_block.transaction_merkle_root)("calc",merkle_root)("next_block",next_block)("id",note.block_id) );
       }
       catch( fc::assert_exception& e )
       {
@@ -2679,10 +2822,10 @@ void database::_apply_block( const signed_block& next_block )
       }
    }
 
-   const witness_object& signing_witness = validate_block_header(skip, next_block);
+   const witness_object& signing_witness = validate_block_header(skip, prepared);
 
    const auto& gprops = get_dynamic_global_properties();
-   auto block_size = fc::raw::pack_size( next_block );
+   auto block_size = prepared.pack_size();
    FC_ASSERT( block_size <= gprops.maximum_block_size, "Block Size is too Big", ("next_block_num",next_block_num)("block_size", block_size)("max",gprops.maximum_block_size) );
 
    if( block_size < ZATTERA_MIN_BLOCK_SIZE )
@@ -2708,7 +2851,40 @@ void database::_apply_block( const signed_block& next_block )
       ("witness",witness)("next_block.witness",next_block.witness)("hardfork_state", hardfork_state)
    );
 
-   for( const auto& trx : next_block.transactions )
+   /* Operation validation does not depend on chain state, so it can run for all transactions
+    * of the block at once. Transactions that passed are then applied with skip_validate; one
+    * that failed is simply validated again in order, so it throws exactly where it used to.
+    *
+    * Signature keys are recovered in the same pass. The result only warms the signature cache,
+    * authority checks during apply then find the keys there instead of recovering them serially.
+    */
+   const auto& transactions = next_block.transactions;
+   const bool prevalidate = !( skip & skip_validate );
+   const bool prerecover = !( skip & ( skip_transaction_signatures | skip_authority_check ) );
+   std::vector< uint8_t > prevalidated;
+   if( ( prevalidate || prerecover ) && _my->_validation_pool && transactions.size() > 1 )
+   {
+      const chain_id_type& chain_id = get_chain_id();
+      if( prevalidate )
+         prevalidated.resize( transactions.size(), 0 );
+
+      _my->_validation_pool->run( transactions.size(), [&]( size_t i )
+      {
+         try
+         {
+            if( prevalidate )
+            {
+               transactions[i].validate();
+               prevalidated[i] = 1;
+            }
+            if( prerecover )
+               transactions[i].get_signature_keys( chain_id );
+         }
+         catch( ... ) {}
+      });
+   }
+
+   for( size_t i = 0; i < transactions.size(); ++i )
    {
       /* We do not need to push the undo state for each transaction
        * because they either all apply and are valid or the
@@ -2716,7 +2892,7 @@ void database::_apply_block( const signed_block& next_block )
        * for transactions when validating broadcast transactions or
        * when building a block.
        */
-      apply_transaction( trx, skip );
+      apply_transaction( prepared, i, ( prevalidated.size() && prevalidated[i] ) ? ( skip | skip_validate ) : skip );
       ++_current_trx_in_block;
    }
 
@@ -2729,7 +2905,7 @@ void database::_apply_block( const signed_block& next_block )
 
    update_last_irreversible_block();
 
-   create_block_summary(next_block);
+   create_block_summary(prepared);
    clear_expired_transactions();
    clear_expired_orders();
    clear_expired_delegations();
@@ -2756,8 +2932,8 @@ void database::_apply_block( const signed_block& next_block )
    notify_post_apply_block( note );
 
    notify_changed_objects();
-} //FC_CAPTURE_AND_RETHROW( (next_block.block_num()) )  }
-FC_CAPTURE_LOG_AND_RETHROW( (next_block.block_num()) )
+} //FC_CAPTURE_AND_RETHROW( (prepared.block_num()) )  }
+FC_CAPTURE_LOG_AND_RETHROW( (prepared.block_num()) )
 }
 
 struct process_header_visitor
@@ -2873,14 +3049,15 @@ try {
    }
 } FC_CAPTURE_AND_RETHROW() }
 
-void database::apply_transaction(const signed_transaction& trx, uint32_t skip)
+void database::apply_transaction(const prepared_block& block, size_t trx_in_block, uint32_t skip)
 {
-   detail::with_skip_flags( *this, skip, [&]() { _apply_transaction(trx); });
+   detail::with_skip_flags( *this, skip, [&]() { _apply_transaction( block.block().transactions[trx_in_block], &block, trx_in_block ); });
 }
 
-void database::_apply_transaction(const signed_transaction& trx)
+void database::_apply_transaction(const signed_transaction& trx, const prepared_block* block, size_t trx_in_block)
 { try {
-   transaction_notification note(trx);
+   transaction_notification note = block ? transaction_notification( trx, block->transaction_id( trx_in_block ) )
+                                         : transaction_notification( trx );
    _current_trx_id = note.transaction_id;
    const transaction_id_type& trx_id = note.transaction_id;
    _current_virtual_op = 0;
@@ -2899,13 +3076,14 @@ void database::_apply_transaction(const signed_transaction& trx)
 
    if( !(skip & (skip_transaction_signatures | skip_authority_check) ) )
    {
-      auto get_active  = [&]( const string& name ) { return authority( get< account_authority_object, by_account >( name ).active ); };
-      auto get_owner   = [&]( const string& name ) { return authority( get< account_authority_object, by_account >( name ).owner );  };
-      auto get_posting = [&]( const string& name ) { return authority( get< account_authority_object, by_account >( name ).posting );  };
+      // Authorities are checked in place in shared memory rather than copied for every lookup
+      auto get_active  = [&]( const string& name ) -> const shared_authority& { return get< account_authority_object, by_account >( name ).active; };
+      auto get_owner   = [&]( const string& name ) -> const shared_authority& { return get< account_authority_object, by_account >( name ).owner; };
+      auto get_posting = [&]( const string& name ) -> const shared_authority& { return get< account_authority_object, by_account >( name ).posting; };
 
       try
       {
-         trx.verify_authority( chain_id, get_active, get_owner, get_posting,
+         protocol::verify_authority( trx.operations, trx.get_signature_keys( chain_id ), get_active, get_owner, get_posting,
             ZATTERA_MAX_SIG_CHECK_DEPTH, ZATTERA_MAX_AUTHORITY_MEMBERSHIP, ZATTERA_MAX_SIG_CHECK_ACCOUNTS );
       }
       catch( protocol::tx_missing_active_auth& e )
@@ -2942,7 +3120,15 @@ void database::_apply_transaction(const signed_transaction& trx)
       create<transaction_object>([&](transaction_object& transaction) {
          transaction.trx_id = trx_id;
          transaction.expiration = trx.expiration;
-         fc::raw::pack_to_buffer( transaction.packed_trx, trx );
+         if( block )
+         {
+            const char* packed = block->packed_transaction( trx_in_block );
+            transaction.packed_trx.assign( packed, packed + block->transactions()[ trx_in_block ].pack_size );
+         }
+         else
+         {
+            fc::raw::pack_to_buffer( transaction.packed_trx, trx );
+         }
       });
    }
 
@@ -3112,14 +3298,15 @@ boost::signals2::connection database::add_post_reindex_handler(const reindex_han
    return connect_impl(_post_reindex_signal, func, plugin, group, "<-reindex");
 }
 
-const witness_object& database::validate_block_header( uint32_t skip, const signed_block& next_block )const
+const witness_object& database::validate_block_header( uint32_t skip, const prepared_block& prepared )const
 { try {
+   const signed_block& next_block = prepared.block();
    FC_ASSERT( head_block_id() == next_block.previous, "", ("head_block_id",head_block_id())("next.prev",next_block.previous) );
    FC_ASSERT( head_block_time() < next_block.timestamp, "", ("head_block_time",head_block_time())("next",next_block.timestamp)("blocknum",next_block.block_num()) );
    const witness_object& witness = get_witness( next_block.witness );
 
    if( !(skip&skip_witness_signature) )
-      FC_ASSERT( next_block.validate_signee( witness.signing_key ) );
+      FC_ASSERT( prepared.validate_signee( witness.signing_key ) );
 
    if( !(skip&skip_witness_schedule_check) )
    {
@@ -3135,7 +3322,7 @@ const witness_object& database::validate_block_header( uint32_t skip, const sign
    return witness;
 } FC_CAPTURE_AND_RETHROW() }
 
-void database::create_block_summary(const signed_block& next_block)
+void database::create_block_summary(const prepared_block& next_block)
 { try {
    block_summary_id_type sid( next_block.block_num() & 0xffff );
    modify( get< block_summary_object >( sid ), [&](block_summary_object& p) {
@@ -3309,7 +3496,7 @@ void database::update_last_irreversible_block()
          {
             shared_ptr< fork_item > block = _fork_db.fetch_block_on_main_branch_by_number( log_head_num+1 );
             FC_ASSERT( block, "Current fork in the fork database does not contain the last_irreversible_block" );
-            _block_log.append( block->data );
+            _block_log.append( block->prepared );
             log_head_num++;
          }
 
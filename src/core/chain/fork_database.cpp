@@ -2,15 +2,22 @@
 
 #include <zattera/chain/database_exceptions.hpp>
 
+#include <algorithm>
+
 namespace zattera { namespace chain {
 
 fork_database::fork_database()
 {
+   reserve_slots( _max_size + 2 );
 }
 void fork_database::reset()
 {
    _head.reset();
-   _index.clear();
+   for( auto& s : _slots )
+      s.clear();
+   _first_num = 0;
+   _last_num = 0;
+   _item_count = 0;
 }
 
 void fork_database::pop_block()
@@ -23,16 +30,15 @@ void fork_database::pop_block()
 
 void     fork_database::start_block(signed_block b)
 {
-   auto item = std::make_shared<fork_item>(std::move(b));
-   _index.insert(item);
-   _head = item;
+   auto item = std::make_shared<fork_item>(prepared_block(std::move(b)));
+   _head = insert(item);
 }
 
 /**
- * Pushes the block into the fork database and caches it if it doesn't link
+ * Pushes the block into the fork database
  *
  */
-shared_ptr<fork_item>  fork_database::push_block(const signed_block& b)
+shared_ptr<fork_item>  fork_database::push_block(const prepared_block& b)
 {
    auto item = std::make_shared<fork_item>(b);
    try {
@@ -41,9 +47,8 @@ shared_ptr<fork_item>  fork_database::push_block(const signed_block& b)
    catch ( const unlinkable_block_exception& e )
    {
       wlog( "Pushing block to fork database that failed to link: ${id}, ${num}", ("id",b.id())("num",b.block_num()) );
-      wlog( "Head: ${num}, ${id}", ("num",_head->data.block_num())("id",_head->data.id()) );
+      wlog( "Head: ${num}, ${id}", ("num",_head->num)("id",_head->id) );
       throw;
-      _unlinked_index.insert( item );
    }
    return _head;
 }
@@ -59,90 +64,111 @@ void  fork_database::_push_block(const item_ptr& item)
 
    if( _head && item->previous_id() != block_id_type() )
    {
-      auto& index = _index.get<block_id>();
-      auto itr = index.find(item->previous_id());
-      ZATTERA_ASSERT(itr != index.end(), unlinkable_block_exception, "block does not link to known chain");
-      FC_ASSERT(!(*itr)->invalid);
-      item->prev = *itr;
+      auto prev = fetch_block(item->previous_id());
+      ZATTERA_ASSERT(prev, unlinkable_block_exception, "block does not link to known chain");
+      FC_ASSERT(!prev->invalid);
+      item->prev = prev;
    }
 
-   _index.insert(item);
-   if( !_head || item->num > _head->num ) _head = item;
+   auto stored = insert(item);
+   if( !_head || stored->num > _head->num ) _head = stored;
 }
 
-/**
- *  Iterate through the unlinked cache and insert anything that
- *  links to the newly inserted item.  This will start a recursive
- *  set of calls performing a depth-first insertion of pending blocks as
- *  _push_next(..) calls _push_block(...) which will in turn call _push_next
- */
-void fork_database::_push_next( const item_ptr& new_item )
+item_ptr fork_database::insert( const item_ptr& item )
 {
-    auto& prev_idx = _unlinked_index.get<by_previous>();
+   uint32_t num = item->num;
+   // A block received again is kept once, the copy already linked in is returned
+   if( auto existing = fetch_block( item->id ) )
+      return existing;
 
-    auto itr = prev_idx.find( new_item->id );
-    while( itr != prev_idx.end() )
-    {
-       auto tmp = *itr;
-       prev_idx.erase( itr );
-       _push_block( tmp );
+   if( _item_count == 0 )
+   {
+      _first_num = num;
+      _last_num = num;
+   }
+   else if( num > _last_num )
+   {
+      _last_num = num;
+      // The ring is always larger than the window kept, whatever would be overwritten is
+      // older than any block that may still be pushed
+      if( _last_num - _first_num >= _slots.size() )
+         prune_below( _last_num - _slots.size() + 1 );
+   }
+   else if( num < _first_num )
+   {
+      reserve_slots( _last_num - num + 1 );
+      _first_num = num;
+   }
 
-       itr = prev_idx.find( new_item->id );
-    }
+   slot( num ).push_back( item );
+   ++_item_count;
+   return item;
 }
 
-void fork_database::set_max_size( uint32_t s )
+void fork_database::prune_below( uint32_t num )
 {
-   _max_size = s;
-   if( !_head ) return;
+   if( _item_count == 0 || num <= _first_num )
+      return;
 
-   { /// index
-      auto& by_num_idx = _index.get<block_num>();
-      auto itr = by_num_idx.begin();
-      while( itr != by_num_idx.end() )
+   if( num > _last_num )
+   {
+      for( uint32_t n = _first_num; n <= _last_num && _item_count > 0; ++n )
       {
-         if( (*itr)->num < std::max(int64_t(0),int64_t(_head->num) - _max_size) )
-            by_num_idx.erase(itr);
-         else
-            break;
-         itr = by_num_idx.begin();
+         _item_count -= slot( n ).size();
+         slot( n ).clear();
       }
+      _item_count = 0;
+      _first_num = _last_num = num;
+      return;
    }
-   { /// unlinked_index
-      auto& by_num_idx = _unlinked_index.get<block_num>();
-      auto itr = by_num_idx.begin();
-      while( itr != by_num_idx.end() )
-      {
-         if( (*itr)->num < std::max(int64_t(0),int64_t(_head->num) - _max_size) )
-            by_num_idx.erase(itr);
-         else
-            break;
-         itr = by_num_idx.begin();
-      }
+
+   for( uint32_t n = _first_num; n < num; ++n )
+   {
+      _item_count -= slot( n ).size();
+      slot( n ).clear();
    }
+   _first_num = num;
+}
+
+void fork_database::reserve_slots( uint32_t count )
+{
+   if( _slots.size() >= count )
+      return;
+
+   size_t size = 1;
+   while( size < count )
+      size <<= 1;
+
+   vector< branch_type > old_slots( size );
+   old_slots.swap( _slots );
+   for( auto& s : old_slots )
+      for( auto& item : s )
+         slot( item->num ).push_back( std::move( item ) );
+}
+
+void fork_database::set_max_size( uint32_t s )
+{
+   _max_size = s;
+   reserve_slots( _max_size + 2 );
+   if( !_head ) return;
+
+   prune_below( uint32_t( std::max( int64_t(0), int64_t(_head->num) - _max_size ) ) );
 }
 
 bool fork_database::is_known_block(const block_id_type& id)const
 {
-   auto& index = _index.get<block_id>();
-   auto itr = index.find(id);
-   if( itr != index.end() )
-      return true;
-   auto& unlinked_index = _unlinked_index.get<block_id>();
-   auto unlinked_itr = unlinked_index.find(id);
-   return unlinked_itr != unlinked_index.end();
+   return fetch_block(id) != nullptr;
 }
 
 item_ptr fork_database::fetch_block(const block_id_type& id)const
 {
-   auto& index = _index.get<block_id>();
-   auto itr = index.find(id);
-   if( itr != index.end() )
-      return *itr;
-   auto& unlinked_index = _unlinked_index.get<block_id>();
-   auto unlinked_itr = unlinked_index.find(id);
-   if( unlinked_itr != unlinked_index.end() )
-      return *unlinked_itr;
+   uint32_t num = protocol::block_header::num_from_id(id);
+   if( _item_count == 0 || num < _first_num || num > _last_num )
+      return item_ptr();
+
+   for( const auto& item : slot(num) )
+      if( item->id == id )
+         return item;
    return item_ptr();
 }
 
@@ -150,17 +176,9 @@ vector<item_ptr> fork_database::fetch_block_by_number(uint32_t num)const
 {
    try
    {
-   vector<item_ptr> result;
-   auto itr = _index.get<block_num>().find(num);
-   while( itr != _index.get<block_num>().end() )
-   {
-      if( (*itr)->num == num )
-         result.push_back( *itr );
-      else
-         break;
-      ++itr;
-   }
-   return result;
+   if( _item_count == 0 || num < _first_num || num > _last_num )
+      return vector<item_ptr>();
+   return slot(num);
    }
    FC_LOG_AND_RETHROW()
 }
@@ -171,28 +189,25 @@ pair<fork_database::branch_type,fork_database::branch_type>
    // This function gets a branch (i.e. vector<fork_item>) leading
    // back to the most recent common ancestor.
    pair<branch_type,branch_type> result;
-   auto first_branch_itr = _index.get<block_id>().find(first);
-   FC_ASSERT(first_branch_itr != _index.get<block_id>().end());
-   auto first_branch = *first_branch_itr;
+   auto first_branch = fetch_block(first);
+   FC_ASSERT(first_branch);
 
-   auto second_branch_itr = _index.get<block_id>().find(second);
-   FC_ASSERT(second_branch_itr != _index.get<block_id>().end());
-   auto second_branch = *second_branch_itr;
+   auto second_branch = fetch_block(second);
+   FC_ASSERT(second_branch);
 
-
-   while( first_branch->data.block_num() > second_branch->data.block_num() )
+   while( first_branch->num > second_branch->num )
    {
       result.first.push_back(first_branch);
       first_branch = first_branch->prev.lock();
       FC_ASSERT(first_branch);
    }
-   while( second_branch->data.block_num() > first_branch->data.block_num() )
+   while( second_branch->num > first_branch->num )
    {
       result.second.push_back( second_branch );
       second_branch = second_branch->prev.lock();
       FC_ASSERT(second_branch);
    }
-   while( first_branch->data.previous != second_branch->data.previous )
+   while( first_branch->previous_id() != second_branch->previous_id() )
    {
       result.first.push_back(first_branch);
       result.second.push_back(second_branch);
@@ -237,7 +252,17 @@ void fork_database::set_head(shared_ptr<fork_item> h)
 
 void fork_database::remove(block_id_type id)
 {
-   _index.get<block_id>().erase(id);
+   uint32_t num = protocol::block_header::num_from_id(id);
+   if( _item_count == 0 || num < _first_num || num > _last_num )
+      return;
+
+   auto& items = slot(num);
+   auto itr = std::find_if( items.begin(), items.end(), [&]( const item_ptr& item ) { return item->id == id; } );
+   if( itr != items.end() )
+   {
+      items.erase( itr );
+      --_item_count;
+   }
 }
 
 } } // zattera::chain
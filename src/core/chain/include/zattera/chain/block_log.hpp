@@ -1,6 +1,6 @@
 #pragma once
 #include <fc/filesystem.hpp>
-#include <zattera/protocol/block.hpp>
+#include <zattera/protocol/prepared_block.hpp>
 
 namespace zattera { namespace chain {
 
@@ -43,6 +43,8 @@ namespace zattera { namespace chain {
          bool is_open()const;
 
          uint64_t append( const signed_block& b );
+         /// Writes the already packed bytes of a prepared block
+         uint64_t append( const prepared_block& b );
          void flush();
          std::pair< signed_block, uint64_t > read_block( uint64_t file_pos )const;
          optional< signed_block > read_block_by_num( uint32_t block_num )const;
@@ -64,6 +66,7 @@ namespace zattera { namespace chain {
 
       private:
          void construct_index();
+         uint64_t append_packed( const signed_block& b, const block_id_type& id, const char* data, size_t size );
 
          std::pair< signed_block, uint64_t > read_block_helper( uint64_t file_pos )const;
          uint64_t get_block_pos_helper( uint32_t block_num ) const;
@@ -1,20 +1,22 @@
 #pragma once
 
-#include <zattera/protocol/block.hpp>
+#include <zattera/protocol/prepared_block.hpp>
 
 namespace zattera { namespace chain {
 
 struct block_notification
 {
-   block_notification( const zattera::protocol::signed_block& b ) : block(b)
+   block_notification( const zattera::protocol::prepared_block& b ) : block(b.block()), prepared(b)
    {
       block_id = b.id();
-      block_num = block_header::num_from_id( block_id );
+      block_num = b.block_num();
    }
 
    zattera::protocol::block_id_type          block_id;
    uint32_t                                block_num = 0;
    const zattera::protocol::signed_block&    block;
+   /// Packed bytes, transaction ids and sizes of the block, computed once when it was received
+   const zattera::protocol::prepared_block&  prepared;
 };
 
 } }
@@ -0,0 +1,70 @@
+#pragma once
+#include <fc/filesystem.hpp>
+#include <zattera/chain/zattera_object_types.hpp>
+
+namespace zattera { namespace chain {
+
+   namespace detail { class comment_content_store_impl; }
+
+   /// The text of one version of a comment
+   struct comment_content
+   {
+      string title;
+      string body;
+      string json_metadata;
+   };
+
+   /* The comment content store is an external append only log of comment titles, bodies and json
+    * metadata, used in place of the shared strings of comment_content_object so that the text of
+    * every post does not have to live in shared memory. Each entry holds one version of a comment:
+    *
+    * +------------+------------+-------------------+------------+------------+-------------------+-----+
+    * | Size of E1 | Comment id | Packed content E1 | Size of E2 | Comment id | Packed content E2 | ... |
+    * +------------+------------+-------------------+------------+------------+-------------------+-----+
+    *
+    * The size is a uint32 covering the comment id and the packed content. The comment_content_object
+    * keeps the position and size of the entry of its current version, so an edit appends a new entry
+    * and moves the object to it. Entries are never overwritten, which keeps undo trivial: reverting
+    * the object points it back at the previous entry, still intact in the file. The price is that
+    * superseded and undone entries are only reclaimed when the state is rebuilt by a reindex.
+    *
+    * The shared memory file survives the process being killed, so the database flushes the store after
+    * every block and records the resulting size in the comment_content_store_object. A file shorter
+    * than that size on open is missing entries and the chain must be replayed. Recently read and
+    * written entries are kept in an in memory cache bounded by their total size.
+    */
+   class comment_content_store {
+      public:
+         comment_content_store();
+         ~comment_content_store();
+
+         /// @param cache_size maximum size in bytes of the cached entries, 0 disables the cache
+         void open( const fc::path& file, uint64_t cache_size );
+         void close();
+         bool is_open()const;
+
+         /// Discards every entry, used when the state is initialized from scratch
+         void clear();
+         void flush();
+
+         /**
+          * Appends an entry for content and returns its position. When the last entry written for
+          * the comment holds the same content, as when an operation is applied again after being
+          * undone, that entry is returned instead of writing a copy.
+          * @param entry_size set to the size to pass back to read()
+          */
+         uint64_t append( comment_id_type comment, const comment_content& content, uint32_t& entry_size );
+         comment_content read( comment_id_type comment, uint64_t position, uint32_t entry_size )const;
+
+         /// Size of the file, including entries not flushed yet
+         uint64_t size()const;
+         /// Total size of the cached entries
+         uint64_t cached_bytes()const;
+
+      private:
+         std::unique_ptr< detail::comment_content_store_impl > my;
+   };
+
+} }
+
+FC_REFLECT( zattera::chain::comment_content, (title)(body)(json_metadata) )
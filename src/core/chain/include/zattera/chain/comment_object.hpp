@@ -122,6 +122,31 @@ namespace zattera { namespace chain {
          shared_string     title;
          shared_string     body;
          shared_string     json_metadata;
+
+         /// Where the content is in the comment content store, the strings above are empty when content_size is set
+         uint64_t          content_position = 0;
+         uint32_t          content_size = 0;
+   };
+
+   /**
+    * Singleton recording how much of the comment content store the state depends on. It is updated
+    * after every block, once the block's entries are flushed, so a store file found shorter than this
+    * on open is missing entries the state references.
+    */
+   class comment_content_store_object : public object< comment_content_store_object_type, comment_content_store_object >
+   {
+      comment_content_store_object() = delete;
+
+      public:
+         template< typename Constructor, typename Allocator >
+         comment_content_store_object( Constructor&& c, allocator< Allocator > a )
+         {
+            c( *this );
+         }
+
+         id_type           id;
+
+         uint64_t          committed_size = 0;
    };
 
    /**
@@ -248,6 +273,14 @@ namespace zattera { namespace chain {
       allocator< comment_content_object >
    > comment_content_index;
 
+   typedef multi_index_container<
+      comment_content_store_object,
+      indexed_by<
+         ordered_unique< tag< by_id >, member< comment_content_store_object, comment_content_store_id_type, &comment_content_store_object::id > >
+      >,
+      allocator< comment_content_store_object >
+   > comment_content_store_index;
+
 } } // zattera::chain
 
 FC_REFLECT( zattera::chain::comment_object,
@@ -264,9 +297,13 @@ FC_REFLECT( zattera::chain::comment_object,
 CHAINBASE_SET_INDEX_TYPE( zattera::chain::comment_object, zattera::chain::comment_index )
 
 FC_REFLECT( zattera::chain::comment_content_object,
-            (id)(comment)(title)(body)(json_metadata) )
+            (id)(comment)(title)(body)(json_metadata)(content_position)(content_size) )
 CHAINBASE_SET_INDEX_TYPE( zattera::chain::comment_content_object, zattera::chain::comment_content_index )
 
+FC_REFLECT( zattera::chain::comment_content_store_object,
+            (id)(committed_size) )
+CHAINBASE_SET_INDEX_TYPE( zattera::chain::comment_content_store_object, zattera::chain::comment_content_store_index )
+
 FC_REFLECT( zattera::chain::comment_vote_object,
              (id)(voter)(comment)(weight)(rshares)(vote_percent)(last_update)(num_changes)
           )
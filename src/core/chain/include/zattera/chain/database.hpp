@@ -5,6 +5,7 @@
 #include <zattera/chain/block_log.hpp>
 #include <zattera/chain/block_notification.hpp>
 #include <zattera/chain/chain_property_object.hpp>
+#include <zattera/chain/comment_content_store.hpp>
 #include <zattera/chain/fork_database.hpp>
 #include <zattera/chain/global_property_object.hpp>
 #include <zattera/chain/hardfork_property_object.hpp>
@@ -105,6 +106,11 @@ namespace zattera { namespace chain {
             uint32_t chainbase_flags = 0;
             bool do_validate_invariants = false;
             bool benchmark_is_enabled = false;
+            bool compact_shared_file = false;
+
+            /// Keeps comment titles, bodies and json metadata in the comment content store instead of shared memory
+            bool use_comment_content_store = false;
+            uint64_t comment_content_cache_size = 0;
 
             // The following fields are only used on reindexing
             uint32_t stop_replay_at = 0;
@@ -140,6 +146,9 @@ namespace zattera { namespace chain {
          void wipe(const fc::path& data_dir, const fc::path& shared_mem_dir, bool include_blocks);
          void close(bool rewind = true);
 
+         /// Flushes the comment content store and the shared memory file, in that order
+         void flush();
+
          //////////////////// db_block.cpp ////////////////////
 
          /**
@@ -152,6 +161,8 @@ namespace zattera { namespace chain {
          block_id_type              get_block_id_for_num( uint32_t block_num )const;
          optional<signed_block>     fetch_block_by_id( const block_id_type& id )const;
          optional<signed_block>     fetch_block_by_number( uint32_t num )const;
+         /// Only reversible blocks, which are still in the fork DB, are available prepared
+         optional<prepared_block>   fetch_prepared_block_by_id( const block_id_type& id )const;
          const signed_transaction   get_recent_transaction( const transaction_id_type& trx_id )const;
          std::vector<block_id_type> get_block_ids_on_fork(block_id_type head_of_fork) const;
 
@@ -189,6 +200,17 @@ namespace zattera { namespace chain {
          const comment_object*  find_comment( const account_name_type& author, const string& permlink )const;
 #endif
 
+         /**
+          *  The title, body and json metadata of a comment, read from shared memory or from the comment
+          *  content store depending on where they were written. Empty when comment content is not kept.
+          */
+         comment_content        get_comment_content( const comment_id_type& comment )const;
+         comment_content        get_comment_content( const comment_content_object& con )const;
+
+         /// Stores content for the comment, must be called from within create or modify of con
+         void                   set_comment_content( comment_content_object& con, const comment_content& content );
+         const comment_content_store& get_comment_content_store()const { return _comment_content_store; }
+
          const escrow_object&   get_escrow(  const account_name_type& name, uint32_t escrow_id )const;
          const escrow_object*   find_escrow( const account_name_type& name, uint32_t escrow_id )const;
 
@@ -222,9 +244,10 @@ namespace zattera { namespace chain {
          bool                                   before_last_checkpoint()const;
 
          bool push_block( const signed_block& b, uint32_t skip = skip_nothing );
+         bool push_block( const prepared_block& b, uint32_t skip = skip_nothing );
          void push_transaction( const signed_transaction& trx, uint32_t skip = skip_nothing );
          void _maybe_warn_multiple_production( uint32_t height )const;
-         bool _push_block( const signed_block& b );
+         bool _push_block( const prepared_block& b );
          void _push_transaction( const signed_transaction& trx );
 
          signed_block generate_block(
@@ -442,8 +465,20 @@ namespace zattera { namespace chain {
          const std::string& get_json_schema() const;
 
          void set_flush_interval( uint32_t flush_blocks );
+
+         /**
+          * Number of worker threads used to validate the transactions of a block in parallel before
+          * they are applied in order. 0 (the default) validates each transaction inline.
+          */
+         void set_parallel_validation_threads( uint32_t threads );
          void check_free_memory( bool force_print, uint32_t current_block_num );
 
+         /**
+          * Rebuilds the shared memory file into a densely packed segment and logs the reclaimed
+          * space. Must be called when there is no undo state, e.g. right after open().
+          */
+         void compact_shared_memory();
+
 #ifdef IS_TEST_MODE
          bool skip_price_feed_limit_check = true;
          bool skip_transaction_delta_check = true;
@@ -458,18 +493,19 @@ namespace zattera { namespace chain {
       private:
          optional< chainbase::database::session > _pending_tx_session;
 
-         void apply_block( const signed_block& next_block, uint32_t skip = skip_nothing );
-         void apply_transaction( const signed_transaction& trx, uint32_t skip = skip_nothing );
-         void _apply_block( const signed_block& next_block );
-         void _apply_transaction( const signed_transaction& trx );
+         void apply_block( const prepared_block& next_block, uint32_t skip = skip_nothing );
+         void apply_transaction( const prepared_block& block, size_t trx_in_block, uint32_t skip = skip_nothing );
+         void _apply_block( const prepared_block& next_block );
+         /// When the transaction is part of a prepared block, its cached id and packed bytes are used
+         void _apply_transaction( const signed_transaction& trx, const prepared_block* block = nullptr, size_t trx_in_block = 0 );
          void apply_operation( const operation& op );
 
 
          ///Steps involved in applying a new block
          ///@{
 
-         const witness_object& validate_block_header( uint32_t skip, const signed_block& next_block )const;
-         void create_block_summary(const signed_block& next_block);
+         const witness_object& validate_block_header( uint32_t skip, const prepared_block& next_block )const;
+         void create_block_summary(const prepared_block& next_block);
 
          void clear_null_account_balance();
 
@@ -497,6 +533,8 @@ namespace zattera { namespace chain {
          protocol::hardfork_version    _hardfork_versions[ ZATTERA_NUM_HARDFORKS + 1 ];
 
          block_log                     _block_log;
+         comment_content_store         _comment_content_store;
+         bool                          _use_comment_content_store = false;
 
          // this function needs access to _plugin_index_signal
          template< typename MultiIndexType >
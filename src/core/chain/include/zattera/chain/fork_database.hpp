@@ -1,24 +1,16 @@
 #pragma once
-#include <zattera/protocol/block.hpp>
-
-#include <boost/multi_index_container.hpp>
-#include <boost/multi_index/member.hpp>
-#include <boost/multi_index/ordered_index.hpp>
-#include <boost/multi_index/hashed_index.hpp>
-#include <boost/multi_index/mem_fun.hpp>
+#include <zattera/protocol/prepared_block.hpp>
 
 
 namespace zattera { namespace chain {
-   using boost::multi_index_container;
-   using namespace boost::multi_index;
-
    using zattera::protocol::signed_block;
+   using zattera::protocol::prepared_block;
    using zattera::protocol::block_id_type;
 
    struct fork_item
    {
-      fork_item( signed_block d )
-      :num(d.block_num()),id(d.id()),data( std::move(d) ){}
+      fork_item( prepared_block b )
+      :num(b.block_num()),id(b.id()),prepared( std::move(b) ),data( prepared.block() ){}
 
       block_id_type previous_id()const { return data.previous; }
 
@@ -30,7 +22,8 @@ namespace zattera { namespace chain {
        */
       bool                  invalid = false;
       block_id_type         id;
-      signed_block          data;
+      prepared_block        prepared;
+      const signed_block&   data;
    };
    typedef shared_ptr<fork_item> item_ptr;
 
@@ -44,6 +37,12 @@ namespace zattera { namespace chain {
     *
     *  Every time a block is pushed into the fork DB the
     *  block with the highest block_num will be returned.
+    *
+    *  Items live in a ring of slots indexed by block number, a slot holding every
+    *  block at that height. A block id carries its block number, so a lookup by id
+    *  only scans the few blocks of one slot, and dropping the blocks that fell out
+    *  of the window clears one slot per block the head advanced. Each item shares
+    *  the prepared block, and its packed bytes, with the chain and the block log.
     */
    class fork_database
    {
@@ -65,7 +64,7 @@ namespace zattera { namespace chain {
          /**
           *  @return the new head block ( the longest fork )
           */
-         shared_ptr<fork_item>            push_block(const signed_block& b);
+         shared_ptr<fork_item>            push_block(const prepared_block& b);
          shared_ptr<fork_item>            head()const { return _head; }
          void                             pop_block();
 
@@ -78,29 +77,26 @@ namespace zattera { namespace chain {
          shared_ptr<fork_item>            walk_main_branch_to_num( uint32_t block_num )const;
          shared_ptr<fork_item>            fetch_block_on_main_branch_by_number( uint32_t block_num )const;
 
-         struct block_id;
-         struct block_num;
-         struct by_previous;
-         typedef multi_index_container<
-            item_ptr,
-            indexed_by<
-               hashed_unique<tag<block_id>, member<fork_item, block_id_type, &fork_item::id>, std::hash<fc::ripemd160>>,
-               hashed_non_unique<tag<by_previous>, const_mem_fun<fork_item, block_id_type, &fork_item::previous_id>, std::hash<fc::ripemd160>>,
-               ordered_non_unique<tag<block_num>, member<fork_item,uint32_t,&fork_item::num>>
-            >
-         > fork_multi_index_type;
-
          void set_max_size( uint32_t s );
 
       private:
-         /** @return a pointer to the newly pushed item */
          void _push_block(const item_ptr& b );
-         void _push_next(const item_ptr& newly_inserted);
+
+         const branch_type&       slot( uint32_t num )const { return _slots[ num & ( _slots.size() - 1 ) ]; }
+         branch_type&             slot( uint32_t num )      { return _slots[ num & ( _slots.size() - 1 ) ]; }
+         /// Returns the item already stored when a block with the same id is known
+         item_ptr                 insert( const item_ptr& item );
+         void                     prune_below( uint32_t num );
+         void                     reserve_slots( uint32_t count );
 
          uint32_t                 _max_size = 1024;
 
-         fork_multi_index_type    _unlinked_index;
-         fork_multi_index_type    _index;
+         /// Power of two sized, always larger than the window of block numbers kept
+         vector< branch_type >    _slots;
+         /// Block numbers that may have items, slots are cleared from _first_num on when pruning
+         uint32_t                 _first_num = 0;
+         uint32_t                 _last_num = 0;
+         size_t                   _item_count = 0;
          shared_ptr<fork_item>    _head;
    };
 
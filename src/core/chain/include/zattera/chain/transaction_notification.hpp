@@ -11,6 +11,9 @@ struct transaction_notification
       transaction_id = tx.id();
    }
 
+   transaction_notification( const zattera::protocol::signed_transaction& tx, const zattera::protocol::transaction_id_type& id )
+      : transaction_id(id), transaction(tx) {}
+
    zattera::protocol::transaction_id_type          transaction_id;
    const zattera::protocol::signed_transaction&    transaction;
 };
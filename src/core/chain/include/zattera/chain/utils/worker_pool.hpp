@@ -0,0 +1,34 @@
+#pragma once
+
+#include <boost/asio/thread_pool.hpp>
+
+#include <functional>
+#include <memory>
+
+namespace zattera { namespace chain { namespace util {
+
+/**
+ * Fixed set of worker threads used to spread stateless, per-item work (validation, signature
+ * recovery) across cores. The calling thread takes part in the work, so a pool of N threads
+ * runs up to N+1 items at once.
+ *
+ * The work function must not touch chainbase state and must not throw; callers are expected
+ * to record failures per item and handle them in order once the batch completes.
+ */
+class worker_pool
+{
+   public:
+      explicit worker_pool( uint32_t thread_count );
+      ~worker_pool();
+
+      uint32_t size()const { return _thread_count; }
+
+      /// Calls work( i ) for every i in [0, count) and returns once all calls have finished
+      void run( size_t count, const std::function< void( size_t ) >& work );
+
+   private:
+      uint32_t                                     _thread_count = 0;
+      std::unique_ptr< boost::asio::thread_pool >  _pool;
+};
+
+} } } // zattera::chain::util
@@ -65,7 +65,8 @@ enum object_type
    block_stats_object_type,
    reward_fund_object_type,
    vesting_delegation_object_type,
-   vesting_delegation_expiration_object_type
+   vesting_delegation_expiration_object_type,
+   comment_content_store_object_type
 };
 
 class chain_property_object;
@@ -97,6 +98,7 @@ class block_stats_object;
 class reward_fund_object;
 class vesting_delegation_object;
 class vesting_delegation_expiration_object;
+class comment_content_store_object;
 
 typedef oid< chain_property_object                  > chain_property_id_type;
 typedef oid< dynamic_global_property_object         > dynamic_global_property_id_type;
@@ -127,6 +129,7 @@ typedef oid< block_stats_object                     > block_stats_id_type;
 typedef oid< reward_fund_object                     > reward_fund_id_type;
 typedef oid< vesting_delegation_object              > vesting_delegation_id_type;
 typedef oid< vesting_delegation_expiration_object   > vesting_delegation_expiration_id_type;
+typedef oid< comment_content_store_object           > comment_content_store_id_type;
 
 enum bandwidth_type
 {
@@ -218,6 +221,7 @@ FC_REFLECT_ENUM( zattera::chain::object_type,
                  (reward_fund_object_type)
                  (vesting_delegation_object_type)
                  (vesting_delegation_expiration_object_type)
+                 (comment_content_store_object_type)
                )
 
 #ifndef ENABLE_STD_ALLOCATOR
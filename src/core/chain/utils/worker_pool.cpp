@@ -0,0 +1,72 @@
+#include <zattera/chain/utils/worker_pool.hpp>
+
+#include <boost/asio/post.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+
+namespace zattera { namespace chain { namespace util {
+
+worker_pool::worker_pool( uint32_t thread_count )
+   : _thread_count( thread_count )
+{
+   if( _thread_count > 0 )
+      _pool.reset( new boost::asio::thread_pool( _thread_count ) );
+}
+
+worker_pool::~worker_pool()
+{
+   if( _pool )
+   {
+      _pool->stop();
+      _pool->join();
+   }
+}
+
+void worker_pool::run( size_t count, const std::function< void( size_t ) >& work )
+{
+   if( count == 0 )
+      return;
+
+   if( !_pool || count == 1 )
+   {
+      for( size_t i = 0; i < count; ++i )
+         work( i );
+      return;
+   }
+
+   std::atomic< size_t >   next( 0 );
+   size_t                  helpers = std::min< size_t >( _thread_count, count - 1 );
+   size_t                  helpers_done = 0;
+   std::mutex              done_mutex;
+   std::condition_variable done_cv;
+
+   auto drain = [&]()
+   {
+      for( size_t i = next++; i < count; i = next++ )
+         work( i );
+   };
+
+   // Helpers reference this stack frame, so we must not return before every one of them has exited,
+   // even those that started too late to find any work left.
+   for( size_t h = 0; h < helpers; ++h )
+   {
+      boost::asio::post( *_pool, [&]()
+      {
+         drain();
+
+         std::lock_guard< std::mutex > lock( done_mutex );
+         if( ++helpers_done == helpers )
+            done_cv.notify_one();
+      } );
+   }
+
+   drain();
+
+   std::unique_lock< std::mutex > lock( done_mutex );
+   done_cv.wait( lock, [&]() { return helpers_done == helpers; } );
+}
+
+} } } // zattera::chain::util
@@ -643,12 +643,14 @@ void comment_evaluator::do_apply( const comment_operation& o )
       {
          con.comment = id;
 
-         from_string( con.title, o.title );
+         comment_content content;
+         content.title = o.title;
          if( o.body.size() < 1024*1024*128 )
          {
-            from_string( con.body, o.body );
+            content.body = o.body;
          }
-         from_string( con.json_metadata, o.json_metadata );
+         content.json_metadata = o.json_metadata;
+         _db.set_comment_content( con, content );
       });
    #endif
 
@@ -691,31 +693,36 @@ void comment_evaluator::do_apply( const comment_operation& o )
          }
       });
    #ifndef IS_LOW_MEM
-      _db.modify( _db.get< comment_content_object, by_comment >( comment.id ), [&]( comment_content_object& con )
-      {
-         if( o.title.size() )         from_string( con.title, o.title );
-         if( o.json_metadata.size() )
-            from_string( con.json_metadata, o.json_metadata );
-
-         if( o.body.size() ) {
-            try {
-            diff_match_patch<std::wstring> dmp;
-            auto patch = dmp.patch_fromText( utf8_to_wstring(o.body) );
-            if( patch.size() ) {
-               auto result = dmp.patch_apply( patch, utf8_to_wstring( to_string( con.body ) ) );
-               auto patched_body = wstring_to_utf8(result.first);
-               if( !fc::is_utf8( patched_body ) ) {
-                  idump(("invalid utf8")(patched_body));
-                  from_string( con.body, fc::prune_invalid_utf8(patched_body) );
-               } else { from_string( con.body, patched_body ); }
-            }
-            else { // replace
-               from_string( con.body, o.body );
-            }
-            } catch ( ... ) {
-               from_string( con.body, o.body );
-            }
+      const auto& comment_content_obj = _db.get< comment_content_object, by_comment >( comment.id );
+      comment_content content = _db.get_comment_content( comment_content_obj );
+
+      if( o.title.size() )         content.title = o.title;
+      if( o.json_metadata.size() )
+         content.json_metadata = o.json_metadata;
+
+      if( o.body.size() ) {
+         try {
+         diff_match_patch<std::wstring> dmp;
+         auto patch = dmp.patch_fromText( utf8_to_wstring(o.body) );
+         if( patch.size() ) {
+            auto result = dmp.patch_apply( patch, utf8_to_wstring( content.body ) );
+            auto patched_body = wstring_to_utf8(result.first);
+            if( !fc::is_utf8( patched_body ) ) {
+               idump(("invalid utf8")(patched_body));
+               content.body = fc::prune_invalid_utf8(patched_body);
+            } else { content.body = patched_body; }
+         }
+         else { // replace
+            content.body = o.body;
          }
+         } catch ( ... ) {
+            content.body = o.body;
+         }
+      }
+
+      _db.modify( comment_content_obj, [&]( comment_content_object& con )
+      {
+         _db.set_comment_content( con, content );
       });
    #endif
 
@@ -123,6 +123,49 @@ namespace chainbase {
       }
    }
 
+   void database::compact()
+   {
+      if( _undo_session_count )
+         BOOST_THROW_EXCEPTION( std::runtime_error( "Cannot compact shared memory file while undo session is active" ) );
+
+#ifndef ENABLE_STD_ALLOCATOR
+      bfs::path data_dir = _data_dir;
+      bfs::path compact_dir = data_dir / "compact";
+      bfs::remove_all( compact_dir );
+
+      {
+         database target;
+         target.open( compact_dir, 0, _file_size );
+
+         for( auto& index_type : _index_types )
+         {
+            index_type->add_index( target );
+            index_type->copy_index( *this, target );
+         }
+
+         target.flush();
+         target.close();
+      }
+
+      _segment.reset();
+      _meta.reset();
+      _flock = bip::file_lock();
+
+      bfs::rename( compact_dir / "shared_memory.bin", data_dir / "shared_memory.bin" );
+      bfs::remove_all( compact_dir );
+
+      open( data_dir, 0, _file_size );
+
+      _index_list.clear();
+      _index_map.clear();
+
+      for( auto& index_type : _index_types )
+      {
+         index_type->add_index( *this );
+      }
+#endif
+   }
+
    void database::set_require_locking( bool enable_require_locking )
    {
 #ifdef CHAINBASE_CHECK_LOCKING
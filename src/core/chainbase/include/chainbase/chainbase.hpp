@@ -54,6 +54,8 @@ namespace helpers
       size_t      _item_additional_allocation = 0;
       /// Additional memory used for container internal structures (like tree nodes).
       size_t      _additional_container_allocation = 0;
+      /// Estimated memory held by the undo stack (saved copies of modified and removed items, ids of created ones)
+      size_t      _undo_stack_allocation = 0;
    };
 
    template <class IndexType>
@@ -482,6 +484,51 @@ namespace chainbase {
             _revision = revision;
          }
 
+         /**
+          * Inserts a copy of every object of other in primary key order, keeping ids, _next_id and
+          * the revision. Used to rebuild an index into a fresh segment, so neither index may have
+          * an undo stack.
+          */
+         void copy_from( const generic_index& other )
+         {
+            if( _stack.size() != 0 || other._stack.size() != 0 )
+               BOOST_THROW_EXCEPTION( std::logic_error("cannot copy index while there is an existing undo stack") );
+
+            for( const auto& item : other._indices )
+            {
+               auto constructor = [&]( value_type& v ) { v = item; };
+               auto insert_result = _indices.emplace( constructor, _indices.get_allocator() );
+
+               if( !insert_result.second ) {
+                  BOOST_THROW_EXCEPTION( std::logic_error("could not insert object, most likely a uniqueness constraint was violated") );
+               }
+            }
+
+            _next_id = other._next_id;
+            _revision = other._revision;
+         }
+
+         /**
+          * Estimate of the memory held by the undo stack. Tree nodes are counted as the stored
+          * value plus three pointers and a color word; dynamic allocations held by saved values
+          * are not included.
+          */
+         size_t undo_stack_allocation()const
+         {
+            const size_t node_overhead = 4 * sizeof( void* );
+            const size_t value_node_size = sizeof( std::pair< typename value_type::id_type, value_type > ) + node_overhead;
+            const size_t id_node_size = sizeof( typename value_type::id_type ) + node_overhead;
+
+            size_t total = 0;
+            for( const auto& state : _stack )
+            {
+               total += sizeof( undo_state_type );
+               total += ( state.old_values.size() + state.removed_values.size() ) * value_node_size;
+               total += state.new_ids.size() * id_node_size;
+            }
+            return total;
+         }
+
       private:
          bool enabled()const { return _stack.size(); }
 
@@ -627,7 +674,9 @@ namespace chainbase {
          {
             typedef typename BaseIndex::index_type index_type;
             helpers::index_statistic_provider<index_type> provider;
-            return provider.gather_statistics(_base.indices(), onlyStaticInfo);
+            statistic_info info = provider.gather_statistics(_base.indices(), onlyStaticInfo);
+            info._undo_stack_allocation = _base.undo_stack_allocation();
+            return info;
          }
          virtual size_t size() const override final
             { return _base.indicies().size(); }
@@ -695,6 +744,7 @@ namespace chainbase {
                virtual ~abstract_index_type() {}
 
                virtual void add_index( database& db ) = 0;
+               virtual void copy_index( const database& source, database& target ) = 0;
          };
 
          template< typename IndexType >
@@ -704,6 +754,11 @@ namespace chainbase {
             {
                db.add_index_helper< IndexType >();
             }
+
+            virtual void copy_index( const database& source, database& target ) override
+            {
+               target.get_mutable_index< IndexType >().copy_from( source.get_index< IndexType >() );
+            }
          };
 
       public:
@@ -712,6 +767,13 @@ namespace chainbase {
          void flush();
          void wipe( const bfs::path& dir );
          void resize( size_t new_shared_file_size );
+
+         /**
+          * Rebuilds every registered index into a fresh shared memory file of the same size,
+          * inserting objects in primary key order, and replaces the current file with it.
+          * Ids and revisions are preserved. Requires that no undo state exists.
+          */
+         void compact();
          void set_require_locking( bool enable_require_locking );
 
 #ifdef CHAINBASE_CHECK_LOCKING
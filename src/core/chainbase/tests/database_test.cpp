@@ -135,4 +135,107 @@ BOOST_AUTO_TEST_CASE( database_open_create_and_undo )
    }
 }
 
+BOOST_AUTO_TEST_CASE( database_compact )
+{
+   boost::filesystem::path temp = boost::filesystem::temp_directory_path() / boost::filesystem::unique_path();
+   BOOST_TEST_MESSAGE( temp.native() );
+
+   try {
+      chainbase::database db;
+      db.open( temp, 0, 1024*1024*8 );
+      db.add_index< book_index >();
+
+      for( int i = 0; i < 1000; ++i )
+         db.create<book>( [&]( book& b ) { b.a = i; b.b = i * 2; } );
+
+      for( int i = 0; i < 1000; i += 2 )
+         db.remove( db.get( book::id_type(i) ) );
+
+      db.set_revision( 42 );
+
+      {
+         auto session = db.start_undo_session();
+         BOOST_CHECK_THROW( db.compact(), std::runtime_error );
+      }
+
+      size_t free_before = db.get_free_memory();
+      db.compact();
+
+      BOOST_REQUIRE_EQUAL( db.get_max_memory(), size_t( 1024*1024*8 ) );
+      BOOST_REQUIRE_GE( db.get_free_memory(), free_before );
+      BOOST_REQUIRE_EQUAL( db.revision(), 42 );
+      BOOST_REQUIRE_EQUAL( db.get_index< book_index >().indices().size(), 500u );
+      BOOST_CHECK( !bfs::exists( temp / "compact" ) );
+
+      for( int i = 1; i < 1000; i += 2 )
+      {
+         const auto& b = db.get( book::id_type(i) );
+         BOOST_REQUIRE_EQUAL( b.a, i );
+         BOOST_REQUIRE_EQUAL( b.b, i * 2 );
+      }
+
+      const auto& new_book = db.create<book>( []( book& b ) { b.a = -1; } );
+      BOOST_REQUIRE( new_book.id == book::id_type(1000) );
+
+      db.close();
+
+      chainbase::database db2;
+      db2.open( temp );
+      db2.add_index< book_index >();
+      BOOST_REQUIRE_EQUAL( db2.get_index< book_index >().indices().size(), 501u );
+      BOOST_REQUIRE_EQUAL( db2.get( book::id_type(999) ).b, 1998 );
+      db2.close();
+
+      bfs::remove_all( temp );
+   } catch ( ... ) {
+      bfs::remove_all( temp );
+      throw;
+   }
+}
+
+BOOST_AUTO_TEST_CASE( index_statistics_report_undo_stack )
+{
+   boost::filesystem::path temp = boost::filesystem::unique_path();
+   BOOST_TEST_MESSAGE( temp.native() );
+
+   try {
+      chainbase::database db;
+      db.open( temp, 0, 1024*1024*8 );
+      db.add_index< book_index >();
+
+      for( int i = 0; i < 10; ++i )
+         db.create<book>( [&]( book& b ) { b.a = i; } );
+
+      const auto& cntr = db.get_abstract_index_cntr();
+      BOOST_REQUIRE_EQUAL( cntr.size(), 1u );
+
+      auto info = cntr.front()->get_statistics( true );
+      BOOST_REQUIRE_EQUAL( info._item_count, 10u );
+      BOOST_REQUIRE_EQUAL( info._item_sizeof, sizeof( book ) );
+      BOOST_REQUIRE_GT( info._additional_container_allocation, 0u );
+      BOOST_REQUIRE_EQUAL( info._undo_stack_allocation, 0u );
+
+      {
+         auto session = db.start_undo_session();
+         size_t empty_stack = cntr.front()->get_statistics( true )._undo_stack_allocation;
+         BOOST_REQUIRE_GT( empty_stack, 0u );
+
+         db.modify( db.get( book::id_type(1) ), []( book& b ) { b.a = 100; } );
+         db.remove( db.get( book::id_type(2) ) );
+         db.create<book>( []( book& b ) { b.a = 200; } );
+
+         size_t with_changes = cntr.front()->get_statistics( true )._undo_stack_allocation;
+         BOOST_REQUIRE_GT( with_changes, empty_stack + 2 * sizeof( book ) );
+      }
+
+      BOOST_REQUIRE_EQUAL( cntr.front()->get_statistics( true )._undo_stack_allocation, 0u );
+
+      db.close();
+      bfs::remove_all( temp );
+   } catch ( ... ) {
+      bfs::remove_all( temp );
+      throw;
+   }
+}
+
 BOOST_AUTO_TEST_SUITE_END()
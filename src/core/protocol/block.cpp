@@ -16,11 +16,15 @@ namespace zattera { namespace protocol {
 
    block_id_type signed_block_header::id()const
    {
-      auto tmp = fc::sha224::hash( *this );
-      tmp._hash[0] = fc::endian_reverse_u32(block_num()); // store the block num in the ID, 160 bits is plenty for the hash
-      static_assert( sizeof(tmp._hash[0]) == 4, "should be 4 bytes" );
+      return id_from_hash( fc::sha224::hash( *this ), block_num() );
+   }
+
+   block_id_type signed_block_header::id_from_hash( fc::sha224 hash, uint32_t block_num )
+   {
+      hash._hash[0] = fc::endian_reverse_u32(block_num); // store the block num in the ID, 160 bits is plenty for the hash
+      static_assert( sizeof(hash._hash[0]) == 4, "should be 4 bytes" );
       block_id_type result;
-      memcpy(result._hash, tmp._hash, std::min(sizeof(result), sizeof(tmp)));
+      memcpy(result._hash, hash._hash, std::min(sizeof(result), sizeof(hash)));
       return result;
    }
 
@@ -49,19 +53,27 @@ namespace zattera { namespace protocol {
       for( uint32_t i = 0; i < transactions.size(); ++i )
          ids[i] = transactions[i].merkle_digest();
 
-      vector<digest_type>::size_type current_number_of_hashes = ids.size();
-      while( current_number_of_hashes > 1 )
-      {
-         // hash ID's in pairs
-         uint32_t i_max = current_number_of_hashes - (current_number_of_hashes&1);
-         uint32_t k = 0;
+      return merkle_root_of( std::move( ids ) );
+   }
 
-         for( uint32_t i = 0; i < i_max; i += 2 )
-            ids[k++] = digest_type::hash( std::make_pair( ids[i], ids[i+1] ) );
+   checksum_type signed_block::merkle_root_of( vector< digest_type > ids )
+   {
+      if( ids.size() == 0 )
+         return checksum_type();
+
+      // Each pair is hashed as the 64 byte concatenation of both digests, so a whole level can be
+      // handed to hash_many at once
+      static_assert( sizeof( digest_type ) == 32, "merkle pairs must be contiguous" );
+      vector<digest_type> next( ( ids.size() + 1 ) / 2 );
+      while( ids.size() > 1 )
+      {
+         size_t pairs = ids.size() / 2;
+         next.resize( pairs + ( ids.size() & 1 ) );
+         digest_type::hash_many( (const char*)ids.data(), 2 * sizeof( digest_type ), pairs, next.data() );
 
-         if( current_number_of_hashes&1 )
-            ids[k++] = ids[i_max];
-         current_number_of_hashes = k;
+         if( ids.size() & 1 )
+            next[pairs] = ids.back();
+         ids.swap( next );
       }
       return checksum_type::hash( ids[0] );
    }
@@ -23,6 +23,9 @@ namespace zattera { namespace protocol {
       void                       sign( const fc::ecc::private_key& signer );
       bool                       validate_signee( const fc::ecc::public_key& expected_signee )const;
 
+      /// Builds the id of a block from the sha224 of its packed signed header
+      static block_id_type       id_from_hash( fc::sha224 hash, uint32_t block_num );
+
       signature_type             witness_signature;
    };
 
@@ -0,0 +1,66 @@
+#pragma once
+#include <zattera/protocol/block.hpp>
+
+#include <memory>
+
+namespace zattera { namespace protocol {
+
+   /**
+    *  An immutable signed_block together with everything that is derived from its serialization:
+    *  the packed bytes, the block id, the header digest and, for every transaction, its id,
+    *  merkle digest and packed size.
+    *
+    *  signed_block::id(), transaction::id() and friends serialize and hash the object again on
+    *  every call. A block is prepared once when it enters the node, from the network or the block
+    *  log, and the chain uses the cached values from then on. The block is packed a single time
+    *  and every hash is taken over a slice of that buffer.
+    *
+    *  Copies share the same state, so a prepared_block is cheap to pass around and store.
+    */
+   class prepared_block
+   {
+      public:
+         struct transaction_info
+         {
+            transaction_id_type id;
+            digest_type         merkle_digest;
+            uint32_t            offset = 0;      ///< position of the transaction in packed()
+            uint32_t            pack_size = 0;
+         };
+
+         explicit prepared_block( const signed_block& b );
+         explicit prepared_block( signed_block&& b );
+
+         const signed_block&              block()const               { return _data->block; }
+         const block_id_type&             id()const                  { return _data->id; }
+         uint32_t                         block_num()const           { return block_header::num_from_id( _data->id ); }
+         const digest_type&               header_digest()const       { return _data->header_digest; }
+
+         const vector< char >&            packed()const              { return _data->packed; }
+         size_t                           pack_size()const           { return _data->packed.size(); }
+
+         const vector< transaction_info >& transactions()const       { return _data->transactions; }
+         const transaction_id_type&       transaction_id( size_t i )const { return _data->transactions[i].id; }
+         const char*                      packed_transaction( size_t i )const { return _data->packed.data() + _data->transactions[i].offset; }
+
+         /** Same result as signed_block::calculate_merkle_root(), from the cached merkle digests */
+         checksum_type                    calculate_merkle_root()const;
+         fc::ecc::public_key              signee()const;
+         bool                             validate_signee( const fc::ecc::public_key& expected_signee )const;
+
+      private:
+         struct data
+         {
+            signed_block                  block;
+            block_id_type                 id;
+            digest_type                   header_digest;
+            vector< char >                packed;
+            vector< transaction_info >    transactions;
+         };
+
+         static void prepare( data& d );
+
+         std::shared_ptr< const data >    _data;
+   };
+
+} } // zattera::protocol
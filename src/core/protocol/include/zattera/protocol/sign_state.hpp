@@ -7,27 +7,21 @@ namespace zattera { namespace protocol {
 
 typedef std::function<authority(const string&)> authority_getter;
 
-struct sign_state
+/**
+ *  Signature bookkeeping shared by every sign_state, independent of how authorities are looked up.
+ */
+struct sign_state_base
 {
       /** returns true if we have a signature for this key or can
        * produce a signature for this key, else returns false.
        */
       bool signed_by( const public_key_type& k );
-      bool check_authority( string id );
-
-      /**
-       *  Checks to see if we have signatures of the active authorites of
-       *  the accounts specified in authority or the keys specified.
-       */
-      bool check_authority( const authority& au, uint32_t depth = 0, uint32_t account_auth_count = 0 );
 
       bool remove_unused_signatures();
 
-      sign_state( const flat_set<public_key_type>& sigs,
-                  const authority_getter& a,
-                  const flat_set<public_key_type>& keys );
+      sign_state_base( const flat_set<public_key_type>& sigs,
+                       const flat_set<public_key_type>& keys );
 
-      const authority_getter&          get_active;
       const flat_set<public_key_type>& available_keys;
 
       flat_map<public_key_type,bool>   provided_signatures;
@@ -35,9 +29,104 @@ struct sign_state
       uint32_t                         max_recursion = ZATTERA_MAX_SIG_CHECK_DEPTH;
       uint32_t                         max_membership = ~0;
       uint32_t                         max_account_auths = ~0;
+};
+
+/**
+ *  Checks authorities against a set of signatures.
+ *
+ *  AuthorityGetter is called with an account name and may return either an authority by value or a
+ *  const reference to any type with the same weight_threshold, key_auths and account_auths members,
+ *  which lets the chain check the shared_authority of an account in place instead of copying it.
+ */
+template< typename AuthorityGetter >
+struct basic_sign_state : public sign_state_base
+{
+      bool check_authority( const string& id )
+      {
+         if( approved_by.find(id) != approved_by.end() ) return true;
+         uint32_t account_auth_count = 1;
+         return check_authority_impl( get_active(id), 0, &account_auth_count );
+      }
+
+      /**
+       *  Checks to see if we have signatures of the active authorites of
+       *  the accounts specified in authority or the keys specified.
+       */
+      template< typename AuthorityType >
+      auto check_authority( const AuthorityType& au, uint32_t depth = 0, uint32_t account_auth_count = 0 )
+         -> decltype( au.weight_threshold, bool() )
+      {
+         return check_authority_impl( au, depth, &account_auth_count );
+      }
+
+      basic_sign_state( const flat_set<public_key_type>& sigs,
+                        const AuthorityGetter& a,
+                        const flat_set<public_key_type>& keys )
+         : sign_state_base( sigs, keys ), get_active( a ) {}
+
+      const AuthorityGetter&           get_active;
 
       private:
-         bool check_authority_impl( const authority& au, uint32_t depth, uint32_t* account_auth_count );
+         template< typename AuthorityType >
+         bool check_authority_impl( const AuthorityType& auth, uint32_t depth, uint32_t* account_auth_count )
+         {
+            uint32_t total_weight = 0;
+            size_t membership = 0;
+            for( const auto& k : auth.key_auths )
+            {
+               if( signed_by( k.first ) )
+               {
+                  total_weight += k.second;
+                  if( total_weight >= auth.weight_threshold )
+                     return true;
+               }
+
+               membership++;
+               if( max_membership > 0 && membership >= max_membership )
+               {
+                  return false;
+               }
+            }
+
+            for( const auto& a : auth.account_auths )
+            {
+               if( approved_by.find(a.first) == approved_by.end() )
+               {
+                  if( depth == max_recursion )
+                     continue;
+
+                  if( max_account_auths > 0 && *account_auth_count >= max_account_auths )
+                  {
+                     return false;
+                  }
+
+                  (*account_auth_count)++;
+
+                  if( check_authority_impl( get_active( a.first ), depth + 1, account_auth_count ) )
+                  {
+                     approved_by.insert( a.first );
+                     total_weight += a.second;
+                     if( total_weight >= auth.weight_threshold )
+                        return true;
+                  }
+               }
+               else
+               {
+                  total_weight += a.second;
+                  if( total_weight >= auth.weight_threshold )
+                     return true;
+               }
+
+               membership++;
+               if( max_membership > 0 && membership >= max_membership )
+               {
+                  return false;
+               }
+            }
+            return total_weight >= auth.weight_threshold;
+         }
 };
 
+typedef basic_sign_state< authority_getter > sign_state;
+
 } } // zattera::protocol
@@ -0,0 +1,78 @@
+#pragma once
+
+#include <zattera/protocol/types.hpp>
+
+#include <array>
+#include <atomic>
+#include <deque>
+#include <mutex>
+#include <unordered_map>
+
+namespace zattera { namespace protocol {
+
+/**
+ *  Process wide cache of public keys recovered from compact signatures, keyed by the signed digest
+ *  and the signature.
+ *
+ *  A transaction is recovered when it is received, again whenever the pending queue is re-applied
+ *  and once more when it is included in a block; all of these go through
+ *  signed_transaction::get_signature_keys, which looks the keys up here first. Only successful
+ *  recoveries are cached, so a hit implies the signature was canonical.
+ *
+ *  The cache is split into shards with their own lock, and recovery itself runs outside of any
+ *  lock, so it can be filled from several threads at once. Each shard evicts its oldest entry
+ *  once it is full.
+ */
+class signature_cache
+{
+   public:
+      static signature_cache& instance();
+
+      /// Returns the key that signed digest with sig, recovering it only if it is not cached.
+      public_key_type recover( const digest_type& digest, const signature_type& sig );
+
+      /// Maximum number of cached keys, 0 disables the cache. Shrinking evicts immediately.
+      void     set_capacity( size_t capacity );
+      size_t   capacity()const { return _capacity; }
+
+      size_t   size()const;
+      uint64_t hits()const { return _hits; }
+      uint64_t misses()const { return _misses; }
+
+      void     clear();
+
+   private:
+      signature_cache();
+
+      struct key_type
+      {
+         digest_type    digest;
+         signature_type sig;
+
+         bool operator==( const key_type& o )const { return digest == o.digest && sig == o.sig; }
+      };
+
+      struct key_hash
+      {
+         size_t operator()( const key_type& k )const;
+      };
+
+      struct shard
+      {
+         mutable std::mutex                                             mutex;
+         std::unordered_map< key_type, public_key_type, key_hash >      keys;
+         std::deque< key_type >                                         insertion_order;
+      };
+
+      static constexpr size_t shard_count = 16;
+
+      shard& shard_for( size_t hash );
+      void   trim( shard& s, size_t limit );
+
+      std::array< shard, shard_count >   _shards;
+      std::atomic< size_t >              _capacity;
+      std::atomic< uint64_t >            _hits;
+      std::atomic< uint64_t >            _misses;
+};
+
+} } // zattera::protocol
@@ -3,6 +3,8 @@
 #include <zattera/protocol/sign_state.hpp>
 #include <zattera/protocol/types.hpp>
 
+#include <fc/io/json_decoder.hpp>
+
 #include <numeric>
 
 namespace zattera { namespace protocol {
@@ -116,3 +118,6 @@ namespace zattera { namespace protocol {
 FC_REFLECT( zattera::protocol::transaction, (ref_block_num)(ref_block_prefix)(expiration)(operations)(extensions) )
 FC_REFLECT_DERIVED( zattera::protocol::signed_transaction, (zattera::protocol::transaction), (signatures) )
 FC_REFLECT_DERIVED( zattera::protocol::annotated_signed_transaction, (zattera::protocol::signed_transaction), (transaction_id)(block_num)(transaction_num) );
+
+FC_JSON_DECODE_REFLECTED( zattera::protocol::transaction )
+FC_JSON_DECODE_REFLECTED( zattera::protocol::signed_transaction )
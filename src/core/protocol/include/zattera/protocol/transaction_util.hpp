@@ -4,11 +4,15 @@
 
 namespace zattera { namespace protocol {
 
-template< typename AuthContainerType >
+/**
+ *  The getters may return authorities by value or, like the chain does, a const reference to an
+ *  authority stored elsewhere; see basic_sign_state.
+ */
+template< typename AuthContainerType, typename ActiveGetter, typename OwnerGetter, typename PostingGetter >
 void verify_authority( const vector<AuthContainerType>& auth_containers, const flat_set<public_key_type>& sigs,
-                       const authority_getter& get_active,
-                       const authority_getter& get_owner,
-                       const authority_getter& get_posting,
+                       const ActiveGetter& get_active,
+                       const OwnerGetter& get_owner,
+                       const PostingGetter& get_posting,
                        uint32_t max_recursion_depth = ZATTERA_MAX_SIG_CHECK_DEPTH,
                        uint32_t max_membership = ZATTERA_MAX_AUTHORITY_MEMBERSHIP,
                        uint32_t max_account_auths = ZATTERA_MAX_SIG_CHECK_ACCOUNTS,
@@ -40,7 +44,7 @@ void verify_authority( const vector<AuthContainerType>& auth_containers, const f
       FC_ASSERT( other.size() == 0 );
 
       flat_set< public_key_type > avail;
-      sign_state s(sigs,get_posting,avail);
+      basic_sign_state< PostingGetter > s(sigs,get_posting,avail);
       s.max_recursion = max_recursion_depth;
       s.max_membership = max_membership;
       s.max_account_auths = max_account_auths;
@@ -53,9 +57,9 @@ void verify_authority( const vector<AuthContainerType>& auth_containers, const f
                           s.check_authority(get_owner(id)),
                           tx_missing_posting_auth, "Missing Posting Authority ${id}",
                           ("id",id)
-                          ("posting",get_posting(id))
-                          ("active",get_active(id))
-                          ("owner",get_owner(id)) );
+                          ("posting",authority(get_posting(id)))
+                          ("active",authority(get_active(id)))
+                          ("owner",authority(get_owner(id))) );
       }
       ZATTERA_ASSERT(
          !s.remove_unused_signatures(),
@@ -66,7 +70,7 @@ void verify_authority( const vector<AuthContainerType>& auth_containers, const f
    }
 
    flat_set< public_key_type > avail;
-   sign_state s(sigs,get_active,avail);
+   basic_sign_state< ActiveGetter > s(sigs,get_active,avail);
    s.max_recursion = max_recursion_depth;
    s.max_membership = max_membership;
    s.max_account_auths = max_account_auths;
@@ -85,14 +89,14 @@ void verify_authority( const vector<AuthContainerType>& auth_containers, const f
    {
       ZATTERA_ASSERT( s.check_authority(id) ||
                        s.check_authority(get_owner(id)),
-                       tx_missing_active_auth, "Missing Active Authority ${id}", ("id",id)("auth",get_active(id))("owner",get_owner(id)) );
+                       tx_missing_active_auth, "Missing Active Authority ${id}", ("id",id)("auth",authority(get_active(id)))("owner",authority(get_owner(id))) );
    }
 
    for( const auto& id : required_owner )
    {
       ZATTERA_ASSERT( owner_approvals.find(id) != owner_approvals.end() ||
                        s.check_authority(get_owner(id)),
-                       tx_missing_owner_auth, "Missing Owner Authority ${id}", ("id",id)("auth",get_owner(id)) );
+                       tx_missing_owner_auth, "Missing Owner Authority ${id}", ("id",id)("auth",authority(get_owner(id))) );
    }
 
    ZATTERA_ASSERT(
@@ -0,0 +1,86 @@
+#include <zattera/protocol/prepared_block.hpp>
+#include <fc/io/raw.hpp>
+
+namespace zattera { namespace protocol {
+
+   prepared_block::prepared_block( const signed_block& b )
+   {
+      auto d = std::make_shared< data >();
+      d->block = b;
+      prepare( *d );
+      _data = std::move( d );
+   }
+
+   prepared_block::prepared_block( signed_block&& b )
+   {
+      auto d = std::make_shared< data >();
+      d->block = std::move( b );
+      prepare( *d );
+      _data = std::move( d );
+   }
+
+   /**
+    *  Packs the block field by field, as FC_REFLECT for signed_block does, so the position of the
+    *  header, the signature and every transaction in the buffer is known without serializing
+    *  anything a second time.
+    */
+   void prepared_block::prepare( data& d )
+   {
+      const signed_block& b = d.block;
+      d.packed.resize( fc::raw::pack_size( b ) );
+      fc::datastream< char* > ds( d.packed.data(), d.packed.size() );
+
+      fc::raw::pack( ds, static_cast< const block_header& >( b ) );
+      size_t header_size = ds.tellp();
+      fc::raw::pack( ds, b.witness_signature );
+      size_t signed_header_size = ds.tellp();
+      fc::raw::pack( ds, fc::unsigned_int( b.transactions.size() ) );
+
+      vector< size_t > unsigned_sizes( b.transactions.size() );
+      d.transactions.resize( b.transactions.size() );
+      for( size_t i = 0; i < b.transactions.size(); ++i )
+      {
+         auto& info = d.transactions[i];
+         info.offset = ds.tellp();
+         fc::raw::pack( ds, static_cast< const transaction& >( b.transactions[i] ) );
+         unsigned_sizes[i] = ds.tellp() - info.offset;
+         fc::raw::pack( ds, b.transactions[i].signatures );
+         info.pack_size = ds.tellp() - info.offset;
+      }
+      FC_ASSERT( ds.tellp() == d.packed.size(), "Prepared block does not match its serialization" );
+
+      const char* packed = d.packed.data();
+      d.header_digest = digest_type::hash( packed, header_size );
+      d.id = signed_block_header::id_from_hash( fc::sha224::hash( packed, signed_header_size ), b.block_num() );
+
+      for( size_t i = 0; i < d.transactions.size(); ++i )
+      {
+         auto& info = d.transactions[i];
+         // transaction::id() is the digest of the transaction without its signatures, truncated
+         digest_type id_digest = digest_type::hash( packed + info.offset, unsigned_sizes[i] );
+         memcpy( info.id._hash, id_digest._hash, std::min( sizeof( info.id ), sizeof( id_digest ) ) );
+         info.merkle_digest = digest_type::hash( packed + info.offset, info.pack_size );
+      }
+   }
+
+   checksum_type prepared_block::calculate_merkle_root()const
+   {
+      vector< digest_type > digests;
+      digests.reserve( _data->transactions.size() );
+      for( const auto& info : _data->transactions )
+         digests.push_back( info.merkle_digest );
+
+      return signed_block::merkle_root_of( std::move( digests ) );
+   }
+
+   fc::ecc::public_key prepared_block::signee()const
+   {
+      return fc::ecc::public_key( _data->block.witness_signature, _data->header_digest, true/*enforce canonical*/ );
+   }
+
+   bool prepared_block::validate_signee( const fc::ecc::public_key& expected_signee )const
+   {
+      return signee() == expected_signee;
+   }
+
+} } // zattera::protocol
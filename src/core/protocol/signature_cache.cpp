@@ -0,0 +1,101 @@
+#include <zattera/protocol/signature_cache.hpp>
+
+#include <cstring>
+
+namespace zattera { namespace protocol {
+
+signature_cache& signature_cache::instance()
+{
+   static signature_cache cache;
+   return cache;
+}
+
+signature_cache::signature_cache() : _capacity( 100000 ), _hits( 0 ), _misses( 0 ) {}
+
+size_t signature_cache::key_hash::operator()( const key_type& k )const
+{
+   // Both parts are uniformly distributed already, r of the signature follows the recovery byte
+   uint64_t r;
+   memcpy( &r, k.sig.begin() + 1, sizeof( r ) );
+   return size_t( k.digest._hash[0] ^ r );
+}
+
+signature_cache::shard& signature_cache::shard_for( size_t hash )
+{
+   return _shards[ hash % shard_count ];
+}
+
+public_key_type signature_cache::recover( const digest_type& digest, const signature_type& sig )
+{
+   if( _capacity == 0 )
+      return fc::ecc::public_key( sig, digest );
+
+   key_type k{ digest, sig };
+   size_t hash = key_hash()( k );
+   shard& s = shard_for( hash );
+
+   {
+      std::lock_guard< std::mutex > lock( s.mutex );
+      auto itr = s.keys.find( k );
+      if( itr != s.keys.end() )
+      {
+         ++_hits;
+         return itr->second;
+      }
+   }
+
+   ++_misses;
+   public_key_type result = fc::ecc::public_key( sig, digest );
+
+   std::lock_guard< std::mutex > lock( s.mutex );
+   if( s.keys.emplace( k, result ).second )
+   {
+      s.insertion_order.push_back( k );
+      trim( s, _capacity / shard_count + 1 );
+   }
+
+   return result;
+}
+
+void signature_cache::trim( shard& s, size_t limit )
+{
+   while( s.keys.size() > limit )
+   {
+      s.keys.erase( s.insertion_order.front() );
+      s.insertion_order.pop_front();
+   }
+}
+
+void signature_cache::set_capacity( size_t capacity )
+{
+   _capacity = capacity;
+
+   for( auto& s : _shards )
+   {
+      std::lock_guard< std::mutex > lock( s.mutex );
+      trim( s, capacity ? capacity / shard_count + 1 : 0 );
+   }
+}
+
+size_t signature_cache::size()const
+{
+   size_t result = 0;
+   for( const auto& s : _shards )
+   {
+      std::lock_guard< std::mutex > lock( s.mutex );
+      result += s.keys.size();
+   }
+   return result;
+}
+
+void signature_cache::clear()
+{
+   for( auto& s : _shards )
+   {
+      std::lock_guard< std::mutex > lock( s.mutex );
+      s.keys.clear();
+      s.insertion_order.clear();
+   }
+}
+
+} } // zattera::protocol
@@ -1,5 +1,6 @@
 
 #include <zattera/protocol/transaction.hpp>
+#include <zattera/protocol/signature_cache.hpp>
 #include <zattera/protocol/transaction_util.hpp>
 
 #include <fc/io/raw.hpp>
@@ -89,7 +90,7 @@ flat_set<public_key_type> signed_transaction::get_signature_keys( const chain_id
    for( const auto&  sig : signatures )
    {
       ZATTERA_ASSERT(
-         result.insert( fc::ecc::public_key(sig,d) ).second,
+         result.insert( signature_cache::instance().recover( d, sig ) ).second,
          tx_duplicate_sig,
          "Duplicate Signature detected" );
    }
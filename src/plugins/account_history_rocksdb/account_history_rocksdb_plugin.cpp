@@ -12,17 +12,25 @@
 
 #include <appbase/application.hpp>
 
+#include <rocksdb/cache.h>
 #include <rocksdb/db.h>
 #include <rocksdb/options.h>
 #include <rocksdb/slice.h>
+#include <rocksdb/table.h>
 #include <rocksdb/utilities/write_batch_with_index.h>
 
 #include <boost/type.hpp>
 #include <boost/algorithm/string.hpp>
 #include <boost/container/flat_set.hpp>
 
+#include <atomic>
+#include <condition_variable>
+#include <cstring>
 #include <limits>
+#include <mutex>
+#include <set>
 #include <string>
+#include <thread>
 #include <typeindex>
 #include <typeinfo>
 
@@ -39,11 +47,30 @@ namespace bpo = boost::program_options;
 #define OPERATION_BY_BLOCK 3
 #define AH_INFO_BY_NAME 4
 #define AH_OPERATION_BY_ID 5
+#define VIRTUAL_OP_BY_BLOCK_TYPE 6
+#define AH_OP_TYPE_BITMAP 7
+#define COLD_OPERATION_BY_ID 8
 
 #define WRITE_BUFFER_FLUSH_LIMIT     10
 #define ACCOUNT_HISTORY_LENGTH_LIMIT 30
 #define ACCOUNT_HISTORY_TIME_LIMIT   30
 #define VIRTUAL_OP_FLAG              0x8000000000000000
+/// Number of consecutive account history entries covered by one operation type bitmap.
+#define OP_TYPE_BITMAP_CHUNK         1024
+
+/// Operations moved to cold storage per write.
+#define COLD_MIGRATION_BATCH         10000
+/// Seconds between two passes of the cold storage migration.
+#define COLD_MIGRATION_INTERVAL      60
+#define COLD_STORAGE_BLOCK_SIZE      ( 64 * 1024 )
+#define COLD_STORAGE_DICTIONARY_SIZE ( 16 * 1024 )
+
+/// Cold operations are read rarely, so the best ratio is preferred: zstd when RocksDB is built with it.
+#ifdef ZATTERA_ROCKSDB_ZSTD
+#define COLD_STORAGE_COMPRESSION     ::rocksdb::kZSTD
+#else
+#define COLD_STORAGE_COMPRESSION     ::rocksdb::kZlibCompression
+#endif
 
 /** Because localtion_id_pair stores block_number paired with (VIRTUAL_OP_FLAG|operation_id),
  *  max allowed operation-id is max_int (instead of max_uint).
@@ -51,7 +78,9 @@ namespace bpo = boost::program_options;
 #define MAX_OPERATION_ID             std::numeric_limits<int64_t>::max()
 
 #define STORE_MAJOR_VERSION          1
-#define STORE_MINOR_VERSION          0
+/// Minor version 1 adds the virtual_op_by_block_type column, which is built on open for older stores.
+/// Minor version 2 adds the ah_op_type_bitmap column, built on open the same way.
+#define STORE_MINOR_VERSION          2
 
 namespace zattera { namespace plugins { namespace account_history_rocksdb {
 
@@ -243,11 +272,41 @@ typedef PrimitiveTypeComparatorImpl< block_op_id_pair > op_by_block_num_Comparat
 typedef std::pair< int64_t, uint32_t > ah_op_id_pair;
 typedef PrimitiveTypeComparatorImpl< ah_op_id_pair > ah_op_by_id_ComparatorImpl;
 
+/** Key of the virtual operation index: the block, the operation type (its tag in the operation
+ *  static_variant) and the operation ID, so virtual ops of a given type in a block are adjacent.
+ */
+struct block_op_type_id
+{
+   uint32_t block = 0;
+   uint32_t op_type = 0;
+   uint64_t op_id = 0;
+
+   block_op_type_id() = default;
+   block_op_type_id(uint32_t b, uint32_t t, uint64_t id) : block(b), op_type(t), op_id(id) {}
+
+   bool operator<(const block_op_type_id& o) const
+   {
+      return std::tie(block, op_type, op_id) < std::tie(o.block, o.op_type, o.op_id);
+   }
+
+   bool operator>(const block_op_type_id& o) const
+   {
+      return o < *this;
+   }
+
+   bool operator==(const block_op_type_id& o) const
+   {
+      return block == o.block && op_type == o.op_type && op_id == o.op_id;
+   }
+};
+typedef PrimitiveTypeComparatorImpl< block_op_type_id > vop_by_block_type_ComparatorImpl;
+
 typedef PrimitiveTypeSlice< int64_t > id_slice_t;
 typedef PrimitiveTypeSlice< block_op_id_pair > op_by_block_num_slice_t;
 typedef PrimitiveTypeSlice< uint32_t > by_block_slice_t;
 typedef PrimitiveTypeSlice< account_name_type::Storage > ah_info_by_name_slice_t;
 typedef PrimitiveTypeSlice< ah_op_id_pair > ah_op_by_id_slice_t;
+typedef PrimitiveTypeSlice< block_op_type_id > vop_by_block_type_slice_t;
 
 const Comparator* by_id_Comparator()
 {
@@ -273,6 +332,107 @@ const Comparator* ah_op_by_id_Comparator()
    return &c;
 }
 
+const Comparator* vop_by_block_type_Comparator()
+{
+   static vop_by_block_type_ComparatorImpl c;
+   return &c;
+}
+
+/** Options of the column holding operations moved out of operation_by_id. Serialized operations
+ *  share most of their structure, so larger blocks and a compression dictionary sampled from the
+ *  data pay off well for data which is rarely read.
+ */
+ColumnFamilyOptions coldOperationColumnOptions()
+{
+   ColumnFamilyOptions options;
+   options.comparator = by_id_Comparator();
+   options.compression = COLD_STORAGE_COMPRESSION;
+   options.compression_opts.max_dict_bytes = COLD_STORAGE_DICTIONARY_SIZE;
+   options.level_compaction_dynamic_level_bytes = true;
+
+   ::rocksdb::BlockBasedTableOptions tableOptions;
+   tableOptions.block_size = COLD_STORAGE_BLOCK_SIZE;
+   options.table_factory.reset(::rocksdb::NewBlockBasedTableFactory(tableOptions));
+
+   return options;
+}
+
+/** Adds the memory RocksDB holds for `db` to `usage`: memtables, index and filter blocks of open
+ *  tables, and the block caches of the given columns. Columns using the default table options each
+ *  own a block cache, caches shared by several columns are counted once.
+ */
+void collectMemoryUsage(DB* db, const std::vector<ColumnFamilyHandle*>& columns, const std::string& prefix,
+   fc::flat_map<std::string, uint64_t>* usage)
+{
+   uint64_t value = 0;
+   if(db->GetAggregatedIntProperty(DB::Properties::kSizeAllMemTables, &value))
+      (*usage)[prefix + "memtables"] = value;
+   if(db->GetAggregatedIntProperty(DB::Properties::kEstimateTableReadersMem, &value))
+      (*usage)[prefix + "table_readers"] = value;
+
+   std::set<const ::rocksdb::Cache*> caches;
+   uint64_t cacheUsage = 0;
+   uint64_t cachePinnedUsage = 0;
+   for(auto* column : columns)
+   {
+      auto tableFactory = db->GetOptions(column).table_factory;
+      if(tableFactory == nullptr || std::strcmp(tableFactory->Name(), "BlockBasedTable") != 0)
+         continue;
+
+      auto* tableOptions = static_cast<::rocksdb::BlockBasedTableOptions*>(tableFactory->GetOptions());
+      if(tableOptions == nullptr || tableOptions->block_cache == nullptr ||
+         caches.insert(tableOptions->block_cache.get()).second == false)
+         continue;
+
+      cacheUsage += tableOptions->block_cache->GetUsage();
+      cachePinnedUsage += tableOptions->block_cache->GetPinnedUsage();
+   }
+
+   (*usage)[prefix + "block_cache"] = cacheUsage;
+   (*usage)[prefix + "block_cache_pinned"] = cachePinnedUsage;
+}
+
+/// Reads the operation type (static_variant tag) from the front of a serialized operation.
+uint32_t getOperationType(const serialize_buffer_t& serializedOp)
+{
+   fc::unsigned_int which;
+   fc::datastream<const char*> ds(serializedOp.data(), serializedOp.size());
+   fc::raw::unpack(ds, which);
+   return which.value;
+}
+
+/** Set of operation types (tags of protocol::operation), one bit per type. Every chunk of
+ *  OP_TYPE_BITMAP_CHUNK consecutive entries of an account history has one, holding the types of
+ *  all operations in the chunk, so filtered queries can skip chunks without reading them.
+ */
+typedef std::vector< uint64_t > op_type_bitmap;
+
+/// Returns true if the type was not in the bitmap yet.
+bool addOperationType(op_type_bitmap* bitmap, uint32_t opType)
+{
+   if(bitmap->size() <= opType / 64)
+      bitmap->resize(opType / 64 + 1, 0);
+
+   auto& word = (*bitmap)[opType / 64];
+   const uint64_t bit = uint64_t(1) << (opType % 64);
+   if(word & bit)
+      return false;
+
+   word |= bit;
+   return true;
+}
+
+bool hasAnyOperationType(const op_type_bitmap& bitmap, const op_type_bitmap& mask)
+{
+   for(size_t i = 0; i < std::min(bitmap.size(), mask.size()); ++i)
+   {
+      if(bitmap[i] & mask[i])
+         return true;
+   }
+
+   return false;
+}
+
 #define checkStatus(s) FC_ASSERT((s).ok(), "Data access failed: ${m}", ("m", (s).ToString()))
 
 class operation_name_provider
@@ -338,9 +498,43 @@ public:
       checkStatus(s);
    }
 
+   /// Returns the operation type bitmap of an account history chunk, empty if it has none yet.
+   op_type_bitmap getOpTypeBitmap(const ah_op_id_pair& chunk)
+   {
+      auto fi = _opTypeBitmapCache.find(chunk);
+      if(fi != _opTypeBitmapCache.end())
+         return fi->second;
+
+      op_type_bitmap bitmap;
+      PinnableSlice buffer;
+      auto s = _storage->Get(ReadOptions(), _columnHandles[AH_OP_TYPE_BITMAP], ah_op_by_id_slice_t(chunk), &buffer);
+      if(s.ok())
+         load(bitmap, buffer.data(), buffer.size());
+      else
+         FC_ASSERT(s.IsNotFound());
+
+      return _opTypeBitmapCache[chunk] = bitmap;
+   }
+
+   void putOpTypeBitmap(const ah_op_id_pair& chunk, const op_type_bitmap& bitmap)
+   {
+      _opTypeBitmapCache[chunk] = bitmap;
+      auto serializeBuf = dump(bitmap);
+      auto s = Put(_columnHandles[AH_OP_TYPE_BITMAP], ah_op_by_id_slice_t(chunk), Slice(serializeBuf.data(), serializeBuf.size()));
+      checkStatus(s);
+   }
+
+   void deleteOpTypeBitmap(const ah_op_id_pair& chunk)
+   {
+      _opTypeBitmapCache.erase(chunk);
+      auto s = Delete(_columnHandles[AH_OP_TYPE_BITMAP], ah_op_by_id_slice_t(chunk));
+      checkStatus(s);
+   }
+
    void Clear()
    {
       _ahInfoCache.clear();
+      _opTypeBitmapCache.clear();
       WriteBatch::Clear();
    }
 
@@ -348,6 +542,7 @@ private:
    const std::unique_ptr<DB>&                        _storage;
    const std::vector<ColumnFamilyHandle*>&           _columnHandles;
    std::map<account_name_type, account_history_info> _ahInfoCache;
+   std::map<ah_op_id_pair, op_type_bitmap>           _opTypeBitmapCache;
 };
 
 
@@ -375,6 +570,9 @@ public:
          }, _self, 0);
 
       add_plugin_index< volatile_operation_index >( _mainDb );
+
+      appbase::app().get_plugin<zattera::plugins::chain::chain_plugin>().register_memory_usage_provider(
+         _self.name(), [this]() { return memoryUsage(); });
       }
 
    ~impl()
@@ -397,15 +595,21 @@ public:
 
       DBOptions dbOptions(options);
       options.max_open_files = OPEN_FILE_LIMIT;
+      /// Stores written by older versions lack columns added since, they are created empty here.
+      dbOptions.create_missing_column_families = true;
 
       auto status = DB::Open(dbOptions, strPath, columnDefs, &_columnHandles, &storageDb);
 
       if(status.ok())
       {
          ilog("RocksDB opened successfully storage at location: `${p}'.", ("p", strPath));
-         verifyStoreVersion(storageDb);
+         auto storeMinorVersion = verifyStoreVersion(storageDb);
          loadSeqIdentifiers(storageDb);
          _storage.reset(storageDb);
+         openColdStorage();
+
+         if(storeMinorVersion < STORE_MINOR_VERSION)
+            upgradeStore(storeMinorVersion);
 
          const auto& rocksdb_plugin = appbase::app().get_plugin< account_history_rocksdb_plugin >();
 
@@ -435,6 +639,12 @@ public:
             },
             rocksdb_plugin
          );
+
+         if(_hotHistoryDays > 0)
+         {
+            _stopColdMigration = false;
+            _coldMigrationThread = std::thread([this]() { coldMigrationLoop(); });
+         }
       }
       else
       {
@@ -450,7 +660,8 @@ public:
    /// Allows to start immediate data import (outside replay process).
    void importData(unsigned int blockLimit);
 
-   void find_account_history_data(const account_name_type& name, uint64_t start, uint32_t limit,
+   fc::optional<uint64_t> find_account_history_data(const account_name_type& name, uint64_t start, uint32_t limit,
+      const flat_set<uint32_t>& opTypes, uint32_t scanLimit,
       std::function<void(unsigned int, const rocksdb_operation_object&)> processor) const;
    bool find_operation_object(size_t opId, rocksdb_operation_object* op) const;
    /// Allows to look for all operations present in given block and call `processor` for them.
@@ -459,13 +670,33 @@ public:
    /// Allows to enumerate all operations registered in given block range.
    uint32_t enumVirtualOperationsFromBlockRange(uint32_t blockRangeBegin,
       uint32_t blockRangeEnd, std::function<void(const rocksdb_operation_object&)> processor) const;
+   /// Pages through virtual operations of given types, see account_history_rocksdb_plugin::enum_virtual_operations.
+   virtual_op_cursor enumVirtualOperations(uint32_t blockRangeBegin, uint32_t blockRangeEnd,
+      uint64_t operationBegin, uint32_t limit, const flat_set<uint32_t>& opTypes,
+      std::function<void(const rocksdb_operation_object&)> processor) const;
+
+   /// Memory held by RocksDB outside of the shared memory file, see chain_plugin::get_memory_usage.
+   fc::flat_map<std::string, uint64_t> memoryUsage() const
+   {
+      fc::flat_map<std::string, uint64_t> usage;
+      if(_storage == nullptr)
+         return usage;
+
+      collectMemoryUsage(_storage.get(), _columnHandles, "", &usage);
+      if(_coldStorage)
+         collectMemoryUsage(_coldStorage.get(), { _coldStorage->DefaultColumnFamily() }, "cold_", &usage);
+
+      return usage;
+   }
 
    void shutdownDb()
    {
       chain::util::disconnect_signal(_on_post_apply_operation_con);
       chain::util::disconnect_signal(_on_irreversible_block_conn);
+      stopColdMigration();
       flushStorage();
       cleanupColumnHandles();
+      _coldStorage.reset();
       _storage.reset();
    }
 
@@ -496,6 +727,7 @@ private:
       }
 
       obj.id = _operationSeqId++;
+      _newestOperationTime = obj.timestamp.sec_since_epoch();
 
       serialize_buffer_t serializedObj;
       auto size = fc::raw::pack_size(obj);
@@ -521,6 +753,13 @@ private:
       s = _writeBuffer.Put(_columnHandles[OPERATION_BY_BLOCK], blockLocSlice, idSlice);
       checkStatus(s);
 
+      if( obj.virtual_op > 0 )
+      {
+         vop_by_block_type_slice_t vopSlice( block_op_type_id( obj.block, getOperationType( obj.serialized_op ), obj.id ) );
+         s = _writeBuffer.Put(_columnHandles[VIRTUAL_OP_BY_BLOCK_TYPE], vopSlice, idSlice);
+         checkStatus(s);
+      }
+
       for(const auto& name : impacted)
          buildAccountHistoryRecord( name, obj );
 
@@ -531,6 +770,32 @@ private:
 }
 
    void buildAccountHistoryRecord( const account_name_type& name, const rocksdb_operation_object& obj );
+
+   /** Opens the separate cold storage DB if `account-history-rocksdb-cold-path` is set, otherwise cold
+    *  operations live in the operation_by_id_cold column of the main store.
+    */
+   void openColdStorage();
+   DB* coldDb() const { return _coldStorage ? _coldStorage.get() : _storage.get(); }
+   ColumnFamilyHandle* coldColumn() const
+   {
+      return _coldStorage ? _coldStorage->DefaultColumnFamily() : _columnHandles[COLD_OPERATION_BY_ID];
+   }
+
+   /// Runs migrateColdOperations every COLD_MIGRATION_INTERVAL seconds until stopColdMigration.
+   void coldMigrationLoop();
+   void stopColdMigration();
+   /** Moves operations older than `account-history-rocksdb-hot-days` (by the timestamp of the newest
+    *  imported operation) from operation_by_id to cold storage. Runs in its own thread, the import
+    *  itself is never blocked.
+    */
+   void migrateColdOperations();
+   /// Marks the type of the operation stored as given account history entry in the bitmap of its chunk.
+   void updateOpTypeBitmap(int64_t ahId, uint32_t entryId, const rocksdb_operation_object& obj);
+   /// Walks the account history backwards from `start`, skipping chunks whose bitmap has none of `opTypes`.
+   /// Stops after `scanLimit` entries read and chunks skipped, returning the entry to resume from.
+   fc::optional<uint64_t> findFilteredAccountHistoryData(const account_history_info& ahInfo, uint64_t start, uint32_t limit,
+      const flat_set<uint32_t>& opTypes, uint32_t scanLimit,
+      std::function<void(unsigned int, const rocksdb_operation_object&)> processor) const;
    void prunePotentiallyTooOldItems(account_history_info* ahInfo, const account_name_type& name,
       const fc::time_point_sec& now);
 
@@ -545,7 +810,8 @@ private:
       checkStatus(s);
    }
 
-   void verifyStoreVersion(DB* storageDb)
+   /// Returns minor version of the store, which may be older than STORE_MINOR_VERSION.
+   uint32_t verifyStoreVersion(DB* storageDb)
    {
       ReadOptions rOptions;
 
@@ -560,9 +826,28 @@ private:
       checkStatus(s);
       const auto minor = PrimitiveTypeSlice<uint32_t>::unpackSlice(buffer);
 
-      FC_ASSERT(minor == STORE_MINOR_VERSION, "Store minor version mismatch");
+      FC_ASSERT(minor <= STORE_MINOR_VERSION, "Store minor version mismatch");
+
+      return minor;
    }
 
+   /// Brings a store written with an older minor version up to date.
+   void upgradeStore(uint32_t storeMinorVersion)
+   {
+      if(storeMinorVersion < 1)
+         buildVirtualOpIndex();
+      if(storeMinorVersion < 2)
+         buildOpTypeBitmaps();
+
+      saveStoreVersion();
+      flushWriteBuffer();
+   }
+
+   /// Fills virtual_op_by_block_type from operation_by_block, for stores created before it existed.
+   void buildVirtualOpIndex();
+   /// Fills ah_op_type_bitmap from ah_operation_by_id, for stores created before it existed.
+   void buildOpTypeBitmaps();
+
    void storeSequenceIds()
    {
       Slice opSeqIdName("OPERATION_SEQ_ID");
@@ -593,8 +878,12 @@ private:
       checkStatus(s);
       _accountHistorySeqId = id_slice_t::unpackSlice(buffer);
 
-      ilog("Loaded OperationObject seqId: ${o}, AccountHistoryObject seqId: ${ah}.",
-         ("o", _operationSeqId)("ah", _accountHistorySeqId));
+      s = storageDb->Get(rOptions, Slice("COLD_OPERATION_BOUNDARY"), &buffer);
+      FC_ASSERT(s.ok() || s.IsNotFound());
+      _coldBoundary = s.ok() ? id_slice_t::unpackSlice(buffer) : 0;
+
+      ilog("Loaded OperationObject seqId: ${o}, AccountHistoryObject seqId: ${ah}, cold storage boundary: ${c}.",
+         ("o", _operationSeqId)("ah", _accountHistorySeqId)("c", _coldBoundary.load()));
    }
 
    void flushWriteBuffer(DB* storage = nullptr)
@@ -626,6 +915,12 @@ private:
          auto s = _storage->Flush(fOptions, cf);
          checkStatus(s);
       }
+
+      if(_coldStorage)
+      {
+         auto s = _coldStorage->Flush(fOptions);
+         checkStatus(s);
+      }
    }
 
    void on_post_apply_operation(const operation_notification& opNote);
@@ -695,9 +990,23 @@ private:
    flat_set<std::string>            _op_list;
    flat_set<std::string>            _blacklisted_op_list;
 
-   bool                             _reindexing = false;
+   std::atomic<bool>                _reindexing = { false };
 
    bool                             _prune = false;
+
+   /// Operations older than this many days are moved to cold storage, 0 keeps everything hot.
+   uint32_t                         _hotHistoryDays = 0;
+   bfs::path                        _coldStoragePath;
+   std::unique_ptr<DB>              _coldStorage;
+   /// Operations with a lower ID have been moved to cold storage.
+   std::atomic<int64_t>             _coldBoundary = { 0 };
+   /// Timestamp of the newest imported operation, the age of operations is measured against it.
+   std::atomic<uint32_t>            _newestOperationTime = { 0 };
+
+   std::thread                      _coldMigrationThread;
+   std::mutex                       _coldMigrationMutex;
+   std::condition_variable          _coldMigrationCondition;
+   bool                             _stopColdMigration = false;
 };
 
 void account_history_rocksdb_plugin::impl::collectOptions(const boost::program_options::variables_map& options)
@@ -722,6 +1031,15 @@ void account_history_rocksdb_plugin::impl::collectOptions(const boost::program_o
 
    if(_blacklisted_op_list.empty() == false)
       ilog( "Account History: blacklisting ops ${o}", ("o", _blacklisted_op_list) );
+
+   _hotHistoryDays = options.at("account-history-rocksdb-hot-days").as<uint32_t>();
+
+   if(options.count("account-history-rocksdb-cold-path"))
+   {
+      _coldStoragePath = options.at("account-history-rocksdb-cold-path").as<bfs::path>();
+      if(_coldStoragePath.empty() == false && _coldStoragePath.is_absolute() == false)
+         _coldStoragePath = appbase::app().data_dir() / _coldStoragePath;
+   }
 }
 
 inline bool account_history_rocksdb_plugin::impl::isTrackedAccount(const account_name_type& name) const
@@ -827,8 +1145,9 @@ void account_history_rocksdb_plugin::impl::storeOpFilteringParameters(const std:
       }
    }
 
-void account_history_rocksdb_plugin::impl::find_account_history_data(const account_name_type& name, uint64_t start,
-   uint32_t limit, std::function<void(unsigned int, const rocksdb_operation_object&)> processor) const
+fc::optional<uint64_t> account_history_rocksdb_plugin::impl::find_account_history_data(const account_name_type& name,
+   uint64_t start, uint32_t limit, const flat_set<uint32_t>& opTypes, uint32_t scanLimit,
+   std::function<void(unsigned int, const rocksdb_operation_object&)> processor) const
 {
    ReadOptions rOptions;
 
@@ -837,13 +1156,16 @@ void account_history_rocksdb_plugin::impl::find_account_history_data(const accou
    auto s = _storage->Get(rOptions, _columnHandles[AH_INFO_BY_NAME], nameSlice, &buffer);
 
    if(s.IsNotFound())
-      return;
+      return fc::optional<uint64_t>();
 
    checkStatus(s);
 
    account_history_info ahInfo;
    load(ahInfo, buffer.data(), buffer.size());
 
+   if(opTypes.empty() == false)
+      return findFilteredAccountHistoryData(ahInfo, start, limit, opTypes, scanLimit, processor);
+
    ah_op_by_id_slice_t lowerBoundSlice(std::make_pair(ahInfo.id, ahInfo.oldestEntryId));
    ah_op_by_id_slice_t upperBoundSlice(std::make_pair(ahInfo.id, ahInfo.newestEntryId+1));
 
@@ -858,7 +1180,7 @@ void account_history_rocksdb_plugin::impl::find_account_history_data(const accou
    it->SeekForPrev(key);
 
    if(it->Valid() == false)
-      return;
+      return fc::optional<uint64_t>();
 
    auto keySlice = it->key();
    auto keyValue = ah_op_by_id_slice_t::unpackSlice(keySlice);
@@ -884,13 +1206,100 @@ void account_history_rocksdb_plugin::impl::find_account_history_data(const accou
       if(keyValue.second <= lowerBound)
         break;
    }
+
+   return fc::optional<uint64_t>();
+}
+
+fc::optional<uint64_t> account_history_rocksdb_plugin::impl::findFilteredAccountHistoryData(const account_history_info& ahInfo,
+   uint64_t start, uint32_t limit, const flat_set<uint32_t>& opTypes, uint32_t scanLimit,
+   std::function<void(unsigned int, const rocksdb_operation_object&)> processor) const
+{
+   op_type_bitmap mask;
+   for(auto opType : opTypes)
+      addOperationType(&mask, opType);
+
+   ReadOptions rOptions;
+   ah_op_by_id_slice_t lowerBoundSlice(std::make_pair(ahInfo.id, ahInfo.oldestEntryId));
+   ah_op_by_id_slice_t upperBoundSlice(std::make_pair(ahInfo.id, ahInfo.newestEntryId+1));
+   rOptions.iterate_lower_bound = &lowerBoundSlice;
+   rOptions.iterate_upper_bound = &upperBoundSlice;
+
+   std::unique_ptr<::rocksdb::Iterator> it(_storage->NewIterator(rOptions, _columnHandles[AH_OPERATION_BY_ID]));
+
+   uint32_t entryId = static_cast<uint32_t>(std::min<uint64_t>(start, ahInfo.newestEntryId));
+   uint32_t found = 0;
+   uint32_t scanned = 0;
+
+   while(found < limit && entryId >= ahInfo.oldestEntryId)
+   {
+      if(scanned >= scanLimit)
+         return fc::optional<uint64_t>(entryId);
+
+      const uint32_t chunk = entryId / OP_TYPE_BITMAP_CHUNK;
+      const uint32_t chunkBegin = std::max(chunk * OP_TYPE_BITMAP_CHUNK, ahInfo.oldestEntryId);
+
+      std::string buffer;
+      auto s = _storage->Get(ReadOptions(), _columnHandles[AH_OP_TYPE_BITMAP],
+         ah_op_by_id_slice_t(std::make_pair(ahInfo.id, chunk)), &buffer);
+      FC_ASSERT(s.ok() || s.IsNotFound());
+
+      op_type_bitmap bitmap;
+      if(s.ok())
+         load(bitmap, buffer.data(), buffer.size());
+
+      /// A chunk without a bitmap is read, so missing bitmaps can only cost time.
+      if(s.IsNotFound() || hasAnyOperationType(bitmap, mask))
+      {
+         for(it->SeekForPrev(ah_op_by_id_slice_t(std::make_pair(ahInfo.id, entryId))); it->Valid(); it->Prev())
+         {
+            auto keyValue = ah_op_by_id_slice_t::unpackSlice(it->key());
+            if(keyValue.second < chunkBegin)
+               break;
+
+            if(scanned >= scanLimit)
+               return fc::optional<uint64_t>(keyValue.second);
+            ++scanned;
+
+            const auto& opId = id_slice_t::unpackSlice(it->value());
+            rocksdb_operation_object oObj;
+            bool isFound = find_operation_object(opId, &oObj);
+            FC_ASSERT(isFound, "Missing operation?");
+
+            if(opTypes.find(getOperationType(oObj.serialized_op)) == opTypes.end())
+               continue;
+
+            processor(keyValue.second, oObj);
+
+            if(++found >= limit)
+               break;
+         }
+      }
+      else
+      {
+         ++scanned;
+      }
+
+      if(chunkBegin == 0)
+         break;
+
+      entryId = chunkBegin - 1;
+   }
+
+   return fc::optional<uint64_t>();
 }
 
 bool account_history_rocksdb_plugin::impl::find_operation_object(size_t opId, rocksdb_operation_object* op) const
 {
    std::string data;
    id_slice_t idSlice(opId);
-   ::rocksdb::Status s = _storage->Get(ReadOptions(), _columnHandles[OPERATION_BY_ID], idSlice, &data);
+   ::rocksdb::Status s = ::rocksdb::Status::NotFound();
+
+   if(static_cast<int64_t>(opId) >= _coldBoundary)
+      s = _storage->Get(ReadOptions(), _columnHandles[OPERATION_BY_ID], idSlice, &data);
+
+   /// An operation missing in operation_by_id may have been moved to cold storage while looking it up.
+   if(s.IsNotFound())
+      s = coldDb()->Get(ReadOptions(), coldColumn(), idSlice, &data);
 
    if(s.ok())
    {
@@ -977,6 +1386,319 @@ uint32_t account_history_rocksdb_plugin::impl::enumVirtualOperationsFromBlockRan
    return 0;
 }
 
+virtual_op_cursor account_history_rocksdb_plugin::impl::enumVirtualOperations(uint32_t blockRangeBegin,
+   uint32_t blockRangeEnd, uint64_t operationBegin, uint32_t limit, const flat_set<uint32_t>& opTypes,
+   std::function<void(const rocksdb_operation_object&)> processor) const
+{
+   FC_ASSERT(blockRangeEnd > blockRangeBegin, "Block range must be upward");
+
+   /** Moves `it` forward to the next key of one of `opTypes`, seeking over the keys of other types
+    *  in a block instead of reading them.
+    */
+   auto seekToMatching = [&opTypes](::rocksdb::Iterator* it) -> bool
+   {
+      while(it->Valid())
+      {
+         const auto& key = vop_by_block_type_slice_t::unpackSlice(it->key());
+         if(opTypes.empty() || opTypes.find(key.op_type) != opTypes.end())
+            return true;
+
+         auto nextType = opTypes.upper_bound(key.op_type);
+         if(nextType != opTypes.end())
+            it->Seek(vop_by_block_type_slice_t(block_op_type_id(key.block, *nextType, 0)));
+         else if(key.block < std::numeric_limits<uint32_t>::max())
+            it->Seek(vop_by_block_type_slice_t(block_op_type_id(key.block + 1, 0, 0)));
+         else
+            return false;
+      }
+      return false;
+   };
+
+   vop_by_block_type_slice_t upperBoundSlice(block_op_type_id(blockRangeEnd, 0, 0));
+   ReadOptions rOptions;
+   rOptions.iterate_upper_bound = &upperBoundSlice;
+
+   std::unique_ptr<::rocksdb::Iterator> it(_storage->NewIterator(rOptions, _columnHandles[VIRTUAL_OP_BY_BLOCK_TYPE]));
+   it->Seek(vop_by_block_type_slice_t(block_op_type_id(blockRangeBegin, 0, 0)));
+
+   uint32_t found = 0;
+   std::vector<uint64_t> blockOpIds;
+
+   while(seekToMatching(it.get()))
+   {
+      /// Keys of a block are grouped by type, collect them to report operations in their original order.
+      const uint32_t block = vop_by_block_type_slice_t::unpackSlice(it->key()).block;
+      blockOpIds.clear();
+
+      for(; seekToMatching(it.get()); it->Next())
+      {
+         const auto& key = vop_by_block_type_slice_t::unpackSlice(it->key());
+         if(key.block != block)
+            break;
+         if(block == blockRangeBegin && key.op_id < operationBegin)
+            continue;
+         blockOpIds.push_back(key.op_id);
+      }
+
+      std::sort(blockOpIds.begin(), blockOpIds.end());
+
+      for(auto opId : blockOpIds)
+      {
+         if(limit != 0 && found == limit)
+            return virtual_op_cursor{ block, opId };
+
+         rocksdb_operation_object op;
+         bool exists = find_operation_object(opId, &op);
+         FC_ASSERT(exists);
+
+         processor(op);
+         ++found;
+      }
+   }
+
+   /// Whole range has been processed, point to the next block holding matching operations.
+   it.reset(_storage->NewIterator(ReadOptions(), _columnHandles[VIRTUAL_OP_BY_BLOCK_TYPE]));
+   it->Seek(vop_by_block_type_slice_t(block_op_type_id(blockRangeEnd, 0, 0)));
+
+   if(seekToMatching(it.get()))
+      return virtual_op_cursor{ vop_by_block_type_slice_t::unpackSlice(it->key()).block, 0 };
+
+   return virtual_op_cursor();
+}
+
+void account_history_rocksdb_plugin::impl::buildVirtualOpIndex()
+{
+   ilog("Building virtual operation index...");
+
+   std::unique_ptr<::rocksdb::Iterator> it(_storage->NewIterator(ReadOptions(), _columnHandles[OPERATION_BY_BLOCK]));
+   size_t indexedOps = 0;
+
+   for(it->SeekToFirst(); it->Valid(); it->Next())
+   {
+      const auto& key = op_by_block_num_slice_t::unpackSlice(it->key());
+      if((key.second & VIRTUAL_OP_FLAG) == 0)
+         continue;
+
+      const auto& opId = id_slice_t::unpackSlice(it->value());
+      rocksdb_operation_object op;
+      bool found = find_operation_object(opId, &op);
+      FC_ASSERT(found);
+
+      vop_by_block_type_slice_t vopSlice(block_op_type_id(op.block, getOperationType(op.serialized_op), op.id));
+      auto s = _writeBuffer.Put(_columnHandles[VIRTUAL_OP_BY_BLOCK_TYPE], vopSlice, it->value());
+      checkStatus(s);
+
+      if(++indexedOps % 100000 == 0)
+      {
+         flushWriteBuffer();
+         ilog("Virtual operation index: ${n} operations indexed, reached block ${b}.", ("n", indexedOps)("b", op.block));
+      }
+   }
+
+   ilog("Virtual operation index built, ${n} operations indexed.", ("n", indexedOps));
+}
+
+void account_history_rocksdb_plugin::impl::buildOpTypeBitmaps()
+{
+   ilog("Building account history operation type bitmaps...");
+
+   std::unique_ptr<::rocksdb::Iterator> it(_storage->NewIterator(ReadOptions(), _columnHandles[AH_OPERATION_BY_ID]));
+   size_t indexedEntries = 0;
+
+   /// Entries are ordered by account history and entry id, so every chunk is completed before the next one starts.
+   ah_op_id_pair chunk(-1, 0);
+   op_type_bitmap bitmap;
+
+   auto putChunk = [&]()
+   {
+      if(bitmap.empty())
+         return;
+
+      auto serializeBuf = dump(bitmap);
+      auto s = _writeBuffer.Put(_columnHandles[AH_OP_TYPE_BITMAP], ah_op_by_id_slice_t(chunk), Slice(serializeBuf.data(), serializeBuf.size()));
+      checkStatus(s);
+      bitmap.clear();
+   };
+
+   for(it->SeekToFirst(); it->Valid(); it->Next())
+   {
+      const auto& key = ah_op_by_id_slice_t::unpackSlice(it->key());
+      ah_op_id_pair entryChunk(key.first, key.second / OP_TYPE_BITMAP_CHUNK);
+      if(entryChunk != chunk)
+      {
+         putChunk();
+         chunk = entryChunk;
+      }
+
+      const auto& opId = id_slice_t::unpackSlice(it->value());
+      rocksdb_operation_object op;
+      bool found = find_operation_object(opId, &op);
+      FC_ASSERT(found);
+
+      addOperationType(&bitmap, getOperationType(op.serialized_op));
+
+      if(++indexedEntries % 100000 == 0)
+      {
+         flushWriteBuffer();
+         ilog("Operation type bitmaps: ${n} account history entries processed.", ("n", indexedEntries));
+      }
+   }
+
+   putChunk();
+
+   ilog("Operation type bitmaps built, ${n} account history entries processed.", ("n", indexedEntries));
+}
+
+void account_history_rocksdb_plugin::impl::openColdStorage()
+{
+   if(_coldStoragePath.empty())
+      return;
+
+   Options options(DBOptions(), coldOperationColumnOptions());
+   options.IncreaseParallelism();
+   options.create_if_missing = true;
+   options.max_open_files = OPEN_FILE_LIMIT;
+
+   DB* coldDb = nullptr;
+   auto strPath = _coldStoragePath.string();
+   auto s = DB::Open(options, strPath, &coldDb);
+   FC_ASSERT(s.ok(), "RocksDB cannot open cold storage at location: `${p}': ${e}", ("p", strPath)("e", s.ToString()));
+
+   _coldStorage.reset(coldDb);
+   ilog("RocksDB opened cold storage at location: `${p}'.", ("p", strPath));
+}
+
+void account_history_rocksdb_plugin::impl::coldMigrationLoop()
+{
+   ilog("Moving account history operations older than ${d} days to cold storage.", ("d", _hotHistoryDays));
+
+   std::unique_lock<std::mutex> lock(_coldMigrationMutex);
+   while(_stopColdMigration == false)
+   {
+      _coldMigrationCondition.wait_for(lock, std::chrono::seconds(COLD_MIGRATION_INTERVAL));
+      if(_stopColdMigration || _reindexing)
+         continue;
+
+      lock.unlock();
+      try
+      {
+         migrateColdOperations();
+      }
+      catch(const fc::exception& e)
+      {
+         elog("Cold storage migration failed: ${e}", ("e", e.to_detail_string()));
+      }
+      lock.lock();
+   }
+}
+
+void account_history_rocksdb_plugin::impl::stopColdMigration()
+{
+   if(_coldMigrationThread.joinable() == false)
+      return;
+
+   {
+      std::lock_guard<std::mutex> lock(_coldMigrationMutex);
+      _stopColdMigration = true;
+   }
+
+   _coldMigrationCondition.notify_all();
+   _coldMigrationThread.join();
+}
+
+void account_history_rocksdb_plugin::impl::migrateColdOperations()
+{
+   std::unique_ptr<::rocksdb::Iterator> it(_storage->NewIterator(ReadOptions(), _columnHandles[OPERATION_BY_ID]));
+
+   uint32_t newestTime = _newestOperationTime;
+   if(newestTime == 0)
+   {
+      /// Nothing imported since startup yet, the newest stored operation tells the current age.
+      it->SeekToLast();
+      if(it->Valid() == false)
+         return;
+
+      rocksdb_operation_object op;
+      load(op, it->value().data(), it->value().size());
+      newestTime = op.timestamp.sec_since_epoch();
+   }
+
+   const uint32_t hotSeconds = _hotHistoryDays * 24 * 60 * 60;
+   if(newestTime <= hotSeconds)
+      return;
+
+   const fc::time_point_sec cutoff(newestTime - hotSeconds);
+   const bool separateColdStorage = _coldStorage != nullptr;
+
+   it->Seek(id_slice_t(_coldBoundary));
+
+   size_t movedOps = 0;
+   bool reachedCutoff = false;
+
+   while(reachedCutoff == false && it->Valid() && _reindexing == false)
+   {
+      {
+         std::lock_guard<std::mutex> lock(_coldMigrationMutex);
+         if(_stopColdMigration)
+            break;
+      }
+
+      WriteBatch hotBatch;
+      WriteBatch coldBatch;
+      /// Within one store the move is a single atomic write.
+      WriteBatch& moveBatch = separateColdStorage ? coldBatch : hotBatch;
+      int64_t boundary = _coldBoundary;
+      size_t batchOps = 0;
+
+      /// IDs grow with the chain, so operations are visited from the oldest and the first young one ends the pass.
+      for(; it->Valid() && batchOps < COLD_MIGRATION_BATCH; it->Next())
+      {
+         rocksdb_operation_object op;
+         load(op, it->value().data(), it->value().size());
+         if(op.timestamp >= cutoff)
+         {
+            reachedCutoff = true;
+            break;
+         }
+
+         auto s = moveBatch.Put(coldColumn(), it->key(), it->value());
+         checkStatus(s);
+         s = hotBatch.Delete(_columnHandles[OPERATION_BY_ID], it->key());
+         checkStatus(s);
+
+         boundary = op.id + 1;
+         ++batchOps;
+      }
+
+      if(batchOps == 0)
+         break;
+
+      auto s = hotBatch.Put(Slice("COLD_OPERATION_BOUNDARY"), id_slice_t(boundary));
+      checkStatus(s);
+
+      if(separateColdStorage)
+      {
+         /// Operations are removed from the main store only once the cold copy is durable.
+         ::rocksdb::WriteOptions syncOptions;
+         syncOptions.sync = true;
+         s = _coldStorage->Write(syncOptions, &coldBatch);
+         checkStatus(s);
+      }
+
+      s = _storage->Write(::rocksdb::WriteOptions(), &hotBatch);
+      checkStatus(s);
+      _coldBoundary = boundary;
+
+      movedOps += batchOps;
+   }
+
+   if(movedOps != 0)
+   {
+      ilog("Moved ${n} account history operations to cold storage, operations below ${b} are cold now.",
+         ("n", movedOps)("b", _coldBoundary.load()));
+   }
+}
+
 uint32_t account_history_rocksdb_plugin::impl::get_lib()
 {
    std::string data;
@@ -1006,6 +1728,8 @@ account_history_rocksdb_plugin::impl::ColumnDefinitions account_history_rocksdb_
    columnDefs.emplace_back("operation_by_id", ColumnFamilyOptions());
    auto& byIdColumn = columnDefs.back();
    byIdColumn.options.comparator = by_id_Comparator();
+   /// Recent operations are read most, they stay with fast compression.
+   byIdColumn.options.compression = ::rocksdb::kSnappyCompression;
 
    columnDefs.emplace_back("operation_by_block", ColumnFamilyOptions());
    auto& byLocationColumn = columnDefs.back();
@@ -1019,6 +1743,16 @@ account_history_rocksdb_plugin::impl::ColumnDefinitions account_history_rocksdb_
    auto& byAHInfoColumn = columnDefs.back();
    byAHInfoColumn.options.comparator = ah_op_by_id_Comparator();
 
+   columnDefs.emplace_back("virtual_op_by_block_type", ColumnFamilyOptions());
+   auto& vopByBlockTypeColumn = columnDefs.back();
+   vopByBlockTypeColumn.options.comparator = vop_by_block_type_Comparator();
+
+   columnDefs.emplace_back("ah_op_type_bitmap", ColumnFamilyOptions());
+   auto& opTypeBitmapColumn = columnDefs.back();
+   opTypeBitmapColumn.options.comparator = ah_op_by_id_Comparator();
+
+   columnDefs.emplace_back("operation_by_id_cold", coldOperationColumnOptions());
+
    return columnDefs;
 }
 
@@ -1042,6 +1776,10 @@ bool account_history_rocksdb_plugin::impl::createDbSchema(const bfs::path& path)
       return false; /// DB does not need data import.
    }
 
+   std::vector<std::string> existingColumns;
+   if(DB::ListColumnFamilies(options, strPath, &existingColumns).ok())
+      return false; /// Store of an older version, openDb creates the missing columns.
+
    options.create_if_missing = true;
 
    s = DB::Open(options, strPath, &db);
@@ -1105,6 +1843,8 @@ void account_history_rocksdb_plugin::impl::buildAccountHistoryRecord( const acco
       id_slice_t valueSlice(obj.id);
       auto s = _writeBuffer.Put(_columnHandles[AH_OPERATION_BY_ID], ahInfoOpSlice, valueSlice);
       checkStatus(s);
+
+      updateOpTypeBitmap(ahInfo.id, nextEntryId, obj);
    }
    else
    {
@@ -1119,9 +1859,21 @@ void account_history_rocksdb_plugin::impl::buildAccountHistoryRecord( const acco
       id_slice_t valueSlice(obj.id);
       auto s = _writeBuffer.Put(_columnHandles[AH_OPERATION_BY_ID], ahInfoOpSlice, valueSlice);
       checkStatus(s);
+
+      updateOpTypeBitmap(ahInfo.id, 0, obj);
    }
 }
 
+void account_history_rocksdb_plugin::impl::updateOpTypeBitmap(int64_t ahId, uint32_t entryId, const rocksdb_operation_object& obj)
+{
+   ah_op_id_pair chunk(ahId, entryId / OP_TYPE_BITMAP_CHUNK);
+   auto bitmap = _writeBuffer.getOpTypeBitmap(chunk);
+
+   /// Most operations of an account repeat types already seen in the chunk, these need no write.
+   if(addOperationType(&bitmap, getOperationType(obj.serialized_op)))
+      _writeBuffer.putOpTypeBitmap(chunk, bitmap);
+}
+
 void account_history_rocksdb_plugin::impl::prunePotentiallyTooOldItems(account_history_info* ahInfo, const account_name_type& name,
    const fc::time_point_sec& now)
 {
@@ -1156,6 +1908,7 @@ void account_history_rocksdb_plugin::impl::prunePotentiallyTooOldItems(account_h
    /// Boundaries of keys to be removed
    //uint32_t leftBoundary = ahInfo->oldestEntryId;
    uint32_t rightBoundary = ahInfo->oldestEntryId;
+   const uint32_t oldestChunk = ahInfo->oldestEntryId / OP_TYPE_BITMAP_CHUNK;
 
    for(; dataItr->Valid(); dataItr->Next())
    {
@@ -1190,6 +1943,10 @@ void account_history_rocksdb_plugin::impl::prunePotentiallyTooOldItems(account_h
          break;
       }
    }
+
+   /// Chunks left entirely below the oldest entry have nothing more to filter
+   for(uint32_t chunk = oldestChunk; chunk < ahInfo->oldestEntryId / OP_TYPE_BITMAP_CHUNK; ++chunk)
+      _writeBuffer.deleteOpTypeBitmap(std::make_pair(ahInfo->id, chunk));
 }
 
 void account_history_rocksdb_plugin::impl::on_pre_reindex(const zattera::chain::reindex_notification& note)
@@ -1202,6 +1959,12 @@ void account_history_rocksdb_plugin::impl::on_pre_reindex(const zattera::chain::
    auto s = ::rocksdb::DestroyDB(strPath, ::rocksdb::Options());
    checkStatus(s);
 
+   if(_coldStoragePath.empty() == false)
+   {
+      s = ::rocksdb::DestroyDB(_coldStoragePath.string(), ::rocksdb::Options());
+      checkStatus(s);
+   }
+
    openDb();
 
    ilog("Setting write limit to massive level");
@@ -1424,6 +2187,10 @@ void account_history_rocksdb_plugin::set_program_options(
       ("account-history-rocksdb-track-account-range", boost::program_options::value< std::vector<std::string> >()->composing()->multitoken(), "Defines a range of accounts to track as a json pair [\"from\",\"to\"] [from,to] Can be specified multiple times.")
       ("account-history-rocksdb-whitelist-ops", boost::program_options::value< std::vector<std::string> >()->composing(), "Defines a list of operations which will be explicitly logged.")
       ("account-history-rocksdb-blacklist-ops", boost::program_options::value< std::vector<std::string> >()->composing(), "Defines a list of operations which will be explicitly ignored.")
+      ("account-history-rocksdb-hot-days", bpo::value<uint32_t>()->default_value(0),
+         "Operations older than this many days are moved in the background to strongly compressed cold storage. 0 keeps all operations in hot storage.")
+      ("account-history-rocksdb-cold-path", bpo::value<bfs::path>(),
+         "Location of a separate rocksdb database for cold operations, e.g. on cheaper disk. By default they are kept in the main storage.")
 
    ;
    command_line_options.add_options()
@@ -1469,13 +2236,15 @@ void account_history_rocksdb_plugin::plugin_startup()
 void account_history_rocksdb_plugin::plugin_shutdown()
 {
    ilog("Shutting down account_history_rocksdb_plugin...");
+   appbase::app().get_plugin<zattera::plugins::chain::chain_plugin>().unregister_memory_usage_provider(name());
    _my->shutdownDb();
 }
 
-void account_history_rocksdb_plugin::find_account_history_data(const account_name_type& name, uint64_t start, uint32_t limit,
+fc::optional<uint64_t> account_history_rocksdb_plugin::find_account_history_data(const account_name_type& name, uint64_t start,
+   uint32_t limit, const flat_set<uint32_t>& opTypes, uint32_t scanLimit,
    std::function<void(unsigned int, const rocksdb_operation_object&)> processor) const
 {
-   _my->find_account_history_data(name, start, limit, processor);
+   return _my->find_account_history_data(name, start, limit, opTypes, scanLimit, processor);
 }
 
 bool account_history_rocksdb_plugin::find_operation_object(size_t opId, rocksdb_operation_object* op) const
@@ -1495,6 +2264,13 @@ uint32_t account_history_rocksdb_plugin::enum_operations_from_block_range(uint32
    return _my->enumVirtualOperationsFromBlockRange(blockRangeBegin, blockRangeEnd, processor);
 }
 
+virtual_op_cursor account_history_rocksdb_plugin::enum_virtual_operations(uint32_t blockRangeBegin, uint32_t blockRangeEnd,
+   uint64_t operationBegin, uint32_t limit, const flat_set<uint32_t>& opTypes,
+   std::function<void(const rocksdb_operation_object&)> processor) const
+{
+   return _my->enumVirtualOperations(blockRangeBegin, blockRangeEnd, operationBegin, limit, opTypes, processor);
+}
+
 } } }
 
 FC_REFLECT( zattera::plugins::account_history_rocksdb::account_history_info,
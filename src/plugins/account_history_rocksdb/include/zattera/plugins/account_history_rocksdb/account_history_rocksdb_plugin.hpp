@@ -14,7 +14,14 @@ namespace plugins { namespace account_history_rocksdb {
 
 namespace bfs = boost::filesystem;
 
-
+/// Position in the virtual operation index to resume an enumeration from.
+struct virtual_op_cursor
+{
+   /// Block to continue from, 0 if there are no further matching operations.
+   uint32_t block = 0;
+   /// ID of the first operation in `block` not returned yet, 0 to continue at the beginning of `block`.
+   uint64_t operation = 0;
+};
 
 class account_history_rocksdb_plugin final : public appbase::plugin< account_history_rocksdb_plugin >
 {
@@ -35,13 +42,31 @@ public:
    virtual void plugin_startup() override;
    virtual void plugin_shutdown() override;
 
-   void find_account_history_data(const protocol::account_name_type& name, uint64_t start, uint32_t limit,
+   /** Passes the account history entries of `name` to `processor`, newest first, starting at entry `start`.
+    *  \param opTypes - operation types (tags of protocol::operation) to return, all if empty. When set, `limit`
+    *                   counts the returned operations and chunks of the history holding none of the types are
+    *                   skipped using their operation type bitmap.
+    *  \param scanLimit - with opTypes set, maximum number of entries read plus chunks skipped by one call.
+    *  \return entry to pass as `start` of the next call when the scan limit was reached.
+    */
+   fc::optional<uint64_t> find_account_history_data(const protocol::account_name_type& name, uint64_t start, uint32_t limit,
+      const flat_set<uint32_t>& opTypes, uint32_t scanLimit,
       std::function<void(unsigned int, const rocksdb_operation_object&)> processor) const;
    bool find_operation_object(size_t opId, rocksdb_operation_object* data) const;
    void find_operations_by_block(size_t blockNum,
       std::function<void(const rocksdb_operation_object&)> processor) const;
    uint32_t enum_operations_from_block_range(uint32_t blockRangeBegin, uint32_t blockRangeEnd,
       std::function<void(const rocksdb_operation_object&)> processor) const;
+   /** Enumerates virtual operations in [blockRangeBegin, blockRangeEnd) using the virtual operation index.
+    *  \param operationBegin - operations in blockRangeBegin with a lower ID are skipped (resume cursor)
+    *  \param limit          - maximum number of operations passed to `processor`, 0 for no limit
+    *  \param opTypes        - operation types (tags of protocol::operation) to return, all if empty
+    *  \returns the position to resume from when the limit was hit, otherwise the first following block
+    *           holding matching operations.
+    */
+   virtual_op_cursor enum_virtual_operations(uint32_t blockRangeBegin, uint32_t blockRangeEnd,
+      uint64_t operationBegin, uint32_t limit, const flat_set<uint32_t>& opTypes,
+      std::function<void(const rocksdb_operation_object&)> processor) const;
 
 private:
    class impl;
@@ -43,3 +43,5 @@ FC_REFLECT( zattera::plugins::account_by_key::get_key_references_args,
 
 FC_REFLECT( zattera::plugins::account_by_key::get_key_references_return,
    (accounts) )
+
+FC_JSON_DECODE_REFLECTED( zattera::plugins::account_by_key::get_key_references_args )
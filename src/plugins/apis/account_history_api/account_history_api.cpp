@@ -7,6 +7,44 @@ namespace zattera { namespace plugins { namespace account_history {
 
 namespace detail {
 
+namespace
+{
+   /// Maps operation names to their tag in protocol::operation, only virtual operations if only_virtual is set.
+   flat_map< std::string, uint32_t > build_operation_types( bool only_virtual )
+   {
+      flat_map< std::string, uint32_t > result;
+      zattera::protocol::operation op;
+      for( int64_t i = 0; i < zattera::protocol::operation::count(); ++i )
+      {
+         op.set_which( i );
+         if( !only_virtual || is_virtual_operation( op ) )
+         {
+            std::string name;
+            op.visit( fc::get_static_variant_name( name ) );
+            result[ name ] = i;
+         }
+      }
+      return result;
+   }
+
+   /// Translates an operation name filter of an API call into operation tags.
+   flat_set< uint32_t > get_operation_types( const flat_set< std::string >& filter, bool only_virtual )
+   {
+      static const flat_map< std::string, uint32_t > all_types = build_operation_types( false );
+      static const flat_map< std::string, uint32_t > virtual_types = build_operation_types( true );
+      const auto& types = only_virtual ? virtual_types : all_types;
+
+      flat_set< uint32_t > result;
+      for( const auto& name : filter )
+      {
+         auto itr = types.find( name );
+         FC_ASSERT( itr != types.end(), "Unknown ${v}operation ${o}", ("v", only_virtual ? "virtual " : "")("o",name) );
+         result.insert( itr->second );
+      }
+      return result;
+   }
+}
+
 class abstract_account_history_api_impl
 {
    public:
@@ -88,25 +126,42 @@ DEFINE_API_IMPL( account_history_api_chainbase_impl, get_transaction )
 DEFINE_API_IMPL( account_history_api_chainbase_impl, get_account_history )
 {
    FC_ASSERT( args.limit <= 10000, "limit of ${l} is greater than maxmimum allowed", ("l",args.limit) );
-   FC_ASSERT( args.start >= args.limit, "start must be greater than limit" );
+   FC_ASSERT( args.start >= args.limit || !args.filter.empty(), "start must be greater than limit" );
+
+   auto op_types = get_operation_types( args.filter, false );
 
    return _db.with_read_lock( [&]()
    {
       const auto& idx = _db.get_index< chain::account_history_index, chain::by_account >();
       auto itr = idx.lower_bound( boost::make_tuple( args.account, args.start ) );
       uint32_t n = 0;
+      uint32_t scanned = 0;
 
       get_account_history_return result;
-      while( true )
+      for( ; itr != idx.end(); ++itr )
       {
-         if( itr == idx.end() )
-            break;
          if( itr->account != args.account )
             break;
          if( n >= args.limit )
             break;
-         result.history[ itr->sequence ] = _db.get( itr->op );
-         ++itr;
+         if( !op_types.empty() && scanned >= ACCOUNT_HISTORY_API_FILTER_SCAN_LIMIT )
+         {
+            result.next_start = itr->sequence;
+            break;
+         }
+         ++scanned;
+
+         const auto& op = _db.get( itr->op );
+         if( !op_types.empty() )
+         {
+            fc::unsigned_int which;
+            fc::datastream< const char* > ds( op.serialized_op.data(), op.serialized_op.size() );
+            fc::raw::unpack( ds, which );
+            if( op_types.find( which.value ) == op_types.end() )
+               continue;
+         }
+
+         result.history[ itr->sequence ] = op;
          ++n;
       }
 
@@ -151,11 +206,12 @@ DEFINE_API_IMPL( account_history_api_rocksdb_impl, get_ops_in_block )
 DEFINE_API_IMPL( account_history_api_rocksdb_impl, get_account_history )
 {
    FC_ASSERT( args.limit <= 10000, "limit of ${l} is greater than maxmimum allowed", ("l",args.limit) );
-   FC_ASSERT( args.start >= args.limit, "start must be greater than limit" );
+   FC_ASSERT( args.start >= args.limit || !args.filter.empty(), "start must be greater than limit" );
 
    get_account_history_return result;
 
-   _dataSource.find_account_history_data(args.account, args.start, args.limit,
+   result.next_start = _dataSource.find_account_history_data(args.account, args.start, args.limit,
+      get_operation_types( args.filter, false ), ACCOUNT_HISTORY_API_FILTER_SCAN_LIMIT,
       [&result](unsigned int sequence, const account_history_rocksdb::rocksdb_operation_object& op)
       {
          result.history[sequence] = api_operation_object( op );
@@ -171,16 +227,23 @@ DEFINE_API_IMPL( account_history_api_rocksdb_impl, get_transaction )
 
 DEFINE_API_IMPL( account_history_api_rocksdb_impl, enum_virtual_ops)
 {
+   FC_ASSERT( args.limit <= 10000, "limit of ${l} is greater than maxmimum allowed", ("l",args.limit) );
+
+   auto op_types = get_operation_types( args.filter, true );
+
    enum_virtual_ops_return result;
 
-   result.next_block_range_begin = _dataSource.enum_operations_from_block_range(args.block_range_begin,
-      args.block_range_end,
+   auto next = _dataSource.enum_virtual_operations(args.block_range_begin, args.block_range_end,
+      args.operation_begin, args.limit, op_types,
       [&result](const account_history_rocksdb::rocksdb_operation_object& op)
       {
          result.ops.emplace_back(api_operation_object(op));
       }
    );
 
+   result.next_block_range_begin = next.block;
+   result.next_operation_begin = next.operation;
+
    return result;
 }
 
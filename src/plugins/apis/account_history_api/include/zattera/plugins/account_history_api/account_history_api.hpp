@@ -10,6 +10,9 @@
 #include <fc/variant.hpp>
 #include <fc/vector.hpp>
 
+/// Maximum number of history entries a filtered get_account_history call looks at, matching or not
+#define ACCOUNT_HISTORY_API_FILTER_SCAN_LIMIT 100000
+
 namespace zattera { namespace plugins { namespace account_history {
 
 
@@ -65,32 +68,55 @@ struct get_transaction_args
 typedef zattera::protocol::annotated_signed_transaction get_transaction_return;
 
 
+/** \param filter - names of the operations to return (e.g. `transfer_operation`), all operations if empty.
+ *                  With a filter `limit` is the maximum number of matching operations returned, and a call
+ *                  stops after looking at ACCOUNT_HISTORY_API_FILTER_SCAN_LIMIT entries. The RocksDB backend
+ *                  counts a chunk of the history skipped through its operation type bitmap as one entry.
+ */
 struct get_account_history_args
 {
    zattera::protocol::account_name_type   account;
    uint64_t                               start = -1;
    uint32_t                               limit = 1000;
+   flat_set< std::string >                filter;
 };
 
+/** \param next_start - set when a filtered call stopped at the scan limit, pass it as `start` of the next
+ *                      call to continue with the older entries
+ */
 struct get_account_history_return
 {
    std::map< uint32_t, api_operation_object > history;
+   fc::optional< uint64_t >                   next_start;
 };
 
 /** Allows to specify range of blocks to retrieve virtual operations for.
  *  \param block_range_begin - starting block number (inclusive) to search for virtual operations
  *  \param block_range_end   - last block number (exclusive) to search for virtual operations
+ *  \param operation_begin   - skips operations of block_range_begin with a lower ID, used to resume a
+ *                             paged enumeration from the `next_operation_begin` of the previous call
+ *  \param limit             - maximum number of operations to return, 0 returns the whole range
+ *  \param filter            - names of the virtual operations to return (e.g. `fill_order_operation`),
+ *                             all virtual operations if empty
  */
 struct enum_virtual_ops_args
 {
-   uint32_t block_range_begin = 1;
-   uint32_t block_range_end = 2;
+   uint32_t                   block_range_begin = 1;
+   uint32_t                   block_range_end = 2;
+   uint64_t                   operation_begin = 0;
+   uint32_t                   limit = 0;
+   flat_set< std::string >    filter;
 };
 
+/** \param next_block_range_begin - block to continue from, 0 if there are no more matching operations
+ *  \param next_operation_begin   - if non zero the limit was hit inside `next_block_range_begin`, pass it as
+ *                                  `operation_begin` of the next call
+ */
 struct enum_virtual_ops_return
 {
    vector<api_operation_object> ops;
    uint32_t                     next_block_range_begin = 0;
+   uint64_t                     next_operation_begin = 0;
 };
 
 
@@ -126,13 +152,18 @@ FC_REFLECT( zattera::plugins::account_history::get_transaction_args,
    (id) )
 
 FC_REFLECT( zattera::plugins::account_history::get_account_history_args,
-   (account)(start)(limit) )
+   (account)(start)(limit)(filter) )
 
 FC_REFLECT( zattera::plugins::account_history::get_account_history_return,
-   (history) )
+   (history)(next_start) )
 
 FC_REFLECT( zattera::plugins::account_history::enum_virtual_ops_args,
-   (block_range_begin)(block_range_end) )
+   (block_range_begin)(block_range_end)(operation_begin)(limit)(filter) )
 
 FC_REFLECT( zattera::plugins::account_history::enum_virtual_ops_return,
-   (ops)(next_block_range_begin) )
+   (ops)(next_block_range_begin)(next_operation_begin) )
+
+FC_JSON_DECODE_REFLECTED( zattera::plugins::account_history::get_ops_in_block_args )
+FC_JSON_DECODE_REFLECTED( zattera::plugins::account_history::get_transaction_args )
+FC_JSON_DECODE_REFLECTED( zattera::plugins::account_history::get_account_history_args )
+FC_JSON_DECODE_REFLECTED( zattera::plugins::account_history::enum_virtual_ops_args )
@@ -46,3 +46,5 @@ FC_REFLECT( zattera::plugins::block_api::get_block_args,
 FC_REFLECT( zattera::plugins::block_api::get_block_return,
    (block) )
 
+FC_JSON_DECODE_REFLECTED( zattera::plugins::block_api::get_block_header_args )
+FC_JSON_DECODE_REFLECTED( zattera::plugins::block_api::get_block_args )
@@ -50,3 +50,5 @@ class chain_api
 FC_REFLECT( zattera::plugins::chain::push_block_args, (block)(currently_syncing) )
 FC_REFLECT( zattera::plugins::chain::push_block_return, (success)(error) )
 FC_REFLECT( zattera::plugins::chain::push_transaction_return, (success)(error) )
+
+FC_JSON_DECODE_REFLECTED( zattera::plugins::chain::push_block_args )
@@ -24,6 +24,7 @@ class database_api_impl
          (get_reward_funds)
          (get_current_price_feed)
          (get_feed_history)
+         (get_memory_usage)
          (list_witnesses)
          (find_witnesses)
          (list_witness_votes)
@@ -83,6 +84,7 @@ class database_api_impl
       }
 
       chain::database& _db;
+      bool             _allow_dynamic_memory_usage = false;
 };
 
 //////////////////////////////////////////////////////////////////////
@@ -100,7 +102,8 @@ database_api::database_api()
 database_api::~database_api() {}
 
 database_api_impl::database_api_impl()
-   : _db( appbase::app().get_plugin< zattera::plugins::chain::chain_plugin >().db() ) {}
+   : _db( appbase::app().get_plugin< zattera::plugins::chain::chain_plugin >().db() ),
+     _allow_dynamic_memory_usage( appbase::app().get_plugin< database_api_plugin >().allow_dynamic_memory_usage ) {}
 
 database_api_impl::~database_api_impl() {}
 
@@ -157,6 +160,13 @@ DEFINE_API_IMPL( database_api_impl, get_feed_history )
    return _db.get_feed_history();
 }
 
+DEFINE_API_IMPL( database_api_impl, get_memory_usage )
+{
+   FC_ASSERT( !args.include_dynamic || _allow_dynamic_memory_usage,
+      "Counting dynamic allocations is disabled on this node, see api-memory-usage-include-dynamic" );
+   return appbase::app().get_plugin< zattera::plugins::chain::chain_plugin >().get_memory_usage( args.include_dynamic );
+}
+
 
 //////////////////////////////////////////////////////////////////////
 //                                                                  //
@@ -1426,6 +1436,7 @@ DEFINE_READ_APIS( database_api,
    (get_reward_funds)
    (get_current_price_feed)
    (get_feed_history)
+   (get_memory_usage)
    (list_witnesses)
    (find_witnesses)
    (list_witness_votes)
@@ -8,10 +8,17 @@ database_api_plugin::~database_api_plugin() {}
 
 void database_api_plugin::set_program_options(
    options_description& cli,
-   options_description& cfg ) {}
+   options_description& cfg )
+{
+   cfg.add_options()
+      ("api-memory-usage-include-dynamic", bpo::value< bool >()->default_value( false ),
+         "Allow get_memory_usage to count dynamic allocations. Each such call walks every index under the read lock, enable only on private nodes")
+      ;
+}
 
 void database_api_plugin::plugin_initialize( const variables_map& options )
 {
+   allow_dynamic_memory_usage = options.at( "api-memory-usage-include-dynamic" ).as< bool >();
    api = std::make_shared< database_api >();
 }
 
@@ -38,6 +38,12 @@ class database_api
          (get_current_price_feed)
          (get_feed_history)
 
+         /**
+         * @brief Memory used in the shared memory file, per index, and by plugins storing state elsewhere.
+         * Counting the dynamic allocations of objects (include_dynamic) walks whole indexes.
+         */
+         (get_memory_usage)
+
          ///////////////
          // Witnesses //
          ///////////////
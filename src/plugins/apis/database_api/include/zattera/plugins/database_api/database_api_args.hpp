@@ -5,6 +5,7 @@
 #include <zattera/protocol/transaction.hpp>
 #include <zattera/protocol/block_header.hpp>
 
+#include <zattera/plugins/chain/chain_plugin.hpp>
 #include <zattera/plugins/json_rpc/utility.hpp>
 
 namespace zattera { namespace plugins { namespace database_api {
@@ -95,6 +96,16 @@ typedef void_type                get_feed_history_args;
 typedef api_feed_history_object  get_feed_history_return;
 
 
+/* get_memory_usage */
+
+struct get_memory_usage_args
+{
+   bool include_dynamic = false;
+};
+
+typedef chain::memory_usage      get_memory_usage_return;
+
+
 /* Witnesses */
 
 struct list_witnesses_args
@@ -591,6 +602,9 @@ FC_REFLECT_ENUM( zattera::plugins::database_api::sort_order_type,
 FC_REFLECT( zattera::plugins::database_api::get_reward_funds_return,
    (funds) )
 
+FC_REFLECT( zattera::plugins::database_api::get_memory_usage_args,
+   (include_dynamic) )
+
 FC_REFLECT( zattera::plugins::database_api::list_witnesses_args,
    (start)(limit)(order) )
 
@@ -775,3 +789,43 @@ FC_REFLECT( zattera::plugins::database_api::verify_signatures_args,
 
 FC_REFLECT( zattera::plugins::database_api::verify_signatures_return,
    (valid) )
+
+FC_JSON_DECODE_REFLECTED( zattera::plugins::database_api::get_memory_usage_args )
+FC_JSON_DECODE_REFLECTED( zattera::plugins::database_api::list_witnesses_args )
+FC_JSON_DECODE_REFLECTED( zattera::plugins::database_api::find_witnesses_args )
+FC_JSON_DECODE_REFLECTED( zattera::plugins::database_api::list_witness_votes_args )
+FC_JSON_DECODE_REFLECTED( zattera::plugins::database_api::list_accounts_args )
+FC_JSON_DECODE_REFLECTED( zattera::plugins::database_api::find_accounts_args )
+FC_JSON_DECODE_REFLECTED( zattera::plugins::database_api::list_owner_histories_args )
+FC_JSON_DECODE_REFLECTED( zattera::plugins::database_api::find_owner_histories_args )
+FC_JSON_DECODE_REFLECTED( zattera::plugins::database_api::list_account_recovery_requests_args )
+FC_JSON_DECODE_REFLECTED( zattera::plugins::database_api::find_account_recovery_requests_args )
+FC_JSON_DECODE_REFLECTED( zattera::plugins::database_api::list_change_recovery_account_requests_args )
+FC_JSON_DECODE_REFLECTED( zattera::plugins::database_api::find_change_recovery_account_requests_args )
+FC_JSON_DECODE_REFLECTED( zattera::plugins::database_api::list_escrows_args )
+FC_JSON_DECODE_REFLECTED( zattera::plugins::database_api::find_escrows_args )
+FC_JSON_DECODE_REFLECTED( zattera::plugins::database_api::list_withdraw_vesting_routes_args )
+FC_JSON_DECODE_REFLECTED( zattera::plugins::database_api::find_withdraw_vesting_routes_args )
+FC_JSON_DECODE_REFLECTED( zattera::plugins::database_api::list_savings_withdrawals_args )
+FC_JSON_DECODE_REFLECTED( zattera::plugins::database_api::find_savings_withdrawals_args )
+FC_JSON_DECODE_REFLECTED( zattera::plugins::database_api::list_vesting_delegations_args )
+FC_JSON_DECODE_REFLECTED( zattera::plugins::database_api::find_vesting_delegations_args )
+FC_JSON_DECODE_REFLECTED( zattera::plugins::database_api::list_vesting_delegation_expirations_args )
+FC_JSON_DECODE_REFLECTED( zattera::plugins::database_api::find_vesting_delegation_expirations_args )
+FC_JSON_DECODE_REFLECTED( zattera::plugins::database_api::list_dollar_conversion_requests_args )
+FC_JSON_DECODE_REFLECTED( zattera::plugins::database_api::find_dollar_conversion_requests_args )
+FC_JSON_DECODE_REFLECTED( zattera::plugins::database_api::list_decline_voting_rights_requests_args )
+FC_JSON_DECODE_REFLECTED( zattera::plugins::database_api::find_decline_voting_rights_requests_args )
+FC_JSON_DECODE_REFLECTED( zattera::plugins::database_api::list_comments_args )
+FC_JSON_DECODE_REFLECTED( zattera::plugins::database_api::find_comments_args )
+FC_JSON_DECODE_REFLECTED( zattera::plugins::database_api::list_votes_args )
+FC_JSON_DECODE_REFLECTED( zattera::plugins::database_api::find_votes_args )
+FC_JSON_DECODE_REFLECTED( zattera::plugins::database_api::list_limit_orders_args )
+FC_JSON_DECODE_REFLECTED( zattera::plugins::database_api::find_limit_orders_args )
+FC_JSON_DECODE_REFLECTED( zattera::plugins::database_api::get_order_book_args )
+FC_JSON_DECODE_REFLECTED( zattera::plugins::database_api::get_transaction_hex_args )
+FC_JSON_DECODE_REFLECTED( zattera::plugins::database_api::get_required_signatures_args )
+FC_JSON_DECODE_REFLECTED( zattera::plugins::database_api::get_potential_signatures_args )
+FC_JSON_DECODE_REFLECTED( zattera::plugins::database_api::verify_authority_args )
+FC_JSON_DECODE_REFLECTED( zattera::plugins::database_api::verify_account_authority_args )
+FC_JSON_DECODE_REFLECTED( zattera::plugins::database_api::verify_signatures_args )
@@ -72,10 +72,10 @@ struct api_comment_object
          root_permlink = to_string( root->permlink );
       }
 #ifndef IS_LOW_MEM
-      const auto& con = db.get< chain::comment_content_object, chain::by_comment >( o.id );
-      title = to_string( con.title );
-      body = to_string( con.body );
-      json_metadata = to_string( con.json_metadata );
+      auto content = db.get_comment_content( db.get< chain::comment_content_object, chain::by_comment >( o.id ) );
+      title = std::move( content.title );
+      body = std::move( content.body );
+      json_metadata = std::move( content.json_metadata );
 #endif
    }
 
@@ -31,6 +31,9 @@ class database_api_plugin : public plugin< database_api_plugin >
       virtual void plugin_shutdown() override;
 
       std::shared_ptr< class database_api > api;
+
+      /// Whether get_memory_usage may walk the indexes to count dynamic allocations
+      bool allow_dynamic_memory_usage = false;
 };
 
 } } } // zattera::plugins::database_api
@@ -131,3 +131,7 @@ FC_REFLECT( zattera::plugins::debug_node::debug_has_hardfork_return,
 
 FC_REFLECT( zattera::plugins::debug_node::debug_get_json_schema_return,
             (schema) )
+
+FC_JSON_DECODE_REFLECTED( zattera::plugins::debug_node::debug_push_blocks_args )
+FC_JSON_DECODE_REFLECTED( zattera::plugins::debug_node::debug_generate_blocks_until_args )
+FC_JSON_DECODE_REFLECTED( zattera::plugins::debug_node::debug_set_hardfork_args )
@@ -249,3 +249,9 @@ FC_REFLECT( zattera::plugins::follow::get_blog_authors_args,
 
 FC_REFLECT( zattera::plugins::follow::get_blog_authors_return,
             (blog_authors) );
+
+FC_JSON_DECODE_REFLECTED( zattera::plugins::follow::get_followers_args )
+FC_JSON_DECODE_REFLECTED( zattera::plugins::follow::get_follow_count_args )
+FC_JSON_DECODE_REFLECTED( zattera::plugins::follow::get_feed_entries_args )
+FC_JSON_DECODE_REFLECTED( zattera::plugins::follow::get_reblogged_by_args )
+FC_JSON_DECODE_REFLECTED( zattera::plugins::follow::get_blog_authors_args )
@@ -164,3 +164,8 @@ FC_REFLECT( zattera::plugins::market_history::get_market_history_return,
 
 FC_REFLECT( zattera::plugins::market_history::get_market_history_buckets_return,
             (bucket_sizes) )
+
+FC_JSON_DECODE_REFLECTED( zattera::plugins::market_history::get_order_book_args )
+FC_JSON_DECODE_REFLECTED( zattera::plugins::market_history::get_trade_history_args )
+FC_JSON_DECODE_REFLECTED( zattera::plugins::market_history::get_recent_trades_args )
+FC_JSON_DECODE_REFLECTED( zattera::plugins::market_history::get_market_history_args )
@@ -37,6 +37,10 @@ struct broadcast_block_args
 
 typedef void_type broadcast_block_return;
 
+typedef void_type get_p2p_task_profile_args;
+
+typedef fc::thread_profile get_p2p_task_profile_return;
+
 namespace detail{ class network_broadcast_api_impl; }
 
 class network_broadcast_api
@@ -48,6 +52,7 @@ class network_broadcast_api
       DECLARE_API(
          (broadcast_transaction)
          (broadcast_block)
+         (get_p2p_task_profile)
       )
 
    private:
@@ -61,3 +66,6 @@ FC_REFLECT( zattera::plugins::network_broadcast_api::broadcast_transaction_args,
 
 FC_REFLECT( zattera::plugins::network_broadcast_api::broadcast_block_args,
    (block) )
+
+FC_JSON_DECODE_REFLECTED( zattera::plugins::network_broadcast_api::broadcast_transaction_args )
+FC_JSON_DECODE_REFLECTED( zattera::plugins::network_broadcast_api::broadcast_block_args )
@@ -19,6 +19,7 @@ namespace detail
          DECLARE_API_IMPL(
             (broadcast_transaction)
             (broadcast_block)
+            (get_p2p_task_profile)
          )
 
          bool check_max_block_age( int32_t max_block_age ) const;
@@ -43,6 +44,11 @@ namespace detail
       return broadcast_block_return();
    }
 
+   DEFINE_API_IMPL( network_broadcast_api_impl, get_p2p_task_profile )
+   {
+      return _p2p.get_task_profile();
+   }
+
    bool network_broadcast_api_impl::check_max_block_age( int32_t max_block_age ) const
    {
       if( max_block_age < 0 )
@@ -69,6 +75,7 @@ network_broadcast_api::~network_broadcast_api() {}
 DEFINE_LOCKLESS_APIS( network_broadcast_api,
    (broadcast_transaction)
    (broadcast_block)
+   (get_p2p_task_profile)
 )
 
 } } } // zattera::plugins::network_broadcast_api
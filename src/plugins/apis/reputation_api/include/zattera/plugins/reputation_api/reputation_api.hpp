@@ -59,3 +59,5 @@ FC_REFLECT( zattera::plugins::reputation::get_account_reputations_args,
 
 FC_REFLECT( zattera::plugins::reputation::get_account_reputations_return,
             (reputations) );
+
+FC_JSON_DECODE_REFLECTED( zattera::plugins::reputation::get_account_reputations_args )
@@ -279,3 +279,10 @@ FC_REFLECT( zattera::plugins::tags::get_discussions_by_author_before_date_args,
 
 FC_REFLECT( zattera::plugins::tags::get_active_votes_return,
             (votes) )
+
+FC_JSON_DECODE_REFLECTED( zattera::plugins::tags::discussion_query )
+FC_JSON_DECODE_REFLECTED( zattera::plugins::tags::get_trending_tags_args )
+FC_JSON_DECODE_REFLECTED( zattera::plugins::tags::get_tags_used_by_author_args )
+FC_JSON_DECODE_REFLECTED( zattera::plugins::tags::get_discussion_args )
+FC_JSON_DECODE_REFLECTED( zattera::plugins::tags::get_replies_by_last_update_args )
+FC_JSON_DECODE_REFLECTED( zattera::plugins::tags::get_discussions_by_author_before_date_args )
@@ -45,3 +45,6 @@ FC_REFLECT( zattera::plugins::test_api::test_api_a_args, )
 FC_REFLECT( zattera::plugins::test_api::test_api_b_args, )
 FC_REFLECT( zattera::plugins::test_api::test_api_a_return, (value) )
 FC_REFLECT( zattera::plugins::test_api::test_api_b_return, (value) )
+
+FC_JSON_DECODE_REFLECTED( zattera::plugins::test_api::test_api_a_args )
+FC_JSON_DECODE_REFLECTED( zattera::plugins::test_api::test_api_b_args )
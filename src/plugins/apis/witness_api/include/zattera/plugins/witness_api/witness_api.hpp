@@ -53,3 +53,5 @@ FC_REFLECT( zattera::plugins::witness::get_account_bandwidth_args,
 
 FC_REFLECT( zattera::plugins::witness::get_account_bandwidth_return,
             (bandwidth) )
+
+FC_JSON_DECODE_REFLECTED( zattera::plugins::witness::get_account_bandwidth_args )
@@ -15,9 +15,23 @@
 #include <zattera/chain/index.hpp>
 #include <zattera/chain/operation_notification.hpp>
 
+#include <zattera/schema/schema.hpp>
+
+#include <fc/io/raw.hpp>
+
+#include <boost/iostreams/device/file_descriptor.hpp>
+#include <boost/iostreams/filtering_stream.hpp>
+#include <boost/iostreams/operations.hpp>
 #include <boost/thread/future.hpp>
 #include <boost/thread/sync_bounded_queue.hpp>
 
+#include <fcntl.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+#include <zlib.h>
+
+#include <cstring>
 #include <fstream>
 #include <iostream>
 #include <queue>
@@ -47,17 +61,133 @@ struct api_export_data_object
    }
 };
 
+/**
+ * First frame of a binary export stream. It names the type exported under every key and
+ * carries the schema of those types and of everything they contain, as produced by
+ * zattera::schema, so a reader can decode the frames without linking against the node.
+ */
+struct binary_export_header
+{
+   std::string                                        format = "zattera-block-data-export";
+   uint32_t                                           version = 1;
+   std::vector< std::pair< std::string, std::string > >
+                                                      export_types;
+   std::vector< std::string >                         schemas;
+};
+
+/**
+ * One frame per block. The data of every plugin is kept as its own byte string, so a reader
+ * can skip the keys it does not know.
+ */
+struct binary_export_frame
+{
+   block_id_type                                      block_id;
+   block_id_type                                      previous;
+   std::vector< std::pair< std::string, std::vector< char > > >
+                                                      export_data;
+};
+
 } } } }
 
 FC_REFLECT( zattera::plugins::block_data_export::detail::api_export_data_object, (block_id)(previous)(export_data) )
+FC_REFLECT( zattera::plugins::block_data_export::detail::binary_export_header, (format)(version)(export_types)(schemas) )
+FC_REFLECT( zattera::plugins::block_data_export::detail::binary_export_frame, (block_id)(previous)(export_data) )
 
 namespace zattera { namespace plugins { namespace block_data_export { namespace detail {
 
 struct work_item
 {
    std::shared_ptr< api_export_data_object >          edo;
-   boost::promise< std::shared_ptr< std::string > >   edo_json_promise;
-   boost::future< std::shared_ptr< std::string > >    edo_json_future = edo_json_promise.get_future();
+   boost::promise< std::shared_ptr< std::string > >   edo_output_promise;
+   boost::future< std::shared_ptr< std::string > >    edo_output_future = edo_output_promise.get_future();
+};
+
+enum class export_format
+{
+   json,
+   binary
+};
+
+/**
+ * Binary frames are the fc::raw serialization of their object, prefixed with its size as a
+ * little endian uint32.
+ */
+template< typename T >
+std::shared_ptr< std::string > make_binary_frame( const T& obj )
+{
+   uint32_t size = fc::raw::pack_size( obj );
+   auto frame = std::make_shared< std::string >( sizeof( size ) + size, '\0' );
+   fc::datastream< char* > ds( &(*frame)[0], frame->size() );
+   fc::raw::pack( ds, size );
+   fc::raw::pack( ds, obj );
+   return frame;
+}
+
+/**
+ * gzip compressing output filter. boost::iostreams::gzip_compressor is not flushable, so a
+ * reader would only see whole deflate blocks, long after the block they hold was applied.
+ * Flushing this filter ends the pending data with Z_SYNC_FLUSH, so every frame written so far
+ * can be decompressed while the stream stays open.
+ */
+class sync_flush_gzip_compressor
+{
+   public:
+      typedef char char_type;
+      struct category :
+         boost::iostreams::output_filter_tag,
+         boost::iostreams::multichar_tag,
+         boost::iostreams::flushable_tag,
+         boost::iostreams::closable_tag {};
+
+      sync_flush_gzip_compressor() : _zs( std::make_shared< z_stream >() )
+      {
+         memset( _zs.get(), 0, sizeof( z_stream ) );
+         // 16 added to the window bits selects the gzip wrapper
+         FC_ASSERT( deflateInit2( _zs.get(), Z_DEFAULT_COMPRESSION, Z_DEFLATED, 15 + 16, 8, Z_DEFAULT_STRATEGY ) == Z_OK,
+            "Could not initialize gzip compression" );
+      }
+
+      template< typename Sink >
+      std::streamsize write( Sink& snk, const char* s, std::streamsize n )
+      {
+         _zs->next_in = (Bytef*)s;
+         _zs->avail_in = uInt( n );
+         deflate_to( snk, Z_NO_FLUSH );
+         return n;
+      }
+
+      template< typename Sink >
+      bool flush( Sink& snk )
+      {
+         deflate_to( snk, Z_SYNC_FLUSH );
+         return boost::iostreams::flush( snk );
+      }
+
+      template< typename Sink >
+      void close( Sink& snk )
+      {
+         deflate_to( snk, Z_FINISH );
+         deflateEnd( _zs.get() );
+      }
+
+   private:
+      template< typename Sink >
+      void deflate_to( Sink& snk, int mode )
+      {
+         char buffer[ 16 * 1024 ];
+         int result;
+         do
+         {
+            _zs->next_out = (Bytef*)buffer;
+            _zs->avail_out = sizeof( buffer );
+            result = deflate( _zs.get(), mode );
+            FC_ASSERT( result != Z_STREAM_ERROR, "gzip compression failed" );
+            boost::iostreams::write( snk, buffer, sizeof( buffer ) - _zs->avail_out );
+         } while( _zs->avail_out == 0 || ( mode == Z_FINISH && result != Z_STREAM_END ) );
+      }
+
+      /// Filters are copied when pushed on a chain, the stream state is shared by the copies
+      std::shared_ptr< z_stream >   _zs;
 };
 
 class block_data_export_plugin_impl
@@ -79,8 +209,10 @@ class block_data_export_plugin_impl
 
       void start_threads();
       void stop_threads();
-      void convert_to_json_thread_main();
+      void convert_thread_main();
       void output_thread_main();
+      std::shared_ptr< std::string > create_binary_header();
+      int open_output_fd();
 
       database&                     _db;
       block_data_export_plugin&     _self;
@@ -94,6 +226,9 @@ class block_data_export_plugin_impl
          > >                        _factory_list;
       std::string                   _output_name;
       bool                          _enabled = false;
+      export_format                 _format = export_format::json;
+      bool                          _compress = false;
+      std::shared_ptr< std::string > _binary_header;
 
       size_t                        _max_queue_size = 100;
       boost::concurrent::sync_bounded_queue< std::shared_ptr< work_item > >    _data_queue;
@@ -102,7 +237,7 @@ class block_data_export_plugin_impl
       size_t                        _thread_stack_size = 4096*1024;
       std::shared_ptr< boost::thread >                      _output_thread;
 
-      std::vector< boost::thread >  _json_conversion_threads;
+      std::vector< boost::thread >  _conversion_threads;
 };
 
 void block_data_export_plugin_impl::start_threads()
@@ -110,10 +245,14 @@ void block_data_export_plugin_impl::start_threads()
    boost::thread::attributes attrs;
    attrs.set_stack_size( _thread_stack_size );
 
+   // Schemas are created lazily and not thread safe, so the header is built before any thread runs
+   if( _format == export_format::binary )
+      _binary_header = create_binary_header();
+
    size_t num_threads = boost::thread::hardware_concurrency()+1;
    for( size_t i=0; i<num_threads; i++ )
    {
-      _json_conversion_threads.emplace_back( attrs, [this]() { convert_to_json_thread_main(); } );
+      _conversion_threads.emplace_back( attrs, [this]() { convert_thread_main(); } );
    }
 
    _output_thread = std::make_shared< boost::thread >( attrs, [this]() { output_thread_main(); } );
@@ -134,12 +273,35 @@ void block_data_export_plugin_impl::stop_threads()
    _output_thread.reset();
 
    _data_queue.close();
-   for( boost::thread& t : _json_conversion_threads )
+   for( boost::thread& t : _conversion_threads )
       t.join();
-   _json_conversion_threads.clear();
+   _conversion_threads.clear();
 }
 
-void block_data_export_plugin_impl::convert_to_json_thread_main()
+std::shared_ptr< std::string > block_data_export_plugin_impl::create_binary_header()
+{
+   binary_export_header header;
+   std::vector< std::shared_ptr< zattera::schema::abstract_schema > > schemas;
+
+   for( const auto& fact : _factory_list )
+   {
+      std::shared_ptr< zattera::schema::abstract_schema > sch = fact.second()->get_schema();
+      header.export_types.emplace_back( fact.first, std::string() );
+      sch->get_name( header.export_types.back().second );
+      schemas.push_back( sch );
+   }
+
+   zattera::schema::add_dependent_schemas( schemas );
+   for( const auto& sch : schemas )
+   {
+      header.schemas.emplace_back();
+      sch->get_str_schema( header.schemas.back() );
+   }
+
+   return make_binary_frame( header );
+}
+
+void block_data_export_plugin_impl::convert_thread_main()
 {
    while( true )
    {
@@ -154,14 +316,79 @@ void block_data_export_plugin_impl::convert_to_json_thread_main()
       }
 
       // TODO exception handling
-      std::shared_ptr< std::string > edo_json = std::make_shared< std::string >( fc::json::to_string( work->edo ) );
-      work->edo_json_promise.set_value( edo_json );
+      if( _format == export_format::binary )
+      {
+         binary_export_frame frame;
+         frame.block_id = work->edo->block_id;
+         frame.previous = work->edo->previous;
+         frame.export_data.reserve( work->edo->export_data.size() );
+         for( const auto& data : work->edo->export_data )
+         {
+            frame.export_data.emplace_back( data.first, std::vector< char >() );
+            data.second->to_binary( frame.export_data.back().second );
+         }
+         work->edo_output_promise.set_value( make_binary_frame( frame ) );
+      }
+      else
+      {
+         std::shared_ptr< std::string > edo_json = std::make_shared< std::string >( fc::json::to_string( work->edo ) );
+         edo_json->push_back( '\n' );
+         work->edo_output_promise.set_value( edo_json );
+      }
+   }
+}
+
+/**
+ * The output is a file, a named pipe, which blocks until a reader opens it, or a Unix
+ * socket given as "unix:<path>". Writes block while a pipe or socket reader falls behind,
+ * the bounded queues then fill up and block block application until the reader catches up.
+ */
+int block_data_export_plugin_impl::open_output_fd()
+{
+   static const std::string unix_prefix = "unix:";
+   if( _output_name.compare( 0, unix_prefix.size(), unix_prefix ) == 0 )
+   {
+      std::string path = _output_name.substr( unix_prefix.size() );
+      sockaddr_un addr;
+      memset( &addr, 0, sizeof( addr ) );
+      addr.sun_family = AF_UNIX;
+      FC_ASSERT( path.size() < sizeof( addr.sun_path ), "Unix socket path is too long", ("path", path) );
+      strncpy( addr.sun_path, path.c_str(), sizeof( addr.sun_path ) - 1 );
+
+      int fd = ::socket( AF_UNIX, SOCK_STREAM, 0 );
+      FC_ASSERT( fd >= 0, "Could not create socket: ${e}", ("e", strerror( errno )) );
+      if( ::connect( fd, (sockaddr*)&addr, sizeof( addr ) ) != 0 )
+      {
+         int err = errno;
+         ::close( fd );
+         FC_THROW( "Could not connect to ${path}: ${e}", ("path", path)("e", strerror( err )) );
+      }
+      return fd;
    }
+
+   int fd = ::open( _output_name.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644 );
+   FC_ASSERT( fd >= 0, "Could not open ${f}: ${e}", ("f", _output_name)("e", strerror( errno )) );
+   return fd;
 }
 
 void block_data_export_plugin_impl::output_thread_main()
 {
-   std::ofstream output_file( _output_name, std::ios::binary );
+   boost::iostreams::filtering_ostream output;
+   try
+   {
+      if( _compress )
+         output.push( sync_flush_gzip_compressor() );
+      output.push( boost::iostreams::file_descriptor_sink( open_output_fd(), boost::iostreams::close_handle ) );
+   }
+   catch( const fc::exception& e )
+   {
+      elog( "Could not open block data export output: ${e}", ("e", e.to_detail_string()) );
+      output.reset();
+   }
+
+   if( _binary_header && !output.empty() )
+      output.write( _binary_header->data(), _binary_header->size() );
+
    while( true )
    {
       std::shared_ptr< work_item > work;
@@ -174,12 +401,17 @@ void block_data_export_plugin_impl::output_thread_main()
          break;
       }
 
-      std::shared_ptr< std::string > edo_json = work->edo_json_future.get();
+      std::shared_ptr< std::string > edo_output = work->edo_output_future.get();
+
+      if( output.empty() )
+         continue;
 
-      output_file.write( edo_json->c_str(), edo_json->length() );
-      output_file.put( '\n' );
-      output_file.flush();
+      output.write( edo_output->data(), edo_output->size() );
+      output.flush();
    }
+
+   if( !output.empty() )
+      output.reset();
 }
 
 void block_data_export_plugin_impl::register_export_data_factory(
@@ -267,7 +499,9 @@ std::shared_ptr< exportable_block_data > block_data_export_plugin::find_abstract
 void block_data_export_plugin::set_program_options( options_description& cli, options_description& cfg )
 {
    cfg.add_options()
-         ("block-data-export-file", boost::program_options::value< string >()->default_value("NONE"), "Where to export data (NONE to discard)")
+         ("block-data-export-file", boost::program_options::value< string >()->default_value("NONE"), "Where to export data: a file, a named pipe, unix:<path> for a Unix socket, or NONE to discard")
+         ("block-data-export-format", boost::program_options::value< string >()->default_value("json"), "Export format: json (one object per line) or binary (length-prefixed fc::raw frames after a schema header)")
+         ("block-data-export-compress", boost::program_options::value< bool >()->default_value(false), "Compress the export stream with gzip")
          ;
 }
 
@@ -283,6 +517,13 @@ void block_data_export_plugin::plugin_initialize( const boost::program_options::
       if( !my->_enabled )
          return;
 
+      const std::string& format = options.at( "block-data-export-format" ).as< string >();
+      if( format == "binary" )
+         my->_format = detail::export_format::binary;
+      else
+         FC_ASSERT( format == "json", "Unknown block-data-export-format ${f}, expected json or binary", ("f", format) );
+      my->_compress = options.at( "block-data-export-compress" ).as< bool >();
+
       my->_pre_apply_block_conn = my->_db.add_pre_apply_block_handler(
          [&]( const block_notification& note ){ my->on_pre_apply_block( note ); }, *this, -9300 );
       my->_post_apply_block_conn = my->_db.add_post_apply_block_handler(
@@ -1,11 +1,17 @@
 #pragma once
 
+#include <memory>
 #include <string>
+#include <vector>
 
 namespace fc {
 class variant;
 }
 
+namespace zattera { namespace schema {
+struct abstract_schema;
+} }
+
 namespace zattera { namespace plugins { namespace block_data_export {
 
 class exportable_block_data
@@ -15,6 +21,11 @@ class exportable_block_data
       virtual ~exportable_block_data();
 
       virtual void to_variant( fc::variant& v )const = 0;
+
+      /// fc::raw serialization of the data, written by the binary export format
+      virtual void to_binary( std::vector< char >& out )const = 0;
+      /// Schema of the type serialized by to_binary(), written to the binary stream header
+      virtual std::shared_ptr< zattera::schema::abstract_schema > get_schema()const = 0;
 };
 
 } } }
@@ -1,4 +1,6 @@
 #include <zattera/chain/database_exceptions.hpp>
+#include <zattera/chain/utils/signal.hpp>
+#include <zattera/protocol/signature_cache.hpp>
 
 #include <zattera/plugins/chain/chain_plugin.hpp>
 #include <zattera/plugins/statsd/utility.hpp>
@@ -14,8 +16,10 @@
 #include <boost/thread/future.hpp>
 #include <boost/lockfree/queue.hpp>
 
+#include <algorithm>
 #include <thread>
 #include <memory>
+#include <mutex>
 #include <iostream>
 
 namespace zattera { namespace plugins { namespace chain {
@@ -42,7 +46,7 @@ struct generate_block_request
    signed_block block;
 };
 
-typedef fc::static_variant< const signed_block*, const signed_transaction*, generate_block_request* > write_request_ptr;
+typedef fc::static_variant< const prepared_block*, const signed_transaction*, generate_block_request* > write_request_ptr;
 typedef fc::static_variant< boost::promise< void >*, fc::future< void >* > promise_ptr;
 
 struct write_context
@@ -64,6 +68,7 @@ class chain_plugin_impl
 
       void start_write_processing();
       void stop_write_processing();
+      void report_memory_usage()const;
 
       uint64_t                         shared_memory_size = 0;
       uint16_t                         shared_file_full_threshold = 0;
@@ -77,11 +82,21 @@ class chain_plugin_impl
       bool                             dump_memory_details = false;
       bool                             benchmark_is_enabled =false;
       bool                             statsd_on_replay = false;
+      bool                             compact_shared_file = false;
+      bool                             exit_after_compaction = false;
+      bool                             use_comment_content_store = false;
+      uint64_t                         comment_content_cache_size = 0;
       uint32_t                         stop_replay_at = 0;
       uint32_t                         benchmark_interval = 0;
       uint32_t                         flush_interval = 0;
+      uint32_t                         parallel_validation_threads = 0;
+      uint32_t                         statsd_memory_usage_interval = 0;
       flat_map<uint32_t,block_id_type> loaded_checkpoints;
 
+      mutable std::mutex               memory_usage_providers_mutex;
+      std::vector< std::pair< std::string, chain_plugin::memory_usage_provider > > memory_usage_providers;
+      boost::signals2::connection      post_apply_block_conn;
+
       uint32_t allow_future_time = 5;
 
       bool                             running = true;
@@ -102,7 +117,7 @@ struct write_request_visitor
 
    typedef bool result_type;
 
-   bool operator()( const signed_block* block )
+   bool operator()( const prepared_block* block )
    {
       bool result = false;
 
@@ -267,6 +282,45 @@ void chain_plugin_impl::start_write_processing()
    });
 }
 
+/// Index type names are demangled C++ names, statsd keys only keep the unqualified name
+static std::string memory_usage_key( const std::string& type )
+{
+   std::string key = type.substr( 0, type.find( '<' ) );
+   auto pos = key.rfind( "::" );
+   if( pos != std::string::npos )
+      key = key.substr( pos + 2 );
+
+   for( char& c : key )
+      if( !std::isalnum( static_cast< unsigned char >( c ) ) && c != '_' )
+         c = '_';
+   return key;
+}
+
+void chain_plugin_impl::report_memory_usage()const
+{
+   const auto& statsd = statsd::util::get_statsd();
+   memory_usage usage = appbase::app().get_plugin< chain_plugin >().get_memory_usage();
+
+   statsd.gauge( "chain", "memory", "shared_memory.size", usage.shared_memory.size );
+   statsd.gauge( "chain", "memory", "shared_memory.free", usage.shared_memory.free );
+   statsd.gauge( "chain", "memory", "shared_memory.used", usage.shared_memory.used );
+   statsd.gauge( "chain", "memory", "shared_memory.accounted", usage.shared_memory.accounted );
+   statsd.gauge( "chain", "memory", "shared_memory.unaccounted", usage.shared_memory.unaccounted );
+
+   for( const auto& idx : usage.indexes )
+   {
+      std::string prefix = "index." + memory_usage_key( idx.type ) + ".";
+      statsd.gauge( "chain", "memory", prefix + "item_count", idx.item_count );
+      statsd.gauge( "chain", "memory", prefix + "payload", idx.payload );
+      statsd.gauge( "chain", "memory", prefix + "node_overhead", idx.node_overhead );
+      statsd.gauge( "chain", "memory", prefix + "undo_stack", idx.undo_stack );
+   }
+
+   for( const auto& plugin : usage.plugins )
+      for( const auto& entry : plugin.usage )
+         statsd.gauge( "chain", "memory", "plugin." + plugin.plugin + "." + entry.first, entry.second );
+}
+
 void chain_plugin_impl::stop_write_processing()
 {
    running = false;
@@ -305,9 +359,19 @@ void chain_plugin::set_program_options(options_description& cli, options_descrip
             "A 2 precision percentage (0-10000) that defines the threshold for when to autoscale the shared memory file. Setting this to 0 disables autoscaling. Recommended value for consensus node is 9500 (95%). Full node is 9900 (99%)" )
          ("shared-file-scale-rate", bpo::value<uint16_t>()->default_value(0),
             "A 2 precision percentage (0-10000) that defines how quickly to scale the shared memory file. When autoscaling occurs the file's size will be increased by this percent. Setting this to 0 disables autoscaling. Recommended value is between 1000-2000 (10-20%)" )
+         ("comment-content-store", bpo::value<bool>()->default_value(false),
+            "Keep comment titles, bodies and json metadata in an append only file next to the shared memory file instead of in shared memory. Space taken by edited comments is reclaimed on replay")
+         ("comment-content-cache-size", bpo::value<string>()->default_value("64M"),
+            "Size of the in memory cache of comment content read from the comment content store")
          ("checkpoint,c", bpo::value<vector<string>>()->composing(), "Pairs of [BLOCK_NUM,BLOCK_ID] that should be enforced as checkpoints.")
          ("flush-state-interval", bpo::value<uint32_t>(),
             "flush shared memory changes to disk every N blocks")
+         ("parallel-validation-threads", bpo::value<uint32_t>()->default_value(0),
+            "Number of threads used to validate the transactions of a block in parallel before applying them in order. 0 disables")
+         ("signature-cache-size", bpo::value<uint32_t>()->default_value(100000),
+            "Number of public keys recovered from transaction signatures to keep for reuse. 0 disables")
+         ("statsd-memory-usage-interval", bpo::value<uint32_t>()->default_value(0),
+            "Report the memory usage of the shared memory file, its indexes and plugin storage as statsd gauges every N blocks. 0 disables")
          ;
    cli.add_options()
          ("replay-blockchain", bpo::bool_switch()->default_value(false), "clear chain database and replay all blocks" )
@@ -318,6 +382,8 @@ void chain_plugin::set_program_options(options_description& cli, options_descrip
          ("dump-memory-details", bpo::bool_switch()->default_value(false), "Dump database objects memory usage info. Use set-benchmark-interval to set dump interval.")
          ("check-locks", bpo::bool_switch()->default_value(false), "Check correctness of chainbase locking" )
          ("validate-database-invariants", bpo::bool_switch()->default_value(false), "Validate all supply invariants check out" )
+         ("compact-shared-file", bpo::bool_switch()->default_value(false), "Rebuild the shared memory file into a densely packed segment on startup" )
+         ("exit-after-compaction", bpo::bool_switch()->default_value(false), "Exit after compacting the shared memory file (use with compact-shared-file)" )
          ;
 }
 
@@ -341,6 +407,20 @@ void chain_plugin::plugin_initialize(const variables_map& options) {
    if( options.count( "shared-file-scale-rate" ) )
       my->shared_file_scale_rate = options.at( "shared-file-scale-rate" ).as< uint16_t >();
 
+   my->use_comment_content_store = options.at( "comment-content-store" ).as< bool >();
+   my->comment_content_cache_size = fc::parse_size( options.at( "comment-content-cache-size" ).as< string >() );
+   if( my->use_comment_content_store )
+   {
+      register_memory_usage_provider( name(), [this]()
+      {
+         const auto& store = my->db.get_comment_content_store();
+         fc::flat_map< std::string, uint64_t > usage;
+         usage[ "comment_content_store_file" ] = store.size();
+         usage[ "comment_content_cache" ] = store.cached_bytes();
+         return usage;
+      });
+   }
+
    my->replay              = options.at( "replay-blockchain").as<bool>();
    my->resync              = options.at( "resync-blockchain").as<bool>();
    my->stop_replay_at      =
@@ -350,11 +430,17 @@ void chain_plugin::plugin_initialize(const variables_map& options) {
    my->check_locks         = options.at( "check-locks" ).as< bool >();
    my->validate_invariants = options.at( "validate-database-invariants" ).as<bool>();
    my->dump_memory_details = options.at( "dump-memory-details" ).as<bool>();
+   my->compact_shared_file = options.at( "compact-shared-file" ).as<bool>();
+   my->exit_after_compaction = options.at( "exit-after-compaction" ).as<bool>();
    if( options.count( "flush-state-interval" ) )
       my->flush_interval = options.at( "flush-state-interval" ).as<uint32_t>();
    else
       my->flush_interval = 10000;
 
+   my->parallel_validation_threads = options.at( "parallel-validation-threads" ).as< uint32_t >();
+   my->statsd_memory_usage_interval = options.at( "statsd-memory-usage-interval" ).as< uint32_t >();
+   zattera::protocol::signature_cache::instance().set_capacity( options.at( "signature-cache-size" ).as< uint32_t >() );
+
    if(options.count("checkpoint"))
    {
       auto cps = options.at("checkpoint").as<vector<string>>();
@@ -424,9 +510,19 @@ void chain_plugin::plugin_startup()
    }
 
    my->db.set_flush_interval( my->flush_interval );
+   my->db.set_parallel_validation_threads( my->parallel_validation_threads );
    my->db.add_checkpoints( my->loaded_checkpoints );
    my->db.set_require_locking( my->check_locks );
 
+   if( my->statsd_memory_usage_interval > 0 )
+   {
+      my->post_apply_block_conn = my->db.add_post_apply_block_handler( [this]( const block_notification& note )
+      {
+         if( note.block_num % my->statsd_memory_usage_interval == 0 && statsd::util::statsd_enabled() )
+            my->report_memory_usage();
+      }, *this, 0 );
+   }
+
    bool dump_memory_details = my->dump_memory_details;
    zattera::utilities::benchmark_dumper dumper;
 
@@ -455,6 +551,8 @@ void chain_plugin::plugin_startup()
    db_open_args.shared_file_size = my->shared_memory_size;
    db_open_args.shared_file_full_threshold = my->shared_file_full_threshold;
    db_open_args.shared_file_scale_rate = my->shared_file_scale_rate;
+   db_open_args.use_comment_content_store = my->use_comment_content_store;
+   db_open_args.comment_content_cache_size = my->comment_content_cache_size;
    db_open_args.do_validate_invariants = my->validate_invariants;
    db_open_args.stop_replay_at = my->stop_replay_at;
    db_open_args.benchmark_is_enabled = my->benchmark_is_enabled;
@@ -525,7 +623,9 @@ void chain_plugin::plugin_startup()
       {
          ilog("Opening shared memory from ${path}", ("path",my->shared_memory_dir.generic_string()));
 
+         db_open_args.compact_shared_file = my->compact_shared_file;
          my->db.open( db_open_args );
+         db_open_args.compact_shared_file = false;
 
          if( dump_memory_details )
             dumper.dump( true, get_indexes_memory_details );
@@ -546,6 +646,13 @@ void chain_plugin::plugin_startup()
       }
    }
 
+   if( my->compact_shared_file && my->exit_after_compaction )
+   {
+      ilog( "Compacted shared memory on user request, exiting." );
+      appbase::app().quit();
+      return;
+   }
+
    ilog( "Started on blockchain with ${n} blocks", ("n", my->db.head_block_num()) );
    on_sync();
 
@@ -556,6 +663,7 @@ void chain_plugin::plugin_shutdown()
 {
    ilog("closing chain database");
    my->stop_write_processing();
+   zattera::chain::util::disconnect_signal( my->post_apply_block_conn );
    my->db.close();
    ilog("database closed successfully");
 }
@@ -571,9 +679,12 @@ bool chain_plugin::accept_block( const zattera::chain::signed_block& block, bool
 
    check_time_in_block( block );
 
+   // Packing and hashing the block happens here, on the caller's thread, instead of under the write lock
+   const prepared_block prepared( block );
+
    boost::promise< void > prom;
    write_context cxt;
-   cxt.req_ptr = &block;
+   cxt.req_ptr = &prepared;
    cxt.skip = skip;
    cxt.prom_ptr = &prom;
 
@@ -635,6 +746,59 @@ int16_t chain_plugin::set_write_lock_hold_time( int16_t new_time )
    return old_time;
 }
 
+void chain_plugin::register_memory_usage_provider( const std::string& plugin, memory_usage_provider provider )
+{
+   std::lock_guard< std::mutex > guard( my->memory_usage_providers_mutex );
+   my->memory_usage_providers.emplace_back( plugin, std::move( provider ) );
+}
+
+void chain_plugin::unregister_memory_usage_provider( const std::string& plugin )
+{
+   std::lock_guard< std::mutex > guard( my->memory_usage_providers_mutex );
+   auto& providers = my->memory_usage_providers;
+   providers.erase( std::remove_if( providers.begin(), providers.end(),
+      [&]( const std::pair< std::string, memory_usage_provider >& p ) { return p.first == plugin; } ),
+      providers.end() );
+}
+
+memory_usage chain_plugin::get_memory_usage( bool include_dynamic )const
+{
+   memory_usage result;
+
+   for( const auto* idx : my->db.get_abstract_index_cntr() )
+   {
+      auto info = idx->get_statistics( !include_dynamic );
+
+      index_memory_usage usage;
+      usage.type = std::move( info._value_type_name );
+      usage.item_count = info._item_count;
+      usage.item_size = info._item_sizeof;
+      usage.payload = info._item_count * info._item_sizeof + info._item_additional_allocation;
+      usage.node_overhead = info._additional_container_allocation;
+      usage.undo_stack = info._undo_stack_allocation;
+
+      result.shared_memory.accounted += usage.payload + usage.node_overhead + usage.undo_stack;
+      result.indexes.push_back( std::move( usage ) );
+   }
+
+   result.shared_memory.size = my->db.get_max_memory();
+   result.shared_memory.free = my->db.get_free_memory();
+   result.shared_memory.used = result.shared_memory.size - result.shared_memory.free;
+   if( result.shared_memory.used > result.shared_memory.accounted )
+      result.shared_memory.unaccounted = result.shared_memory.used - result.shared_memory.accounted;
+
+   std::lock_guard< std::mutex > guard( my->memory_usage_providers_mutex );
+   for( const auto& provider : my->memory_usage_providers )
+   {
+      plugin_memory_usage usage;
+      usage.plugin = provider.first;
+      usage.usage = provider.second();
+      result.plugins.push_back( std::move( usage ) );
+   }
+
+   return result;
+}
+
 bool chain_plugin::block_is_on_preferred_chain(const zattera::chain::block_id_type& block_id )
 {
    // If it's not known, it's not preferred.
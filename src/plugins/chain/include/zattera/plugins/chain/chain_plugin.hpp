@@ -4,6 +4,8 @@
 
 #include <boost/signals2.hpp>
 
+#include <functional>
+
 #define ZATTERA_CHAIN_PLUGIN_NAME "chain"
 
 namespace zattera { namespace plugins { namespace chain {
@@ -16,6 +18,46 @@ using namespace zattera::chain;
 
 namespace bfs = boost::filesystem;
 
+/// Memory used by one chainbase index, in bytes unless noted otherwise
+struct index_memory_usage
+{
+   std::string type;
+   uint64_t    item_count = 0;
+   uint64_t    item_size = 0;             ///< sizeof the stored object
+   uint64_t    payload = 0;               ///< objects plus their dynamic allocations (only with include_dynamic)
+   uint64_t    node_overhead = 0;         ///< container nodes beyond the stored objects
+   uint64_t    undo_stack = 0;
+};
+
+/// Usage of the shared memory segment, in bytes
+struct shared_memory_usage
+{
+   uint64_t    size = 0;
+   uint64_t    free = 0;
+   uint64_t    used = 0;
+   uint64_t    accounted = 0;             ///< payload, node overhead and undo stacks of all indexes
+   /**
+    * Used memory not accounted to any index: allocator headers, dynamic allocations of objects
+    * when include_dynamic is off, and free chunks too small to be reused. A large value that
+    * keeps growing points at fragmentation, see compact-shared-file.
+    */
+   uint64_t    unaccounted = 0;
+};
+
+/// Memory reported by a plugin keeping state outside of the shared memory segment
+struct plugin_memory_usage
+{
+   std::string                         plugin;
+   fc::flat_map< std::string, uint64_t > usage;
+};
+
+struct memory_usage
+{
+   shared_memory_usage                 shared_memory;
+   std::vector< index_memory_usage >   indexes;
+   std::vector< plugin_memory_usage >  plugins;
+};
+
 class chain_plugin : public plugin< chain_plugin >
 {
 public:
@@ -57,6 +99,31 @@ public:
 
    bool block_is_on_preferred_chain( const zattera::chain::block_id_type& block_id );
 
+   typedef std::function< fc::flat_map< std::string, uint64_t >() > memory_usage_provider;
+
+   /**
+    * Registers a callback reporting the memory a plugin holds outside of the shared memory
+    * segment, like RocksDB memtables and caches. It is called from API threads under the
+    * database read lock and from the write thread under the write lock, so it must never take
+    * a chain lock itself. It is called until unregister_memory_usage_provider is called for the
+    * plugin, which a plugin shutting down must do before releasing its storage.
+    */
+   void register_memory_usage_provider( const std::string& plugin, memory_usage_provider provider );
+
+   /**
+    * Removes the providers registered by a plugin. Waits for a call of them in progress to
+    * return, so the plugin may release what they report on once this returns.
+    */
+   void unregister_memory_usage_provider( const std::string& plugin );
+
+   /**
+    * Gathers the memory usage of the shared memory segment, of every index and of the plugins
+    * that registered a provider. The caller must hold at least a read lock on the database.
+    * Counting dynamic allocations held by objects (include_dynamic) walks whole indexes and
+    * is expensive on large ones.
+    */
+   memory_usage get_memory_usage( bool include_dynamic = false ) const;
+
    void check_time_in_block( const zattera::chain::signed_block& block );
 
    template< typename MultiIndexType >
@@ -108,3 +175,8 @@ private:
 };
 
 } } } // zattera::plugins::chain
+
+FC_REFLECT( zattera::plugins::chain::index_memory_usage, (type)(item_count)(item_size)(payload)(node_overhead)(undo_stack) )
+FC_REFLECT( zattera::plugins::chain::shared_memory_usage, (size)(free)(used)(accounted)(unaccounted) )
+FC_REFLECT( zattera::plugins::chain::plugin_memory_usage, (plugin)(usage) )
+FC_REFLECT( zattera::plugins::chain::memory_usage, (shared_memory)(indexes)(plugins) )
@@ -4,6 +4,7 @@
 
 #include <fc/variant.hpp>
 #include <fc/io/json.hpp>
+#include <fc/io/json_decoder.hpp>
 #include <fc/reflect/variant.hpp>
 #include <fc/exception/exception.hpp>
 
@@ -65,6 +66,14 @@ using namespace appbase;
  */
 typedef std::function< fc::variant(const fc::variant&) > api_method;
 
+/**
+ * @brief Internal type used to bind api methods
+ * that decode their args directly from the request JSON.
+ *
+ * Arguments: The "params" member of the request
+ */
+typedef std::function< fc::variant(const fc::json_value&) > api_json_method;
+
 /**
  * @brief An API, containing APIs and Methods
  *
@@ -101,6 +110,7 @@ class json_rpc_plugin : public appbase::plugin< json_rpc_plugin >
       virtual void plugin_shutdown() override;
 
       void add_api_method( const string& api_name, const string& method_name, const api_method& api, const api_method_signature& sig );
+      void add_api_method( const string& api_name, const string& method_name, const api_method& api, const api_json_method& json_api, const api_method_signature& sig );
       string call( const string& body );
 
    private:
@@ -130,6 +140,13 @@ namespace detail {
                {
                   return fc::variant( (plugin.*method)( args.as< Args >(), true ) );
                },
+               [&plugin,method]( const fc::json_value& args ) -> fc::variant
+               {
+                  Args decoded;
+                  // Args marked with FC_JSON_DECODE_REFLECTED are decoded member by member, anything else through from_variant
+                  fc::from_json( args, decoded );
+                  return fc::variant( (plugin.*method)( decoded, true ) );
+               },
                api_method_signature{ fc::variant( Args() ), fc::variant( Ret() ) } );
          }
 
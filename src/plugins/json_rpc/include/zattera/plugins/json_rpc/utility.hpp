@@ -2,6 +2,7 @@
 
 #include <type_traits>
 
+#include <fc/io/json_decoder.hpp>
 #include <fc/reflect/reflect.hpp>
 #include <fc/macros.hpp>
 
@@ -91,3 +92,4 @@ struct void_type {};
 } } } // zattera::plugins::json_rpc
 
 FC_REFLECT( zattera::plugins::json_rpc::void_type, )
+FC_JSON_DECODE_REFLECTED( zattera::plugins::json_rpc::void_type )
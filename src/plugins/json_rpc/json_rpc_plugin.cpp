@@ -131,13 +131,16 @@ namespace detail
          json_rpc_plugin_impl();
          ~json_rpc_plugin_impl();
 
-         void add_api_method( const string& api_name, const string& method_name, const api_method& api, const api_method_signature& sig );
+         void add_api_method( const string& api_name, const string& method_name, const api_method& api, const api_json_method& json_api, const api_method_signature& sig );
 
          api_method* find_api_method( std::string api, std::string method );
+         api_json_method* find_api_json_method( string method );
          api_method* process_params( string method, const fc::variant_object& request, fc::variant& func_args );
          void rpc_id( const fc::variant_object& request, json_rpc_response& response );
-         void rpc_jsonrpc( const fc::variant_object& request, json_rpc_response& response );
+         void rpc_jsonrpc( const fc::variant_object& request, const fc::json_value* params, json_rpc_response& response );
          json_rpc_response rpc( const fc::variant& message );
+         json_rpc_response rpc( const fc::json_value& message );
+         json_rpc_response rpc( const fc::variant* message, const fc::json_value* json_message );
 
          void initialize();
 
@@ -152,6 +155,7 @@ namespace detail
             (get_signature) )
 
          map< string, api_description >                     _registered_apis;
+         map< string, map< string, api_json_method > >      _registered_json_apis;
          vector< string >                                   _methods;
          map< string, map< string, api_method_signature > > _method_sigs;
          std::unique_ptr< json_rpc_logger >                 _logger;
@@ -160,9 +164,11 @@ namespace detail
    json_rpc_plugin_impl::json_rpc_plugin_impl() {}
    json_rpc_plugin_impl::~json_rpc_plugin_impl() {}
 
-   void json_rpc_plugin_impl::add_api_method( const string& api_name, const string& method_name, const api_method& api, const api_method_signature& sig )
+   void json_rpc_plugin_impl::add_api_method( const string& api_name, const string& method_name, const api_method& api, const api_json_method& json_api, const api_method_signature& sig )
    {
       _registered_apis[ api_name ][ method_name ] = api;
+      if( json_api )
+         _registered_json_apis[ api_name ][ method_name ] = json_api;
       _method_sigs[ api_name ][ method_name ] = sig;
 
       std::stringstream canonical_name;
@@ -208,6 +214,27 @@ namespace detail
       return &(method_itr->second);
    }
 
+   api_json_method* json_rpc_plugin_impl::find_api_json_method( string method )
+   {
+      vector< std::string > v;
+      boost::split( v, method, boost::is_any_of( "." ) );
+
+      FC_ASSERT( v.size() == 2, "method specification invalid. Should be api.method" );
+
+      // Report unknown methods the same way as the variant path
+      find_api_method( v[0], v[1] );
+
+      auto api_itr = _registered_json_apis.find( v[0] );
+      if( api_itr == _registered_json_apis.end() )
+         return nullptr;
+
+      auto method_itr = api_itr->second.find( v[1] );
+      if( method_itr == api_itr->second.end() )
+         return nullptr;
+
+      return &(method_itr->second);
+   }
+
    api_method* json_rpc_plugin_impl::process_params( string method, const fc::variant_object& request, fc::variant& func_args )
    {
       api_method* ret = nullptr;
@@ -262,8 +289,19 @@ namespace detail
       }
    }
 
-   void json_rpc_plugin_impl::rpc_jsonrpc( const fc::variant_object& request, json_rpc_response& response )
+   void json_rpc_plugin_impl::rpc_jsonrpc( const fc::variant_object& request, const fc::json_value* params, json_rpc_response& response )
    {
+      // The variant path needs the params in the request object
+      auto full_request = [&]() -> fc::variant_object
+      {
+         if( params == nullptr )
+            return request;
+
+         fc::mutable_variant_object r( request );
+         r( "params", params->to_variant() );
+         return r;
+      };
+
       if( request.contains( "jsonrpc" ) && request[ "jsonrpc" ].is_string() && request[ "jsonrpc" ].as_string() == "2.0" )
       {
          if( request.contains( "method" ) && request[ "method" ].is_string() )
@@ -273,14 +311,19 @@ namespace detail
                string method = request[ "method" ].as_string();
 
                // This is to maintain backwards compatibility with existing call structure.
-               if( ( method == "call" && request.contains( "params" ) ) || method != "call" )
+               if( ( method == "call" && ( request.contains( "params" ) || params != nullptr ) ) || method != "call" )
                {
                   fc::variant func_args;
                   api_method* call = nullptr;
+                  api_json_method* json_call = nullptr;
 
                   try
                   {
-                     call = process_params( method, request, func_args );
+                     if( params != nullptr && method != "call" )
+                        json_call = find_api_json_method( method );
+
+                     if( json_call == nullptr )
+                        call = process_params( method, full_request(), func_args );
                   }
                   catch( fc::assert_exception& e )
                   {
@@ -289,7 +332,9 @@ namespace detail
 
                   try
                   {
-                     if( call )
+                     if( json_call )
+                        response.result = (*json_call)( *params );
+                     else if( call )
                         response.result = (*call)( func_args );
                   }
                   catch( chainbase::lock_exception& e )
@@ -321,18 +366,52 @@ namespace detail
          response.error = json_rpc_error( JSON_RPC_INVALID_REQUEST, "jsonrpc value is not \"2.0\"" );
       }
 
-   log(request, response);
+   if( _logger )
+      log(full_request(), response);
    }
 
    json_rpc_response json_rpc_plugin_impl::rpc( const fc::variant& message )
    {
-      json_rpc_response response;
-
       ddump( (message) );
 
+      return rpc( &message, nullptr );
+   }
+
+   json_rpc_response json_rpc_plugin_impl::rpc( const fc::json_value& message )
+   {
+      return rpc( nullptr, &message );
+   }
+
+   json_rpc_response json_rpc_plugin_impl::rpc( const fc::variant* message, const fc::json_value* json_message )
+   {
+      json_rpc_response response;
+
       try
       {
-         const auto& request = message.get_object();
+         fc::variant_object request;
+         fc::optional< fc::json_value > params;
+
+         if( json_message == nullptr )
+         {
+            request = message->get_object();
+         }
+         else if( json_message->is_object() )
+         {
+            // Everything but the params is small, the params are decoded by the method itself
+            fc::mutable_variant_object r;
+            json_message->for_each_member( [&]( const std::string& key, const fc::json_value& value )
+            {
+               if( key == "params" )
+                  params = value;
+               else
+                  r( key, value.to_variant() );
+            });
+            request = std::move( r );
+         }
+         else
+         {
+            request = json_message->to_variant().get_object();
+         }
 
          rpc_id( request, response );
 
@@ -340,7 +419,7 @@ namespace detail
          try
          {
             if( !response.error.valid() )
-               rpc_jsonrpc( request, response );
+               rpc_jsonrpc( request, params.valid() ? &(*params) : nullptr, response );
          }
          catch( fc::exception& e )
          {
@@ -420,13 +499,51 @@ void json_rpc_plugin::plugin_shutdown() {}
 
 void json_rpc_plugin::add_api_method( const string& api_name, const string& method_name, const api_method& api, const api_method_signature& sig )
 {
-   my->add_api_method( api_name, method_name, api, sig );
+   my->add_api_method( api_name, method_name, api, api_json_method(), sig );
+}
+
+void json_rpc_plugin::add_api_method( const string& api_name, const string& method_name, const api_method& api, const api_json_method& json_api, const api_method_signature& sig )
+{
+   my->add_api_method( api_name, method_name, api, json_api, sig );
 }
 
 string json_rpc_plugin::call( const string& message )
 {
    try
    {
+      std::unique_ptr< fc::json_document > doc;
+
+      try
+      {
+         doc.reset( new fc::json_document( message ) );
+      }
+      catch( const fc::parse_error_exception& )
+      {
+         // Not strict JSON, leave it to the legacy parser
+      }
+
+      if( doc )
+      {
+         fc::json_value root = doc->root();
+
+         if( !root.is_array() )
+            return fc::json::to_string( my->rpc( root ) );
+
+         vector< json_rpc_response > responses;
+         responses.reserve( root.size() );
+         root.for_each_element( [&]( const fc::json_value& m )
+         {
+            responses.push_back( my->rpc( m ) );
+         });
+
+         if( responses.size() )
+            return fc::json::to_string( responses );
+
+         json_rpc_response response;
+         response.error = json_rpc_error( JSON_RPC_SERVER_ERROR, "Array is invalid" );
+         return fc::json::to_string( response );
+      }
+
       fc::variant v = fc::json::from_string( message );
 
       if( v.is_array() )
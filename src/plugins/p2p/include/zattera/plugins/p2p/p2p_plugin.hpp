@@ -4,6 +4,8 @@
 
 #include <appbase/application.hpp>
 
+#include <fc/thread/task_profile.hpp>
+
 #define ZATTERA_P2P_PLUGIN_NAME "p2p"
 
 namespace zattera { namespace plugins { namespace p2p {
@@ -31,6 +33,12 @@ public:
    void broadcast_transaction( const zattera::protocol::signed_transaction& tx );
    void set_block_production( bool producing_blocks );
 
+   /**
+    * Scheduler statistics of the P2P thread, collected since startup or since the last periodic
+    * log, which resets them. Throws unless profiling was enabled in the configuration.
+    */
+   fc::thread_profile get_task_profile();
+
 private:
    std::unique_ptr< detail::p2p_plugin_impl > my;
 };
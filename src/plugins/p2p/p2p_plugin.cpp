@@ -9,6 +9,7 @@
 #include <fc/network/ip.hpp>
 #include <fc/network/resolve.hpp>
 #include <fc/thread/thread.hpp>
+#include <fc/thread/task_profile.hpp>
 #include <fc/io/json.hpp>
 
 #include <boost/range/algorithm/reverse.hpp>
@@ -87,6 +88,8 @@ public:
    bool is_included_block(const block_id_type& block_id);
    virtual zattera::protocol::chain_id_type get_chain_id() const override;
 
+   void log_task_profile();
+
    // node_delegate interface
    virtual bool has_item( const graphene::net::item_id& ) override;
    virtual bool handle_block( const graphene::net::block_message&, bool, std::vector<fc::uint160_t>& ) override;
@@ -109,6 +112,10 @@ public:
    string user_agent;
    fc::mutable_variant_object config;
    uint32_t max_connections = 0;
+   bool task_profile = false;
+   fc::microseconds task_profile_interval;
+   fc::microseconds task_profile_long_slice;
+   fc::future<void> task_profile_log_done;
    bool force_validate = false;
    bool block_producer = false;
    std::atomic_bool   running;
@@ -326,13 +333,28 @@ graphene::net::message p2p_plugin_impl::get_item( const graphene::net::item_id&
    {
       return chain.db().with_read_lock( [&]()
       {
+         // Reversible blocks are served from the bytes packed when they were received, the
+         // message is the packed block_message, which is the block followed by its id
+         auto prepared = chain.db().fetch_prepared_block_by_id(id.item_hash);
+         if( prepared )
+         {
+            graphene::net::message msg;
+            msg.msg_type = block_message::type;
+            msg.data.reserve( prepared->pack_size() + sizeof( block_id_type ) );
+            msg.data.assign( prepared->packed().begin(), prepared->packed().end() );
+            auto id_bytes = fc::raw::pack_to_vector( prepared->id() );
+            msg.data.insert( msg.data.end(), id_bytes.begin(), id_bytes.end() );
+            msg.size = (uint32_t)msg.data.size();
+            return msg;
+         }
+
          auto opt_block = chain.db().fetch_block_by_id(id.item_hash);
          if( !opt_block )
             elog("Couldn't find block ${id} -- corresponding ID in our chain is ${id2}",
                ("id", id.item_hash)("id2", chain.db().get_block_id_for_num(block_header::num_from_id(id.item_hash))));
          FC_ASSERT( opt_block.valid() );
          // ilog("Serving up block #${num}", ("num", opt_block->block_num()));
-         return block_message(std::move(*opt_block));
+         return graphene::net::message( block_message(std::move(*opt_block)) );
       });
    }
    return chain.db().with_read_lock( [&]()
@@ -534,6 +556,41 @@ bool p2p_plugin_impl::is_included_block(const block_id_type& block_id)
 
 ////////////////////////////// End node_delegate Implementation //////////////////////////////
 
+void p2p_plugin_impl::log_task_profile()
+{
+   fc::thread_profile profile = p2p_thread.get_profile( true );
+   fc::microseconds elapsed = fc::time_point::now() - profile.since;
+
+   ilog( "P2P thread task profile over the last ${s}s: ${n} context switches",
+      ("s", elapsed.count() / 1000000)("n", profile.context_switches) );
+
+   const size_t max_logged_tasks = 10;
+   for( size_t i = 0; i < profile.tasks.size() && i < max_logged_tasks; ++i )
+   {
+      const fc::task_profile& t = profile.tasks[i];
+      ilog( "  ${d}: run ${run}ms, ready ${ready}ms, ${runs} runs, ${slices} slices, longest ${longest}ms",
+         ("d", t.description)
+         ("run", t.run_time.count() / 1000)
+         ("ready", t.ready_time.count() / 1000)
+         ("runs", t.runs)
+         ("slices", t.slices)
+         ("longest", t.longest_slice.count() / 1000) );
+   }
+
+   for( const fc::task_profile& t : profile.tasks )
+   {
+      if( t.long_slices )
+         wlog( "P2P task ${d} ran ${n} times for more than ${t}ms without yielding, longest ${longest}ms",
+            ("d", t.description)
+            ("n", t.long_slices)
+            ("t", profile.long_slice_threshold.count() / 1000)
+            ("longest", t.longest_slice.count() / 1000) );
+   }
+
+   task_profile_log_done = fc::schedule( [this](){ log_task_profile(); },
+      fc::time_point::now() + task_profile_interval, "p2p task profile log" );
+}
+
 } // detail
 
 p2p_plugin::p2p_plugin()
@@ -556,6 +613,9 @@ void p2p_plugin::set_program_options( bpo::options_description& cli, bpo::option
       ("seed-node", bpo::value<vector<string>>()->composing(), "The IP address and port of a remote peer to sync with. Deprecated in favor of p2p-seed-node.")
       ("p2p-seed-node", bpo::value<vector<string>>()->composing()->default_value( default_seeds, seed_ss.str() ), "The IP address and port of a remote peer to sync with.")
       ("p2p-parameters", bpo::value<string>(), ("P2P network parameters. (Default: " + fc::json::to_string(graphene::net::node_configuration()) + " )").c_str() )
+      ("p2p-task-profile", bpo::value<bool>()->default_value(false), "Profile the tasks of the P2P thread, the statistics are read through network_broadcast_api.get_p2p_task_profile.")
+      ("p2p-task-profile-interval", bpo::value<uint32_t>()->default_value(0), "Profile the tasks of the P2P thread and log the busiest ones every N seconds, resetting the statistics. 0 disables the log.")
+      ("p2p-task-profile-long-slice", bpo::value<uint32_t>()->default_value(50), "P2P tasks running longer than this many milliseconds without yielding are reported as long running.")
       ;
    cli.add_options()
       ("force-validate", bpo::bool_switch()->default_value(false), "Force validation of all transactions. Deprecated in favor of p2p-force-validate" )
@@ -629,6 +689,10 @@ void p2p_plugin::plugin_initialize(const boost::program_options::variables_map&
       fc::variant var = fc::json::from_string( options.at("p2p-parameters").as<string>(), fc::json::strict_parser );
       my->config = var.get_object();
    }
+
+   my->task_profile = options.at( "p2p-task-profile" ).as< bool >();
+   my->task_profile_interval = fc::seconds( options.at( "p2p-task-profile-interval" ).as< uint32_t >() );
+   my->task_profile_long_slice = fc::milliseconds( options.at( "p2p-task-profile-long-slice" ).as< uint32_t >() );
 }
 
 void p2p_plugin::plugin_startup()
@@ -670,6 +734,15 @@ void p2p_plugin::plugin_startup()
       });
       my->node->sync_from(graphene::net::item_id(graphene::net::block_message_type, block_id), std::vector<uint32_t>());
       ilog("P2P node listening at ${ep}", ("ep", my->node->get_actual_listening_endpoint()));
+
+      if( my->task_profile || my->task_profile_interval.count() )
+         my->p2p_thread.set_profiling( true, my->task_profile_long_slice );
+
+      if( my->task_profile_interval.count() )
+      {
+         my->task_profile_log_done = fc::schedule( [this](){ my->log_task_profile(); },
+            fc::time_point::now() + my->task_profile_interval, "p2p task profile log" );
+      }
    }).wait();
    ilog( "P2P Plugin started" );
 }
@@ -732,6 +805,13 @@ void p2p_plugin::plugin_shutdown() {
    while(bfState != std::future_status::ready && tfState != std::future_status::ready);
 
    ilog("P2P Plugin: checking handle_block and handle_transaction activity");
+   if( my->task_profile_log_done.valid() )
+   {
+      my->p2p_thread.async( [this]
+      {
+         my->task_profile_log_done.cancel_and_wait( "P2P plugin shutdown" );
+      }).wait();
+   }
    my->node->close();
    fc::promise<void>::ptr quitDone(new fc::promise<void>("P2P thread quit"));
    my->p2p_thread.quit(quitDone.get());
@@ -758,4 +838,10 @@ void p2p_plugin::set_block_production( bool producing_blocks )
    my->block_producer = producing_blocks;
 }
 
+fc::thread_profile p2p_plugin::get_task_profile()
+{
+   FC_ASSERT( my->p2p_thread.is_profiling(), "P2P task profiling is disabled, see p2p-task-profile" );
+   return my->p2p_thread.get_profile();
+}
+
 } } } // namespace zattera::plugins::p2p
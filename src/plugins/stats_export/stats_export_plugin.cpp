@@ -10,6 +10,8 @@
 #include <zattera/chain/index.hpp>
 #include <zattera/chain/operation_notification.hpp>
 
+#include <zattera/schema/schema.hpp>
+
 #include <fstream>
 #include <iostream>
 #include <sstream>
@@ -49,6 +51,9 @@ class api_stats_export_data_object
          fc::to_variant( *this, v );
       }
 
+      virtual void to_binary( std::vector< char >& out )const override;
+      virtual std::shared_ptr< zattera::schema::abstract_schema > get_schema()const override;
+
       dynamic_global_property_object                        global_properties;
       std::vector< api_stats_transaction_data_object >      transaction_stats;
       uint64_t                                              free_memory = 0;
@@ -61,6 +66,16 @@ FC_REFLECT( zattera::plugins::stats_export::detail::api_stats_export_data_object
 
 namespace zattera { namespace plugins { namespace stats_export { namespace detail {
 
+void api_stats_export_data_object::to_binary( std::vector< char >& out )const
+{
+   out = fc::raw::pack_to_vector( *this );
+}
+
+std::shared_ptr< zattera::schema::abstract_schema > api_stats_export_data_object::get_schema()const
+{
+   return zattera::schema::get_schema_for_type< api_stats_export_data_object >();
+}
+
 class stats_export_plugin_impl
 {
    public:
@@ -104,13 +119,14 @@ void stats_export_plugin_impl::on_post_apply_block( const block_notification& no
       return;
 
    stats->global_properties = _db.get_dynamic_global_properties();
-   for( const signed_transaction& tx : note.block.transactions )
+   const auto& transactions = note.block.transactions;
+   for( size_t i = 0; i < transactions.size(); ++i )
    {
       stats->transaction_stats.emplace_back();
 
       api_stats_transaction_data_object& tx_stats = stats->transaction_stats.back();
-      tx_stats.user = get_transaction_user( tx );
-      tx_stats.size = fc::raw::pack_size( tx );
+      tx_stats.user = get_transaction_user( transactions[i] );
+      tx_stats.size = note.prepared.transactions()[i].pack_size;
    }
 
    stats->free_memory = _db.get_free_memory();
@@ -70,7 +70,7 @@ class tags_plugin_impl
       void add_stats( const tag_object& tag, const tag_stats_object& stats )const;
       void remove_tag( const tag_object& tag )const;
       const tag_stats_object& get_stats( const string& tag )const;
-      comment_metadata filter_tags( const comment_object& c, const comment_content_object& con )const;
+      comment_metadata filter_tags( const comment_object& c, const comment_content& con )const;
       void update_tag( const tag_object& current, const comment_object& comment, double hot, double trending )const;
       void create_tag( const string& tag, const comment_object& comment, double hot, double trending )const;
       void update_tags( const comment_object& c, bool parse_tags = false )const;
@@ -144,7 +144,7 @@ const tag_stats_object& tags_plugin_impl::get_stats( const string& tag )const
    });
 }
 
-comment_metadata tags_plugin_impl::filter_tags( const comment_object& c, const comment_content_object& con ) const
+comment_metadata tags_plugin_impl::filter_tags( const comment_object& c, const comment_content& con ) const
 {
    comment_metadata meta;
 
@@ -152,7 +152,7 @@ comment_metadata tags_plugin_impl::filter_tags( const comment_object& c, const c
    {
       try
       {
-         meta = fc::json::from_string( to_string( con.json_metadata ) ).as< comment_metadata >();
+         meta = fc::json::from_string( con.json_metadata ).as< comment_metadata >();
       }
       catch( const fc::exception& e )
       {
@@ -270,7 +270,7 @@ void tags_plugin_impl::update_tags( const comment_object& c, bool parse_tags )co
 #ifndef IS_LOW_MEM
    if( parse_tags )
    {
-      auto meta = filter_tags( c, _db.get< comment_content_object, chain::by_comment >( c.id ) );
+      auto meta = filter_tags( c, _db.get_comment_content( c.id ) );
       auto citr = comment_idx.lower_bound( c.id );
 
       map< string, const tag_object* > existing_tags;
@@ -429,7 +429,7 @@ struct operation_visitor
          _my.update_tags( c );
 
 #ifndef IS_LOW_MEM
-         comment_metadata meta = _my.filter_tags( c, _my._db.get< comment_content_object, chain::by_comment >( c.id ) );
+         comment_metadata meta = _my.filter_tags( c, _my._db.get_comment_content( c.id ) );
 
          for( const string& tag : meta.tags )
          {
@@ -43,6 +43,9 @@ class exp_witness_data_object
          fc::to_variant( *this, v );
       }
 
+      virtual void to_binary( std::vector< char >& out )const override;
+      virtual std::shared_ptr< zattera::schema::abstract_schema > get_schema()const override;
+
       std::vector< exp_bandwidth_update_object >            bandwidth_updates;
       exp_reserve_ratio_object                              reserve_ratio;
 };
@@ -12,6 +12,8 @@
 #include <zattera/chain/index.hpp>
 #include <zattera/chain/utils/impacted.hpp>
 
+#include <zattera/schema/schema.hpp>
+
 #include <zattera/utils/key_conversion.hpp>
 #include <zattera/utils/plugin_utilities.hpp>
 
@@ -71,6 +73,16 @@ exp_bandwidth_update_object::exp_bandwidth_update_object( const account_bandwidt
 exp_witness_data_object::exp_witness_data_object() {}
 exp_witness_data_object::~exp_witness_data_object() {}
 
+void exp_witness_data_object::to_binary( std::vector< char >& out )const
+{
+   out = fc::raw::pack_to_vector( *this );
+}
+
+std::shared_ptr< zattera::schema::abstract_schema > exp_witness_data_object::get_schema()const
+{
+   return zattera::schema::get_schema_for_type< exp_witness_data_object >();
+}
+
 namespace detail {
 
    class witness_plugin_impl {
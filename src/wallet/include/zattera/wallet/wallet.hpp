@@ -54,6 +54,21 @@ struct brain_key_info
    string               wif_priv_key;
 };
 
+/**
+ * Summary of a bulk signing or broadcasting run. Transactions are listed in the order of the
+ * input; a transaction that failed to sign or broadcast is reported in errors and the run
+ * continues with the next one.
+ */
+struct bulk_transaction_result
+{
+   uint32_t                         operations = 0;
+   uint32_t                         transactions = 0;
+   uint32_t                         signed_transactions = 0;
+   uint32_t                         broadcast_transactions = 0;
+   vector< transaction_id_type >    transaction_ids;
+   vector< string >                 errors;
+};
+
 struct wallet_data
 {
    vector<char>              cipher_keys; /** encrypted keys */
@@ -858,6 +873,35 @@ class wallet_api
          signed_transaction tx,
          bool broadcast = false);
 
+      /** Packs, signs and optionally broadcasts a file of operations.
+       *
+       * The file holds one operation per line in the JSON form returned by
+       * \c get_prototype_operation(). Consecutive operations are packed into transactions of
+       * at most \c operations_per_transaction operations (0 packs as many as fit the maximum
+       * transaction size). Transactions are handled in batches: each batch fetches the
+       * reference block and the signing accounts once, signs on all cores with the wallet's
+       * keys and keeps several broadcasts in flight at a time.
+       *
+       * @param filename the file of operations to sign
+       * @param operations_per_transaction maximum number of operations per transaction, 0 for no limit
+       * @param output_filename if not empty, the signed transactions are written there, one per line,
+       *                        to be broadcast later with \c bulk_broadcast_transactions()
+       * @param broadcast true if you wish to broadcast the transactions
+       */
+      bulk_transaction_result bulk_sign_operations(
+         string filename,
+         uint32_t operations_per_transaction,
+         string output_filename,
+         bool broadcast );
+
+      /** Broadcasts a file of signed transactions, one per line, as written by \c bulk_sign_operations().
+       *
+       * Several broadcasts are kept in flight at a time. The transactions must not have expired yet.
+       *
+       * @param filename the file of signed transactions
+       */
+      bulk_transaction_result bulk_broadcast_transactions( string filename );
+
       /** Returns an uninitialized object representing a given blockchain operation.
        *
        * This returns a default-initialized object of the given type; it can be used
@@ -1079,6 +1123,15 @@ FC_REFLECT( zattera::wallet::brain_key_info, (brain_priv_key)(wif_priv_key) (pub
 
 FC_REFLECT( zattera::wallet::plain_keys, (checksum)(keys) )
 
+FC_REFLECT( zattera::wallet::bulk_transaction_result,
+            (operations)
+            (transactions)
+            (signed_transactions)
+            (broadcast_transactions)
+            (transaction_ids)
+            (errors)
+          )
+
 FC_REFLECT_ENUM( zattera::wallet::authority_type, (owner)(active)(posting) )
 
 FC_API( zattera::wallet::wallet_api,
@@ -1158,6 +1211,8 @@ FC_API( zattera::wallet::wallet_api,
         (get_prototype_operation)
         (serialize_transaction)
         (sign_transaction)
+        (bulk_sign_operations)
+        (bulk_broadcast_transactions)
 
         (get_active_witnesses)
         (get_transaction)
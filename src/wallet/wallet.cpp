@@ -9,14 +9,20 @@
 
 #include <zattera/plugins/follow/follow_operations.hpp>
 
+#include <zattera/chain/utils/worker_pool.hpp>
+
 #include <algorithm>
 #include <cctype>
+#include <deque>
+#include <fstream>
 #include <iomanip>
 #include <iostream>
 #include <iterator>
+#include <set>
 #include <sstream>
 #include <string>
 #include <list>
+#include <thread>
 
 #include <boost/version.hpp>
 #include <boost/lexical_cast.hpp>
@@ -58,6 +64,12 @@
 
 #define BRAIN_KEY_WORD_COUNT 16
 
+// Bulk signing: transactions sharing one reference block, broadcast calls kept outstanding
+// and bytes left free in each packed transaction for its signatures
+#define BULK_BATCH_TRANSACTIONS 1000
+#define BULK_BROADCASTS_IN_FLIGHT 32
+#define BULK_SIGNATURE_RESERVE 2048
+
 namespace zattera { namespace wallet {
 
 namespace detail {
@@ -697,6 +709,298 @@ public:
       return tx;
    }
 
+   // Accounts and decoded private keys shared by every transaction of a bulk run. Filled on
+   // the wallet thread between batches and only read while the batch is signed in parallel.
+   struct bulk_signing_cache
+   {
+      flat_map< account_name_type, database_api::api_account_object >   accounts;
+      flat_map< public_key_type, fc::ecc::private_key >                 private_keys;
+      flat_set< public_key_type >                                       available_keys;
+   };
+
+   vector< signed_transaction > read_bulk_operations( const string& filename, uint32_t operations_per_transaction, bulk_transaction_result& result )
+   {
+      std::ifstream in( filename );
+      FC_ASSERT( in, "Unable to open ${f}", ("f", filename) );
+
+      // a transaction is the empty transaction plus its operations and a length prefix of at most 5 bytes
+      const size_t max_size = ZATTERA_MAX_TRANSACTION_SIZE - BULK_SIGNATURE_RESERVE - 5;
+      const size_t empty_size = fc::raw::pack_size( signed_transaction() );
+
+      vector< signed_transaction > transactions;
+      size_t tx_size = 0;
+      uint32_t line_num = 0;
+      string line;
+      while( std::getline( in, line ) )
+      {
+         ++line_num;
+         if( line.find_first_not_of( " \t\r" ) == string::npos )
+            continue;
+
+         operation op;
+         try
+         {
+            op = fc::json::from_string( line ).as< operation >();
+         }
+         FC_CAPTURE_AND_RETHROW( (filename)(line_num) )
+
+         size_t op_size = fc::raw::pack_size( op );
+         FC_ASSERT( empty_size + op_size <= max_size, "Operation on line ${l} is too large", ("l", line_num) );
+
+         if( transactions.empty()
+            || ( operations_per_transaction && transactions.back().operations.size() >= operations_per_transaction )
+            || tx_size + op_size > max_size )
+         {
+            transactions.emplace_back();
+            tx_size = empty_size;
+         }
+
+         transactions.back().operations.push_back( std::move( op ) );
+         tx_size += op_size;
+         ++result.operations;
+      }
+
+      return transactions;
+   }
+
+   void fetch_bulk_accounts( const flat_set< account_name_type >& names, bulk_signing_cache& cache )
+   {
+      vector< account_name_type > chunk;
+      for( auto itr = names.begin(); itr != names.end(); )
+      {
+         chunk.clear();
+         for( ; itr != names.end() && chunk.size() < DATABASE_API_SINGLE_QUERY_LIMIT; ++itr )
+            chunk.push_back( *itr );
+
+         for( auto& acct : _remote_api.get_accounts( chunk ) )
+            cache.accounts[ acct.name ] = std::move( acct );
+      }
+   }
+
+   // Fetches the accounts whose authorities transactions [begin, end) need and are not cached yet,
+   // plus the accounts named in their authorities, as far as sign_transaction looks
+   void fill_bulk_signing_cache( const vector< signed_transaction >& transactions, size_t begin, size_t end, bulk_signing_cache& cache )
+   {
+      flat_set< account_name_type > missing;
+      auto need = [&]( const account_name_type& name )
+      {
+         if( cache.accounts.find( name ) == cache.accounts.end() )
+            missing.insert( name );
+      };
+
+      for( size_t i = begin; i < end; ++i )
+      {
+         flat_set< account_name_type > req_active, req_owner, req_posting;
+         vector< authority > other_auths;
+         transactions[i].get_required_authorities( req_active, req_owner, req_posting, other_auths );
+
+         for( const auto& name : req_active )  need( name );
+         for( const auto& name : req_owner )   need( name );
+         for( const auto& name : req_posting ) need( name );
+         for( const auto& auth : other_auths )
+            for( const auto& a : auth.account_auths )
+               need( a.first );
+      }
+
+      flat_set< account_name_type > fetched = missing;
+      fetch_bulk_accounts( missing, cache );
+
+      missing.clear();
+      for( const auto& name : fetched )
+      {
+         auto itr = cache.accounts.find( name );
+         if( itr == cache.accounts.end() )
+            continue;
+         for( const authority* auth : { &itr->second.owner, &itr->second.active, &itr->second.posting } )
+            for( const auto& a : auth->account_auths )
+               need( a.first );
+      }
+      fetch_bulk_accounts( missing, cache );
+   }
+
+   // Only reads the cache, so transactions of a batch can be signed on any thread
+   void sign_with_bulk_cache( signed_transaction& tx, const bulk_signing_cache& cache )const
+   {
+      tx.validate();
+
+      auto get_account = [&]( const string& name ) -> const database_api::api_account_object&
+      {
+         auto itr = cache.accounts.find( name );
+         FC_ASSERT( itr != cache.accounts.end(), "Unknown account ${a}", ("a", name) );
+         return itr->second;
+      };
+
+      auto minimal_signing_keys = tx.minimize_required_signatures(
+         _chain_id,
+         cache.available_keys,
+         [&]( const string& account_name ) -> const authority&
+         { return get_account( account_name ).active; },
+         [&]( const string& account_name ) -> const authority&
+         { return get_account( account_name ).owner; },
+         [&]( const string& account_name ) -> const authority&
+         { return get_account( account_name ).posting; }
+         );
+
+      tx.signatures.clear();
+      for( const public_key_type& k : minimal_signing_keys )
+         tx.sign( cache.private_keys.at( k ), _chain_id );
+   }
+
+   // Broadcasts transactions[ indices ] keeping up to BULK_BROADCASTS_IN_FLIGHT calls outstanding
+   void broadcast_pipelined( const vector< signed_transaction >& transactions, const vector< size_t >& indices, bulk_transaction_result& result )
+   {
+      std::deque< std::pair< size_t, fc::future< void > > > in_flight;
+      auto finish_oldest = [&]()
+      {
+         auto& call = in_flight.front();
+         try
+         {
+            call.second.wait();
+            ++result.broadcast_transactions;
+         }
+         catch( const fc::exception& e )
+         {
+            result.errors.push_back( "broadcast of " + transactions[ call.first ].id().str() + " failed: " + e.to_string() );
+         }
+         in_flight.pop_front();
+      };
+
+      for( size_t i : indices )
+      {
+         if( in_flight.size() >= BULK_BROADCASTS_IN_FLIGHT )
+            finish_oldest();
+
+         const signed_transaction& tx = transactions[i];
+         in_flight.emplace_back( i, fc::async( [this, &tx]() { _remote_api.broadcast_transaction( tx ); }, "bulk broadcast" ) );
+      }
+
+      while( !in_flight.empty() )
+         finish_oldest();
+   }
+
+   bulk_transaction_result bulk_sign_operations( const string& filename, uint32_t operations_per_transaction, const string& output_filename, bool broadcast )
+   {
+      FC_ASSERT( !is_locked(), "The wallet must be unlocked to sign transactions" );
+
+      bulk_transaction_result result;
+      vector< signed_transaction > transactions = read_bulk_operations( filename, operations_per_transaction, result );
+      result.transactions = transactions.size();
+
+      std::ofstream out;
+      if( !output_filename.empty() )
+      {
+         out.open( output_filename );
+         FC_ASSERT( out, "Unable to open ${f}", ("f", output_filename) );
+      }
+
+      bulk_signing_cache cache;
+      for( const auto& key : _keys )
+      {
+         fc::optional< fc::ecc::private_key > privkey = wif_to_key( key.second );
+         FC_ASSERT( privkey.valid(), "Malformed private key in _keys" );
+         cache.private_keys[ key.first ] = *privkey;
+         cache.available_keys.insert( key.first );
+      }
+
+      zattera::chain::util::worker_pool pool( std::max( std::thread::hardware_concurrency(), 1u ) - 1 );
+      std::set< transaction_id_type > ids;
+
+      for( size_t begin = 0; begin < transactions.size(); begin += BULK_BATCH_TRANSACTIONS )
+      {
+         size_t end = std::min< size_t >( transactions.size(), begin + BULK_BATCH_TRANSACTIONS );
+         fill_bulk_signing_cache( transactions, begin, end, cache );
+
+         auto dyn_props = _remote_api.get_dynamic_global_properties();
+         const fc::time_point_sec max_expiration = dyn_props.time + ZATTERA_MAX_TIME_UNTIL_EXPIRATION;
+         for( size_t i = begin; i < end; ++i )
+         {
+            signed_transaction& tx = transactions[i];
+            tx.set_reference_block( dyn_props.head_block_id );
+
+            // Repeated operations, like equal payouts, would otherwise make equal transactions
+            // which the chain rejects as duplicates
+            fc::time_point_sec expiration = dyn_props.time + _tx_expiration_seconds;
+            tx.set_expiration( expiration );
+            while( !ids.insert( tx.id() ).second && expiration < max_expiration )
+               tx.set_expiration( expiration += 1 );
+         }
+
+         vector< string > failures( end - begin );
+         pool.run( end - begin, [&]( size_t i )
+         {
+            try
+            {
+               sign_with_bulk_cache( transactions[ begin + i ], cache );
+            }
+            catch( const fc::exception& e )
+            {
+               failures[i] = e.to_string();
+            }
+            catch( const std::exception& e )
+            {
+               failures[i] = e.what();
+            }
+         });
+
+         vector< size_t > signed_indices;
+         for( size_t i = begin; i < end; ++i )
+         {
+            if( !failures[ i - begin ].empty() )
+            {
+               result.errors.push_back( "signing transaction " + std::to_string( i ) + " failed: " + failures[ i - begin ] );
+               continue;
+            }
+
+            ++result.signed_transactions;
+            result.transaction_ids.push_back( transactions[i].id() );
+            signed_indices.push_back( i );
+            if( out.is_open() )
+               out << fc::json::to_string( transactions[i] ) << '\n';
+         }
+
+         if( broadcast )
+            broadcast_pipelined( transactions, signed_indices, result );
+      }
+
+      return result;
+   }
+
+   bulk_transaction_result bulk_broadcast_transactions( const string& filename )
+   {
+      std::ifstream in( filename );
+      FC_ASSERT( in, "Unable to open ${f}", ("f", filename) );
+
+      vector< signed_transaction > transactions;
+      uint32_t line_num = 0;
+      string line;
+      while( std::getline( in, line ) )
+      {
+         ++line_num;
+         if( line.find_first_not_of( " \t\r" ) == string::npos )
+            continue;
+
+         try
+         {
+            transactions.push_back( fc::json::from_string( line ).as< signed_transaction >() );
+         }
+         FC_CAPTURE_AND_RETHROW( (filename)(line_num) )
+      }
+
+      bulk_transaction_result result;
+      vector< size_t > indices;
+      for( size_t i = 0; i < transactions.size(); ++i )
+      {
+         result.operations += transactions[i].operations.size();
+         result.transaction_ids.push_back( transactions[i].id() );
+         indices.push_back( i );
+      }
+      result.transactions = transactions.size();
+      result.signed_transactions = transactions.size();
+
+      broadcast_pipelined( transactions, indices, result );
+      return result;
+   }
+
    std::map<string,std::function<string(fc::variant,const fc::variants&)>> get_result_formatters() const
    {
       std::map<string,std::function<string(fc::variant,const fc::variants&)> > m;
@@ -1050,6 +1354,17 @@ signed_transaction wallet_api::sign_transaction(
    return result;
 } FC_CAPTURE_AND_RETHROW( (tx) ) }
 
+bulk_transaction_result wallet_api::bulk_sign_operations(
+   string filename, uint32_t operations_per_transaction, string output_filename, bool broadcast )
+{ try {
+   return my->bulk_sign_operations( filename, operations_per_transaction, output_filename, broadcast );
+} FC_CAPTURE_AND_RETHROW( (filename)(operations_per_transaction)(output_filename)(broadcast) ) }
+
+bulk_transaction_result wallet_api::bulk_broadcast_transactions( string filename )
+{ try {
+   return my->bulk_broadcast_transactions( filename );
+} FC_CAPTURE_AND_RETHROW( (filename) ) }
+
 operation wallet_api::get_prototype_operation(string operation_name) {
    return my->get_prototype_operation( operation_name );
 }
@@ -24,11 +24,14 @@
 
 #include <boost/test/unit_test.hpp>
 
+#include <zattera/chain/account_object.hpp>
 #include <zattera/chain/database.hpp>
 #include <zattera/protocol/protocol.hpp>
+#include <zattera/protocol/signature_cache.hpp>
 
 #include <zattera/protocol/zattera_operations.hpp>
 
+#include <fc/bitutil.hpp>
 #include <fc/crypto/digest.hpp>
 #include <fc/crypto/hex.hpp>
 #include "../../fixtures/database_fixture.hpp"
@@ -324,4 +327,139 @@ BOOST_AUTO_TEST_CASE( calculate_merkle_root )
    BOOST_CHECK( block.calculate_merkle_root() == c(dO) );
 }
 
+
+BOOST_AUTO_TEST_CASE( prepared_block_matches_block )
+{
+   fc::ecc::private_key signer = fc::ecc::private_key::regenerate( fc::sha256::hash( string( "prepared" ) ) );
+
+   signed_block block;
+   block.previous._hash[0] = fc::endian_reverse_u32( uint32_t( 41 ) );
+   block.timestamp = fc::time_point_sec( 1000 );
+   block.witness = "alice";
+
+   for( uint32_t i = 0; i < 5; i++ )
+   {
+      signed_transaction tx;
+      tx.ref_block_prefix = i;
+      transfer_operation op;
+      op.from = "alice";
+      op.to = "bob";
+      op.amount = asset( i + 1, LIQUID_SYMBOL );
+      op.memo = string( i * 7, 'm' );
+      tx.operations.push_back( op );
+      tx.sign( signer, chain_id_type() );
+      block.transactions.push_back( tx );
+   }
+   block.transaction_merkle_root = block.calculate_merkle_root();
+   block.sign( signer );
+
+   prepared_block prepared( block );
+   BOOST_CHECK( prepared.id() == block.id() );
+   BOOST_CHECK_EQUAL( prepared.block_num(), 42u );
+   BOOST_CHECK( prepared.header_digest() == block.digest() );
+   BOOST_CHECK( prepared.packed() == fc::raw::pack_to_vector( block ) );
+   BOOST_CHECK( prepared.calculate_merkle_root() == block.transaction_merkle_root );
+   BOOST_CHECK( prepared.validate_signee( signer.get_public_key() ) );
+
+   BOOST_REQUIRE_EQUAL( prepared.transactions().size(), block.transactions.size() );
+   for( size_t i = 0; i < block.transactions.size(); i++ )
+   {
+      const auto& tx = block.transactions[i];
+      const auto& info = prepared.transactions()[i];
+      BOOST_CHECK( info.id == tx.id() );
+      BOOST_CHECK( info.merkle_digest == tx.merkle_digest() );
+      BOOST_CHECK_EQUAL( info.pack_size, fc::raw::pack_size( tx ) );
+      BOOST_CHECK( vector< char >( prepared.packed_transaction( i ), prepared.packed_transaction( i ) + info.pack_size ) == fc::raw::pack_to_vector( tx ) );
+   }
+
+   // Copies share the cached state
+   prepared_block copy = prepared;
+   BOOST_CHECK( &copy.block() == &prepared.block() );
+}
+
+BOOST_AUTO_TEST_CASE( sign_state_shared_authority )
+{
+   ACTORS( (alice)(bob)(sam) )
+
+   db->modify( db->get< account_authority_object, by_account >( "bob" ), [&]( account_authority_object& a )
+   {
+      a.active.clear();
+      a.active.weight_threshold = 2;
+      a.active.add_authority( account_name_type( "alice" ), 1 );
+      a.active.add_authority( account_name_type( "sam" ), 1 );
+   });
+
+   auto get_shared = [&]( const string& name ) -> const shared_authority& { return db->get< account_authority_object, by_account >( name ).active; };
+   authority_getter get_copy = [&]( const string& name ) { return authority( db->get< account_authority_object, by_account >( name ).active ); };
+
+   vector< flat_set< public_key_type > > sig_sets = {
+      {},
+      { alice_public_key },
+      { alice_public_key, sam_public_key },
+      { alice_public_key, sam_public_key, bob_public_key },
+      { bob_public_key }
+   };
+
+   for( const auto& sigs : sig_sets )
+   {
+      flat_set< public_key_type > avail;
+      basic_sign_state< decltype( get_shared ) > shared_state( sigs, get_shared, avail );
+      sign_state copy_state( sigs, get_copy, avail );
+
+      BOOST_REQUIRE_EQUAL( shared_state.check_authority( "bob" ), copy_state.check_authority( "bob" ) );
+      BOOST_REQUIRE_EQUAL( shared_state.check_authority( get_shared( "alice" ) ), copy_state.check_authority( get_copy( "alice" ) ) );
+      BOOST_REQUIRE_EQUAL( shared_state.remove_unused_signatures(), copy_state.remove_unused_signatures() );
+      BOOST_REQUIRE( shared_state.approved_by == copy_state.approved_by );
+   }
+
+   flat_set< public_key_type > avail;
+   basic_sign_state< decltype( get_shared ) > s( { alice_public_key, sam_public_key }, get_shared, avail );
+   BOOST_REQUIRE( s.check_authority( "bob" ) );
+   BOOST_REQUIRE( s.approved_by.count( "alice" ) && s.approved_by.count( "sam" ) );
+}
+
+
+BOOST_AUTO_TEST_CASE( signature_cache_reuses_recovered_keys )
+{
+   auto& cache = signature_cache::instance();
+   size_t old_capacity = cache.capacity();
+   cache.clear();
+
+   fc::ecc::private_key key = generate_private_key( "cache" );
+   public_key_type expected = key.get_public_key();
+
+   vector< std::pair< digest_type, signature_type > > sigs;
+   for( int i = 0; i < 64; ++i )
+   {
+      digest_type d = digest_type::hash( std::to_string( i ) );
+      sigs.emplace_back( d, key.sign_compact( d ) );
+   }
+
+   uint64_t misses = cache.misses();
+   for( int round = 0; round < 2; ++round )
+      for( const auto& s : sigs )
+         BOOST_REQUIRE( cache.recover( s.first, s.second ) == expected );
+
+   BOOST_REQUIRE_EQUAL( cache.misses() - misses, sigs.size() );
+   BOOST_REQUIRE_EQUAL( cache.size(), sigs.size() );
+
+   // A signature over another digest recovers another key and is cached separately
+   BOOST_REQUIRE( cache.recover( sigs[1].first, sigs[0].second ) != expected );
+   BOOST_REQUIRE_EQUAL( cache.size(), sigs.size() + 1 );
+
+   signature_type invalid = sigs[0].second;
+   invalid.data[0] = 0;
+   BOOST_REQUIRE_THROW( cache.recover( sigs[0].first, invalid ), fc::exception );
+   BOOST_REQUIRE_EQUAL( cache.size(), sigs.size() + 1 );
+
+   cache.set_capacity( 16 );
+   BOOST_REQUIRE_LE( cache.size(), 32u );
+   cache.set_capacity( 0 );
+   BOOST_REQUIRE_EQUAL( cache.size(), 0u );
+   BOOST_REQUIRE( cache.recover( sigs[0].first, sigs[0].second ) == expected );
+   BOOST_REQUIRE_EQUAL( cache.size(), 0u );
+
+   cache.set_capacity( old_capacity );
+}
+
 BOOST_AUTO_TEST_SUITE_END()
@@ -27,6 +27,7 @@
 #include <zattera/protocol/exceptions.hpp>
 
 #include <zattera/chain/database.hpp>
+#include <zattera/chain/database_exceptions.hpp>
 #include <zattera/chain/zattera_objects.hpp>
 #include <zattera/chain/history_object.hpp>
 
@@ -243,6 +244,89 @@ BOOST_AUTO_TEST_CASE( fork_blocks )
    }
 }
 
+BOOST_AUTO_TEST_CASE( fork_database_window )
+{
+   try {
+      auto child_of = []( const signed_block& parent, const string& witness )
+      {
+         signed_block b;
+         b.previous = parent.id();
+         b.timestamp = parent.timestamp + ZATTERA_BLOCK_INTERVAL;
+         b.witness = witness;
+         return b;
+      };
+
+      fork_database fdb;
+      vector< signed_block > main_chain( 1 );
+      main_chain[0].timestamp = fc::time_point_sec( ZATTERA_GENESIS_TIME );
+      main_chain[0].witness = "alice";
+      fdb.start_block( main_chain[0] );
+
+      for( uint32_t i = 1; i < 40; ++i )
+      {
+         main_chain.push_back( child_of( main_chain.back(), "alice" ) );
+         fdb.push_block( prepared_block( main_chain.back() ) );
+      }
+      BOOST_REQUIRE_EQUAL( fdb.head()->num, 40u );
+
+      // A shorter fork branching off after block 30 does not become head
+      vector< signed_block > fork_chain( 1, main_chain[29] );
+      for( uint32_t i = 0; i < 5; ++i )
+      {
+         fork_chain.push_back( child_of( fork_chain.back(), "bob" ) );
+         BOOST_CHECK( fdb.push_block( prepared_block( fork_chain.back() ) )->id == main_chain.back().id() );
+      }
+      BOOST_CHECK_EQUAL( fdb.fetch_block_by_number( 32 ).size(), 2u );
+      BOOST_CHECK( fdb.fetch_block( fork_chain[3].id() )->data.witness == "bob" );
+
+      auto branches = fdb.fetch_branch_from( main_chain.back().id(), fork_chain.back().id() );
+      BOOST_CHECK_EQUAL( branches.first.size(), 10u );
+      BOOST_CHECK_EQUAL( branches.second.size(), 5u );
+      BOOST_CHECK( branches.first.back()->previous_id() == main_chain[29].id() );
+      BOOST_CHECK( branches.second.back()->previous_id() == main_chain[29].id() );
+
+      fdb.remove( fork_chain.back().id() );
+      BOOST_CHECK( !fdb.is_known_block( fork_chain.back().id() ) );
+      BOOST_CHECK( fdb.is_known_block( fork_chain[4].id() ) );
+
+      // A block pushed again is stored once, so removing it forgets it
+      BOOST_CHECK( fdb.push_block( prepared_block( fork_chain[3] ) )->id == main_chain.back().id() );
+      BOOST_CHECK( fdb.push_block( prepared_block( main_chain.back() ) )->id == main_chain.back().id() );
+      BOOST_CHECK_EQUAL( fdb.fetch_block_by_number( 33 ).size(), 2u );
+      BOOST_CHECK_EQUAL( fdb.fetch_block_by_number( 40 ).size(), 1u );
+      fdb.remove( fork_chain[3].id() );
+      BOOST_CHECK( !fdb.is_known_block( fork_chain[3].id() ) );
+      BOOST_CHECK_EQUAL( fdb.fetch_block_by_number( 33 ).size(), 1u );
+
+      // Blocks older than the window are dropped, and blocks must link to a known one
+      fdb.set_max_size( 5 );
+      BOOST_CHECK( !fdb.is_known_block( main_chain[33].id() ) );
+      BOOST_CHECK( fdb.is_known_block( main_chain[34].id() ) );
+      BOOST_CHECK_EQUAL( fdb.fetch_block_by_number( 32 ).size(), 0u );
+      BOOST_CHECK_THROW( fdb.push_block( prepared_block( child_of( main_chain[30], "carol" ) ) ), fc::exception );
+      BOOST_CHECK_THROW( fdb.push_block( prepared_block( child_of( child_of( main_chain[36], "carol" ), "carol" ) ) ), unlinkable_block_exception );
+
+      // The ring wraps around many times as the head advances, and grows with the window
+      for( uint32_t i = 0; i < 5000; ++i )
+      {
+         main_chain.push_back( child_of( main_chain.back(), "alice" ) );
+         fdb.push_block( prepared_block( main_chain.back() ) );
+         fdb.set_max_size( i < 3000 ? 10 : 3000 );
+      }
+      BOOST_REQUIRE_EQUAL( fdb.head()->num, 5040u );
+      BOOST_CHECK( fdb.fetch_block_on_main_branch_by_number( 5031 )->id == main_chain[5030].id() );
+      BOOST_CHECK( fdb.fetch_block( main_chain[3100].id() ) );
+      BOOST_CHECK( !fdb.fetch_block( main_chain[3000].id() ) );
+      BOOST_CHECK_EQUAL( fdb.fetch_branch_from( main_chain.back().id(), main_chain[4000].id() ).first.size(), 1040u );
+
+      fdb.pop_block();
+      BOOST_CHECK( fdb.head()->id == main_chain[5038].id() );
+   } catch (fc::exception& e) {
+      edump((e.to_detail_string()));
+      throw;
+   }
+}
+
 BOOST_AUTO_TEST_CASE( switch_forks_undo_create )
 {
    try {
@@ -356,6 +440,77 @@ BOOST_AUTO_TEST_CASE( duplicate_transactions )
    }
 }
 
+BOOST_AUTO_TEST_CASE( parallel_validation )
+{
+   try {
+      fc::temp_directory dir1( zattera::utilities::temp_directory_path() ),
+                         dir2( zattera::utilities::temp_directory_path() );
+      database db1,
+               db2;
+      db1._log_hardforks = false;
+      open_test_database( db1, dir1.path() );
+      db2._log_hardforks = false;
+      open_test_database( db2, dir2.path() );
+      db2.set_parallel_validation_threads( 2 );
+
+      auto skip_sigs = database::skip_transaction_signatures | database::skip_authority_check;
+
+      auto init_account_priv_key  = fc::ecc::private_key::regenerate(fc::sha256::hash(string("init_key")) );
+      public_key_type init_account_pub_key  = init_account_priv_key.get_public_key();
+
+      signed_transaction trx;
+      account_create_operation cop;
+      cop.new_account_name = "alice";
+      cop.creator = ZATTERA_GENESIS_WITNESS_NAME;
+      cop.owner = authority(1, init_account_pub_key, 1);
+      cop.active = cop.owner;
+      trx.operations.push_back(cop);
+      trx.set_expiration( db1.head_block_time() + ZATTERA_MAX_TIME_UNTIL_EXPIRATION );
+      trx.sign( init_account_priv_key, db1.get_chain_id() );
+      PUSH_TX( db1, trx, skip_sigs );
+
+      for( int i = 1; i <= 3; ++i )
+      {
+         trx = decltype(trx)();
+         transfer_operation t;
+         t.from = ZATTERA_GENESIS_WITNESS_NAME;
+         t.to = "alice";
+         t.amount = asset(100 * i,LIQUID_SYMBOL);
+         trx.operations.push_back(t);
+         trx.set_expiration( db1.head_block_time() + ZATTERA_MAX_TIME_UNTIL_EXPIRATION );
+         trx.sign( init_account_priv_key, db1.get_chain_id() );
+         PUSH_TX( db1, trx, skip_sigs );
+      }
+
+      auto b = db1.generate_block( db1.get_slot_time(1), db1.get_scheduled_witness( 1 ), init_account_priv_key, skip_sigs );
+      BOOST_REQUIRE_EQUAL( b.transactions.size(), 4u );
+
+      BOOST_TEST_MESSAGE( "--- A block carrying an invalid transaction is still rejected" );
+      signed_block bad = b;
+      trx = decltype(trx)();
+      transfer_operation neg;
+      neg.from = ZATTERA_GENESIS_WITNESS_NAME;
+      neg.to = "alice";
+      neg.amount = asset(-1,LIQUID_SYMBOL);
+      trx.operations.push_back(neg);
+      trx.set_expiration( db1.head_block_time() + ZATTERA_MAX_TIME_UNTIL_EXPIRATION );
+      bad.transactions.insert( bad.transactions.begin() + 2, trx );
+      bad.transaction_merkle_root = bad.calculate_merkle_root();
+      bad.sign( init_account_priv_key );
+      ZATTERA_CHECK_THROW( PUSH_BLOCK( db2, bad, skip_sigs ), fc::exception );
+      BOOST_CHECK_EQUAL( db2.head_block_num(), 0u );
+
+      BOOST_TEST_MESSAGE( "--- A valid block applies to the same state" );
+      PUSH_BLOCK( db2, b, skip_sigs );
+      BOOST_CHECK( db2.head_block_id() == db1.head_block_id() );
+      BOOST_CHECK_EQUAL(db1.get_balance( "alice", LIQUID_SYMBOL ).amount.value, 600);
+      BOOST_CHECK_EQUAL(db2.get_balance( "alice", LIQUID_SYMBOL ).amount.value, 600);
+   } catch (fc::exception& e) {
+      edump((e.to_detail_string()));
+      throw;
+   }
+}
+
 BOOST_AUTO_TEST_CASE( tapos )
 {
    try {
@@ -0,0 +1,236 @@
+#ifdef IS_TEST_MODE
+#include <boost/test/unit_test.hpp>
+
+#include <zattera/protocol/exceptions.hpp>
+
+#include <zattera/chain/comment_content_store.hpp>
+#include <zattera/chain/database.hpp>
+#include <zattera/chain/zattera_objects.hpp>
+
+#include <zattera/utils/tempdir.hpp>
+
+#include <fc/filesystem.hpp>
+
+#include "../../fixtures/database_fixture.hpp"
+
+using namespace zattera;
+using namespace zattera::chain;
+using namespace zattera::protocol;
+using fc::string;
+
+BOOST_FIXTURE_TEST_SUITE( comment_content_store_tests, clean_database_fixture )
+
+BOOST_AUTO_TEST_CASE( append_and_read )
+{
+   try
+   {
+      BOOST_TEST_MESSAGE( "Testing: append_and_read" );
+
+      fc::temp_directory dir( zattera::utilities::temp_directory_path() );
+      fc::path file = dir.path() / "comment_content.log";
+
+      comment_content first;
+      first.title = "Lorem Ipsum";
+      first.body = "Lorem ipsum dolor sit amet";
+      first.json_metadata = "{\"foo\":\"bar\"}";
+
+      comment_content second;
+      second.body = string( 4096, 'x' );
+
+      uint64_t first_position, second_position;
+      uint32_t first_size, second_size;
+
+      {
+         comment_content_store store;
+         store.open( file, 0 );   // no cache, every read goes to the file
+
+         first_position = store.append( comment_id_type( 1 ), first, first_size );
+         second_position = store.append( comment_id_type( 2 ), second, second_size );
+         BOOST_REQUIRE( second_position > first_position );
+         BOOST_REQUIRE( store.size() == second_position + sizeof( uint32_t ) + second_size );
+         BOOST_REQUIRE( store.cached_bytes() == 0 );
+
+         BOOST_TEST_MESSAGE( "--- Reading entries that have not been flushed" );
+         auto content = store.read( comment_id_type( 2 ), second_position, second_size );
+         BOOST_REQUIRE( content.body == second.body );
+         content = store.read( comment_id_type( 1 ), first_position, first_size );
+         BOOST_REQUIRE( content.title == first.title );
+         BOOST_REQUIRE( content.body == first.body );
+         BOOST_REQUIRE( content.json_metadata == first.json_metadata );
+
+         BOOST_TEST_MESSAGE( "--- Reading an entry for another comment fails" );
+         ZATTERA_REQUIRE_THROW( store.read( comment_id_type( 2 ), first_position, first_size ), fc::exception );
+
+         BOOST_TEST_MESSAGE( "--- Appending the same content again reuses the last entry of the comment" );
+         uint64_t size_before = store.size();
+         uint32_t again_size;
+         BOOST_REQUIRE( store.append( comment_id_type( 2 ), second, again_size ) == second_position );
+         BOOST_REQUIRE( again_size == second_size );
+         BOOST_REQUIRE( store.size() == size_before );
+
+         BOOST_TEST_MESSAGE( "--- The same content for another comment gets its own entry" );
+         uint32_t other_size;
+         uint64_t other_position = store.append( comment_id_type( 3 ), second, other_size );
+         BOOST_REQUIRE( other_position == size_before );
+         BOOST_REQUIRE( store.read( comment_id_type( 3 ), other_position, other_size ).body == second.body );
+         second_position = other_position;
+         second_size = other_size;
+
+         store.close();
+      }
+
+      BOOST_TEST_MESSAGE( "--- Entries are kept when the store is opened again" );
+      comment_content_store store;
+      store.open( file, 1024 * 1024 );
+      BOOST_REQUIRE( store.size() == second_position + sizeof( uint32_t ) + second_size );
+
+      auto content = store.read( comment_id_type( 1 ), first_position, first_size );
+      BOOST_REQUIRE( content.body == first.body );
+      BOOST_REQUIRE( store.cached_bytes() > 0 );
+      content = store.read( comment_id_type( 1 ), first_position, first_size );
+      BOOST_REQUIRE( content.json_metadata == first.json_metadata );
+
+      BOOST_TEST_MESSAGE( "--- Clearing the store discards every entry" );
+      store.clear();
+      BOOST_REQUIRE( store.size() == 0 );
+      BOOST_REQUIRE( store.cached_bytes() == 0 );
+      BOOST_REQUIRE( fc::file_size( file ) == 0 );
+      ZATTERA_REQUIRE_THROW( store.read( comment_id_type( 1 ), first_position, first_size ), fc::exception );
+   }
+   FC_LOG_AND_RETHROW()
+}
+
+BOOST_AUTO_TEST_CASE( comment_content_outside_shared_memory )
+{
+   try
+   {
+      BOOST_TEST_MESSAGE( "Testing: comment_content_outside_shared_memory" );
+
+      use_comment_content_store( 0 );
+
+      ACTORS( (alice) )
+      generate_blocks( 60 / ZATTERA_BLOCK_INTERVAL );
+
+      comment_operation op;
+      op.author = "alice";
+      op.permlink = "lorem";
+      op.parent_author = "";
+      op.parent_permlink = "ipsum";
+      op.title = "Lorem Ipsum";
+      op.body = "Lorem ipsum dolor sit amet, consectetur adipiscing elit, sed do eiusmod tempor incididunt ut labore et dolore magna aliqua.";
+      op.json_metadata = "{\"foo\":\"bar\"}";
+
+      signed_transaction tx;
+      tx.set_expiration( db->head_block_time() + ZATTERA_MAX_TIME_UNTIL_EXPIRATION );
+      tx.operations.push_back( op );
+      tx.sign( alice_private_key, db->get_chain_id() );
+      db->push_transaction( tx, 0 );
+      generate_block();
+
+      const comment_object& alice_comment = db->get_comment( "alice", string( "lorem" ) );
+
+   #ifndef IS_LOW_MEM
+      BOOST_TEST_MESSAGE( "--- The content is in the store, not in shared memory" );
+      const auto& con = db->get< comment_content_object, by_comment >( alice_comment.id );
+      BOOST_REQUIRE( con.content_size > 0 );
+      BOOST_REQUIRE( con.title.size() == 0 );
+      BOOST_REQUIRE( con.body.size() == 0 );
+      BOOST_REQUIRE( con.json_metadata.size() == 0 );
+
+      auto content = db->get_comment_content( alice_comment.id );
+      BOOST_REQUIRE( content.title == op.title );
+      BOOST_REQUIRE( content.body == op.body );
+      BOOST_REQUIRE( content.json_metadata == op.json_metadata );
+
+      BOOST_TEST_MESSAGE( "--- Editing the body appends a new version" );
+      uint64_t first_position = con.content_position;
+
+      op.title = "";
+      op.json_metadata = "";
+      op.body = "Ut enim ad minim veniam";
+      tx.clear();
+      tx.operations.push_back( op );
+      tx.sign( alice_private_key, db->get_chain_id() );
+      db->push_transaction( tx, 0 );
+
+      const auto& edited = db->get< comment_content_object, by_comment >( alice_comment.id );
+      BOOST_REQUIRE( edited.content_position > first_position );
+      content = db->get_comment_content( alice_comment.id );
+      BOOST_REQUIRE( content.title == "Lorem Ipsum" );
+      BOOST_REQUIRE( content.body == op.body );
+      BOOST_REQUIRE( content.json_metadata == "{\"foo\":\"bar\"}" );
+
+      BOOST_TEST_MESSAGE( "--- Undoing the edit points back at the first version" );
+      db->clear_pending();
+
+      const auto& reverted = db->get< comment_content_object, by_comment >( alice_comment.id );
+      BOOST_REQUIRE( reverted.content_position == first_position );
+      content = db->get_comment_content( alice_comment.id );
+      BOOST_REQUIRE( content.title == "Lorem Ipsum" );
+      BOOST_REQUIRE( content.body == "Lorem ipsum dolor sit amet, consectetur adipiscing elit, sed do eiusmod tempor incididunt ut labore et dolore magna aliqua." );
+   #endif
+
+      validate_database();
+   }
+   FC_LOG_AND_RETHROW()
+}
+
+BOOST_AUTO_TEST_CASE( truncated_store_requires_replay )
+{
+   try
+   {
+      BOOST_TEST_MESSAGE( "Testing: truncated_store_requires_replay" );
+
+      use_comment_content_store( 0 );
+
+      ACTORS( (alice) )
+      generate_blocks( 60 / ZATTERA_BLOCK_INTERVAL );
+
+      comment_operation op;
+      op.author = "alice";
+      op.permlink = "lorem";
+      op.parent_author = "";
+      op.parent_permlink = "ipsum";
+      op.title = "Lorem Ipsum";
+      op.body = "Lorem ipsum dolor sit amet";
+
+      signed_transaction tx;
+      tx.set_expiration( db->head_block_time() + ZATTERA_MAX_TIME_UNTIL_EXPIRATION );
+      tx.operations.push_back( op );
+      tx.sign( alice_private_key, db->get_chain_id() );
+      db->push_transaction( tx, 0 );
+      generate_block();
+      uint32_t comment_block = db->head_block_num();
+
+   #ifndef IS_LOW_MEM
+      BOOST_TEST_MESSAGE( "--- Every block records the store size after flushing it" );
+      uint64_t store_size = db->get_comment_content_store().size();
+      BOOST_REQUIRE( store_size > 0 );
+      BOOST_REQUIRE( db->get< comment_content_store_object >().committed_size == store_size );
+      BOOST_REQUIRE( fc::file_size( data_dir->path() / "comment_content.log" ) == store_size );
+
+      generate_blocks( 2 * ZATTERA_MAX_WITNESSES );
+      BOOST_REQUIRE( db->get_dynamic_global_properties().last_irreversible_block_num >= comment_block );
+
+      BOOST_TEST_MESSAGE( "--- Opening with entries missing from the store fails" );
+      database::open_args args;
+      args.data_dir = data_dir->path();
+      args.shared_mem_dir = args.data_dir;
+      args.liquid_initial_supply = TEST_LIQUID_INITIAL_SUPPLY;
+      args.dollar_initial_supply = TEST_DOLLAR_INITIAL_SUPPLY;
+      args.shared_file_size = 1024 * 1024 * 1024;
+      args.use_comment_content_store = true;
+
+      db->close();
+      boost::filesystem::resize_file( ( data_dir->path() / "comment_content.log" ).string(), store_size - 1 );
+      ZATTERA_REQUIRE_THROW( db->open( args ), fc::exception );
+
+      // Start over so the fixture is left with a usable database
+      use_comment_content_store( 0 );
+   #endif
+   }
+   FC_LOG_AND_RETHROW()
+}
+
+BOOST_AUTO_TEST_SUITE_END()
+#endif
@@ -17,6 +17,16 @@
 #include <iomanip>
 #include <sstream>
 
+#ifdef __linux__
+#include <fcntl.h>
+#include <linux/fs.h>
+#include <sys/ioctl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <cerrno>
+#include <cstring>
+#endif
+
 #include "database_fixture.hpp"
 
 //using namespace zattera::chain::test;
@@ -62,23 +72,8 @@ clean_database_fixture::clean_database_fixture()
 
    init_account_pub_key = init_account_priv_key.get_public_key();
 
-   open_database();
-
-   generate_block();
-   db->set_hardfork( ZATTERA_BLOCKCHAIN_VERSION.minor() );
-   generate_block();
-
-   vest( "genesis", 10000 );
-
-   // Fill up the rest of the required witnesses
-   for( int i = ZATTERA_NUM_GENESIS_WITNESSES; i < ZATTERA_MAX_WITNESSES; i++ )
-   {
-      account_create( ZATTERA_GENESIS_WITNESS_NAME + fc::to_string( i ), init_account_pub_key );
-      fund( ZATTERA_GENESIS_WITNESS_NAME + fc::to_string( i ), 10000 );
-      witness_create( ZATTERA_GENESIS_WITNESS_NAME + fc::to_string( i ), init_account_priv_key, "foo.bar", init_account_pub_key, 0 );
-   }
-
-   validate_database();
+   static fixture_snapshot snapshot;
+   open_test_chain( snapshot );
    } catch ( const fc::exception& e )
    {
       edump( (e.to_detail_string()) );
@@ -104,7 +99,33 @@ clean_database_fixture::~clean_database_fixture()
    exit(1);
 }
 
+static database::open_args test_open_args( const fc::path& data_dir )
+{
+   database::open_args args;
+   args.data_dir = data_dir;
+   args.shared_mem_dir = args.data_dir;
+   args.liquid_initial_supply = TEST_LIQUID_INITIAL_SUPPLY;
+   args.dollar_initial_supply = TEST_DOLLAR_INITIAL_SUPPLY;
+   args.shared_file_size = 1024 * 1024 * 1024;   // 512MB file for testing (avoid OOM on long test runs)
+   return args;
+}
+
 void clean_database_fixture::resize_shared_mem( uint64_t size )
+{
+   database::open_args args = test_open_args( data_dir->path() );
+   args.shared_file_size = size;
+   reopen_database( args );
+}
+
+void clean_database_fixture::use_comment_content_store( uint64_t cache_size )
+{
+   database::open_args args = test_open_args( data_dir->path() );
+   args.use_comment_content_store = true;
+   args.comment_content_cache_size = cache_size;
+   reopen_database( args );
+}
+
+void clean_database_fixture::reopen_database( const database::open_args& args )
 {
    db->wipe( data_dir->path(), data_dir->path(), true );
    int argc = boost::unit_test::framework::master_test_suite().argc;
@@ -119,15 +140,7 @@ void clean_database_fixture::resize_shared_mem( uint64_t size )
    }
    init_account_pub_key = init_account_priv_key.get_public_key();
 
-   {
-      database::open_args args;
-      args.data_dir = data_dir->path();
-      args.shared_mem_dir = args.data_dir;
-      args.liquid_initial_supply = TEST_LIQUID_INITIAL_SUPPLY;
-      args.dollar_initial_supply = TEST_DOLLAR_INITIAL_SUPPLY;
-      args.shared_file_size = size;
-      db->open( args );
-   }
+   db->open( args );
 
    boost::program_options::variables_map options;
 
@@ -223,15 +236,170 @@ void database_fixture::open_database()
    {
       data_dir = fc::temp_directory( zattera::utilities::temp_directory_path() );
       db->_log_hardforks = false;
+      db->open( test_open_args( data_dir->path() ) );
+   }
+}
 
-      database::open_args args;
-      args.data_dir = data_dir->path();
-      args.shared_mem_dir = args.data_dir;
-      args.liquid_initial_supply = TEST_LIQUID_INITIAL_SUPPLY;
-      args.dollar_initial_supply = TEST_DOLLAR_INITIAL_SUPPLY;
-      args.shared_file_size = 1024 * 1024 * 1024;   // 512MB file for testing (avoid OOM on long test runs)
-      db->open(args);
+#ifdef __linux__
+static void copy_file_range_by_blocks( int in, int out, off_t begin, off_t end )
+{
+   std::vector< char > buffer( 1024 * 1024 );
+   while( begin < end )
+   {
+      ssize_t bytes_read = ::pread( in, buffer.data(), std::min< off_t >( buffer.size(), end - begin ), begin );
+      FC_ASSERT( bytes_read > 0, "Error reading fixture snapshot file: ${e}", ("e", strerror( errno )) );
+      for( ssize_t written = 0; written < bytes_read; )
+      {
+         ssize_t bytes_written = ::pwrite( out, buffer.data() + written, bytes_read - written, begin + written );
+         FC_ASSERT( bytes_written > 0, "Error writing fixture snapshot file: ${e}", ("e", strerror( errno )) );
+         written += bytes_written;
+      }
+      begin += bytes_read;
+   }
+}
+
+static void clone_file( int in, int out )
+{
+   if( ::ioctl( out, FICLONE, in ) == 0 )
+      return;
+
+   struct stat in_stat;
+   FC_ASSERT( ::fstat( in, &in_stat ) == 0, "Error reading fixture snapshot file: ${e}", ("e", strerror( errno )) );
+
+   // Copy only the data extents so the mostly empty shared memory file stays sparse,
+   // ftruncate() recreates the trailing hole.
+   off_t data = ::lseek( in, 0, SEEK_DATA );
+   if( data < 0 && errno == EINVAL )
+      copy_file_range_by_blocks( in, out, 0, in_stat.st_size );
+
+   while( data >= 0 )
+   {
+      off_t hole = ::lseek( in, data, SEEK_HOLE );
+      if( hole < 0 )
+         hole = in_stat.st_size;
+      copy_file_range_by_blocks( in, out, data, hole );
+      data = ::lseek( in, hole, SEEK_DATA );
    }
+
+   FC_ASSERT( ::ftruncate( out, in_stat.st_size ) == 0, "Error writing fixture snapshot file: ${e}", ("e", strerror( errno )) );
+}
+#endif
+
+/**
+ * Copies every file of a fixture data directory. Files are cloned with FICLONE when the file
+ * system supports it, otherwise only their data is copied.
+ */
+static void clone_directory( const fc::path& from, const fc::path& to )
+{
+   for( boost::filesystem::directory_iterator itr( from ); itr != boost::filesystem::directory_iterator(); ++itr )
+   {
+      if( !boost::filesystem::is_regular_file( itr->path() ) )
+         continue;
+
+      fc::path target = to / itr->path().filename().string();
+#ifdef __linux__
+      int in = ::open( itr->path().string().c_str(), O_RDONLY );
+      FC_ASSERT( in >= 0, "Unable to open ${f}: ${e}", ("f", itr->path().string())("e", strerror( errno )) );
+      int out = ::open( target.string().c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644 );
+      if( out < 0 )
+      {
+         ::close( in );
+         FC_THROW( "Unable to create ${f}: ${e}", ("f", target)("e", strerror( errno )) );
+      }
+
+      try
+      {
+         clone_file( in, out );
+      }
+      catch( ... )
+      {
+         ::close( in );
+         ::close( out );
+         throw;
+      }
+      ::close( in );
+      ::close( out );
+#else
+      fc::copy( fc::path( itr->path().string() ), target );
+#endif
+   }
+}
+
+static bool fixture_snapshots_enabled()
+{
+   const char* disable = getenv( "ZATTERA_DISABLE_FIXTURE_SNAPSHOT" );
+   return disable == nullptr || std::string( disable ) == "0";
+}
+
+void database_fixture::open_test_chain( fixture_snapshot& snapshot )
+{
+   if( restore_snapshot( snapshot ) )
+      return;
+
+   open_database();
+
+   generate_block();
+   db->set_hardfork( ZATTERA_BLOCKCHAIN_VERSION.minor() );
+   generate_block();
+
+   vest( "genesis", 10000 );
+
+   // Fill up the rest of the required witnesses
+   for( int i = ZATTERA_NUM_GENESIS_WITNESSES; i < ZATTERA_MAX_WITNESSES; i++ )
+   {
+      account_create( ZATTERA_GENESIS_WITNESS_NAME + fc::to_string( i ), init_account_pub_key );
+      fund( ZATTERA_GENESIS_WITNESS_NAME + fc::to_string( i ), 10000 );
+      witness_create( ZATTERA_GENESIS_WITNESS_NAME + fc::to_string( i ), init_account_priv_key, "foo.bar", init_account_pub_key, 0 );
+   }
+
+   validate_database();
+
+   if( fixture_snapshots_enabled() )
+      save_snapshot( snapshot );
+}
+
+bool database_fixture::restore_snapshot( const fixture_snapshot& snapshot )
+{
+   if( !snapshot.dir || data_dir )
+      return false;
+
+   data_dir = fc::temp_directory( zattera::utilities::temp_directory_path() );
+   clone_directory( snapshot.dir->path(), data_dir->path() );
+   db->_log_hardforks = false;
+
+   // A normal open rewinds the copy to the last irreversible block, the blocks after it are
+   // pushed again so the clone is the same chain and they can still be popped.
+   db->open( test_open_args( data_dir->path() ) );
+   for( const signed_block& b : snapshot.reversible_blocks )
+      if( b.block_num() > db->head_block_num() )
+         db->push_block( b, default_skip );
+
+   for( const signed_transaction& tx : snapshot.pending_transactions )
+      db->push_transaction( tx, ~0 );
+   trx = snapshot.trx;
+
+   validate_database();
+   return true;
+}
+
+void database_fixture::save_snapshot( fixture_snapshot& snapshot )
+{
+   for( uint32_t block_num = db->get_dynamic_global_properties().last_irreversible_block_num + 1;
+        block_num <= db->head_block_num(); ++block_num )
+      snapshot.reversible_blocks.push_back( *db->fetch_block_by_number( block_num ) );
+   snapshot.pending_transactions = db->_pending_tx;
+   snapshot.trx = trx;
+
+   // The pending transactions live in an undo session that open() has no block for, copy the
+   // state without them and apply them again on both sides.
+   db->clear_pending();
+   db->flush();
+
+   snapshot.dir = fc::temp_directory( zattera::utilities::temp_directory_path() );
+   clone_directory( data_dir->path(), snapshot.dir->path() );
+
+   for( const signed_transaction& tx : snapshot.pending_transactions )
+      db->push_transaction( tx, ~0 );
 }
 
 void database_fixture::generate_block(uint32_t skip, const fc::ecc::private_key& key, int miss_blocks)
@@ -604,23 +772,8 @@ json_rpc_database_fixture::json_rpc_database_fixture()
 
    init_account_pub_key = init_account_priv_key.get_public_key();
 
-   open_database();
-
-   generate_block();
-   db->set_hardfork( ZATTERA_BLOCKCHAIN_VERSION.minor() );
-   generate_block();
-
-   vest( "genesis", 10000 );
-
-   // Fill up the rest of the required witnesses
-   for( int i = ZATTERA_NUM_GENESIS_WITNESSES; i < ZATTERA_MAX_WITNESSES; i++ )
-   {
-      account_create( ZATTERA_GENESIS_WITNESS_NAME + fc::to_string( i ), init_account_pub_key );
-      fund( ZATTERA_GENESIS_WITNESS_NAME + fc::to_string( i ), 10000 );
-      witness_create( ZATTERA_GENESIS_WITNESS_NAME + fc::to_string( i ), init_account_priv_key, "foo.bar", init_account_pub_key, 0 );
-   }
-
-   validate_database();
+   static fixture_snapshot snapshot;
+   open_test_chain( snapshot );
    } catch ( const fc::exception& e )
    {
       edump( (e.to_detail_string()) );
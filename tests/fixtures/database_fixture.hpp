@@ -172,6 +172,19 @@ namespace zattera { namespace chain {
 
 using namespace zattera::protocol;
 
+/**
+ * The state a fixture is in after its setup, saved by the first fixture of its kind in a process
+ * so the ones after it start from a clone instead of building the chain again. dir holds a copy
+ * of the data directory taken while the database was open; the rest is what does not live in it.
+ */
+struct fixture_snapshot
+{
+   optional< fc::temp_directory > dir;
+   vector< signed_block >         reversible_blocks;
+   vector< signed_transaction >   pending_transactions;
+   signed_transaction             trx;
+};
+
 struct database_fixture {
    // the reason we use an app is to exercise the indexes of built-in
    //   plugins
@@ -197,6 +210,15 @@ struct database_fixture {
    static fc::ecc::private_key generate_private_key( string seed = "init_key" );
    string generate_anon_acct_name();
    void open_database();
+
+   /**
+    * @brief Opens the database at the state every fixture starts from: the current hardfork,
+    * two blocks and the remaining genesis witnesses pending
+    * @param snapshot cloned if a previous fixture saved it, otherwise saved after building the chain
+    */
+   void open_test_chain( fixture_snapshot& snapshot );
+   bool restore_snapshot( const fixture_snapshot& snapshot );
+   void save_snapshot( fixture_snapshot& snapshot );
    void generate_block(uint32_t skip = 0,
                                const fc::ecc::private_key& key = generate_private_key("init_key"),
                                int miss_blocks = 0);
@@ -266,6 +288,12 @@ struct clean_database_fixture : public database_fixture
    virtual ~clean_database_fixture();
 
    void resize_shared_mem( uint64_t size );
+   /// Starts the chain over with comment content kept in the comment content store
+   void use_comment_content_store( uint64_t cache_size );
+
+private:
+   /// Wipes the chain and builds the genesis state again with args
+   void reopen_database( const chain::database::open_args& args );
 };
 
 struct live_database_fixture : public database_fixture
@@ -294,5 +294,34 @@ BOOST_AUTO_TEST_CASE( validate_json_rpc_semantics )
    FC_LOG_AND_RETHROW()
 }
 
+BOOST_AUTO_TEST_CASE( validate_json_rpc_typed_params )
+{
+   try
+   {
+      std::string request;
+
+      // Decoded straight from the request text; like the legacy parser, \u escapes are kept as text
+      request = "{\"jsonrpc\":\"2.0\", \"method\":\"database_api.find_accounts\", \"params\":{\"accounts\":[\"te\\u006dp\",\"temp\"], \"unknown\":[1,{}]}, \"id\":30}";
+      fc::variant answer = make_request( request, 0, false, false );
+      BOOST_REQUIRE_EQUAL( answer[ "result" ][ "accounts" ].size(), 1u );
+      BOOST_REQUIRE_EQUAL( answer[ "result" ][ "accounts" ][ size_t(0) ][ "name" ].as_string(), ZATTERA_TEMP_ACCOUNT );
+
+      request = "{\"jsonrpc\":\"2.0\", \"method\":\"database_api.find_accounts\", \"params\":[], \"id\":31}";
+      make_request( request, JSON_RPC_SERVER_ERROR );
+
+      request = "{\"jsonrpc\":\"2.0\", \"method\":\"block_api.get_block\", \"params\":{\"block_num\":\"1\"}, \"id\":32}";
+      make_positive_request( request );
+
+      // Not strict JSON, handled by the legacy parser
+      request = "{\"jsonrpc\":\"2.0\", \"method\":\"block_api.get_block\", \"params\":{\"block_num\":01}, \"id\":33}";
+      make_positive_request( request );
+
+      request = "[{\"jsonrpc\":\"2.0\", \"method\":\"database_api.find_accounts\", \"params\":{\"accounts\":[\"init_miner\"]}, \"id\":34},"
+                 "{\"jsonrpc\":\"2.0\", \"method\":\"database_api.get_dynamic_global_properties\", \"params\":{}, \"id\":35}]";
+      make_array_request( request, 0, false, false );
+   }
+   FC_LOG_AND_RETHROW()
+}
+
 BOOST_AUTO_TEST_SUITE_END()
 #endif
@@ -0,0 +1,94 @@
+#!/bin/bash
+
+# Runs the test cases of a Boost.Test executable (chain_test, plugin_test) across several
+# processes. Test cases are dealt round robin to the shards, each shard is one process with
+# its own ZATTERA_TEMPDIR so their databases never share a directory.
+
+if [[ $# -lt 1 ]]
+then
+   echo Usage: test_executable [jobs [boost_test_args...]]
+   echo        if jobs not passed or 0 the processor count is used
+   echo        shard logs are kept in \$ZATTERA_SHARD_DIR if set, otherwise in a temporary directory
+   echo Example: ./tests/chain_test 8 --log_level=test_suite
+   exit -1
+fi
+
+TEST=$1
+JOBS=${2:-0}
+shift 2 2>/dev/null || shift $#
+
+if [ $JOBS -eq 0 ]
+then
+   JOBS=$(nproc --all)
+fi
+
+SHARD_DIR=${ZATTERA_SHARD_DIR:-$(mktemp -d -t zattera-shards.XXXXXX)}
+mkdir -p $SHARD_DIR
+
+# --list_content prints one unit per line, indented 4 spaces per level, enabled units end with '*'
+CASES=( $("$TEST" --list_content 2>&1 | awk '
+   {
+      match( $0, /^ */ )
+      depth = RLENGTH / 4
+      name = substr( $0, RLENGTH + 1 )
+      enabled = ( name ~ /\*$/ )
+      sub( /[* ]+$/, "", name )
+      path[depth] = name
+      full = path[0]
+      for( i = 1; i <= depth; i++ )
+         full = full "/" path[i]
+      units[NR] = full
+      unit_depth[NR] = depth
+      unit_on[NR] = enabled
+   }
+   END {
+      # a unit is a test case when the next line is not nested below it
+      for( n = 1; n <= NR; n++ )
+         if( unit_on[n] && ( n == NR || unit_depth[n + 1] <= unit_depth[n] ) )
+            print units[n]
+   }') )
+
+if [ ${#CASES[@]} -eq 0 ]
+then
+   echo "No test cases found in $TEST"
+   exit -1
+fi
+
+if [ $JOBS -gt ${#CASES[@]} ]
+then
+   JOBS=${#CASES[@]}
+fi
+
+echo "Running ${#CASES[@]} test cases of $TEST in $JOBS shards, logs in $SHARD_DIR"
+
+PIDS=()
+for (( shard = 0; shard < JOBS; shard++ ))
+do
+   FILTER=""
+   for (( i = shard; i < ${#CASES[@]}; i += JOBS ))
+   do
+      FILTER="$FILTER${FILTER:+:}${CASES[$i]}"
+   done
+
+   mkdir -p $SHARD_DIR/$shard/tmp
+   ZATTERA_TEMPDIR=$SHARD_DIR/$shard/tmp "$TEST" --run_test="$FILTER" "$@" > $SHARD_DIR/$shard.log 2>&1 &
+   PIDS[$shard]=$!
+done
+
+FAILED=0
+for (( shard = 0; shard < JOBS; shard++ ))
+do
+   if ! wait ${PIDS[$shard]}
+   then
+      echo "Shard $shard failed:"
+      tail -n 20 $SHARD_DIR/$shard.log
+      FAILED=1
+   fi
+done
+
+if [ $FAILED -eq 0 ]
+then
+   echo "All shards passed"
+fi
+
+exit $FAILED